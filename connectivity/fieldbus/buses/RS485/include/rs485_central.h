@@ -6,6 +6,9 @@ extern "C" {
 
 void rs485_central_poll_and_save(uint32_t timeout_ms);
 
+// Cadastro de sensores ou modelos mudou: o próximo ciclo relê o arquivo
+void rs485_central_invalidate_config(void);
+
 #ifdef __cplusplus
 }
 #endif
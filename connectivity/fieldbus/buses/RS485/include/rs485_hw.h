@@ -52,6 +52,9 @@ typedef struct {
 
 esp_err_t rs485_hw_init(const rs485_hw_cfg_t *cfg);
 
+/* Remove o driver da UART instalado por rs485_hw_init (DE/RE fica em RX) */
+esp_err_t rs485_hw_deinit(void);
+
 esp_err_t rs485_hw_tx(const uint8_t *data, size_t len, TickType_t tmo);
 esp_err_t rs485_hw_rx(uint8_t *data, size_t max_len, size_t *out_len, TickType_t tmo);
 
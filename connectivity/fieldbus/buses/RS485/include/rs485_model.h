@@ -0,0 +1,117 @@
+/*
+ * rs485_model.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Modelos de equipamento RS-485 descritos em JSON (/littlefs/rs485_models.json)
+ * e compilados em tabelas de decodificação em RAM.
+ *
+ * Permite cadastrar um medidor novo em campo sem gerar firmware: o JSON diz
+ * registradores, tipos, escala, ordem das words e FC; no carregamento vira
+ * um mb_reg_spec_t[] + plano de leitura em bloco (modbus_block_plan), e as
+ * buscas por endereço/tipo viram índices. Na leitura não há string nenhuma.
+ *
+ * Formato:
+ * {
+ *   "models": [{
+ *     "name": "SDM120",            // até 15 caracteres
+ *     "type": "energia",           // mesmo vocabulário do cadastro (rs485_type_from_str)
+ *     "subtype": "monofasico",     // opcional
+ *     "fc": 4,                     // 3 ou 4
+ *     "word_order": "hi_lo",       // ou "lo_hi" (valores de 32 bits)
+ *     "addresses": [7, 8],         // opcional: modelo só nesses endereços (sem: vale p/ o tipo)
+ *     "id": { "reg": 64512, "value": 288, "mask": 65535 },   // opcional (probe)
+ *     "values": [
+ *       { "reg": 0, "type": "f32", "scale": 1, "kind": "tensao", "sub": 1, "decimals": 1 }
+ *     ]
+ *   }]
+ * }
+ *  - type: u16 | s16 | u32 | s32 | f32
+ *  - kind: temperatura | umidade | tensao | corrente | potencia | energia |
+ *          frequencia | fp | pressao | vazao | nivel | outro
+ *  - sub : subcanal na gravação (0 = "canal", N = "canal.N")
+ *
+ * O resultado compilado fica também em /littlefs/rs485_models.bin (com CRC):
+ * enquanto o conteúdo do JSON não mudar (tamanho + CRC32), o boot não passa
+ * pelo cJSON.
+ */
+
+#ifndef CONNECTIVITY_FIELDBUS_BUSES_RS485_INCLUDE_RS485_MODEL_H_
+#define CONNECTIVITY_FIELDBUS_BUSES_RS485_INCLUDE_RS485_MODEL_H_
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rs485_registry.h"
+#include "modbus_block_plan.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RS485_MODEL_MAX          8
+#define RS485_MODEL_MAX_VALUES   16
+#define RS485_MODEL_NAME_LEN     16
+
+typedef struct {
+    char           name[RS485_MODEL_NAME_LEN];
+    uint8_t        type;                             // rs485_type_t
+    uint8_t        subtype;                          // rs485_subtype_t
+    uint8_t        fc;                               // 0x03 / 0x04
+    uint8_t        n_values;
+    mb_reg_spec_t  specs[RS485_MODEL_MAX_VALUES];
+    uint8_t        kind[RS485_MODEL_MAX_VALUES];     // rs485_meas_kind_t
+    uint8_t        sub[RS485_MODEL_MAX_VALUES];
+    uint8_t        decimals[RS485_MODEL_MAX_VALUES];
+    mb_read_plan_t plan;
+    bool           has_id;
+    uint16_t       id_reg;
+    uint16_t       id_mask;
+    uint16_t       id_value;
+} rs485_model_t;
+
+/** @brief (Re)carrega e compila os modelos. Sem arquivo => zero modelos (ESP_OK). */
+esp_err_t rs485_models_load(void);
+
+/**
+ * @brief Valida (compilando) e grava um novo JSON de modelos; recarrega.
+ * @return ESP_ERR_INVALID_ARG se o JSON não compila (nada é gravado).
+ */
+esp_err_t rs485_models_save_json(const char *json, size_t len);
+
+size_t rs485_models_count(void);
+
+/**
+ * @brief Modelo para um sensor cadastrado: primeiro por endereço
+ *        ("addresses"), depois por tipo+subtipo, depois só tipo.
+ * @return índice do modelo ou -1.
+ */
+int rs485_model_find(uint8_t addr, rs485_type_t type, rs485_subtype_t subtype);
+
+/** @brief Cópia do modelo 'idx' (seguro contra recarga concorrente). */
+esp_err_t rs485_model_get(int idx, rs485_model_t *out);
+
+/**
+ * @brief Lê o escravo com o plano do modelo e gera as medições.
+ * @return nº de medições (>=0) ou <0 em erro (mesma convenção do dispatcher).
+ */
+int rs485_model_read(int idx, uint8_t addr, uint16_t channel,
+                     rs485_measurement_t *out, size_t out_len);
+
+/**
+ * @brief Probe pelos modelos que têm "id": lê id_reg e compara com value/mask.
+ * @return índice do modelo reconhecido ou -1.
+ */
+int rs485_model_probe(uint8_t addr, uint8_t *out_fc);
+
+/** @brief Nome do modelo (válido até a próxima recarga) ou NULL. */
+const char *rs485_model_name(int idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_FIELDBUS_BUSES_RS485_INCLUDE_RS485_MODEL_H_ */
@@ -43,12 +43,16 @@ typedef enum {
     RS485_MEAS_NONE = 0,
     RS485_MEAS_TEMP_C,     /* °C */
     RS485_MEAS_HUM_PCT,    /* %RH */
-    /* Exemplos futuros:
-       RS485_MEAS_POWER_W,
-       RS485_MEAS_ENERGY_KWH,
-       RS485_MEAS_FLOW_LMH,
-       RS485_MEAS_PRESS_BAR,
-    */
+    RS485_MEAS_VOLT_V,
+    RS485_MEAS_CURR_A,
+    RS485_MEAS_POWER_W,
+    RS485_MEAS_ENERGY_KWH,
+    RS485_MEAS_FREQ_HZ,
+    RS485_MEAS_PF,
+    RS485_MEAS_PRESS_BAR,
+    RS485_MEAS_FLOW,
+    RS485_MEAS_LEVEL,
+    RS485_MEAS_OTHER,
 } rs485_meas_kind_t;
 
 /* Sensor cadastrado pelo front */
@@ -62,6 +66,8 @@ typedef struct {
 /* Medição produzida pelo dispatcher */
 typedef struct {
     uint16_t          channel;
+    uint8_t           subchannel;  /* 0 = "canal"; N = "canal.N" */
+    uint8_t           decimals;    /* casas na gravação (perfis de modelo) */
     rs485_meas_kind_t kind;
     float             value;
 } rs485_measurement_t;
@@ -74,6 +80,10 @@ const char*      rs485_type_to_str(rs485_type_t t);
 rs485_subtype_t  rs485_subtype_from_str(const char *s);
 const char*      rs485_subtype_to_str(rs485_subtype_t st);
 
+/* Atalhos sobre as strings do cadastro (sensor_map_t) */
+bool             rs485_type_str_is_energy(const char *s);
+int              rs485_phases_from_subtype_str(const char *s);  /* 1 = monofásico; senão 3 */
+
 /* =========================
  * Dispatcher de leitura
  * =========================
@@ -91,7 +101,8 @@ int rs485_poll_all(const rs485_sensor_t *list, size_t count,
 /* =========================
  * Probe / identificação
  * =========================
- * Varre os drivers conhecidos no endereço 'addr'.
+ * Varre os drivers conhecidos (e os modelos de rs485_model com "id") no
+ * endereço 'addr'.
  * Se algum reconhecer, retorna true e preenche:
  *  - out_type/out_subtype: tipo/subtipo para cadastro
  *  - out_used_fc: FC usada pelo driver (0x03/0x04)
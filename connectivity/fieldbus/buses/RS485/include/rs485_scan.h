@@ -0,0 +1,119 @@
+/*
+ * rs485_scan.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Varredura rápida do barramento RS-485 (descoberta de escravos).
+ *
+ * Duas fases:
+ *  1) Sondagem universal "crua" (FC03, 1 registrador em 0x0000) direto na
+ *     UART, com janela de escuta curta calculada a partir do baud rate.
+ *     Qualquer resposta válida — dados OU exceção Modbus — marca o endereço
+ *     como presente. Endereço mudo custa só a janela, não o timeout global
+ *     do esp-modbus.
+ *  2) Fingerprint (rs485_registry_probe_any) apenas nos que responderam,
+ *     com cache por endereço: um escravo já identificado não é sondado de
+ *     novo enquanto a entrada estiver válida.
+ */
+
+#ifndef CONNECTIVITY_FIELDBUS_BUSES_RS485_INCLUDE_RS485_SCAN_H_
+#define CONNECTIVITY_FIELDBUS_BUSES_RS485_INCLUDE_RS485_SCAN_H_
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "rs485_registry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef RS485_SCAN_TURNAROUND_MS
+#define RS485_SCAN_TURNAROUND_MS  40    // espera pelo 1º byte após o fim do pedido
+#endif
+#ifndef RS485_SCAN_FP_SLOTS
+#define RS485_SCAN_FP_SLOTS       16    // entradas do cache de fingerprint
+#endif
+#ifndef RS485_SCAN_FP_TTL_S
+#define RS485_SCAN_FP_TTL_S       600   // validade de uma identificação
+#endif
+
+typedef struct {
+    uint8_t          addr;
+    bool             exception;    // respondeu com exceção (presente, FC03@0 não suportado)
+    uint8_t          used_fc;      // FC que respondeu com dados (0 = desconhecida)
+    uint16_t         latency_ms;   // fim do pedido -> fim da resposta (fase 1)
+    bool             identified;   // algum driver reconheceu
+    bool             cached;       // identificação veio do cache
+    rs485_type_t     type;
+    rs485_subtype_t  subtype;
+    const char      *driver;       // "XY_MD02", "JSY_MK_333"... ou NULL
+} rs485_scan_hit_t;
+
+typedef enum {
+    RS485_SCAN_EV_PROGRESS = 0,    // hit == NULL; addr = último endereço varrido
+    RS485_SCAN_EV_ALIVE,           // respondeu à sondagem universal (fase 1)
+    RS485_SCAN_EV_IDENTIFIED,      // resultado do fingerprint (fase 2)
+} rs485_scan_event_t;
+
+/* Retorne false para cancelar a varredura (ex.: cliente HTTP desconectou). */
+typedef bool (*rs485_scan_cb_t)(rs485_scan_event_t ev, uint8_t addr,
+                                const rs485_scan_hit_t *hit, void *ctx);
+
+typedef struct {
+    uint8_t  first, last;          // faixa (1..247)
+    uint16_t turnaround_ms;        // 0 => RS485_SCAN_TURNAROUND_MS
+    bool     fingerprint;          // roda a fase 2
+    uint32_t skip[8];              // bitmap de endereços a ignorar (ex.: já cadastrados)
+    rs485_scan_cb_t cb;
+    void    *ctx;
+} rs485_scan_cfg_t;
+
+typedef struct {
+    uint16_t scanned;
+    uint16_t alive;
+    uint16_t identified;
+    uint16_t cache_hits;
+    uint32_t sweep_ms;             // fase 1
+    uint32_t fingerprint_ms;       // fase 2
+    bool     cancelled;
+} rs485_scan_stats_t;
+
+void rs485_scan_cfg_defaults(rs485_scan_cfg_t *cfg);
+
+static inline void rs485_scan_skip_addr(rs485_scan_cfg_t *cfg, uint8_t addr)
+{
+    cfg->skip[addr >> 5] |= 1u << (addr & 31);
+}
+
+/**
+ * @brief Varre [first..last]. Abre a própria sessão Modbus (bloqueia o
+ *        barramento durante toda a varredura).
+ * @return ESP_OK (mesmo se cancelada; ver stats), ou erro ao abrir a sessão/UART.
+ */
+esp_err_t rs485_scan_run(const rs485_scan_cfg_t *cfg, rs485_scan_stats_t *stats);
+
+/**
+ * @brief Identifica o escravo em 'addr' usando o cache; se não houver entrada
+ *        válida roda rs485_registry_probe_any() e guarda o resultado. O
+ *        negativo só é guardado se 'out' já indica presença (respondeu na
+ *        fase 1). Chamar com a sessão Modbus aberta.
+ */
+bool rs485_scan_fingerprint(uint8_t addr, rs485_scan_hit_t *out);
+
+/** @brief Guarda uma identificação feita fora da varredura (ex.: /rs485Ping). */
+void rs485_scan_cache_put(const rs485_scan_hit_t *hit);
+
+/** @brief Só consulta o cache (não toca o barramento). */
+bool rs485_scan_cache_lookup(uint8_t addr, rs485_scan_hit_t *out);
+
+/** @brief Esquece a identificação (cadastro removido, reendereçamento...). */
+void rs485_scan_cache_forget(uint8_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_FIELDBUS_BUSES_RS485_INCLUDE_RS485_SCAN_H_ */
@@ -1,37 +1,234 @@
 // rs485_central.c
 #include "rs485_central.h"
 
+#include <stdio.h>
+#include <string.h>
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 
-#include "energy_meter.h"   // energy_meter_save_registered_currents()
+#include "energy_meter.h"   // energy_meter_save_currents_for()
+#include "modbus_dev_profile.h"
+#include "modbus_guard_session.h"
+#include "datalogger_driver.h"   // load_rs485_config(), sensor_map_t
+#include "sdmmc_driver.h"        // record_batch_add()
+#include "rs485_registry.h"
+#include "rs485_model.h"
 
 static const char *TAG = "RS485_CENTRAL";
 
+// Prazo de cada escravo dentro do ciclo (leitura + eventual fallback de FC)
+#ifndef RS485_SLAVE_DEADLINE_MS
+#define RS485_SLAVE_DEADLINE_MS   800
+#endif
+// Orçamento padrão do ciclo quando o chamador passa 0
+#ifndef RS485_CYCLE_BUDGET_MS
+#define RS485_CYCLE_BUDGET_MS     5000
+#endif
+
+typedef struct {
+    uint8_t channel;
+    uint8_t addr;
+    uint8_t phases;
+    uint8_t fail_streak;
+    uint16_t latency_ms;
+    uint16_t timeout_ms;     // derivado do histórico (0 = sem histórico)
+    int8_t   model;          // modelo JSON (rs485_model), -1 = driver de energia
+} rs485_poll_item_t;
+
+// Cadastro já resolvido (endereço, fases, modelo) entre ciclos, em RTC para
+// valer também entre deep sleeps: o arquivo só é relido depois de cold boot
+// ou quando o portal salva sensores ou modelos
+// (rs485_central_invalidate_config incrementa s_cfg_gen).
+typedef struct {
+    uint8_t channel;
+    uint8_t addr;
+    uint8_t phases;
+    int8_t  model;
+} rs485_cfg_item_t;
+
+RTC_DATA_ATTR static rs485_cfg_item_t  s_cfg[RS485_MAX_SENSORS];
+RTC_DATA_ATTR static uint8_t           s_cfg_n;
+RTC_DATA_ATTR static uint32_t          s_cfg_loaded_gen;
+RTC_DATA_ATTR static volatile uint32_t s_cfg_gen = 1;   // != s_cfg_loaded_gen => recarregar
+
+void rs485_central_invalidate_config(void)
+{
+    s_cfg_gen++;
+}
+
+static esp_err_t cfg_refresh(void)
+{
+    uint32_t gen = s_cfg_gen;   // lido antes: salvar durante a carga força outra
+    if (gen == s_cfg_loaded_gen) return ESP_OK;
+
+    sensor_map_t map[RS485_MAX_SENSORS];
+    size_t count = 0;
+    esp_err_t err = load_rs485_config(map, &count);
+    if (err != ESP_OK) return err;
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (map[i].address == 0) continue;
+
+        // Modelo JSON (tabela já compilada) vale para qualquer tipo; sem
+        // modelo, só energia tem leitura aqui
+        int model = rs485_model_find(map[i].address,
+                                     rs485_type_from_str(map[i].type),
+                                     rs485_subtype_from_str(map[i].subtype));
+        if (model < 0 && !rs485_type_str_is_energy(map[i].type)) continue;
+
+        s_cfg[n++] = (rs485_cfg_item_t){
+            .channel = map[i].channel,
+            .addr    = map[i].address,
+            .phases  = (uint8_t)rs485_phases_from_subtype_str(map[i].subtype),
+            .model   = (int8_t)model,
+        };
+    }
+    s_cfg_n = (uint8_t)n;
+    s_cfg_loaded_gen = gen;
+    ESP_LOGI(TAG, "Cadastro RS-485 recarregado: %u escravo(s) no ciclo", (unsigned)n);
+    return ESP_OK;
+}
+
+// Ordem do ciclo: quem está respondendo primeiro (menos falhas seguidas),
+// depois o mais rápido; quem vem falhando fica para o fim do orçamento.
+static bool poll_before(const rs485_poll_item_t *a, const rs485_poll_item_t *b)
+{
+    if (a->fail_streak != b->fail_streak) return a->fail_streak < b->fail_streak;
+    if (a->latency_ms  != b->latency_ms)  return a->latency_ms  < b->latency_ms;
+    return a->addr < b->addr;
+}
+
+static size_t plan_cycle(rs485_poll_item_t *items, size_t *backoff)
+{
+    if (cfg_refresh() != ESP_OK) return 0;
+
+    size_t n = 0;
+    for (size_t i = 0; i < s_cfg_n; ++i) {
+        rs485_poll_item_t it = {
+            .channel = s_cfg[i].channel,
+            .addr    = s_cfg[i].addr,
+            .phases  = s_cfg[i].phases,
+            .model   = s_cfg[i].model,
+        };
+        // escravo que não responde há vários ciclos: backoff exponencial
+        if (!mb_prof_should_poll(it.addr)) {
+            (*backoff)++;
+            continue;
+        }
+
+        mb_dev_profile_t prof;
+        if (mb_prof_get(it.addr, &prof) == ESP_OK) {
+            it.fail_streak = prof.fail_streak;
+            it.latency_ms  = prof.srtt_ms ? prof.srtt_ms : prof.last_latency_ms;
+            if (prof.hist_n) it.timeout_ms = (uint16_t)mb_prof_timeout_ms(it.addr);
+        }
+
+        // inserção ordenada (no máximo RS485_MAX_SENSORS itens)
+        size_t j = n++;
+        while (j > 0 && poll_before(&it, &items[j - 1])) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = it;
+    }
+    return n;
+}
+
+// Escravo descrito por modelo JSON: um plano de leitura em bloco, valores
+// gravados como "canal.sub" com as casas decimais do modelo
+static esp_err_t save_model_values(const rs485_poll_item_t *it)
+{
+    rs485_measurement_t meas[RS485_MODEL_MAX_VALUES];
+    int n = rs485_model_read(it->model, it->addr, it->channel, meas, RS485_MODEL_MAX_VALUES);
+    if (n <= 0) return ESP_FAIL;
+
+    esp_err_t err = ESP_OK;
+    for (int k = 0; k < n; ++k) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "%.*f", meas[k].decimals, meas[k].value);
+        esp_err_t e = record_batch_add(meas[k].channel, meas[k].subchannel, buf);
+        if (e != ESP_OK) err = e;
+    }
+    return err;
+}
+
 /**
  * Centraliza a leitura de TODOS os sensores RS-485 de energia cadastrados
  * (aqueles que estão no arquivo de configuração RS485, via front).
  *
- * A lista de canais/endereços vem do adaptador:
- *   rs485_registry_iterate_configured()  (em rs485_registry_adapter.c)
+ * Um ciclo = uma sessão Modbus: o master sobe uma vez, os escravos são
+ * lidos na ordem planejada (plan_cycle) e a sessão fecha no fim. As
+ * sessões curtas de cada leitura (MB_SESSION_WITH no energy_meter) só
+ * incrementam o refcount.
+ *
+ * timeout_ms é o orçamento total do ciclo; cada escravo tem ainda um prazo
+ * próprio, derivado do seu histórico de resposta (mb_prof_timeout_ms) e
+ * limitado a RS485_SLAVE_DEADLINE_MS. Quem não couber fica para o próximo
+ * ciclo; quem não responde há vários ciclos entra em backoff.
+ *
+ * Sensores com modelo JSON (rs485_model) entram no mesmo ciclo, de
+ * qualquer tipo, lidos pelo plano pré-compilado do modelo.
  *
- * Para cada item, o energy_meter grava os valores no SD usando
- * save_record_sd_rs485() no formato "canal" / "canal.subcanal".
+ * Os valores vão para o SD via record_batch_add() no formato
+ * "canal" / "canal.subcanal".
  */
 void rs485_central_poll_and_save(uint32_t timeout_ms)
 {
-    // Por enquanto não usamos o timeout; deixei para futura expansão
-    (void) timeout_ms;
-
-    esp_err_t err = energy_meter_save_registered_currents();
-
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Central: leituras RS485 salvas com sucesso.");
-    } else if (err == ESP_ERR_NOT_FOUND) {
-        // Ninguém cadastrado (ou iterador ainda é a versão WEAK)
-        ESP_LOGW(TAG, "Central: nenhum medidor RS485 cadastrado.");
-    } else {
-        ESP_LOGW(TAG, "Central: falha ao salvar leituras RS485: %s",
-                 esp_err_to_name(err));
+    const int64_t t0 = esp_timer_get_time();
+    const int64_t cycle_deadline = t0 + (int64_t)(timeout_ms ? timeout_ms : RS485_CYCLE_BUDGET_MS) * 1000;
+
+    rs485_poll_item_t items[RS485_MAX_SENSORS];
+    size_t backoff = 0;
+    size_t n = plan_cycle(items, &backoff);
+    if (n == 0) {
+        if (backoff) ESP_LOGI(TAG, "Central: %u medidor(es) em backoff; nada a ler.", (unsigned)backoff);
+        else         ESP_LOGW(TAG, "Central: nenhum medidor RS485 cadastrado.");
+        (void) mb_prof_flush();
+        return;
+    }
+
+    esp_err_t err = mb_session_begin(pdMS_TO_TICKS(500));
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Central: sessão Modbus indisponível: %s", esp_err_to_name(err));
+        return;
+    }
+    const int64_t t_open = esp_timer_get_time();
+
+    size_t ok = 0, failed = 0, skipped = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t now = esp_timer_get_time();
+        if (now >= cycle_deadline) {
+            skipped = n - i;
+            break;
+        }
+        uint32_t slave_ms = RS485_SLAVE_DEADLINE_MS;
+        if (items[i].timeout_ms && items[i].timeout_ms < slave_ms) slave_ms = items[i].timeout_ms;
+        int64_t slave_deadline = now + (int64_t)slave_ms * 1000;
+        if (slave_deadline > cycle_deadline) slave_deadline = cycle_deadline;
+
+        esp_err_t e = (items[i].model >= 0)
+                    ? save_model_values(&items[i])
+                    : energy_meter_save_currents_for(items[i].channel, items[i].addr,
+                                                     items[i].phases, slave_deadline);
+        if (e == ESP_OK) ok++; else failed++;
+
+        int64_t spent_ms = (esp_timer_get_time() - now) / 1000;
+        if (spent_ms > (int64_t)slave_ms) {
+            ESP_LOGW(TAG, "ch=%u addr=%u estourou o prazo (%lldms)",
+                     items[i].channel, items[i].addr, (long long)spent_ms);
+        }
     }
+
+    mb_session_end();
+
+    // FC/ordem de words que mudaram no ciclo vão para a flash de uma vez
+    (void) mb_prof_flush();
+
+    int64_t t_end = esp_timer_get_time();
+    ESP_LOGI(TAG, "Central: %u ok, %u falha(s), %u adiado(s), %u em backoff | abertura=%lldms ciclo=%lldms",
+             (unsigned)ok, (unsigned)failed, (unsigned)skipped, (unsigned)backoff,
+             (long long)((t_open - t0) / 1000), (long long)((t_end - t0) / 1000));
 }
@@ -55,6 +55,13 @@ esp_err_t rs485_hw_init(const rs485_hw_cfg_t *cfg)
     return ESP_OK;
 }
 
+esp_err_t rs485_hw_deinit(void)
+{
+    gpio_set_level(s_cfg.de_re_gpio, 0);
+    if (!uart_is_driver_installed(s_cfg.uart_num)) return ESP_OK;
+    return uart_driver_delete(s_cfg.uart_num);
+}
+
 static inline void set_tx(void){ gpio_set_level(s_cfg.de_re_gpio, 1); }
 static inline void set_rx(void){ gpio_set_level(s_cfg.de_re_gpio, 0); }
 
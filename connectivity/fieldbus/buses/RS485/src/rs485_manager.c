@@ -8,6 +8,7 @@
 
 #include "modbus_rtu_master.h"   // backend genérico (ping básico)
 #include "rs485_registry.h"      // rs485_registry_probe_any()
+#include "rs485_scan.h"          // rs485_scan_cache_put()
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -79,6 +80,10 @@ ESP_LOGW(TAG, "ping drivers: chamando rs485_registry_probe_any(addr=%u)", (unsig
                  "ping driver addr=%u -> FOUND type=%d subtype=%d driver=%s fc=0x%02X",
                  addr, (int)type, (int)st, (drv ? drv : "NULL"), drv_fc);
         if (used_fc) *used_fc = drv_fc;
+        // a varredura do portal reaproveita a identificação
+        rs485_scan_cache_put(&(rs485_scan_hit_t) {
+            .addr = addr, .identified = true, .used_fc = drv_fc,
+            .type = type, .subtype = st, .driver = drv });
         // exception segue false
         return true;
     }
@@ -0,0 +1,485 @@
+/*
+ * rs485_model.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "rs485_model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "cJSON.h"
+#include "modbus_rtu_master.h"
+#include "modbus_dev_profile.h"
+#include "modbus_guard_session.h"
+
+#define RS485_MODEL_JSON      "/littlefs/rs485_models.json"
+#define RS485_MODEL_JSON_TMP  "/littlefs/rs485_models.tmp"
+#define RS485_MODEL_BIN       "/littlefs/rs485_models.bin"
+#define RS485_MODEL_BIN_TMP   "/littlefs/rs485_models.btmp"
+#define RS485_MODEL_MAGIC     0x324C444Du   // "MDL2"
+#define RS485_MODEL_JSON_MAX  8192
+
+#define NO_MODEL              0xFF
+#define N_TYPES               (RS485_TYPE_OUTRO + 1)
+#define N_SUBTYPES            (RS485_SUBTYPE_TRIFASICO + 1)
+
+static const char *TAG = "RS485_MODEL";
+
+// ---- Tabela compilada (RAM) ----
+typedef struct {
+    uint8_t       count;
+    rs485_model_t m[RS485_MODEL_MAX];
+    uint8_t       by_addr[248];                  // endereço -> modelo
+    uint8_t       by_type[N_TYPES][N_SUBTYPES];  // tipo/subtipo -> modelo
+} model_table_t;
+
+// ---- Binário compilado: cabeçalho + tabela + CRC32 ----
+// 'json_size'/'json_crc' amarram o binário ao conteúdo do JSON de origem
+// (o mtime depende do relógio, que pode não estar acertado ou voltar
+// no tempo); 'tab_size' invalida o cache quando o layout de rs485_model_t
+// muda entre versões.
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t json_size;
+    uint32_t json_crc;
+    uint32_t tab_size;
+} model_file_hdr_t;
+
+static model_table_t     s_tab;
+static bool              s_loaded;
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock;
+static portMUX_TYPE      s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void lock(void)
+{
+    if (!s_lock) {
+        portENTER_CRITICAL(&s_init_mux);
+        if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+        portEXIT_CRITICAL(&s_init_mux);
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void) { xSemaphoreGive(s_lock); }
+
+static void table_reset(model_table_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    memset(t->by_addr, NO_MODEL, sizeof(t->by_addr));
+    memset(t->by_type, NO_MODEL, sizeof(t->by_type));
+}
+
+/* ---------------- JSON -> tabela ---------------- */
+
+static int val_type_from_str(const char *s, bool lo_hi)
+{
+    if (!s || strcasecmp(s, "u16") == 0) return MB_VAL_U16;
+    if (strcasecmp(s, "s16") == 0) return MB_VAL_S16;
+    if (strcasecmp(s, "u32") == 0) return lo_hi ? MB_VAL_U32_LE : MB_VAL_U32;
+    if (strcasecmp(s, "s32") == 0) return lo_hi ? MB_VAL_S32_LE : MB_VAL_S32;
+    if (strcasecmp(s, "f32") == 0) return lo_hi ? MB_VAL_F32_LE : MB_VAL_F32;
+    return -1;
+}
+
+static rs485_meas_kind_t kind_from_str(const char *s)
+{
+    static const struct { const char *name; rs485_meas_kind_t kind; } map[] = {
+        { "temperatura", RS485_MEAS_TEMP_C },    { "umidade",    RS485_MEAS_HUM_PCT },
+        { "tensao",      RS485_MEAS_VOLT_V },    { "corrente",   RS485_MEAS_CURR_A },
+        { "potencia",    RS485_MEAS_POWER_W },   { "energia",    RS485_MEAS_ENERGY_KWH },
+        { "frequencia",  RS485_MEAS_FREQ_HZ },   { "fp",         RS485_MEAS_PF },
+        { "pressao",     RS485_MEAS_PRESS_BAR }, { "vazao",      RS485_MEAS_FLOW },
+        { "nivel",       RS485_MEAS_LEVEL },
+    };
+    if (s) {
+        for (size_t i = 0; i < sizeof(map) / sizeof(map[0]); i++) {
+            if (strcasecmp(s, map[i].name) == 0) return map[i].kind;
+        }
+    }
+    return RS485_MEAS_OTHER;
+}
+
+static int json_int(const cJSON *obj, const char *key, int def)
+{
+    const cJSON *it = cJSON_GetObjectItem(obj, key);
+    return cJSON_IsNumber(it) ? it->valueint : def;
+}
+
+static const char *json_str(const cJSON *obj, const char *key)
+{
+    const cJSON *it = cJSON_GetObjectItem(obj, key);
+    return (cJSON_IsString(it) && it->valuestring) ? it->valuestring : NULL;
+}
+
+static esp_err_t compile_model(const cJSON *jm, uint8_t idx, model_table_t *t)
+{
+    rs485_model_t *m = &t->m[idx];
+    memset(m, 0, sizeof(*m));
+
+    const char *name = json_str(jm, "name");
+    snprintf(m->name, sizeof(m->name), "%s", name ? name : "modelo");
+
+    rs485_type_t type = rs485_type_from_str(json_str(jm, "type"));
+    if (type == RS485_TYPE_INVALID) {
+        ESP_LOGW(TAG, "%s: 'type' inválido", m->name);
+        return ESP_ERR_INVALID_ARG;
+    }
+    m->type    = (uint8_t)type;
+    m->subtype = (uint8_t)rs485_subtype_from_str(json_str(jm, "subtype"));
+
+    int fc = json_int(jm, "fc", 0x03);
+    if (fc != 0x03 && fc != 0x04) {
+        ESP_LOGW(TAG, "%s: fc=%d (use 3 ou 4)", m->name, fc);
+        return ESP_ERR_INVALID_ARG;
+    }
+    m->fc = (uint8_t)fc;
+
+    const char *wo = json_str(jm, "word_order");
+    bool lo_hi = wo && strcasecmp(wo, "lo_hi") == 0;
+
+    const cJSON *vals = cJSON_GetObjectItem(jm, "values");
+    int nv = cJSON_GetArraySize(vals);
+    if (!cJSON_IsArray(vals) || nv <= 0 || nv > RS485_MODEL_MAX_VALUES) {
+        ESP_LOGW(TAG, "%s: 'values' deve ter 1..%d itens", m->name, RS485_MODEL_MAX_VALUES);
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < nv; i++) {
+        const cJSON *jv  = cJSON_GetArrayItem(vals, i);
+        int reg          = json_int(jv, "reg", -1);
+        int vt           = val_type_from_str(json_str(jv, "type"), lo_hi);
+        const cJSON *sc  = cJSON_GetObjectItem(jv, "scale");
+        if (reg < 0 || reg > 0xFFFF || vt < 0) {
+            ESP_LOGW(TAG, "%s: values[%d] com reg/type inválido", m->name, i);
+            return ESP_ERR_INVALID_ARG;
+        }
+        m->specs[i] = (mb_reg_spec_t){
+            .reg   = (uint16_t)reg,
+            .type  = (uint8_t)vt,
+            .scale = cJSON_IsNumber(sc) ? (float)sc->valuedouble : 1.0f,
+        };
+        m->kind[i]     = (uint8_t)kind_from_str(json_str(jv, "kind"));
+        m->sub[i]      = (uint8_t)json_int(jv, "sub", i + 1);
+        m->decimals[i] = (uint8_t)json_int(jv, "decimals", 2);
+    }
+    m->n_values = (uint8_t)nv;
+
+    // O plano sai pronto daqui: na leitura é só executar
+    esp_err_t err = mb_plan_build(m->specs, nv, MB_PLAN_DEFAULT_SPAN, MB_PLAN_DEFAULT_GAP, &m->plan);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s: mapa não cabe num plano de leitura (%s)", m->name, esp_err_to_name(err));
+        return err;
+    }
+
+    const cJSON *jid = cJSON_GetObjectItem(jm, "id");
+    if (cJSON_IsObject(jid) && json_int(jid, "reg", -1) >= 0) {
+        m->has_id   = true;
+        m->id_reg   = (uint16_t)json_int(jid, "reg", 0);
+        m->id_value = (uint16_t)json_int(jid, "value", 0);
+        m->id_mask  = (uint16_t)json_int(jid, "mask", 0xFFFF);
+    }
+
+    // Índices: o primeiro modelo que reivindicar o endereço/tipo fica com ele.
+    // Com "addresses" o modelo vale só nesses endereços; sem, vale para o tipo.
+    const cJSON *addrs = cJSON_GetObjectItem(jm, "addresses");
+    if (cJSON_IsArray(addrs) && cJSON_GetArraySize(addrs) > 0) {
+        const cJSON *ja;
+        cJSON_ArrayForEach(ja, addrs) {
+            if (!cJSON_IsNumber(ja) || ja->valueint < 1 || ja->valueint > 247) continue;
+            if (t->by_addr[ja->valueint] == NO_MODEL) t->by_addr[ja->valueint] = idx;
+        }
+    } else if (t->by_type[m->type][m->subtype] == NO_MODEL) {
+        t->by_type[m->type][m->subtype] = idx;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t compile_json(const char *json, size_t len, model_table_t *t)
+{
+    table_reset(t);
+
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!root) {
+        ESP_LOGW(TAG, "JSON de modelos inválido");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    const cJSON *models = cJSON_GetObjectItem(root, "models");
+    if (!cJSON_IsArray(models) || cJSON_GetArraySize(models) > RS485_MODEL_MAX) {
+        ESP_LOGW(TAG, "'models' deve ser uma lista de até %d modelos", RS485_MODEL_MAX);
+        err = ESP_ERR_INVALID_ARG;
+    } else {
+        const cJSON *jm;
+        cJSON_ArrayForEach(jm, models) {
+            err = compile_model(jm, t->count, t);
+            if (err != ESP_OK) break;
+            t->count++;
+        }
+    }
+    cJSON_Delete(root);
+    return err;
+}
+
+/* ---------------- binário compilado ---------------- */
+
+static bool load_bin(size_t json_len, uint32_t json_crc, model_table_t *t)
+{
+    FILE *f = fopen(RS485_MODEL_BIN, "rb");
+    if (!f) return false;
+
+    model_file_hdr_t hdr;
+    uint32_t crc_file = 0;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+              hdr.magic == RS485_MODEL_MAGIC &&
+              hdr.json_size == (uint32_t)json_len &&
+              hdr.json_crc == json_crc &&
+              hdr.tab_size == sizeof(*t) &&
+              fread(t, sizeof(*t), 1, f) == 1 &&
+              fread(&crc_file, sizeof(crc_file), 1, f) == 1;
+    fclose(f);
+    if (!ok) return false;
+
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, sizeof(hdr));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)t, sizeof(*t));
+    return crc == crc_file && t->count <= RS485_MODEL_MAX;
+}
+
+static void save_bin(size_t json_len, uint32_t json_crc, const model_table_t *t)
+{
+    model_file_hdr_t hdr = {
+        .magic      = RS485_MODEL_MAGIC,
+        .json_size  = (uint32_t)json_len,
+        .json_crc   = json_crc,
+        .tab_size   = sizeof(*t),
+    };
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, sizeof(hdr));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)t, sizeof(*t));
+
+    FILE *f = fopen(RS485_MODEL_BIN_TMP, "wb");
+    bool ok = f &&
+              fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(t, sizeof(*t), 1, f) == 1 &&
+              fwrite(&crc, sizeof(crc), 1, f) == 1;
+    if (f) fclose(f);
+    if (ok && rename(RS485_MODEL_BIN_TMP, RS485_MODEL_BIN) != 0) ok = false;
+    if (!ok) {
+        // Sem o cache só se perde tempo de boot: o JSON continua valendo
+        ESP_LOGW(TAG, "Falha ao gravar %s: %s", RS485_MODEL_BIN, strerror(errno));
+        unlink(RS485_MODEL_BIN_TMP);
+    }
+}
+
+static esp_err_t read_json(const struct stat *st, char **out, size_t *out_len)
+{
+    if (st->st_size <= 0 || st->st_size > RS485_MODEL_JSON_MAX) return ESP_ERR_INVALID_SIZE;
+
+    FILE *f = fopen(RS485_MODEL_JSON, "rb");
+    if (!f) return ESP_ERR_NOT_FOUND;
+    char *buf = malloc((size_t)st->st_size + 1);
+    if (!buf) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+    size_t n = fread(buf, 1, (size_t)st->st_size, f);
+    fclose(f);
+    buf[n] = '\0';
+    *out = buf;
+    *out_len = n;
+    return ESP_OK;
+}
+
+/* ---------------- API ---------------- */
+
+static void table_publish(const model_table_t *t)
+{
+    lock();
+    s_tab = *t;
+    s_loaded = true;
+    unlock();
+}
+
+esp_err_t rs485_models_load(void)
+{
+    model_table_t *t = malloc(sizeof(*t));
+    if (!t) return ESP_ERR_NO_MEM;
+
+    // Ler o JSON e tirar o CRC custa bem menos que o parse cJSON + compilação
+    esp_err_t err = ESP_OK;
+    struct stat st;
+    char *json = NULL;
+    size_t len = 0;
+    if (stat(RS485_MODEL_JSON, &st) != 0) {
+        table_reset(t);                      // sem arquivo: nenhum modelo
+    } else if ((err = read_json(&st, &json, &len)) != ESP_OK) {
+        ESP_LOGW(TAG, "Modelos ignorados (%s)", esp_err_to_name(err));
+        table_reset(t);
+    } else {
+        uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)json, len);
+        if (load_bin(len, crc, t)) {
+            ESP_LOGI(TAG, "%u modelo(s) do binário compilado", (unsigned)t->count);
+        } else if ((err = compile_json(json, len, t)) == ESP_OK) {
+            save_bin(len, crc, t);
+            ESP_LOGI(TAG, "%u modelo(s) compilado(s) de %s", (unsigned)t->count, RS485_MODEL_JSON);
+        } else {
+            ESP_LOGW(TAG, "Modelos ignorados (%s)", esp_err_to_name(err));
+            table_reset(t);
+        }
+        free(json);
+    }
+
+    table_publish(t);
+    free(t);
+    return err;
+}
+
+static inline void ensure_loaded(void)
+{
+    if (!s_loaded) (void)rs485_models_load();
+}
+
+esp_err_t rs485_models_save_json(const char *json, size_t len)
+{
+    if (!json || len == 0 || len > RS485_MODEL_JSON_MAX) return ESP_ERR_INVALID_ARG;
+
+    // Valida antes de tocar na flash: se não compila, nada muda
+    model_table_t *t = malloc(sizeof(*t));
+    if (!t) return ESP_ERR_NO_MEM;
+    esp_err_t err = compile_json(json, len, t);
+    if (err != ESP_OK) {
+        free(t);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FILE *f = fopen(RS485_MODEL_JSON_TMP, "wb");
+    bool ok = f && fwrite(json, 1, len, f) == len;
+    if (f) fclose(f);
+    if (ok && rename(RS485_MODEL_JSON_TMP, RS485_MODEL_JSON) != 0) ok = false;
+    if (!ok) {
+        ESP_LOGW(TAG, "Falha ao gravar %s: %s", RS485_MODEL_JSON, strerror(errno));
+        unlink(RS485_MODEL_JSON_TMP);
+        free(t);
+        return ESP_FAIL;
+    }
+    // A tabela que acabou de ser compilada vira o cache do novo conteúdo
+    save_bin(len, esp_rom_crc32_le(0, (const uint8_t *)json, len), t);
+    table_publish(t);
+    ESP_LOGI(TAG, "%u modelo(s) salvo(s)", (unsigned)t->count);
+    free(t);
+    return ESP_OK;
+}
+
+size_t rs485_models_count(void)
+{
+    ensure_loaded();
+    return s_tab.count;
+}
+
+int rs485_model_find(uint8_t addr, rs485_type_t type, rs485_subtype_t subtype)
+{
+    ensure_loaded();
+    if (s_tab.count == 0) return -1;
+
+    uint8_t idx = NO_MODEL;
+    lock();
+    if (addr >= 1 && addr <= 247) idx = s_tab.by_addr[addr];
+    if (idx == NO_MODEL && type > RS485_TYPE_INVALID && type < N_TYPES) {
+        if (subtype < N_SUBTYPES) idx = s_tab.by_type[type][subtype];
+        if (idx == NO_MODEL)      idx = s_tab.by_type[type][RS485_SUBTYPE_NONE];
+    }
+    unlock();
+    return (idx == NO_MODEL) ? -1 : idx;
+}
+
+esp_err_t rs485_model_get(int idx, rs485_model_t *out)
+{
+    if (!out) return ESP_ERR_INVALID_ARG;
+    ensure_loaded();
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    lock();
+    if (idx >= 0 && idx < s_tab.count) {
+        *out = s_tab.m[idx];
+        err = ESP_OK;
+    }
+    unlock();
+    return err;
+}
+
+int rs485_model_read(int idx, uint8_t addr, uint16_t channel,
+                     rs485_measurement_t *out, size_t out_len)
+{
+    if (!out || out_len == 0) return -1;
+
+    rs485_model_t m;
+    if (rs485_model_get(idx, &m) != ESP_OK) return -3;
+
+    float v[RS485_MODEL_MAX_VALUES];
+    esp_err_t err = ESP_ERR_TIMEOUT;   // sessão não abriu => não lemos nada
+    bool tried = false;
+    uint32_t lat_ms = 0;
+
+    // Dentro do ciclo do rs485_central a sessão já está aberta: só refcount
+    MB_SESSION_WITH(pdMS_TO_TICKS(500)) {
+        tried = true;
+        int64_t t0 = esp_timer_get_time();
+        err = mb_plan_read(addr, m.fc, m.specs, m.n_values, &m.plan, v);
+        lat_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+    }
+    if (err != ESP_OK) {
+        if (tried) mb_prof_note_fail(addr);   // barramento ocupado não conta contra o escravo
+        ESP_LOGW(TAG, "%s addr=%u: %s", m.name, addr, esp_err_to_name(err));
+        return -1;
+    }
+    mb_prof_note_ok(addr, m.fc, lat_ms);
+
+    size_t n = (m.n_values < out_len) ? m.n_values : out_len;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (rs485_measurement_t){
+            .channel    = channel,
+            .subchannel = m.sub[i],
+            .decimals   = m.decimals[i],
+            .kind       = (rs485_meas_kind_t)m.kind[i],
+            .value      = v[i],
+        };
+    }
+    return (int)n;
+}
+
+int rs485_model_probe(uint8_t addr, uint8_t *out_fc)
+{
+    ensure_loaded();
+    for (int i = 0; i < RS485_MODEL_MAX; i++) {
+        rs485_model_t m;
+        if (rs485_model_get(i, &m) != ESP_OK) break;
+        if (!m.has_id) continue;
+
+        uint16_t w = 0;
+        esp_err_t e = (m.fc == 0x04)
+                    ? modbus_master_read_input_registers(addr, m.id_reg, 1, &w)
+                    : modbus_master_read_holding_registers(addr, m.id_reg, 1, &w);
+        if (e == ESP_OK && (w & m.id_mask) == (m.id_value & m.id_mask)) {
+            if (out_fc) *out_fc = m.fc;
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *rs485_model_name(int idx)
+{
+    ensure_loaded();
+    // Aponta para a tabela estática: válido até a próxima recarga
+    return (idx >= 0 && idx < s_tab.count) ? s_tab.m[idx].name : NULL;
+}
@@ -15,6 +15,7 @@
 #include "esp_log.h"
 #include "xy_md02_driver.h"              // temperature_rs485_probe/read  (XY-MD02)
 #include "energy_jsy_mk_333_driver.h"    // jsy_mk333_probe               (JSY-MK-333)
+#include "rs485_model.h"                 // modelos descritos em JSON
 
 /* Se um termo-higrômetro reportar UR, publicamos no mesmo canal do T */
 #define TH_HUM_SAME_CHANNEL 1
@@ -86,6 +87,14 @@ rs485_subtype_t rs485_subtype_from_str(const char *s) {
     return RS485_SUBTYPE_NONE;
 }
 
+bool rs485_type_str_is_energy(const char *s) {
+    return rs485_type_from_str(s) == RS485_TYPE_ENERGIA;
+}
+
+int rs485_phases_from_subtype_str(const char *s) {
+    return (rs485_subtype_from_str(s) == RS485_SUBTYPE_MONOFASICO) ? 1 : 3;
+}
+
 const char* rs485_subtype_to_str(rs485_subtype_t st) {
     switch (st) {
         case RS485_SUBTYPE_MONOFASICO: return "monofasico";
@@ -102,6 +111,12 @@ int rs485_read_measurements(const rs485_sensor_t *sensor,
 {
     if (!sensor || !out || out_len == 0) return -1;
 
+    /* Modelo cadastrado em JSON tem prioridade sobre o driver embutido */
+    int model = rs485_model_find(sensor->address, sensor->type, sensor->subtype);
+    if (model >= 0) {
+        return rs485_model_read(model, sensor->address, sensor->channel, out, out_len);
+    }
+
     switch (sensor->type) {
 
         case RS485_TYPE_TERMOHIGRO:
@@ -233,6 +248,23 @@ ESP_LOGW("RS485_REG_PROBE", "tentando JSY_MK333 em addr=%u", (unsigned)addr);
         return true;
     }
 
+    /* 3) Modelos em JSON que declaram registrador de identificação */
+    fc = 0;
+    int model = rs485_model_probe(addr, &fc);
+    if (model >= 0) {
+        rs485_model_t m;
+        if (rs485_model_get(model, &m) == ESP_OK) {
+            if (out_type)      *out_type = (rs485_type_t)m.type;
+            if (out_subtype)   *out_subtype = (rs485_subtype_t)m.subtype;
+            if (out_used_fc)   *out_used_fc = fc;
+            if (out_driver_name) *out_driver_name = rs485_model_name(model);
+            ESP_LOGW("RS485_REG_PROBE",
+                 "FOUND modelo %s: addr=%u fc=0x%02X",
+                 m.name, (unsigned)addr, (unsigned)fc);
+            return true;
+        }
+    }
+
     /* Acrescente aqui outros probes de drivers futuros */
 ESP_LOGW("RS485_REG_PROBE",
          "probe_any: nenhum driver reconheceu addr=%u", (unsigned)addr);
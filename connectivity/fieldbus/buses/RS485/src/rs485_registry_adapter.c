@@ -1,9 +1,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
-#include <ctype.h>
 #include "esp_log.h"
 #include "datalogger_driver.h"   // sensor_map_t, RS485_MAX_SENSORS, load_rs485_config()
+#include "rs485_registry.h"
 
 #ifndef RS485_REG_GLUE_VERBOSE
 #define RS485_REG_GLUE_VERBOSE 1  // coloque 0 para silenciar o dump
@@ -13,27 +13,12 @@ int rs485_registry_adapter_link_anchor = 0;
 
 static const char *TAG = "RS485_REG_GLUE";
 
-static bool streq_ci(const char *a, const char *b) {
-    if (!a || !b) return false;
-    while (*a && *b) { if (tolower((unsigned char)*a++) != tolower((unsigned char)*b++)) return false; }
-    return true;
-}
-static bool is_energy(const char *s) {
-    return s && *s && streq_ci(s, "energia");
-}
-static int subtype_to_phases(const char *s) {
-    if (!s || !*s) return 3;
-    if (streq_ci(s, "monofasico") || streq_ci(s, "monofásico")) return 1;
-    if (streq_ci(s, "trifasico")  || streq_ci(s, "trifásico"))  return 3;
-    return 3;
-}
-
 bool rs485_registry_get_channel_addr(uint8_t channel, uint8_t *out_addr)
 {
     sensor_map_t map[RS485_MAX_SENSORS] = {0}; size_t count = 0;
     if (load_rs485_config(map, &count) != ESP_OK) { ESP_LOGW(TAG, "load falhou"); return false; }
     for (size_t i = 0; i < count; ++i) {
-        if (map[i].channel == channel && is_energy(map[i].type)) {
+        if (map[i].channel == channel && rs485_type_str_is_energy(map[i].type)) {
             if (out_addr) *out_addr = map[i].address;
             ESP_LOGI(TAG, "get_addr: ch=%u → addr=%u", channel, map[i].address);
             return true;
@@ -48,8 +33,8 @@ int rs485_registry_get_channel_phase_count(uint8_t channel)
     sensor_map_t map[RS485_MAX_SENSORS] = {0}; size_t count = 0;
     if (load_rs485_config(map, &count) != ESP_OK) return 0;
     for (size_t i = 0; i < count; ++i) {
-        if (map[i].channel == channel && is_energy(map[i].type)) {
-            int p = subtype_to_phases(map[i].subtype);
+        if (map[i].channel == channel && rs485_type_str_is_energy(map[i].type)) {
+            int p = rs485_phases_from_subtype_str(map[i].subtype);
             ESP_LOGI(TAG, "get_phases: ch=%u → %d", channel, p);
             return p;
         }
@@ -85,7 +70,7 @@ int rs485_registry_iterate_configured(bool (*cb)(uint8_t, uint8_t, void*), void
 
     int n = 0;
     for (size_t i = 0; i < count; ++i) {
-        if (!is_energy(map[i].type)) continue;  // só itens de energia
+        if (!rs485_type_str_is_energy(map[i].type)) continue;  // só itens de energia
         ESP_LOGI(TAG, "iterate: ch=%u addr=%u subtype='%s'",
                  map[i].channel, map[i].address, map[i].subtype);
         if (cb(map[i].channel, map[i].address, user)) n++;
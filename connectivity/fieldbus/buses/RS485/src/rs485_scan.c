@@ -0,0 +1,337 @@
+/*
+ * rs485_scan.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Fase 1 fala direto com a UART (rs485_hw): o esp-modbus espera o timeout
+ * global de resposta em cada endereço mudo, o que torna uma varredura
+ * 1..247 inviável. Aqui cada endereço custa o pedido (8 caracteres) + uma
+ * janela curta para o 1º byte; quem responde é entregue em ~1 caractere
+ * após o fim do quadro (TOUT da UART em 3 símbolos).
+ *
+ * Com o master lite (CONFIG_MODBUS_RTU_LITE) a UART já é do rs485_hw: a
+ * fase 1 só aperta o TOUT, sem derrubar/subir o master.
+ */
+
+#include "rs485_scan.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+
+#include "rs485_hw.h"
+#include "modbus_rtu_master.h"     // modbus_master_init()/deinit()
+#include "modbus_rtu_lite.h"       // mb_rtu_crc16()
+#include "modbus_guard_session.h"
+#include "log_mux.h"
+
+static const char *TAG = "RS485_SCAN";
+
+#define SCAN_PROGRESS_EVERY   8     // evento de progresso a cada N endereços
+#define SCAN_MAX_ALIVE        32    // respondentes guardados para a fase 2
+#define SCAN_RETRY_FACTOR     4     // janela da 2ª tentativa em resposta truncada
+
+typedef enum {
+    PROBE_SILENT = 0,
+    PROBE_DATA,
+    PROBE_EXCEPTION,
+    PROBE_GARBLED,      // chegaram bytes, mas não um quadro válido
+} probe_res_t;
+
+// ---- Cache de fingerprint (RAM) ----
+typedef struct {
+    uint8_t     addr;           // 0 = livre
+    bool        identified;
+    uint8_t     type;
+    uint8_t     subtype;
+    uint8_t     used_fc;
+    const char *driver;         // literal do registry (vida estática)
+    int64_t     ts_us;
+} fp_entry_t;
+
+static fp_entry_t   s_fp[RS485_SCAN_FP_SLOTS];
+static portMUX_TYPE s_fp_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ---------------------------------------------------------------------------
+// Tempo de 1 caractere RTU (11 bits) em µs
+static uint32_t char_time_us(uint32_t baud)
+{
+    return (11u * 1000000u + baud - 1) / baud;
+}
+
+// Arredonda para cima e soma 1 tick (o 1º tick pode estar quase no fim)
+static TickType_t ms_to_ticks_ceil(uint32_t ms)
+{
+    return (TickType_t)((ms * configTICK_RATE_HZ + 999) / 1000) + 1;
+}
+
+// ---- UART "crua" durante a fase 1 ----
+static esp_err_t raw_bus_acquire(void)
+{
+#if CONFIG_MODBUS_RTU_LITE
+    // UART já está no rs485_hw (sessão aberta): só encurta o TOUT
+    (void) uart_set_rx_timeout(RS485_UART_NUM, 3);
+    return ESP_OK;
+#else
+    // Master esp-modbus fora do ar: a UART fica por nossa conta
+    (void) modbus_master_deinit();
+    if (uart_is_driver_installed(RS485_UART_NUM)) {
+        ESP_RETURN_ON_ERROR(uart_driver_delete(RS485_UART_NUM), TAG, "uart_driver_delete");
+    }
+
+    rs485_hw_cfg_t cfg;
+    rs485_hw_fill_defaults(&cfg);
+    cfg.baudrate = RS485_DEFAULT_BAUD;
+    ESP_RETURN_ON_ERROR(rs485_hw_init(&cfg), TAG, "rs485_hw_init");
+
+    // Entrega o quadro ao driver 3 símbolos depois do último byte
+    (void) uart_set_rx_timeout(RS485_UART_NUM, 3);
+    logmux_notify_rs485_active((uart_port_t)RS485_UART_NUM, true);
+    return ESP_OK;
+#endif
+}
+
+static void raw_bus_release(void)
+{
+#if CONFIG_MODBUS_RTU_LITE
+    // devolve o TOUT de t3.5 do master lite
+    (void) uart_set_rx_timeout(RS485_UART_NUM, mb_rtu_rx_tout_symbols(RS485_DEFAULT_BAUD));
+#else
+    (void) rs485_hw_deinit();
+    logmux_notify_rs485_active((uart_port_t)RS485_UART_NUM, false);
+#endif
+}
+
+// Sondagem universal: FC03, 1 registrador em 0x0000
+static probe_res_t probe_once(uint8_t addr, uint32_t window_ms, uint32_t t_char_us,
+                              uint16_t *latency_ms)
+{
+    uint8_t req[8] = { addr, 0x03, 0x00, 0x00, 0x00, 0x01, 0, 0 };
+    uint16_t crc = mb_rtu_crc16(req, 6);
+    req[6] = (uint8_t)(crc & 0xFF);
+    req[7] = (uint8_t)(crc >> 8);
+
+    // silêncio de 3,5 caracteres entre quadros
+    esp_rom_delay_us(t_char_us * 4);
+    uart_flush_input(RS485_UART_NUM);
+    if (rs485_hw_tx(req, sizeof(req), pdMS_TO_TICKS(50)) != ESP_OK) return PROBE_SILENT;
+    const int64_t t0 = esp_timer_get_time();
+
+    // 5 bytes = exceção inteira, ou cabeçalho + 1º dado da resposta normal
+    uint8_t rx[7];
+    int n = uart_read_bytes(RS485_UART_NUM, rx, 5, ms_to_ticks_ceil(window_ms + (5 * t_char_us) / 1000));
+    if (n <= 0) return PROBE_SILENT;
+    if (n < 5 || rx[0] != addr) return PROBE_GARBLED;
+
+    probe_res_t res = PROBE_GARBLED;
+    if (rx[1] == 0x83) {
+        if (mb_rtu_crc_ok(rx, 5)) res = PROBE_EXCEPTION;
+    } else if (rx[1] == 0x03 && rx[2] == 2) {
+        int m = uart_read_bytes(RS485_UART_NUM, rx + 5, 2, ms_to_ticks_ceil((3 * t_char_us) / 1000));
+        if (m == 2 && mb_rtu_crc_ok(rx, 7)) res = PROBE_DATA;
+    }
+    if (latency_ms) *latency_ms = (uint16_t)((esp_timer_get_time() - t0) / 1000);
+    return res;
+}
+
+// ---- Cache ----
+static void fp_store(uint8_t addr, const rs485_scan_hit_t *h)
+{
+    portENTER_CRITICAL(&s_fp_mux);
+    fp_entry_t *slot = NULL;
+    for (int i = 0; i < RS485_SCAN_FP_SLOTS; i++) {
+        if (s_fp[i].addr == addr) { slot = &s_fp[i]; break; }
+    }
+    if (!slot) {
+        slot = &s_fp[0];
+        for (int i = 0; i < RS485_SCAN_FP_SLOTS; i++) {
+            if (s_fp[i].addr == 0) { slot = &s_fp[i]; break; }
+            if (s_fp[i].ts_us < slot->ts_us) slot = &s_fp[i];
+        }
+    }
+    *slot = (fp_entry_t) {
+        .addr       = addr,
+        .identified = h->identified,
+        .type       = (uint8_t)h->type,
+        .subtype    = (uint8_t)h->subtype,
+        .used_fc    = h->used_fc,
+        .driver     = h->driver,
+        .ts_us      = esp_timer_get_time(),
+    };
+    portEXIT_CRITICAL(&s_fp_mux);
+}
+
+void rs485_scan_cache_put(const rs485_scan_hit_t *hit)
+{
+    if (!hit || hit->addr == 0 || hit->addr > 247) return;
+    fp_store(hit->addr, hit);
+}
+
+bool rs485_scan_cache_lookup(uint8_t addr, rs485_scan_hit_t *out)
+{
+    if (addr == 0 || !out) return false;
+    const int64_t now = esp_timer_get_time();
+    bool found = false;
+
+    portENTER_CRITICAL(&s_fp_mux);
+    for (int i = 0; i < RS485_SCAN_FP_SLOTS; i++) {
+        fp_entry_t *e = &s_fp[i];
+        if (e->addr != addr) continue;
+        if (now - e->ts_us > (int64_t)RS485_SCAN_FP_TTL_S * 1000000) {
+            e->addr = 0;            // vencida
+            break;
+        }
+        out->addr       = addr;
+        out->identified = e->identified;
+        out->cached     = true;
+        out->type       = (rs485_type_t)e->type;
+        out->subtype    = (rs485_subtype_t)e->subtype;
+        out->driver     = e->driver;
+        if (e->used_fc) out->used_fc = e->used_fc;
+        found = true;
+        break;
+    }
+    portEXIT_CRITICAL(&s_fp_mux);
+    return found;
+}
+
+void rs485_scan_cache_forget(uint8_t addr)
+{
+    portENTER_CRITICAL(&s_fp_mux);
+    for (int i = 0; i < RS485_SCAN_FP_SLOTS; i++) {
+        if (s_fp[i].addr == addr) s_fp[i].addr = 0;
+    }
+    portEXIT_CRITICAL(&s_fp_mux);
+}
+
+bool rs485_scan_fingerprint(uint8_t addr, rs485_scan_hit_t *out)
+{
+    if (addr == 0 || addr > 247 || !out) return false;
+    if (rs485_scan_cache_lookup(addr, out)) return out->identified;
+
+    rs485_type_t    type = RS485_TYPE_INVALID;
+    rs485_subtype_t st   = RS485_SUBTYPE_NONE;
+    uint8_t         fc   = 0;
+    const char     *drv  = NULL;
+
+    out->addr       = addr;
+    out->cached     = false;
+    out->identified = rs485_registry_probe_any(addr, &type, &st, &fc, &drv);
+    out->type       = out->identified ? type : RS485_TYPE_INVALID;
+    out->subtype    = out->identified ? st   : RS485_SUBTYPE_NONE;
+    out->driver     = out->identified ? drv  : NULL;
+    if (fc) out->used_fc = fc;
+
+    // negativo só de quem respondeu: um endereço vazio pode ganhar um
+    // dispositivo a qualquer momento
+    if (out->identified || out->exception || out->used_fc) fp_store(addr, out);
+    return out->identified;
+}
+
+// ---------------------------------------------------------------------------
+void rs485_scan_cfg_defaults(rs485_scan_cfg_t *cfg)
+{
+    if (!cfg) return;
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->first         = 1;
+    cfg->last          = 247;
+    cfg->turnaround_ms = RS485_SCAN_TURNAROUND_MS;
+    cfg->fingerprint   = true;
+}
+
+static inline bool emit(const rs485_scan_cfg_t *cfg, rs485_scan_event_t ev,
+                        uint8_t addr, const rs485_scan_hit_t *hit)
+{
+    return cfg->cb ? cfg->cb(ev, addr, hit, cfg->ctx) : true;
+}
+
+esp_err_t rs485_scan_run(const rs485_scan_cfg_t *cfg, rs485_scan_stats_t *stats)
+{
+    if (!cfg || cfg->first == 0 || cfg->last > 247 || cfg->first > cfg->last) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rs485_scan_stats_t local;
+    rs485_scan_stats_t *st = stats ? stats : &local;
+    memset(st, 0, sizeof(*st));
+
+    const uint32_t t_char_us = char_time_us(RS485_DEFAULT_BAUD);
+    const uint32_t window_ms = cfg->turnaround_ms ? cfg->turnaround_ms : RS485_SCAN_TURNAROUND_MS;
+
+    ESP_RETURN_ON_ERROR(mb_session_begin(pdMS_TO_TICKS(1000)), TAG, "sessão Modbus");
+
+    rs485_scan_hit_t hits[SCAN_MAX_ALIVE];
+    size_t n_hits = 0;
+
+    // ---------------- Fase 1: sondagem universal ----------------
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = raw_bus_acquire();
+    if (err == ESP_OK) {
+        for (unsigned a = cfg->first; a <= cfg->last; ++a) {
+            const uint8_t addr = (uint8_t)a;
+            bool skip = (cfg->skip[addr >> 5] >> (addr & 31)) & 1u;
+
+            if (!skip) {
+                st->scanned++;
+                uint16_t lat = 0;
+                probe_res_t r = probe_once(addr, window_ms, t_char_us, &lat);
+                if (r == PROBE_GARBLED) {
+                    // resposta lenta/truncada: uma 2ª chance com janela maior
+                    vTaskDelay(ms_to_ticks_ceil(window_ms));
+                    r = probe_once(addr, window_ms * SCAN_RETRY_FACTOR, t_char_us, &lat);
+                }
+                if (r == PROBE_DATA || r == PROBE_EXCEPTION) {
+                    st->alive++;
+                    rs485_scan_hit_t h = {
+                        .addr       = addr,
+                        .exception  = (r == PROBE_EXCEPTION),
+                        .used_fc    = (r == PROBE_DATA) ? 0x03 : 0,
+                        .latency_ms = lat,
+                    };
+                    if (n_hits < SCAN_MAX_ALIVE) hits[n_hits++] = h;
+                    if (!emit(cfg, RS485_SCAN_EV_ALIVE, addr, &h)) { st->cancelled = true; break; }
+                }
+            }
+
+            if ((a - cfg->first + 1) % SCAN_PROGRESS_EVERY == 0 || a == cfg->last) {
+                if (!emit(cfg, RS485_SCAN_EV_PROGRESS, addr, NULL)) { st->cancelled = true; break; }
+            }
+        }
+        raw_bus_release();
+    }
+    st->sweep_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+
+    // Master de volta: fase 2 usa os drivers e o guard faz o deinit normal
+    // em mb_session_end() (no lite é noop: o master nunca saiu)
+    esp_err_t e_init = modbus_master_init();
+
+    // ---------------- Fase 2: fingerprint só nos respondentes ----------------
+    t0 = esp_timer_get_time();
+    if (err == ESP_OK && e_init == ESP_OK && cfg->fingerprint && !st->cancelled) {
+        for (size_t i = 0; i < n_hits; ++i) {
+            rs485_scan_hit_t *h = &hits[i];
+            if (rs485_scan_fingerprint(h->addr, h)) st->identified++;
+            if (h->cached) st->cache_hits++;
+            if (!emit(cfg, RS485_SCAN_EV_IDENTIFIED, h->addr, h)) { st->cancelled = true; break; }
+        }
+    }
+    st->fingerprint_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+
+    mb_session_end();
+
+    if (err != ESP_OK) return err;
+    if (e_init != ESP_OK) {
+        ESP_LOGE(TAG, "master não voltou após a varredura: %s", esp_err_to_name(e_init));
+        return e_init;
+    }
+    ESP_LOGI(TAG, "varredura %u..%u: %u endereço(s), %u respondeu(ram), %u identificado(s) "
+             "(%u do cache) | fase1=%lums fase2=%lums%s",
+             cfg->first, cfg->last, st->scanned, st->alive, st->identified, st->cache_hits,
+             (unsigned long)st->sweep_ms, (unsigned long)st->fingerprint_ms,
+             st->cancelled ? " [cancelada]" : "");
+    return ESP_OK;
+}
@@ -8,9 +8,11 @@
 #include "energy_jsy_mk_333_driver.h"
 
 #include "modbus_rtu_master.h"
+#include "modbus_block_plan.h"
+#include "modbus_dev_profile.h"
+#include "freertos/FreeRTOS.h"
 #include "esp_log.h"
 #include "esp_err.h"
-#include "mbcontroller.h"   // se não estiver sendo incluído por modbus_rtu_master.h
 
 static const char *TAG = "JSY_MK333";
 
@@ -24,6 +26,15 @@ static bool read_one(jsy_fc_t fc, uint8_t addr, uint16_t reg, uint16_t *out)
     }
 }
 
+/* Valores básicos do mapa: V /10, A /100, W /10, kWh /100 (ordem de jsy_values_t) */
+static void basic_specs(const jsy_map_t *map, mb_reg_spec_t specs[4])
+{
+    specs[0] = (mb_reg_spec_t){ map->reg_voltage, MB_VAL_U16, 0.1f  };
+    specs[1] = (mb_reg_spec_t){ map->reg_current, MB_VAL_U16, 0.01f };
+    specs[2] = (mb_reg_spec_t){ map->reg_power,   MB_VAL_U16, 0.1f  };
+    specs[3] = (mb_reg_spec_t){ map->reg_energy,  MB_VAL_U16, 0.01f };
+}
+
 /* Detecta FC e registra “alguma” vida do equipamento */
 int jsy_mk333_probe(uint8_t addr, jsy_map_t *map, uint8_t *used_fc)
 {
@@ -34,12 +45,21 @@ int jsy_mk333_probe(uint8_t addr, jsy_map_t *map, uint8_t *used_fc)
     if (map->fc == JSY_FC_AUTO) { fc_try[0] = JSY_FC_04; fc_try[1] = JSY_FC_03; }
     else                         { fc_try[0] = map->fc;  fc_try[1] = map->fc;  }
 
+    // Um bloco com o mapa inteiro por FC (antes: até 4 leituras avulsas por FC)
+    mb_reg_spec_t specs[4];
+    mb_read_plan_t plan;
+    float v[4];
+    basic_specs(map, specs);
+    bool planned = (mb_plan_build(specs, 4, MB_PLAN_DEFAULT_SPAN, MB_PLAN_DEFAULT_GAP, &plan) == ESP_OK);
+
     uint16_t tmp;
     for (int i = 0; i < 2; ++i) {
-        if (read_one(fc_try[i], addr, map->reg_voltage, &tmp) ||
-            read_one(fc_try[i], addr, map->reg_current, &tmp) ||
-            read_one(fc_try[i], addr, map->reg_power,   &tmp) ||
-            read_one(fc_try[i], addr, map->reg_energy,  &tmp)) {
+        if (i == 1 && fc_try[1] == fc_try[0]) break;
+        bool ok = planned
+            ? (mb_plan_read(addr, (uint8_t)fc_try[i], specs, 4, &plan, v) == ESP_OK)
+            : read_one(fc_try[i], addr, map->reg_voltage, &tmp);
+        if (ok) {
+            mb_prof_note_ok(addr, (uint8_t)fc_try[i], 0);
             if (used_fc) *used_fc = (fc_try[i] == JSY_FC_04) ? 0x04 : 0x03;
             map->fc = fc_try[i];
             return 0;
@@ -51,25 +71,31 @@ int jsy_mk333_probe(uint8_t addr, jsy_map_t *map, uint8_t *used_fc)
 int jsy_mk333_read_basic(uint8_t addr, const jsy_map_t *map, jsy_values_t *out)
 {
     if (!map || !out) return -1;
-    jsy_fc_t fc = (map->fc == JSY_FC_AUTO) ? JSY_FC_04 : map->fc;
-
-    uint16_t u16;
-    // Tensao (escala sugestiva /10)
-    if (!read_one(fc, addr, map->reg_voltage, &u16)) return -2;
-    out->voltage_v = (float)u16 / 10.0f;
-
-    // Corrente (escala sugestiva /100)
-    if (!read_one(fc, addr, map->reg_current, &u16)) return -3;
-    out->current_a = (float)u16 / 100.0f;
-
-    // Potência ativa (escala sugestiva /10)
-    if (!read_one(fc, addr, map->reg_power, &u16))   return -4;
-    out->active_power_w = (float)u16 / 10.0f;
+    jsy_fc_t fc = map->fc;
+    if (fc == JSY_FC_AUTO) {
+        // FC que respondeu da última vez (perfil do escravo), senão 04
+        fc = (mb_prof_used_fc(addr) == 0x03) ? JSY_FC_03 : JSY_FC_04;
+    }
 
-    // Energia (escala sugestiva /100)
-    if (!read_one(fc, addr, map->reg_energy, &u16))  return -5;
-    out->energy_kwh = (float)u16 / 100.0f;
+    // Mapa padrão (0x0000..0x0003) => 1 requisição em vez de 4
+    mb_reg_spec_t specs[4];
+    mb_read_plan_t plan;
+    float v[4];
+    basic_specs(map, specs);
+    if (mb_plan_build(specs, 4, MB_PLAN_DEFAULT_SPAN, MB_PLAN_DEFAULT_GAP, &plan) != ESP_OK) {
+        return -1;
+    }
+    TickType_t t0 = xTaskGetTickCount();
+    if (mb_plan_read(addr, (uint8_t)fc, specs, 4, &plan, v) != ESP_OK) {
+        mb_prof_note_fail(addr);
+        return -2;
+    }
+    mb_prof_note_ok(addr, (uint8_t)fc, pdTICKS_TO_MS(xTaskGetTickCount() - t0));
 
+    out->voltage_v      = v[0];
+    out->current_a      = v[1];
+    out->active_power_w = v[2];
+    out->energy_kwh     = v[3];
     return 0;
 }
 
@@ -108,14 +134,8 @@ int jsy_mk333_change_address(uint8_t old_addr, uint8_t new_addr)
     // 1) Ler reg 0x0004 (COMM CONFIG) no endereco atual
     uint16_t comm_reg = 0;
     {
-        mb_param_request_t req = {
-            .slave_addr = old_addr,
-            .command    = 3,                  // FC03 - Read Holding Registers
-            .reg_start  = JSY_REG_COMM_CONFIG,
-            .reg_size   = 1
-        };
-
-        esp_err_t err = mbc_master_send_request(&req, (void *)&comm_reg);
+        // FC03 - Read Holding Registers
+        esp_err_t err = modbus_master_read_holding_registers(old_addr, JSY_REG_COMM_CONFIG, 1, &comm_reg);
         if (err != ESP_OK) {
             ESP_LOGE(TAG,
                      "jsy_mk333_change_address: falha ao ler reg 0x%04X no addr=%u (err=%s)",
@@ -160,14 +180,8 @@ int jsy_mk333_change_address(uint8_t old_addr, uint8_t new_addr)
 
     // 3) Escreve via FC10 (Write Multiple Registers) tamanho 1
     {
-        mb_param_request_t req_wr = {
-            .slave_addr = old_addr,
-            .command    = 0x10,              // FC10 - Write Multiple Registers
-            .reg_start  = JSY_REG_COMM_CONFIG,
-            .reg_size   = 1                  // 1 registrador (2 bytes)
-        };
-
-        esp_err_t err = mbc_master_send_request(&req_wr, (void *)tx_buf);
+        // FC10 - Write Multiple Registers, 1 registrador (2 bytes)
+        esp_err_t err = modbus_master_write_multiple_registers(old_addr, JSY_REG_COMM_CONFIG, 1, tx_buf);
         if (err != ESP_OK) {
             ESP_LOGE(TAG,
                      "jsy_mk333_change_address: falha ao escrever reg 0x%04X no addr=%u (err=%s)",
@@ -184,14 +198,7 @@ int jsy_mk333_change_address(uint8_t old_addr, uint8_t new_addr)
     // 4) Relê o registrador para conferir (diagnóstico)
     {
         uint16_t comm_after = 0;
-        mb_param_request_t req = {
-            .slave_addr = old_addr,
-            .command    = 3,                  // FC03 - Read Holding Registers
-            .reg_start  = JSY_REG_COMM_CONFIG,
-            .reg_size   = 1
-        };
-
-        esp_err_t err = mbc_master_send_request(&req, (void *)&comm_after);
+        esp_err_t err = modbus_master_read_holding_registers(old_addr, JSY_REG_COMM_CONFIG, 1, &comm_after);
         if (err == ESP_OK) {
             uint8_t addr_after = (uint8_t)(comm_after >> 8);
             uint8_t cfg_after  = (uint8_t)(comm_after & 0x00FF);
@@ -8,6 +8,8 @@
 #include "xy_md02_driver.h"
 
 #include "modbus_rtu_master.h"
+#include "modbus_block_plan.h"
+#include "modbus_dev_profile.h"
 #include "esp_log.h"
 
 static const char *TAG = "XY_MD02";
@@ -53,27 +55,59 @@ int temperature_rs485_probe(uint8_t addr, uint8_t *used_fc)
 int temperature_rs485_read(uint8_t addr, float *temp_c,
                            float *hum_pct, bool *has_hum)
 {
-    uint16_t v;
-    // 1) Tenta FC=0x04 e cai p/ 0x03 (igual ao seu fluxo de testes)
-    uint8_t fc = 0x04;
-    if (!try_fc(fc, addr, REG_TEMP, &v)) {
-        fc = 0x03;
-        if (!try_fc(fc, addr, REG_TEMP, &v)) return -1;
+    // Temp + umidade são contíguos: uma leitura só (0x0001..0x0002)
+    static const mb_reg_spec_t specs[] = {
+        { REG_TEMP, MB_VAL_S16, 0.1f },
+        { REG_HUM,  MB_VAL_U16, 0.1f },
+    };
+    static mb_read_plan_t plan;
+    static bool planned;
+    if (!planned) {
+        planned = (mb_plan_build(specs, 2, MB_PLAN_DEFAULT_SPAN, MB_PLAN_DEFAULT_GAP, &plan) == ESP_OK);
     }
-    if (temp_c) *temp_c = (float)v / 10.0f;
 
-    // 2) Umidade (nem todo sensor responde; trate como opcional)
-    if (hum_pct || has_hum) {
-        uint16_t h;
-        if (try_fc(fc, addr, REG_HUM, &h)) {
-            if (hum_pct) *hum_pct = (float)h / 10.0f;
+    // FC que respondeu da última vez primeiro (perfil do escravo); padrão 0x04 -> 0x03
+    const uint8_t fc_first  = (mb_prof_used_fc(addr) == 0x03) ? 0x03 : 0x04;
+    const uint8_t fc_second = (fc_first == 0x04) ? 0x03 : 0x04;
+
+    // Escravo que já rejeitou o bloco (sem umidade) vai direto à leitura só de
+    // temperatura, sem gastar dois timeouts por ciclo
+    const bool try_block = planned && (hum_pct || has_hum) &&
+                           !mb_prof_has_flag(addr, MB_PROF_F_NO_BLOCK);
+    if (try_block) {
+        float v[2];
+        uint8_t fc = fc_first;
+        esp_err_t e = mb_plan_read(addr, fc, specs, 2, &plan, v);
+        if (e != ESP_OK) {
+            fc = fc_second;
+            e  = mb_plan_read(addr, fc, specs, 2, &plan, v);
+        }
+        if (e == ESP_OK) {
+            mb_prof_note_ok(addr, fc, 0);
+            if (temp_c)  *temp_c  = v[0];
+            if (hum_pct) *hum_pct = v[1];
             if (has_hum) *has_hum = true;
             return 2;
-        } else {
-            if (has_hum) *has_hum = false;
-            return 1;
         }
+        // Sensor sem umidade rejeita o bloco: segue no caminho só-temperatura
+    }
+
+    uint16_t v;
+    uint8_t fc = fc_first;
+    if (!try_fc(fc, addr, REG_TEMP, &v)) {
+        fc = fc_second;
+        if (!try_fc(fc, addr, REG_TEMP, &v)) {
+            mb_prof_note_fail(addr);
+            return -1;
+        }
+    }
+    mb_prof_note_ok(addr, fc, 0);
+    if (try_block) {
+        ESP_LOGI(TAG, "addr=%u sem bloco de umidade; lendo só temperatura", addr);
+        mb_prof_set_flag(addr, MB_PROF_F_NO_BLOCK, true);
     }
+    if (temp_c) *temp_c = (float)(int16_t)v / 10.0f;   // com sinal, como no bloco (MB_VAL_S16)
+    if (has_hum) *has_hum = false;
     return 1;
 }
 
@@ -0,0 +1,104 @@
+/*
+ * modbus_block_plan.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_BLOCK_PLAN_H_
+#define CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_BLOCK_PLAN_H_
+
+#pragma once
+/**
+ * Planejador de leitura em bloco para mapas de registradores.
+ *
+ * O driver descreve os valores que precisa (registrador, tipo, escala) e o
+ * planejador junta tudo no menor número de leituras FC03/FC04 contíguas,
+ * respeitando:
+ *  - max_span: tamanho máximo de um bloco (em registradores, <= 125);
+ *  - max_gap : quantos registradores "inúteis" podem ser lidos para juntar
+ *              dois trechos (ler 2 words a mais custa bem menos que um
+ *              novo turnaround a 9600 bps).
+ *
+ * Uso típico (uma vez, em .rodata/estático):
+ *   static const mb_reg_spec_t specs[] = {
+ *       { 0x0000, MB_VAL_U16, 0.1f  },   // V
+ *       { 0x0001, MB_VAL_U16, 0.01f },   // A
+ *   };
+ *   mb_read_plan_t plan;
+ *   mb_plan_build(specs, 2, MB_PLAN_DEFAULT_SPAN, MB_PLAN_DEFAULT_GAP, &plan);
+ *   float v[2];
+ *   mb_plan_read(addr, 0x04, specs, 2, &plan, v);
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MB_PLAN_MAX_BLOCKS     8
+#define MB_PLAN_MAX_WORDS      125     // limite do Modbus por requisição FC03/FC04
+#define MB_PLAN_DEFAULT_SPAN   64
+#define MB_PLAN_DEFAULT_GAP    8
+
+typedef enum {
+    MB_VAL_U16 = 0,
+    MB_VAL_S16,
+    MB_VAL_U32,     // 2 words, word alta primeiro (padrão da maioria dos medidores)
+    MB_VAL_S32,
+    MB_VAL_U32_LE,  // 2 words, word baixa primeiro
+    MB_VAL_S32_LE,
+    MB_VAL_F32,     // IEEE-754, word alta primeiro
+    MB_VAL_F32_LE,
+} mb_val_type_t;
+
+typedef struct {
+    uint16_t reg;
+    uint8_t  type;   // mb_val_type_t
+    float    scale;  // valor = bruto * scale (0 => 1)
+} mb_reg_spec_t;
+
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+} mb_block_t;
+
+typedef struct {
+    mb_block_t blocks[MB_PLAN_MAX_BLOCKS];
+    uint8_t    n_blocks;
+    uint16_t   words;      // soma dos blocos (tamanho do buffer de leitura)
+} mb_read_plan_t;
+
+/**
+ * @brief Monta o plano de leitura.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG ou ESP_ERR_INVALID_SIZE (não coube em
+ *         MB_PLAN_MAX_BLOCKS blocos / MB_PLAN_MAX_WORDS words).
+ */
+esp_err_t mb_plan_build(const mb_reg_spec_t *specs, size_t n,
+                        uint16_t max_span, uint16_t max_gap,
+                        mb_read_plan_t *out);
+
+/**
+ * @brief Decodifica os valores a partir das words lidas (blocos concatenados
+ *        na ordem do plano).
+ */
+esp_err_t mb_plan_decode(const mb_reg_spec_t *specs, size_t n,
+                         const mb_read_plan_t *plan, const uint16_t *words,
+                         float *out_values);
+
+/**
+ * @brief Executa o plano no escravo (fc = 0x03 ou 0x04) e decodifica.
+ *        Para no primeiro bloco que falhar e devolve o erro do Modbus.
+ */
+esp_err_t mb_plan_read(uint8_t addr, uint8_t fc,
+                       const mb_reg_spec_t *specs, size_t n,
+                       const mb_read_plan_t *plan, float *out_values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_BLOCK_PLAN_H_ */
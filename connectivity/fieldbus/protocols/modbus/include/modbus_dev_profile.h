@@ -0,0 +1,123 @@
+/*
+ * modbus_dev_profile.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_DEV_PROFILE_H_
+#define CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_DEV_PROFILE_H_
+
+#pragma once
+/**
+ * Perfil por endereço dos escravos RS-485, mantido em RAM (RTC).
+ *
+ * Substitui a consulta ao /littlefs/rs485_map_ui.json a cada leitura
+ * (rs485_hint_get/set_used_fc): os drivers leem/atualizam a tabela em RAM
+ * e só a FC vai para a flash, num binário compacto, e apenas quando muda
+ * (mb_prof_flush()). A ordem das words de valores de 32 bits não fica aqui:
+ * vem no tipo do valor (MB_VAL_*_LE, "word_order" do rs485_models.json).
+ *
+ * A tabela fica em RTC: latência e sequência de falhas sobrevivem ao deep
+ * sleep sem tocar a flash. O histórico de resposta alimenta um timeout
+ * por escravo (mb_prof_timeout_ms) e o backoff de quem não responde
+ * (mb_prof_should_poll).
+ *
+ * O timeout por escravo só vale por pedido com CONFIG_MODBUS_RTU_LITE: o
+ * controlador do esp-modbus tem um timeout de resposta global
+ * (CONFIG_FMB_MASTER_TIMEOUT_MS_RESPOND, mantido em 3000 ms para escravos
+ * lentos) e aí mb_prof_timeout_ms só limita o prazo do escravo no ciclo do
+ * rs485_central. Após cold boot é recarregada do binário (ou,
+ * na primeira vez, semeada a partir do JSON da UI).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MB_PROF_MAX_DEVICES   16
+#define MB_PROF_RTT_SAMPLES   8      // janela para p50/p95
+
+// Timeout derivado (ms): srtt + 4*rttvar ou 1,5*p95, o maior, + margem
+#define MB_PROF_TO_MARGIN_MS  30
+#define MB_PROF_TO_MIN_MS     60
+#define MB_PROF_TO_MAX_MS     600
+#define MB_PROF_TO_DEFAULT_MS 600    // sem histórico
+
+// Backoff de escravo "morto": a partir de MB_PROF_DEAD_AFTER falhas
+// seguidas ele é lido só a cada 2, 4, 8 ... 2^MB_PROF_SKIP_MAX_LEVEL ciclos
+#define MB_PROF_DEAD_AFTER    3
+#define MB_PROF_SKIP_MAX_LEVEL 5
+
+// Flags do perfil (só RTC: depois de cold boot o escravo é sondado de novo)
+#define MB_PROF_F_NO_BLOCK    0x01   // rejeita a leitura em bloco (ex.: XY-MD02 sem umidade)
+
+typedef struct {
+    uint8_t  addr;             // 1..247 (0 = slot livre)
+    uint8_t  used_fc;          // 0 = desconhecida, 0x03 ou 0x04
+    uint8_t  fail_streak;      // falhas seguidas (satura em 255)
+    uint16_t last_latency_ms;  // última transação OK
+    uint16_t srtt_ms;          // média móvel da resposta (1/8)
+    uint16_t rttvar_ms;        // desvio médio (1/4)
+    uint16_t rtt_hist[MB_PROF_RTT_SAMPLES];
+    uint8_t  hist_pos;
+    uint8_t  hist_n;
+    uint8_t  skip_level;       // expoente do backoff (0 = normal)
+    uint8_t  skip_left;        // ciclos que ainda serão pulados
+    uint8_t  flags;            // MB_PROF_F_*
+    uint32_t ok_total;
+    uint32_t fail_total;
+    uint32_t skipped_total;    // ciclos pulados pelo backoff
+    uint32_t last_used;        // sequência de uso (despejo LRU)
+} mb_dev_profile_t;
+
+/** @brief Carrega a tabela (idempotente; chamado sozinho no primeiro uso). */
+esp_err_t mb_prof_init(void);
+
+/** @brief Cópia do perfil; ESP_ERR_NOT_FOUND se o endereço não tem perfil. */
+esp_err_t mb_prof_get(uint8_t addr, mb_dev_profile_t *out);
+
+/** @brief FC que respondeu da última vez (0 se desconhecida). */
+uint8_t mb_prof_used_fc(uint8_t addr);
+
+/** @brief Transação OK com 'fc' em 'latency_ms' (zera a sequência de falhas). */
+void mb_prof_note_ok(uint8_t addr, uint8_t fc, uint32_t latency_ms);
+
+/** @brief Transação sem resposta/erro. */
+void mb_prof_note_fail(uint8_t addr);
+
+/** @brief Liga/desliga uma flag MB_PROF_F_* do escravo. */
+void mb_prof_set_flag(uint8_t addr, uint8_t flag, bool on);
+
+/** @brief true se a flag está ligada (false se o endereço não tem perfil). */
+bool mb_prof_has_flag(uint8_t addr, uint8_t flag);
+
+/** @brief Timeout sugerido para o escravo, a partir do histórico de resposta. */
+uint32_t mb_prof_timeout_ms(uint8_t addr);
+
+/** @brief Percentil (0..100) das últimas respostas; 0 se sem amostras. */
+uint32_t mb_prof_latency_pct(const mb_dev_profile_t *p, unsigned pct);
+
+/**
+ * @brief Chamar uma vez por ciclo antes de ler o escravo.
+ * @return false se ele está em backoff neste ciclo (consome um "pulo").
+ */
+bool mb_prof_should_poll(uint8_t addr);
+
+/** @brief Cópia dos perfis em uso (para o portal). Retorna quantos. */
+size_t mb_prof_snapshot(mb_dev_profile_t *out, size_t max);
+
+/** @brief Grava o binário se alguma FC mudou desde a última gravação. */
+esp_err_t mb_prof_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_DEV_PROFILE_H_ */
@@ -0,0 +1,139 @@
+/*
+ * modbus_rtu_lite.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_RTU_LITE_H_
+#define CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_RTU_LITE_H_
+
+#pragma once
+/**
+ * Master Modbus RTU mínimo sobre o rs485_hw (FC03, FC04 e FC10).
+ *
+ * Substitui o controlador do esp-modbus (task própria, filas, eventos e
+ * timer de t3.5 por software) para o que o projeto realmente usa: pedidos
+ * simples de leitura/escrita, um por vez.
+ *  - quadro e CRC16 (tabela em flash) montados em buffer fixo, sem malloc;
+ *  - fim de quadro pelo TOUT da UART (uart_set_rx_timeout) ajustado para
+ *    3,5 caracteres no baud rate em uso, e pelo tamanho esperado da
+ *    resposta (que o pedido já determina);
+ *  - silêncio de t3.5 garantido entre quadros;
+ *  - timeout de resposta por pedido (o modbus_rtu_master passa o
+ *    mb_prof_timeout_ms() do escravo).
+ *
+ * API bloqueante (mb_rtu_transact / mb_rtu_read) e assíncrona:
+ * mb_rtu_submit() envia o pedido e retorna; mb_rtu_complete() colhe a
+ * resposta. Entre os dois o chamador pode processar a resposta anterior
+ * enquanto o escravo responde. O RTU é half-duplex: só um pedido em voo.
+ *
+ * Não abre sessão nem trava o barramento: quem chama já está dentro de
+ * mb_session_begin() (ou do mutex do modbus_rtu_master).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MB_RTU_MAX_ADU         256
+#define MB_RTU_MAX_READ_WORDS  125
+#define MB_RTU_MAX_WRITE_WORDS 123
+
+#ifndef MB_RTU_DEFAULT_TIMEOUT_MS
+#define MB_RTU_DEFAULT_TIMEOUT_MS 600
+#endif
+
+typedef struct {
+    // ---- pedido (preenchido pelo chamador) ----
+    uint8_t   addr;
+    uint8_t   fc;             // 0x03, 0x04 ou 0x10
+    uint16_t  reg;
+    uint16_t  count;          // words
+    uint16_t *words;          // destino (leitura) / origem (FC10)
+    uint32_t  timeout_ms;     // fim do pedido -> 1º byte; 0 => MB_RTU_DEFAULT_TIMEOUT_MS
+
+    // ---- resultado ----
+    esp_err_t status;
+    uint8_t   exception;      // código de exceção Modbus (status = ESP_ERR_NOT_SUPPORTED)
+    uint16_t  latency_ms;     // fim do pedido -> fim da resposta
+
+    // ---- interno ----
+    int64_t   t_sent_us;
+    bool      pending;
+} mb_rtu_txn_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t ok;
+    uint32_t timeouts;
+    uint32_t crc_errors;
+    uint32_t bad_frames;      // endereço/FC/tamanho inesperados
+    uint32_t exceptions;
+    uint32_t timeout_wait_ms; // tempo total esperando escravo que não respondeu
+    uint16_t latency_last_ms;
+    uint16_t latency_avg_ms;  // média móvel (1/8)
+    uint16_t latency_max_ms;
+} mb_rtu_stats_t;
+
+/* ---------------- quadro (puro, sem E/S) ---------------- */
+
+uint16_t mb_rtu_crc16(const uint8_t *p, size_t n);
+
+/** @brief true se os 2 últimos bytes são o CRC dos anteriores. */
+bool mb_rtu_crc_ok(const uint8_t *frame, size_t len);
+
+/** @brief t3.5 em µs (fixo em 1750 µs acima de 19200 bps, como na norma). */
+uint32_t mb_rtu_t35_us(uint32_t baud);
+
+/** @brief t3.5 em símbolos do TOUT da UART (10 bits em 8N1), arredondado p/ cima. */
+uint8_t mb_rtu_rx_tout_symbols(uint32_t baud);
+
+/** @brief Monta o pedido em 'frame'. @return tamanho (0 se inválido). */
+size_t mb_rtu_build_request(const mb_rtu_txn_t *t, uint8_t *frame, size_t cap);
+
+/** @brief Tamanho da resposta normal ao pedido 't'. */
+size_t mb_rtu_expected_len(const mb_rtu_txn_t *t);
+
+/**
+ * @brief Valida e decodifica a resposta (endereço, FC, tamanho, CRC);
+ *        leituras vão para t->words.
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED (exceção; ver t->exception),
+ *         ESP_ERR_INVALID_CRC ou ESP_ERR_INVALID_RESPONSE.
+ */
+esp_err_t mb_rtu_parse_response(mb_rtu_txn_t *t, const uint8_t *frame, size_t len);
+
+/* ---------------- barramento ---------------- */
+
+/** @brief Sobe a UART (rs485_hw) no baud dado e ajusta o TOUT para t3.5. */
+esp_err_t mb_rtu_open(uint32_t baud);
+void      mb_rtu_close(void);
+bool      mb_rtu_is_open(void);
+
+/** @brief Envia o pedido e retorna sem esperar a resposta. */
+esp_err_t mb_rtu_submit(mb_rtu_txn_t *t);
+
+/** @brief Espera a resposta de um pedido enviado por mb_rtu_submit(). */
+esp_err_t mb_rtu_complete(mb_rtu_txn_t *t);
+
+/** @brief submit + complete. */
+esp_err_t mb_rtu_transact(mb_rtu_txn_t *t);
+
+esp_err_t mb_rtu_read(uint8_t addr, uint8_t fc, uint16_t reg, uint16_t count,
+                      uint16_t *out, uint32_t timeout_ms);
+
+esp_err_t mb_rtu_write_multiple(uint8_t addr, uint16_t reg, uint16_t count,
+                                const uint16_t *words, uint32_t timeout_ms);
+
+void mb_rtu_get_stats(mb_rtu_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_RTU_LITE_H_ */
@@ -1,6 +1,6 @@
 /*
  * modbus_rtu_master.h
- * API do master RTU (esp-modbus) + wrappers de leitura usados pelos drivers.
+ * API do master RTU (esp-modbus ou lite) + wrappers usados pelos drivers.
  */
 #ifndef CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_RTU_MASTER_H_
 #define CONNECTIVITY_FIELDBUS_PROTOCOLS_MODBUS_INCLUDE_MODBUS_RTU_MASTER_H_
@@ -8,7 +8,21 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
+#include "sdkconfig.h"
+
+#if CONFIG_MODBUS_RTU_LITE
+/* Sem o esp-modbus no build: mesmos valores do mb_param_type_t dele */
+typedef enum {
+    MB_PARAM_HOLDING = 0x00,
+    MB_PARAM_INPUT,
+    MB_PARAM_COIL,
+    MB_PARAM_DISCRETE,
+    MB_PARAM_COUNT,
+    MB_PARAM_UNKNOWN = 0xFF
+} mb_param_type_t;
+#else
 #include "mbcontroller.h"
+#endif
 
 /* -------- Modelagem (mantida) -------- */
 typedef struct {
@@ -42,6 +56,11 @@ esp_err_t modbus_master_read_holding_registers(uint8_t slave_addr,
                                                uint16_t words,
                                                uint16_t *out_words);
 
+esp_err_t modbus_master_write_multiple_registers(uint8_t slave_addr,
+                                                 uint16_t reg_start,
+                                                 uint16_t words,
+                                                 const uint16_t *in_words);
+
 /* -------- Ping canônico (para endpoints/manager) -------- */
 esp_err_t modbus_master_ping(uint8_t slave_addr, bool *alive, uint8_t *used_fc);
 
@@ -0,0 +1,138 @@
+/*
+ * modbus_block_plan.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "modbus_block_plan.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "modbus_rtu_master.h"
+
+static const char *TAG = "MB/PLAN";
+
+static inline uint16_t spec_words(const mb_reg_spec_t *s)
+{
+    return (s->type >= MB_VAL_U32) ? 2 : 1;
+}
+
+esp_err_t mb_plan_build(const mb_reg_spec_t *specs, size_t n,
+                        uint16_t max_span, uint16_t max_gap,
+                        mb_read_plan_t *out)
+{
+    if (!specs || n == 0 || !out) return ESP_ERR_INVALID_ARG;
+    if (max_span == 0 || max_span > MB_PLAN_MAX_WORDS) max_span = MB_PLAN_MAX_WORDS;
+
+    memset(out, 0, sizeof(*out));
+
+    // Ordena os índices por registrador (n é pequeno: inserção basta)
+    uint8_t idx[MB_PLAN_MAX_WORDS];
+    if (n > MB_PLAN_MAX_WORDS) return ESP_ERR_INVALID_SIZE;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = i;
+        while (j > 0 && specs[idx[j - 1]].reg > specs[i].reg) {
+            idx[j] = idx[j - 1];
+            j--;
+        }
+        idx[j] = (uint8_t)i;
+    }
+
+    // Guloso: estende o bloco corrente enquanto o buraco e o tamanho couberem
+    mb_block_t *cur = NULL;
+    for (size_t k = 0; k < n; k++) {
+        const mb_reg_spec_t *s = &specs[idx[k]];
+        uint32_t s_end = (uint32_t)s->reg + spec_words(s);   // exclusivo
+
+        if (cur) {
+            uint32_t cur_end = (uint32_t)cur->start + cur->count;
+            if (s_end <= cur_end) continue;                   // já coberto
+            uint32_t gap = (s->reg > cur_end) ? s->reg - cur_end : 0;
+            if (gap <= max_gap && s_end - cur->start <= max_span) {
+                cur->count = (uint16_t)(s_end - cur->start);
+                continue;
+            }
+        }
+        if (out->n_blocks >= MB_PLAN_MAX_BLOCKS) return ESP_ERR_INVALID_SIZE;
+        cur = &out->blocks[out->n_blocks++];
+        cur->start = s->reg;
+        cur->count = spec_words(s);
+    }
+
+    uint32_t words = 0;
+    for (uint8_t b = 0; b < out->n_blocks; b++) words += out->blocks[b].count;
+    if (words > MB_PLAN_MAX_WORDS) return ESP_ERR_INVALID_SIZE;
+    out->words = (uint16_t)words;
+    return ESP_OK;
+}
+
+// Posição da word 'reg' no buffer concatenado (ou -1)
+static int word_offset(const mb_read_plan_t *plan, uint16_t reg, uint16_t n_words)
+{
+    int base = 0;
+    for (uint8_t b = 0; b < plan->n_blocks; b++) {
+        const mb_block_t *blk = &plan->blocks[b];
+        if (reg >= blk->start && (uint32_t)reg + n_words <= (uint32_t)blk->start + blk->count) {
+            return base + (reg - blk->start);
+        }
+        base += blk->count;
+    }
+    return -1;
+}
+
+esp_err_t mb_plan_decode(const mb_reg_spec_t *specs, size_t n,
+                         const mb_read_plan_t *plan, const uint16_t *words,
+                         float *out_values)
+{
+    if (!specs || !plan || !words || !out_values) return ESP_ERR_INVALID_ARG;
+
+    for (size_t i = 0; i < n; i++) {
+        const mb_reg_spec_t *s = &specs[i];
+        int off = word_offset(plan, s->reg, spec_words(s));
+        if (off < 0) return ESP_ERR_NOT_FOUND;
+
+        const uint16_t *w = &words[off];
+        const uint32_t be = ((uint32_t)w[0] << 16) | w[1];
+        const uint32_t le = ((uint32_t)w[1] << 16) | w[0];
+        float raw;
+        switch (s->type) {
+            case MB_VAL_S16:    raw = (float)(int16_t)w[0]; break;
+            case MB_VAL_U32:    raw = (float)be; break;
+            case MB_VAL_S32:    raw = (float)(int32_t)be; break;
+            case MB_VAL_U32_LE: raw = (float)le; break;
+            case MB_VAL_S32_LE: raw = (float)(int32_t)le; break;
+            case MB_VAL_F32:    memcpy(&raw, &be, sizeof(raw)); break;
+            case MB_VAL_F32_LE: memcpy(&raw, &le, sizeof(raw)); break;
+            case MB_VAL_U16:
+            default:            raw = (float)w[0]; break;
+        }
+        out_values[i] = raw * (s->scale != 0.0f ? s->scale : 1.0f);
+    }
+    return ESP_OK;
+}
+
+esp_err_t mb_plan_read(uint8_t addr, uint8_t fc,
+                       const mb_reg_spec_t *specs, size_t n,
+                       const mb_read_plan_t *plan, float *out_values)
+{
+    if (!plan || plan->n_blocks == 0 || plan->words > MB_PLAN_MAX_WORDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t words[MB_PLAN_MAX_WORDS];
+    uint16_t off = 0;
+    for (uint8_t b = 0; b < plan->n_blocks; b++) {
+        const mb_block_t *blk = &plan->blocks[b];
+        esp_err_t err = (fc == 0x04)
+            ? modbus_master_read_input_registers  (addr, blk->start, blk->count, &words[off])
+            : modbus_master_read_holding_registers(addr, blk->start, blk->count, &words[off]);
+        if (err != ESP_OK) {
+            ESP_LOGD(TAG, "addr=%u fc=0x%02X bloco 0x%04X+%u falhou: %s",
+                     addr, fc, blk->start, blk->count, esp_err_to_name(err));
+            return err;
+        }
+        off += blk->count;
+    }
+    return mb_plan_decode(specs, n, plan, words, out_values);
+}
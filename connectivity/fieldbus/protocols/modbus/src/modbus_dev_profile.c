@@ -0,0 +1,362 @@
+/*
+ * modbus_dev_profile.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "modbus_dev_profile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "datalogger_driver.h"   // load_rs485_config(), rs485_hint_get_used_fc() (semente)
+
+#ifndef MB_PROF_FILE
+#define MB_PROF_FILE      "/littlefs/rs485_prof.bin"
+#define MB_PROF_FILE_TMP  "/littlefs/rs485_prof.tmp"
+#endif
+#define MB_PROF_MAGIC     0x3150424Du   // "MBP1" (arquivo)
+#define MB_PROF_RTC_MAGIC 0x3452424Du   // "MBR4" (layout da tabela em RTC)
+
+static const char *TAG = "MB/PROF";
+
+// ---- Formato do binário: cabeçalho + N entradas + CRC32 ----
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t  count;
+    uint8_t  reserved[3];
+} prof_file_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t addr;
+    uint8_t used_fc;
+    uint8_t reserved[2];   // [0] era a ordem das words (ignorado)
+} prof_file_entry_t;
+
+// ---- Tabela em RTC (sobrevive ao deep sleep) ----
+typedef struct {
+    uint32_t         magic;        // != MB_PROF_RTC_MAGIC => recarregar da flash
+    uint32_t         seq;
+    bool             dirty;        // FC mudou e ainda não foi gravada
+    mb_dev_profile_t dev[MB_PROF_MAX_DEVICES];
+} prof_table_t;
+
+RTC_DATA_ATTR static prof_table_t s_tab;
+
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock;
+static portMUX_TYPE      s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void lock(void)
+{
+    if (!s_lock) {
+        portENTER_CRITICAL(&s_init_mux);
+        if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+        portEXIT_CRITICAL(&s_init_mux);
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void) { xSemaphoreGive(s_lock); }
+
+static mb_dev_profile_t *find(uint8_t addr)
+{
+    for (int i = 0; i < MB_PROF_MAX_DEVICES; i++) {
+        if (s_tab.dev[i].addr == addr) return &s_tab.dev[i];
+    }
+    return NULL;
+}
+
+// Acha ou cria o slot (despeja o menos usado se a tabela estiver cheia)
+static mb_dev_profile_t *find_or_add(uint8_t addr)
+{
+    mb_dev_profile_t *p = find(addr);
+    if (p) return p;
+
+    mb_dev_profile_t *victim = &s_tab.dev[0];
+    for (int i = 0; i < MB_PROF_MAX_DEVICES; i++) {
+        if (s_tab.dev[i].addr == 0) { victim = &s_tab.dev[i]; break; }
+        if (s_tab.dev[i].last_used < victim->last_used) victim = &s_tab.dev[i];
+    }
+    if (victim->addr != 0 && victim->used_fc != 0) s_tab.dirty = true;
+    memset(victim, 0, sizeof(*victim));
+    victim->addr = addr;
+    return victim;
+}
+
+static esp_err_t load_file(void)
+{
+    FILE *f = fopen(MB_PROF_FILE, "rb");
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    prof_file_hdr_t   hdr;
+    prof_file_entry_t ent[MB_PROF_MAX_DEVICES];
+    uint32_t crc_file = 0;
+    esp_err_t err = ESP_ERR_INVALID_CRC;
+
+    if (fread(&hdr, sizeof(hdr), 1, f) == 1 &&
+        hdr.magic == MB_PROF_MAGIC && hdr.count <= MB_PROF_MAX_DEVICES &&
+        fread(ent, sizeof(ent[0]), hdr.count, f) == hdr.count &&
+        fread(&crc_file, sizeof(crc_file), 1, f) == 1)
+    {
+        uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, sizeof(hdr));
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)ent, hdr.count * sizeof(ent[0]));
+        if (crc == crc_file) {
+            for (int i = 0; i < hdr.count; i++) {
+                mb_dev_profile_t *p = &s_tab.dev[i];
+                p->addr    = ent[i].addr;
+                p->used_fc = ent[i].used_fc;
+            }
+            err = ESP_OK;
+        }
+    }
+    fclose(f);
+    return err;
+}
+
+// Primeira vez: aproveita as FCs que o portal já gravou no JSON da UI
+static void seed_from_ui_json(void)
+{
+    sensor_map_t map[RS485_MAX_SENSORS];
+    size_t count = 0;
+    if (load_rs485_config(map, &count) != ESP_OK) return;
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t fc = 0;
+        if (rs485_hint_get_used_fc(map[i].address, &fc) == ESP_OK &&
+            (fc == 0x03 || fc == 0x04)) {
+            mb_dev_profile_t *p = find_or_add(map[i].address);
+            p->used_fc = fc;
+            s_tab.dirty = true;
+        }
+    }
+}
+
+esp_err_t mb_prof_init(void)
+{
+    lock();
+    if (s_tab.magic != MB_PROF_RTC_MAGIC) {
+        memset(&s_tab, 0, sizeof(s_tab));
+        esp_err_t err = load_file();
+        if (err != ESP_OK) {
+            if (err == ESP_ERR_INVALID_CRC) ESP_LOGW(TAG, "%s corrompido; recriando", MB_PROF_FILE);
+            memset(&s_tab, 0, sizeof(s_tab));
+            seed_from_ui_json();
+        }
+        s_tab.magic = MB_PROF_RTC_MAGIC;
+    }
+    unlock();
+    return ESP_OK;
+}
+
+static inline void ensure_init(void)
+{
+    if (s_tab.magic != MB_PROF_RTC_MAGIC) (void)mb_prof_init();
+}
+
+esp_err_t mb_prof_get(uint8_t addr, mb_dev_profile_t *out)
+{
+    if (!out || addr == 0) return ESP_ERR_INVALID_ARG;
+    ensure_init();
+    lock();
+    mb_dev_profile_t *p = find(addr);
+    if (p) *out = *p;
+    unlock();
+    return p ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+uint8_t mb_prof_used_fc(uint8_t addr)
+{
+    mb_dev_profile_t p;
+    return (mb_prof_get(addr, &p) == ESP_OK) ? p.used_fc : 0;
+}
+
+// Estimador do tipo Jacobson/Karels (ganhos 1/8 e 1/4), em ms
+static void rtt_sample(mb_dev_profile_t *p, uint32_t ms)
+{
+    if (ms > UINT16_MAX) ms = UINT16_MAX;
+    if (p->hist_n == 0 && p->srtt_ms == 0) {
+        p->srtt_ms   = (uint16_t)ms;
+        p->rttvar_ms = (uint16_t)(ms / 2);
+    } else {
+        int32_t err = (int32_t)ms - (int32_t)p->srtt_ms;
+        p->srtt_ms   = (uint16_t)((int32_t)p->srtt_ms + err / 8);
+        if (err < 0) err = -err;
+        p->rttvar_ms = (uint16_t)((int32_t)p->rttvar_ms + (err - (int32_t)p->rttvar_ms) / 4);
+    }
+    p->rtt_hist[p->hist_pos] = (uint16_t)ms;
+    p->hist_pos = (uint8_t)((p->hist_pos + 1) % MB_PROF_RTT_SAMPLES);
+    if (p->hist_n < MB_PROF_RTT_SAMPLES) p->hist_n++;
+}
+
+void mb_prof_note_ok(uint8_t addr, uint8_t fc, uint32_t latency_ms)
+{
+    if (addr == 0) return;
+    ensure_init();
+    lock();
+    mb_dev_profile_t *p = find_or_add(addr);
+    if ((fc == 0x03 || fc == 0x04) && p->used_fc != fc) {
+        p->used_fc = fc;
+        s_tab.dirty = true;
+    }
+    if (p->skip_level) {
+        ESP_LOGI(TAG, "addr=%u voltou a responder", addr);
+    }
+    p->fail_streak = 0;
+    p->skip_level  = 0;
+    p->skip_left   = 0;
+    p->ok_total++;
+    if (latency_ms > 0) {            // 0 = sem medição (não entra no histórico)
+        p->last_latency_ms = (latency_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)latency_ms;
+        rtt_sample(p, latency_ms);
+    }
+    p->last_used = ++s_tab.seq;
+    unlock();
+}
+
+void mb_prof_note_fail(uint8_t addr)
+{
+    if (addr == 0) return;
+    ensure_init();
+    lock();
+    mb_dev_profile_t *p = find_or_add(addr);
+    if (p->fail_streak < UINT8_MAX) p->fail_streak++;
+    p->fail_total++;
+    if (p->fail_streak >= MB_PROF_DEAD_AFTER) {
+        if (p->skip_level < MB_PROF_SKIP_MAX_LEVEL) p->skip_level++;
+        p->skip_left = (uint8_t)((1u << p->skip_level) - 1);   // lê 1 a cada 2^nível ciclos
+        ESP_LOGW(TAG, "addr=%u sem resposta %u vez(es): próximo poll em %u ciclo(s)",
+                 addr, p->fail_streak, (unsigned)p->skip_left + 1);
+    }
+    p->last_used = ++s_tab.seq;
+    unlock();
+}
+
+uint32_t mb_prof_latency_pct(const mb_dev_profile_t *p, unsigned pct)
+{
+    if (!p || p->hist_n == 0) return 0;
+    uint16_t v[MB_PROF_RTT_SAMPLES];
+    uint8_t n = p->hist_n;
+    memcpy(v, p->rtt_hist, n * sizeof(v[0]));
+    for (uint8_t i = 1; i < n; i++) {            // inserção (n <= 8)
+        uint16_t x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+        v[j + 1] = x;
+    }
+    if (pct > 100) pct = 100;
+    unsigned idx = (pct * (n - 1) + 50) / 100;   // arredonda para o mais próximo
+    return v[idx];
+}
+
+uint32_t mb_prof_timeout_ms(uint8_t addr)
+{
+    mb_dev_profile_t p;
+    if (mb_prof_get(addr, &p) != ESP_OK || p.hist_n == 0) return MB_PROF_TO_DEFAULT_MS;
+
+    uint32_t rto = (uint32_t)p.srtt_ms + 4u * p.rttvar_ms;
+    uint32_t p95 = mb_prof_latency_pct(&p, 95);
+    if (p95 * 3 / 2 > rto) rto = p95 * 3 / 2;
+    rto += MB_PROF_TO_MARGIN_MS;
+
+    if (rto < MB_PROF_TO_MIN_MS) rto = MB_PROF_TO_MIN_MS;
+    if (rto > MB_PROF_TO_MAX_MS) rto = MB_PROF_TO_MAX_MS;
+    return rto;
+}
+
+bool mb_prof_should_poll(uint8_t addr)
+{
+    if (addr == 0) return false;
+    ensure_init();
+    lock();
+    mb_dev_profile_t *p = find(addr);
+    bool poll = true;
+    if (p && p->skip_left > 0) {
+        p->skip_left--;
+        p->skipped_total++;
+        poll = false;
+    }
+    unlock();
+    return poll;
+}
+
+size_t mb_prof_snapshot(mb_dev_profile_t *out, size_t max)
+{
+    if (!out || max == 0) return 0;
+    ensure_init();
+    size_t n = 0;
+    lock();
+    for (int i = 0; i < MB_PROF_MAX_DEVICES && n < max; i++) {
+        if (s_tab.dev[i].addr != 0) out[n++] = s_tab.dev[i];
+    }
+    unlock();
+    return n;
+}
+
+void mb_prof_set_flag(uint8_t addr, uint8_t flag, bool on)
+{
+    if (addr == 0) return;
+    ensure_init();
+    lock();
+    mb_dev_profile_t *p = find_or_add(addr);
+    if (on) p->flags |= flag;
+    else    p->flags &= (uint8_t)~flag;
+    unlock();
+}
+
+bool mb_prof_has_flag(uint8_t addr, uint8_t flag)
+{
+    mb_dev_profile_t p;
+    return (mb_prof_get(addr, &p) == ESP_OK) && (p.flags & flag);
+}
+
+esp_err_t mb_prof_flush(void)
+{
+    ensure_init();
+
+    prof_file_hdr_t   hdr = { .magic = MB_PROF_MAGIC };
+    prof_file_entry_t ent[MB_PROF_MAX_DEVICES];
+
+    lock();
+    if (!s_tab.dirty) {
+        unlock();
+        return ESP_OK;
+    }
+    for (int i = 0; i < MB_PROF_MAX_DEVICES; i++) {
+        const mb_dev_profile_t *p = &s_tab.dev[i];
+        if (p->addr == 0 || p->used_fc == 0) continue;
+        ent[hdr.count++] = (prof_file_entry_t){ p->addr, p->used_fc, { 0, 0 } };
+    }
+    s_tab.dirty = false;
+    unlock();
+
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr, sizeof(hdr));
+    crc = esp_rom_crc32_le(crc, (const uint8_t *)ent, hdr.count * sizeof(ent[0]));
+
+    // Arquivo temporário + rename (atômico no LittleFS), igual ao journal de índices
+    FILE *f = fopen(MB_PROF_FILE_TMP, "wb");
+    bool ok = f &&
+              fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(ent, sizeof(ent[0]), hdr.count, f) == hdr.count &&
+              fwrite(&crc, sizeof(crc), 1, f) == 1;
+    if (f) fclose(f);
+    if (ok && rename(MB_PROF_FILE_TMP, MB_PROF_FILE) != 0) ok = false;
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Falha ao gravar %s: %s", MB_PROF_FILE, strerror(errno));
+        unlink(MB_PROF_FILE_TMP);
+        lock();
+        s_tab.dirty = true;   // tenta de novo no próximo flush
+        unlock();
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Perfis RS-485 gravados (%u)", (unsigned)hdr.count);
+    return ESP_OK;
+}
@@ -40,9 +40,11 @@ static bool                s_modbus_initialized = false;
 static esp_log_level_t     s_prev_level = CONFIG_LOG_DEFAULT_LEVEL;
 
 /* ---- Helpers ---- */
+// Recursivo: uma sessão do ciclo (rs485_central) pode conter as sessões
+// curtas de cada leitura; as internas só mexem no refcount.
 static inline void ensure_mutex(void) {
     if (!s_mutex) {
-        s_mutex = xSemaphoreCreateMutex();
+        s_mutex = xSemaphoreCreateRecursiveMutex();
     }
 }
 
@@ -96,7 +98,7 @@ esp_err_t mb_session_begin(TickType_t max_wait_ticks)
     ensure_mutex();
     if (!s_mutex) return ESP_ERR_NO_MEM;
 
-    if (xSemaphoreTake(s_mutex, max_wait_ticks) != pdTRUE) {
+    if (xSemaphoreTakeRecursive(s_mutex, max_wait_ticks) != pdTRUE) {
         ESP_LOGW(TAG, "timeout aguardando exclusividade do Modbus");
         return ESP_ERR_TIMEOUT;
     }
@@ -115,7 +117,7 @@ esp_err_t mb_session_begin(TickType_t max_wait_ticks)
                 if (err != ESP_OK) {
                     ESP_LOGE(TAG, "modbus_init falhou: %s", esp_err_to_name(err));
                     esp_log_level_set("*", s_prev_level);
-                    xSemaphoreGive(s_mutex);
+                    xSemaphoreGiveRecursive(s_mutex);
                     return err;
                 }
                 s_modbus_initialized = true;
@@ -126,7 +128,7 @@ esp_err_t mb_session_begin(TickType_t max_wait_ticks)
             if (err != ESP_OK) {
                 ESP_LOGE(TAG, "modbus_init falhou: %s", esp_err_to_name(err));
                 esp_log_level_set("*", s_prev_level);
-                xSemaphoreGive(s_mutex);
+                xSemaphoreGiveRecursive(s_mutex);
                 return err;
             }
             did_fresh_init = true;
@@ -147,7 +149,7 @@ esp_err_t mb_session_begin(TickType_t max_wait_ticks)
                 }
 
                 esp_log_level_set("*", s_prev_level);
-                xSemaphoreGive(s_mutex);
+                xSemaphoreGiveRecursive(s_mutex);
                 return err;
             }
         }
@@ -166,7 +168,7 @@ void mb_session_end(void)
     if (s_refcnt <= 0) {
         // uso incorreto (end sem begin)
         ESP_LOGW(TAG, "mb_session_end() sem begin correspondente");
-        xSemaphoreGive(s_mutex);
+        xSemaphoreGiveRecursive(s_mutex);
         return;
     }
 
@@ -186,7 +188,7 @@ void mb_session_end(void)
         esp_log_level_set("*", s_prev_level);
     }
 
-    xSemaphoreGive(s_mutex);
+    xSemaphoreGiveRecursive(s_mutex);
 }
 
 bool mb_session_is_active(void)
@@ -0,0 +1,373 @@
+/*
+ * modbus_rtu_lite.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "modbus_rtu_lite.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "rs485_hw.h"
+
+static const char *TAG = "MB/RTU";
+
+#define UART_TOUT_MAX_SYMBOLS  126   // limite do TOUT da UART do ESP32
+
+// CRC16/MODBUS (poli 0xA001 refletido), um byte por consulta
+static const uint16_t s_crc_tab[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+// ---- Estado do barramento (dono: quem está na sessão Modbus) ----
+typedef struct {
+    bool          open;
+    int           uart;
+    uint32_t      baud;
+    uint32_t      t35_us;
+    uint32_t      char_us;
+    int64_t       last_edge_us;     // fim do último quadro (TX ou RX)
+    mb_rtu_txn_t *inflight;
+} rtu_bus_t;
+
+static rtu_bus_t s_bus;
+
+static mb_rtu_stats_t s_stats;
+
+/* ---------------- quadro ---------------- */
+
+uint16_t mb_rtu_crc16(const uint8_t *p, size_t n)
+{
+    uint16_t crc = 0xFFFF;
+    while (n--) crc = (uint16_t)((crc >> 8) ^ s_crc_tab[(crc ^ *p++) & 0xFF]);
+    return crc;
+}
+
+bool mb_rtu_crc_ok(const uint8_t *frame, size_t len)
+{
+    if (!frame || len < 3) return false;
+    uint16_t crc = mb_rtu_crc16(frame, len - 2);
+    return frame[len - 2] == (uint8_t)(crc & 0xFF) && frame[len - 1] == (uint8_t)(crc >> 8);
+}
+
+// Caractere RTU = 11 bits (start + 8 + paridade/2º stop + stop)
+static uint32_t char_us(uint32_t baud)
+{
+    return (11u * 1000000u + baud - 1) / baud;
+}
+
+uint32_t mb_rtu_t35_us(uint32_t baud)
+{
+    if (baud == 0) return 0;
+    if (baud > 19200) return 1750;
+    return (38500000u + baud - 1) / baud;   // 3,5 x 11 bits
+}
+
+uint8_t mb_rtu_rx_tout_symbols(uint32_t baud)
+{
+    if (baud == 0) return 1;
+    const uint32_t sym_us = (10u * 1000000u + baud - 1) / baud;
+    uint32_t tout = (mb_rtu_t35_us(baud) + sym_us - 1) / sym_us;
+    if (tout == 0) tout = 1;
+    if (tout > UART_TOUT_MAX_SYMBOLS) tout = UART_TOUT_MAX_SYMBOLS;
+    return (uint8_t)tout;
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)(v & 0xFF);
+}
+
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+size_t mb_rtu_build_request(const mb_rtu_txn_t *t, uint8_t *frame, size_t cap)
+{
+    if (!t || !frame || t->addr == 0 || t->addr > 247 || t->count == 0) return 0;
+
+    size_t n;
+    frame[0] = t->addr;
+    frame[1] = t->fc;
+    put_u16(&frame[2], t->reg);
+    put_u16(&frame[4], t->count);
+
+    switch (t->fc) {
+        case 0x03:
+        case 0x04:
+            if (t->count > MB_RTU_MAX_READ_WORDS || cap < 8) return 0;
+            n = 6;
+            break;
+        case 0x10:
+            if (!t->words || t->count > MB_RTU_MAX_WRITE_WORDS) return 0;
+            if (cap < 9u + 2u * t->count) return 0;
+            frame[6] = (uint8_t)(2 * t->count);
+            for (uint16_t i = 0; i < t->count; i++) put_u16(&frame[7 + 2 * i], t->words[i]);
+            n = 7u + 2u * t->count;
+            break;
+        default:
+            return 0;
+    }
+    uint16_t crc = mb_rtu_crc16(frame, n);
+    frame[n++] = (uint8_t)(crc & 0xFF);
+    frame[n++] = (uint8_t)(crc >> 8);
+    return n;
+}
+
+size_t mb_rtu_expected_len(const mb_rtu_txn_t *t)
+{
+    if (!t) return 0;
+    return (t->fc == 0x10) ? 8 : 5u + 2u * t->count;
+}
+
+esp_err_t mb_rtu_parse_response(mb_rtu_txn_t *t, const uint8_t *frame, size_t len)
+{
+    if (!t || !frame || len < 5 || frame[0] != t->addr) return ESP_ERR_INVALID_RESPONSE;
+
+    if (frame[1] == (t->fc | 0x80)) {
+        if (!mb_rtu_crc_ok(frame, 5)) return ESP_ERR_INVALID_CRC;
+        t->exception = frame[2];
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (frame[1] != t->fc || len != mb_rtu_expected_len(t)) return ESP_ERR_INVALID_RESPONSE;
+    if (!mb_rtu_crc_ok(frame, len)) return ESP_ERR_INVALID_CRC;
+
+    if (t->fc == 0x10) {
+        // eco de endereço inicial + quantidade
+        if (get_u16(&frame[2]) != t->reg || get_u16(&frame[4]) != t->count) return ESP_ERR_INVALID_RESPONSE;
+        return ESP_OK;
+    }
+    if (frame[2] != 2 * t->count) return ESP_ERR_INVALID_RESPONSE;
+    if (t->words) {
+        for (uint16_t i = 0; i < t->count; i++) t->words[i] = get_u16(&frame[3 + 2 * i]);
+    }
+    return ESP_OK;
+}
+
+/* ---------------- barramento ---------------- */
+
+// Arredonda para cima e soma 1 tick (o 1º tick pode estar quase no fim)
+static TickType_t us_to_ticks_ceil(int64_t us)
+{
+    if (us <= 0) return 1;
+    return (TickType_t)((us * configTICK_RATE_HZ + 999999) / 1000000) + 1;
+}
+
+esp_err_t mb_rtu_open(uint32_t baud)
+{
+    if (s_bus.open) return ESP_OK;
+    if (baud == 0) baud = RS485_DEFAULT_BAUD;
+
+    rs485_hw_cfg_t cfg;
+    rs485_hw_fill_defaults(&cfg);
+    cfg.baudrate = baud;
+    // Sobra de outro dono da UART (esp-modbus, varredura): começa limpo
+    if (uart_is_driver_installed(cfg.uart_num)) {
+        ESP_RETURN_ON_ERROR(uart_driver_delete(cfg.uart_num), TAG, "uart_driver_delete");
+    }
+    ESP_RETURN_ON_ERROR(rs485_hw_init(&cfg), TAG, "rs485_hw_init");
+
+    // TOUT em símbolos da UART: o driver entrega o quadro ao ring buffer
+    // assim que a linha fica t3.5 em silêncio
+    const uint32_t t35  = mb_rtu_t35_us(baud);
+    const uint8_t  tout = mb_rtu_rx_tout_symbols(baud);
+    esp_err_t err = uart_set_rx_timeout(cfg.uart_num, tout);
+    if (err != ESP_OK) {
+        (void) rs485_hw_deinit();
+        ESP_LOGE(TAG, "uart_set_rx_timeout(%u) fail: %s", tout, esp_err_to_name(err));
+        return err;
+    }
+
+    s_bus = (rtu_bus_t) {
+        .open         = true,
+        .uart         = cfg.uart_num,
+        .baud         = baud,
+        .t35_us       = t35,
+        .char_us      = char_us(baud),
+        .last_edge_us = esp_timer_get_time(),
+    };
+    ESP_LOGI(TAG, "UART%d %lu bps: t3.5=%luus (TOUT=%u símbolos)",
+             cfg.uart_num, (unsigned long)baud, (unsigned long)t35, tout);
+    return ESP_OK;
+}
+
+void mb_rtu_close(void)
+{
+    if (!s_bus.open) return;
+    (void) rs485_hw_deinit();
+    s_bus.open = false;
+    s_bus.inflight = NULL;
+}
+
+bool mb_rtu_is_open(void) { return s_bus.open; }
+
+esp_err_t mb_rtu_submit(mb_rtu_txn_t *t)
+{
+    if (!t) return ESP_ERR_INVALID_ARG;
+    if (!s_bus.open || s_bus.inflight) return ESP_ERR_INVALID_STATE;
+
+    uint8_t frame[MB_RTU_MAX_ADU];
+    size_t n = mb_rtu_build_request(t, frame, sizeof(frame));
+    if (n == 0) return ESP_ERR_INVALID_ARG;
+
+    t->status     = ESP_ERR_TIMEOUT;
+    t->exception  = 0;
+    t->latency_ms = 0;
+
+    // Silêncio de t3.5 desde o último quadro (o escravo precisa dele para
+    // separar o pedido do que veio antes)
+    int64_t idle = esp_timer_get_time() - s_bus.last_edge_us;
+    if (idle < (int64_t)s_bus.t35_us) esp_rom_delay_us((uint32_t)(s_bus.t35_us - idle));
+
+    uart_flush_input(s_bus.uart);   // resto de resposta atrasada/ruído
+    esp_err_t err = rs485_hw_tx(frame, n, us_to_ticks_ceil((int64_t)n * s_bus.char_us) + 2);
+    s_bus.last_edge_us = esp_timer_get_time();
+    if (err != ESP_OK) return err;
+
+    s_stats.transactions++;
+    t->t_sent_us = s_bus.last_edge_us;
+    t->pending   = true;
+    s_bus.inflight = t;
+    return ESP_OK;
+}
+
+static void account(const mb_rtu_txn_t *t)
+{
+    switch (t->status) {
+        case ESP_OK: {
+            s_stats.ok++;
+            s_stats.latency_last_ms = t->latency_ms;
+            s_stats.latency_avg_ms  = s_stats.latency_avg_ms
+                ? (uint16_t)(s_stats.latency_avg_ms + ((int)t->latency_ms - (int)s_stats.latency_avg_ms) / 8)
+                : t->latency_ms;
+            if (t->latency_ms > s_stats.latency_max_ms) s_stats.latency_max_ms = t->latency_ms;
+            break;
+        }
+        case ESP_ERR_TIMEOUT:
+            s_stats.timeouts++;
+            s_stats.timeout_wait_ms += t->latency_ms;
+            break;
+        case ESP_ERR_INVALID_CRC:   s_stats.crc_errors++; break;
+        case ESP_ERR_NOT_SUPPORTED: s_stats.exceptions++; break;
+        default:                    s_stats.bad_frames++; break;
+    }
+}
+
+esp_err_t mb_rtu_complete(mb_rtu_txn_t *t)
+{
+    if (!t) return ESP_ERR_INVALID_ARG;
+    if (!t->pending) return t->status;
+    if (s_bus.inflight != t) return ESP_ERR_INVALID_STATE;
+
+    uint8_t rx[MB_RTU_MAX_ADU];
+    const size_t want = mb_rtu_expected_len(t);
+    const uint32_t tmo_ms = t->timeout_ms ? t->timeout_ms : MB_RTU_DEFAULT_TIMEOUT_MS;
+
+    // 1) 5 bytes = exceção inteira ou o começo de qualquer resposta normal.
+    //    Prazo: timeout do escravo + tempo de chegada desses 5 caracteres.
+    int64_t deadline = t->t_sent_us + (int64_t)tmo_ms * 1000 + 5 * (int64_t)s_bus.char_us + s_bus.t35_us;
+    size_t got = 0;
+    int r = uart_read_bytes(s_bus.uart, rx, 5, us_to_ticks_ceil(deadline - esp_timer_get_time()));
+    if (r > 0) got = (size_t)r;
+
+    if (got == 0) {
+        t->status = ESP_ERR_TIMEOUT;
+    } else if (got < 5) {
+        t->status = ESP_ERR_INVALID_RESPONSE;        // quadro truncado
+    } else {
+        // 2) o resto: já está no ring buffer (TOUT) ou chega em (want-5) caracteres
+        if (!(rx[1] & 0x80) && want > 5) {
+            r = uart_read_bytes(s_bus.uart, rx + 5, want - 5,
+                                us_to_ticks_ceil((int64_t)(want - 5) * s_bus.char_us + s_bus.t35_us));
+            if (r > 0) got += (size_t)r;
+        }
+        t->status = mb_rtu_parse_response(t, rx, got);
+    }
+
+    s_bus.last_edge_us = esp_timer_get_time();
+    t->latency_ms = (uint16_t)((s_bus.last_edge_us - t->t_sent_us) / 1000);
+    t->pending = false;
+    s_bus.inflight = NULL;
+    account(t);
+
+    if (t->status != ESP_OK && t->status != ESP_ERR_TIMEOUT) {
+        ESP_LOGD(TAG, "addr=%u fc=0x%02X: %s (%u bytes, exc=%u)",
+                 t->addr, t->fc, esp_err_to_name(t->status), (unsigned)got, t->exception);
+    }
+    return t->status;
+}
+
+esp_err_t mb_rtu_transact(mb_rtu_txn_t *t)
+{
+    esp_err_t err = mb_rtu_submit(t);
+    if (err != ESP_OK) return err;
+    return mb_rtu_complete(t);
+}
+
+esp_err_t mb_rtu_read(uint8_t addr, uint8_t fc, uint16_t reg, uint16_t count,
+                      uint16_t *out, uint32_t timeout_ms)
+{
+    if (!out || (fc != 0x03 && fc != 0x04)) return ESP_ERR_INVALID_ARG;
+    mb_rtu_txn_t t = {
+        .addr = addr, .fc = fc, .reg = reg, .count = count,
+        .words = out, .timeout_ms = timeout_ms,
+    };
+    return mb_rtu_transact(&t);
+}
+
+esp_err_t mb_rtu_write_multiple(uint8_t addr, uint16_t reg, uint16_t count,
+                                const uint16_t *words, uint32_t timeout_ms)
+{
+    if (!words) return ESP_ERR_INVALID_ARG;
+    mb_rtu_txn_t t = {
+        .addr = addr, .fc = 0x10, .reg = reg, .count = count,
+        .words = (uint16_t *)words, .timeout_ms = timeout_ms,
+    };
+    return mb_rtu_transact(&t);
+}
+
+void mb_rtu_get_stats(mb_rtu_stats_t *out)
+{
+    // Contadores só mudam dentro da sessão Modbus; cópia sem trava basta
+    // para diagnóstico
+    if (out) *out = s_stats;
+}
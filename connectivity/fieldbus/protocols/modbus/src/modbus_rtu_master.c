@@ -1,12 +1,17 @@
 /*
  * modbus_rtu_master.c
- * Master RTU (esp-modbus) desacoplado de qualquer "slave".
+ * Master RTU desacoplado de qualquer "slave".
  * - init/start (sem tarefa leitora interna)
- * - wrappers de leitura (FC04/FC03) usados pelos drivers
+ * - wrappers de leitura (FC04/FC03) e escrita (FC10) usados pelos drivers
  * - ping canônico (FC04@0x0001 → FC03@0x0000)
+ *
+ * Backend: com CONFIG_MODBUS_RTU_LITE os pedidos vão para o master próprio
+ * (modbus_rtu_lite, direto no rs485_hw, com timeout de resposta por
+ * escravo); sem ela, para o controlador do esp-modbus.
  */
 
 #include "modbus_rtu_master.h"
+#include "modbus_dev_profile.h"
 #include "driver/uart.h"
 #include "rs485_hw.h" 
 #include <string.h>
@@ -15,8 +20,21 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "driver/uart.h"
-#include "mbcontroller.h"
 #include "log_mux.h"
+#if CONFIG_MODBUS_RTU_LITE
+#include "modbus_rtu_lite.h"
+
+/* Pedido no formato do mb_param_request_t (o esp-modbus fica fora do build) */
+typedef struct {
+    uint8_t  slave_addr;
+    uint8_t  command;
+    uint16_t reg_start;
+    uint16_t reg_size;
+} mb_req_t;
+#else
+#include "mbcontroller.h"
+typedef mb_param_request_t mb_req_t;
+#endif
 
 /* Mapear os símbolos do Modbus para os do RS485 (com fallback seguro) */
 /*#ifndef MB_PORT_NUM
@@ -60,7 +78,10 @@
 #  endif
 #endif*/
 
-/* Timeouts internos padrão (ticks) */
+/* Espera pelo mutex do barramento (ticks). No esp-modbus o timeout de
+ * resposta do escravo é global (CONFIG_FMB_MASTER_TIMEOUT_MS_RESPOND) e o
+ * prazo por escravo é aplicado pelo rs485_central; no backend lite cada
+ * pedido já usa mb_prof_timeout_ms() do escravo. */
 #ifndef MB_REQ_TIMEOUT_MS
 #define MB_REQ_TIMEOUT_MS  (800)
 #endif
@@ -81,13 +102,22 @@ static uart_mode_t s_last_uart_mode = UART_MODE_UART;
 void rs485_note_set_mode(uart_mode_t m) { s_last_uart_mode = m; }
 
 /* Helper interno: send_request com lock */
-static inline esp_err_t mb_send_locked(mb_param_request_t *req,
+static inline esp_err_t mb_send_locked(mb_req_t *req,
                                        void *data_buf,
                                        TickType_t tmo_ticks)
 {
     if (!req || !data_buf || req->reg_size == 0) return ESP_ERR_INVALID_ARG;
     if (s_mb_req_mutex) xSemaphoreTake(s_mb_req_mutex, tmo_ticks);
+#if CONFIG_MODBUS_RTU_LITE
+    const uint32_t resp_ms = mb_prof_timeout_ms(req->slave_addr);
+    esp_err_t err = (req->command == 0x10)
+        ? mb_rtu_write_multiple(req->slave_addr, req->reg_start, req->reg_size,
+                                (const uint16_t *)data_buf, resp_ms)
+        : mb_rtu_read(req->slave_addr, req->command, req->reg_start, req->reg_size,
+                      (uint16_t *)data_buf, resp_ms);
+#else
     esp_err_t err = mbc_master_send_request(req, data_buf);
+#endif
     if (s_mb_req_mutex) xSemaphoreGive(s_mb_req_mutex);
     return err;
 }
@@ -130,6 +160,15 @@ esp_err_t modbus_master_init(void)
         return ESP_OK;
     }
 
+#if CONFIG_MODBUS_RTU_LITE
+    ESP_LOGI(TAG, "Init Master RTU (lite): UART%d, %d bps", MB_PORT_NUM, MB_DEV_SPEED);
+    esp_err_t err = mb_rtu_open(MB_DEV_SPEED);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "mb_rtu_open() fail: %s", esp_err_to_name(err));
+        return err;
+    }
+    s_master_handler = (void *)&s_master_ready;   // só marca "em uso"
+#else
     mb_communication_info_t comm = {
         .port     = MB_PORT_NUM,
     #ifdef CONFIG_MB_COMM_MODE_ASCII
@@ -193,6 +232,7 @@ esp_err_t modbus_master_init(void)
         return err;
     }
 #endif
+#endif // CONFIG_MODBUS_RTU_LITE
 
     logmux_notify_rs485_active((uart_port_t)MB_PORT_NUM, true);
   
@@ -202,9 +242,13 @@ if (!s_mb_req_mutex) {
         ESP_LOGE(TAG, "xSemaphoreCreateMutex() NO MEM");
         // rollback seguro:
         logmux_notify_rs485_active((uart_port_t)MB_PORT_NUM, false);
+#if CONFIG_MODBUS_RTU_LITE
+        mb_rtu_close();
+#else
         (void) mbc_master_destroy();
         uart_flush_input(MB_PORT_NUM);
         uart_set_mode(MB_PORT_NUM, UART_MODE_UART);
+#endif
         s_master_handler = NULL;
         return ESP_ERR_NO_MEM;
     }
@@ -212,7 +256,13 @@ if (!s_mb_req_mutex) {
     s_master_ready = true;
     ESP_LOGI(TAG, "Master RTU inicializado e pronto.");
     
-    modbus_uart_selftest();
+    // Diagnóstico só no primeiro init do boot: o ping ao addr=1 custa um
+    // timeout inteiro quando não há ninguém nesse endereço.
+    static bool s_selftest_done;
+    if (!s_selftest_done) {
+        s_selftest_done = true;
+        modbus_uart_selftest();
+    }
     return ESP_OK;
 }
 
@@ -234,6 +284,10 @@ esp_err_t modbus_master_deinit(void)
     s_master_ready = false;  // wrappers passam a retornar INVALID_STATE
 
 
+#if CONFIG_MODBUS_RTU_LITE
+    // 2+3) Remove o driver da UART (DE/RE fica em RX)
+    mb_rtu_close();
+#else
     // 2) Devolve UART para modo normal e limpa buffers
     uart_flush_input(MB_PORT_NUM);
     uart_flush(MB_PORT_NUM);
@@ -246,6 +300,7 @@ esp_err_t modbus_master_deinit(void)
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "mbc_master_destroy() = %s", esp_err_to_name(err));
     }
+#endif
     s_master_handler = NULL;
     
     // 4) Libera e destrói o mutex
@@ -282,7 +337,7 @@ esp_err_t modbus_master_read_input_registers(uint8_t slave_addr,
     if (!s_master_ready) return ESP_ERR_INVALID_STATE;
     if (slave_addr == 0 || words == 0 || out_words == NULL) return ESP_ERR_INVALID_ARG;
 
-    mb_param_request_t req = {
+    mb_req_t req = {
         .slave_addr = slave_addr,
         .command    = 0x04,          // Input Registers
         .reg_start  = reg_start,
@@ -299,7 +354,7 @@ esp_err_t modbus_master_read_holding_registers(uint8_t slave_addr,
     if (!s_master_ready) return ESP_ERR_INVALID_STATE;
     if (slave_addr == 0 || words == 0 || out_words == NULL) return ESP_ERR_INVALID_ARG;
 
-    mb_param_request_t req = {
+    mb_req_t req = {
         .slave_addr = slave_addr,
         .command    = 0x03,          // Holding Registers
         .reg_start  = reg_start,
@@ -308,6 +363,23 @@ esp_err_t modbus_master_read_holding_registers(uint8_t slave_addr,
     return mb_send_locked(&req, out_words, pdMS_TO_TICKS(MB_REQ_TIMEOUT_MS));
 }
 
+esp_err_t modbus_master_write_multiple_registers(uint8_t slave_addr,
+                                                 uint16_t reg_start,
+                                                 uint16_t words,
+                                                 const uint16_t *in_words)
+{
+    if (!s_master_ready) return ESP_ERR_INVALID_STATE;
+    if (slave_addr == 0 || words == 0 || in_words == NULL) return ESP_ERR_INVALID_ARG;
+
+    mb_req_t req = {
+        .slave_addr = slave_addr,
+        .command    = 0x10,          // Write Multiple Registers
+        .reg_start  = reg_start,
+        .reg_size   = words
+    };
+    return mb_send_locked(&req, (void *)in_words, pdMS_TO_TICKS(MB_REQ_TIMEOUT_MS));
+}
+
 /* =================== Ping canônico =================== */
 // Ping genérico Modbus RTU (read-only).
 // - Tenta FC03/FC04 em 0x0000/0x0001.
@@ -327,11 +399,8 @@ esp_err_t modbus_master_ping(uint8_t slave_addr, bool *alive, uint8_t *used_fc)
         if (!s_master_ready) return ESP_ERR_INVALID_STATE;
     }
 
-    // Dica simples por endereço: 0 = sem dica; 3/4 = última FC OK.
-    static uint8_t s_ping_fc_hint[248]; // indexado por endereço (1..247), zera em BSS
-
     uint16_t rx = 0;
-    mb_param_request_t req = {
+    mb_req_t req = {
         .slave_addr = slave_addr,
         .command    = 0x03,    // ajustado a cada tentativa
         .reg_start  = 0x0000,  // ajustado a cada tentativa
@@ -341,13 +410,15 @@ esp_err_t modbus_master_ping(uint8_t slave_addr, bool *alive, uint8_t *used_fc)
     esp_err_t last_err = ESP_FAIL;
 
     // ---- 1) Tenta HINT primeiro (se houver), em offsets comuns 0x0000 e 0x0001
-    uint8_t hint = s_ping_fc_hint[slave_addr];
+    //         Dica = FC da última transação OK no perfil do escravo (0 = sem dica)
+    uint8_t hint = mb_prof_used_fc(slave_addr);
     if (hint == 0x03 || hint == 0x04) {
         const uint16_t hint_regs[] = { 0x0000, 0x0001 };
         for (size_t i = 0; i < sizeof(hint_regs)/sizeof(hint_regs[0]); ++i) {
             req.command   = hint;
             req.reg_start = hint_regs[i];
 
+            TickType_t t0 = xTaskGetTickCount();
             esp_err_t err = mb_send_locked(&req, &rx, pdMS_TO_TICKS(MB_PING_TIMEOUT_MS));
             if (err == ESP_ERR_INVALID_STATE) {
                 (void) modbus_master_init();
@@ -357,7 +428,7 @@ esp_err_t modbus_master_ping(uint8_t slave_addr, bool *alive, uint8_t *used_fc)
                 if (alive)   *alive   = true;
                 if (used_fc) *used_fc = req.command;
                 // reforça a dica
-                s_ping_fc_hint[slave_addr] = req.command;
+                mb_prof_note_ok(slave_addr, req.command, pdTICKS_TO_MS(xTaskGetTickCount() - t0));
                 return ESP_OK;
             }
             last_err = err;
@@ -378,6 +449,7 @@ esp_err_t modbus_master_ping(uint8_t slave_addr, bool *alive, uint8_t *used_fc)
         req.command   = tries[i].fc;
         req.reg_start = tries[i].reg;
 
+        TickType_t t0 = xTaskGetTickCount();
         esp_err_t err = mb_send_locked(&req, &rx, pdMS_TO_TICKS(MB_PING_TIMEOUT_MS));
         if (err == ESP_ERR_INVALID_STATE) {
             (void) modbus_master_init();
@@ -387,7 +459,8 @@ esp_err_t modbus_master_ping(uint8_t slave_addr, bool *alive, uint8_t *used_fc)
         if (err == ESP_OK) {
             if (alive)   *alive   = true;
             if (used_fc) *used_fc = req.command;
-            s_ping_fc_hint[slave_addr] = req.command; // guarda dica para os próximos pings
+            mb_prof_note_ok(slave_addr, req.command,
+                            pdTICKS_TO_MS(xTaskGetTickCount() - t0)); // guarda dica para os próximos pings
             return ESP_OK;
         }
 
@@ -8,6 +8,8 @@
 #ifndef CONNECTIVITY_IP_ACCESS_NETWORK_4G_INCLUDE_LTE_PAYLOAD_BUILDER_H_
 #define CONNECTIVITY_IP_ACCESS_NETWORK_4G_INCLUDE_LTE_PAYLOAD_BUILDER_H_
 
+#include <stdint.h>
+#include <stddef.h>
 #include "esp_err.h"
 #include "datalogger_driver.h"
 
@@ -17,6 +19,29 @@ esp_err_t lte_json_data_payload(char *buf,
                             uint32_t *counter_out,
                             uint32_t *cursor_position);
 
+#define LTE_PAYLOAD_CONTENT_TYPE_JSON   "application/json"
+#define LTE_PAYLOAD_CONTENT_TYPE_CBOR   "application/cbor"
+
+// Mesmo conteúdo em CBOR (formato descrito em lte_payload_builder.c)
+esp_err_t lte_cbor_data_payload(uint8_t *buf,
+                            size_t bufSize,
+                            struct record_index_config rec_index,
+                            uint32_t *counter_out,
+                            uint32_t *cursor_position,
+                            size_t *len_out);
+
+// JSON ou CBOR conforme has_binary_payload(); len_out = bytes a enviar
+esp_err_t lte_data_payload(char *buf,
+                            size_t bufSize,
+                            struct record_index_config rec_index,
+                            uint32_t *counter_out,
+                            uint32_t *cursor_position,
+                            size_t *len_out,
+                            const char **content_type_out);
+
+// Chamar quando o servidor confirmou o payload (controla o reenvio da identificação)
+void lte_payload_delivered(void);
+
 
 
 #endif /* CONNECTIVITY_IP_ACCESS_NETWORK_4G_INCLUDE_LTE_PAYLOAD_BUILDER_H_ */
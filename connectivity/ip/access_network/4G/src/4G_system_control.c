@@ -13,6 +13,7 @@
 #include "u_cell_power_strategy.h" 
 #include "u_device.h"
 #include "sleep_control.h"
+#include "wake_timeline.h"
 
 # ifdef U_CFG_OVERRIDE
 #  include "u_cfg_override.h" // For a customer's configuration override
@@ -20,6 +21,8 @@
 
 static const char *TAG = "4G_SYSTEM_CONTROL";
 
+#define LTE_ACQ_WAIT_MS   60000   // registrado antes das leituras do ciclo: espera até isso
+
 xTaskHandle LTE_System_TaskHandle = NULL;
 extern xTaskHandle network_time_TaskHandle;
 
@@ -30,7 +33,7 @@ extern int32_t cell_OpenDevice_NoReg(uDeviceHandle_t *pDevHandle);
 bool Send_NetConnect_Task_ON=false;
 static void deinit_LTE_System(void);
 //static void cell_Net_Connection_Control(void);
- static void server_connection_control(void);
+ static bool server_connection_control(void);
 
 uDeviceHandle_t devHandle = NULL;
 
@@ -94,7 +97,7 @@ uCellNetStatus_t cell_Net_Connection_Control(void)
  
  } 
  
-static void server_connection_control(void)
+static bool server_connection_control(void)
  {	
 	 bool delivery=false;
      bool keep_registered = false;   // se PSM ou DTR funcionarem, não vamos fazer cleanup
@@ -162,6 +165,7 @@ static void server_connection_control(void)
 }
 
     printf("DELIVERY ====>>> %d\n", delivery);
+    return delivery;
 }
 
 int32_t lte_open_for_sms_if_needed(void)
@@ -191,11 +195,22 @@ static void LTE_System_Task (void* pvParameters)
 
 //DevLteConfig_init ();//Verificar se precisa e melhorar
 
+wake_phase_begin(WAKE_PH_RADIO);
 uCellNetStatus_t net_status = cell_Net_Connection_Control();
+wake_phase_end(WAKE_PH_RADIO);
 
+esp_err_t result = ESP_ERR_TIMEOUT;     // sem registro
 if (net_status==U_CELL_NET_STATUS_REGISTERED_HOME || net_status==U_CELL_NET_STATUS_REGISTERED_ROAMING) {
-	server_connection_control();
+	// O registro corre em paralelo com a aquisição; o envio espera as leituras
+	if (!wake_wait_acquisition(pdMS_TO_TICKS(LTE_ACQ_WAIT_MS))) {
+		ESP_LOGW(TAG, "Aquisição não terminou em %dms; enviando o que houver", LTE_ACQ_WAIT_MS);
+	}
+	wake_phase_begin(WAKE_PH_UPLOAD);
+	result = server_connection_control() ? ESP_OK : ESP_FAIL;
+	wake_phase_end(WAKE_PH_UPLOAD);
 }
+// Antes de baixar o NetConnect: o worker segura o sono até aplicar o backoff
+upload_report_lte_result(result);
 
 /*for (;;){
 	
@@ -5,7 +5,7 @@
  *  mesma lógica do json_data_payload() em server_comm.c:
  *
  *  - Não perde nenhuma linha do SD: todo registro lido entra
- *    no JSON (até MAX_POINTS_TO_SEND).
+ *    no JSON; o que não couber no buffer fica para o próximo lote.
  *  - Usa rec_index.{last_read_idx, last_write_idx, total_idx}
  *    e cursor_position para caminhar corretamente no ring buffer.
  *
@@ -38,6 +38,35 @@
  *      - Só tem DateTime, Pressao (se disponível) e Vazao (se disponível).
  */
 
+/*
+ *  Modo binário (checkbox "Payload LTE: Binário", has_binary_payload()):
+ *  o mesmo conteúdo em CBOR (RFC 8949), Content-Type application/cbor,
+ *  com UMA diferença: o CBOR leva o valor de todo canal que tem valor no
+ *  SD, inclusive os RS-485 (3, 31..39, ...), e o JSON só leva Pressao
+ *  (canais 0/2) e Vazao (canal 1).
+ *  Map com chaves inteiras:
+ *
+ *     0: versão do formato (LTE_CBOR_VERSION)
+ *     1: id
+ *     2: Name   3: Serial Number   4: Phone   (só quando mudaram desde o
+ *        último envio confirmado, ou a cada LTE_CBOR_INFO_EVERY envios)
+ *     5: CSQ
+ *     6: Battery em centivolts (708 => "7.08")
+ *     7: User   8: Password   9: Token       (mesmas regras do JSON)
+ *    10: flags  (bit0 = timestamp_mode: como o backend deve exibir DateTime)
+ *    11: CRC32 de Name/Serial/Phone (o backend usa o cache se 2..4 faltarem)
+ *    12: DateTime do 1º registro, em segundos (mesma base do epoch ms do JSON)
+ *    13: casas decimais por canal {canal: casas} (canais inteiros omitidos)
+ *    14: registros [[dt, canal, valor?], ...]
+ *          dt    = segundos desde o registro anterior (o 1º é relativo à chave 12)
+ *          valor = inteiro escalado pelas casas do canal (37.1 => 371);
+ *                  ausente quando o SD não tem valor
+ *
+ *  Decodificador de referência: tools/lte_cbor_decode.py (descarta os
+ *  valores que o JSON não leva; --selftest compila este arquivo no PC e
+ *  confere o CBOR decodificado contra o JSON dos mesmos registros)
+ */
+
 #include "lte_payload_builder.h"
 
 #include <string.h>
@@ -48,7 +77,10 @@
 #include "datalogger_control.h"
 #include "esp_err.h"
 #include "esp_log.h"
-#include "cJSON.h"
+#include "json_writer.h"
+#include "cbor_writer.h"
+#include "esp_rom_crc.h"
+#include "esp_attr.h"
 
 #include "sdmmc_driver.h"         // struct record_index_config, struct record_data_saved, read_record_sd(), UNSPECIFIC_RECORD
 #include "battery_monitor.h"      // battery_monitor_update(), battery_monitor_get_power_source_voltage()
@@ -63,13 +95,38 @@ bool has_network_http_enabled(void);
 // Checkbox do timestamp em ms (vem da config / factory_control).
 bool has_timestamp_mode(void);*/
 
-// Limite de pontos enviados em um único payload (mesma ideia do server_comm.c)
-#ifndef MAX_POINTS_TO_SEND
-#define MAX_POINTS_TO_SEND 10
-#endif
-
 static const char *TAG = "LTE_PAYLOAD";
 
+#define LTE_CBOR_VERSION      1
+#define LTE_CBOR_INFO_EVERY   24    // reenvia Name/Serial/Phone a cada N envios
+#define LTE_CBOR_RECS_CHUNK   32    // registros lidos crescem no heap de 32 em 32
+
+enum {
+    LTE_CBOR_K_VERSION = 0,
+    LTE_CBOR_K_ID,
+    LTE_CBOR_K_NAME,
+    LTE_CBOR_K_SERIAL,
+    LTE_CBOR_K_PHONE,
+    LTE_CBOR_K_CSQ,
+    LTE_CBOR_K_BATTERY,
+    LTE_CBOR_K_USER,
+    LTE_CBOR_K_PASSWORD,
+    LTE_CBOR_K_TOKEN,
+    LTE_CBOR_K_FLAGS,
+    LTE_CBOR_K_INFO_CRC,
+    LTE_CBOR_K_BASE_TIME,
+    LTE_CBOR_K_DECIMALS,
+    LTE_CBOR_K_RECORDS,
+};
+
+#define LTE_CBOR_FLAG_TIMESTAMP   0x01u
+
+// Identificação enviada por último com sucesso (sobrevive ao deep sleep)
+static RTC_DATA_ATTR uint32_t s_info_crc_sent;
+static RTC_DATA_ATTR uint8_t  s_info_age;
+static uint32_t s_info_crc_pending;
+static bool     s_info_pending;
+
 // ---------------------------------------------------------------------------
 // Converte Data/Hora do SD ("DD/MM/AAAA" e "HH:MM:SS")
 // para epoch em ms, SEM ajustar fuso (NÃO tira 3h, NÃO soma 3h).
@@ -129,6 +186,48 @@ static bool has_meaningful_value(const char *s)
     return (*s != '\0');
 }
 
+// "12.345" => mant=12345, dec=3. false se não for um decimal simples.
+static bool parse_decimal(const char *s, int64_t *mant, uint8_t *dec)
+{
+    while (*s == ' ' || *s == '\t') s++;
+
+    bool neg = false;
+    if (*s == '-' || *s == '+') {
+        neg = (*s == '-');
+        s++;
+    }
+
+    int64_t m = 0;
+    uint8_t d = 0;
+    bool digits = false, point = false;
+    for (; *s; s++) {
+        if (*s >= '0' && *s <= '9') {
+            if (m > (INT64_MAX - 9) / 10) return false;
+            m = m * 10 + (*s - '0');
+            digits = true;
+            if (point) d++;
+        } else if (*s == '.' && !point) {
+            point = true;
+        } else if (*s == ' ' || *s == '\r' || *s == '\n') {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (!digits) return false;
+
+    *mant = neg ? -m : m;
+    *dec  = d;
+    return true;
+}
+
+static int64_t pow10_i64(uint8_t n)
+{
+    int64_t p = 1;
+    while (n--) p *= 10;
+    return p;
+}
+
 esp_err_t lte_json_data_payload(char *buf,
                                 size_t bufSize,
                                 struct record_index_config rec_index,
@@ -142,17 +241,17 @@ esp_err_t lte_json_data_payload(char *buf,
     buf[0] = '\0';
     *counter_out = 0;
 
-    cJSON *root = cJSON_CreateObject();
-    if (!root) {
-        return ESP_FAIL;
-    }
+    // Escreve direto em buf (sem árvore cJSON / heap); mesma saída do PrintUnformatted
+    json_writer_t w;
+    jw_init(&w, buf, bufSize);
+    jw_obj_begin(&w, NULL);
 
     // 1) Campos de identificação, iguais ao server_comm.c
-    cJSON_AddStringToObject(root, "id", get_device_id());
-    cJSON_AddStringToObject(root, "Name", get_name());
-    cJSON_AddStringToObject(root, "Serial Number", get_serial_number());
-    cJSON_AddStringToObject(root, "Phone", get_phone());
-    cJSON_AddNumberToObject(root, "CSQ", get_csq());
+    jw_str(&w, "id", get_device_id());
+    jw_str(&w, "Name", get_name());
+    jw_str(&w, "Serial Number", get_serial_number());
+    jw_str(&w, "Phone", get_phone());
+    jw_num(&w, "CSQ", get_csq());
 
     // 1.1) Battery: leitura da FONTE (não da bateria interna)
     battery_monitor_update();  // garante leitura fresca
@@ -167,26 +266,21 @@ esp_err_t lte_json_data_payload(char *buf,
              bat_str, v_src);
 
     // Envia como string no root para manter 2 casas decimais
-    cJSON_AddStringToObject(root, "Battery", bat_str);
+    jw_str(&w, "Battery", bat_str);
 
     // 1.2) Credenciais opcionais, igual ao server_comm.c
     if (has_network_user_enabled() && !has_network_http_enabled()) {
-        cJSON_AddStringToObject(root, "User", get_network_user());
+        jw_str(&w, "User", get_network_user());
     }
     if (has_network_pw_enabled() && !has_network_http_enabled()) {
-        cJSON_AddStringToObject(root, "Password", get_network_pw());
+        jw_str(&w, "Password", get_network_pw());
     }
     if (has_network_token_enabled() && !has_network_http_enabled()) {
-        cJSON_AddStringToObject(root, "Token", get_network_token());
+        jw_str(&w, "Token", get_network_token());
     }
 
     // 2) Preparar array de medições
-    cJSON *meas_array = cJSON_CreateArray();
-    if (!meas_array) {
-        cJSON_Delete(root);
-        return ESP_FAIL;
-    }
-    cJSON_AddItemToObject(root, "measurements", meas_array);
+    jw_arr_begin(&w, "measurements");
 
     // 3) Calcular index inicial (mesma lógica do json_data_payload)
     uint32_t index;
@@ -207,9 +301,11 @@ esp_err_t lte_json_data_payload(char *buf,
 
     bool send_ms = has_timestamp_mode();
 
-    // 4) Loop de leitura e montagem de cada registro
-    while (*counter_out < MAX_POINTS_TO_SEND) {
+    // 4) Loop de leitura e montagem de cada registro (até o fim dos dados
+    //    ou até o buffer encher)
+    for (;;) {
         struct record_data_saved database;
+        uint32_t cursor_before = *cursor_position;
 
         // read_record_sd atualiza cursor_position conforme rec_index
         if (read_record_sd(cursor_position, &database) != ESP_OK) {
@@ -217,12 +313,6 @@ esp_err_t lte_json_data_payload(char *buf,
             break;
         }
 
-        cJSON *rec_obj = cJSON_CreateObject();
-        if (!rec_obj) {
-            ESP_LOGE(TAG, "lte_json_data_payload: falha ao criar objeto de medição");
-            break;
-        }
-
         // --------------------------------------------------------------------
         // DateTime: baseado em database.date ("DD/MM/AAAA") e database.time ("HH:MM:SS")
         // --------------------------------------------------------------------
@@ -231,13 +321,16 @@ esp_err_t lte_json_data_payload(char *buf,
             ESP_LOGE(TAG,
                      "lte_json_data_payload: falha na conversão Data/Hora -> ms (%s %s)",
                      database.date, database.time);
-            cJSON_Delete(rec_obj);
             break;
         }
 
+        json_writer_mark_t mark;
+        jw_mark(&w, &mark);
+        jw_obj_begin(&w, NULL);
+
         if (send_ms) {
             // Modo timestamp: DateTime numérico (epoch ms), sem mexer em fuso
-            cJSON_AddNumberToObject(rec_obj, "DateTime", (double) datetime_ms);
+            jw_num(&w, "DateTime", (double) datetime_ms);
         } else {
             // Modo string: "AAAA-MM-DDTHH:MM:SS.000-03:00" com a MESMA hora gravada no SD
             int day, mon, year;
@@ -249,7 +342,7 @@ esp_err_t lte_json_data_payload(char *buf,
                 ESP_LOGE(TAG,
                          "lte_json_data_payload: falha ao parsear Data/Hora para string ISO (%s %s)",
                          database.date, database.time);
-                cJSON_Delete(rec_obj);
+                jw_rewind(&w, &mark);
                 break;
             }
 
@@ -258,13 +351,13 @@ esp_err_t lte_json_data_payload(char *buf,
                      "%04d-%02d-%02dT%02d:%02d:%02d.000-03:00",
                      year, mon, day, hh, mm, ss);
 
-            cJSON_AddStringToObject(rec_obj, "DateTime", datetime_str);
+            jw_str(&w, "DateTime", datetime_str);
         }
         
         // --------------------------------------------------------------------
         // Canal: sempre incluído, vem direto da tabela do SD
         // --------------------------------------------------------------------
-        cJSON_AddNumberToObject(rec_obj, "Canal", database.channel);        
+        jw_num(&w, "Canal", database.channel);        
 
 // --------------------------------------------------------------------
         // Pressao / Vazao
@@ -285,11 +378,11 @@ esp_err_t lte_json_data_payload(char *buf,
             switch (database.channel) {
             case 0: // Pressão 1
             case 2: // Pressão 2
-                cJSON_AddNumberToObject(rec_obj, "Pressao", valor);
+                jw_num(&w, "Pressao", valor);
                 break;
 
             case 1: // Vazão
-                cJSON_AddNumberToObject(rec_obj, "Vazao", valor);
+                jw_num(&w, "Vazao", valor);
                 break;
 
             default:
@@ -299,8 +392,16 @@ esp_err_t lte_json_data_payload(char *buf,
         }
         // Se não tiver valor, fica só DateTime + Canal.
 
-        // Adiciona ao array de medições
-        cJSON_AddItemToArray(meas_array, rec_obj);
+        jw_obj_end(&w);
+
+        // Não coube no buffer: o registro fica para o próximo envio
+        if (!jw_can_close(&w)) {
+            jw_rewind(&w, &mark);
+            *cursor_position = cursor_before;
+            ESP_LOGW(TAG, "lte_json_data_payload: buffer cheio com %u registros.",
+                     (unsigned)(*counter_out));
+            break;
+        }
 
         (*counter_out)++;
 
@@ -322,28 +423,308 @@ esp_err_t lte_json_data_payload(char *buf,
         index = (index + 1) % rec_index.total_idx;
     }
 
-    // 5) Serializa em buffer
-    char *p = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    if (!p) {
-        return ESP_FAIL;
-    }
+    jw_arr_end(&w);
+    jw_obj_end(&w);
 
-    size_t len = strlen(p);
-    if (len + 1 > bufSize) {
+    // 5) Fecha o texto em buf
+    size_t len = 0;
+    if (jw_finish(&w, &len) != ESP_OK) {
         ESP_LOGE(TAG,
                  "lte_json_data_payload: buffer insuficiente (%u < %u).",
                  (unsigned)bufSize, (unsigned)(len + 1));
-        free(p);
         return ESP_FAIL;
     }
 
-    memcpy(buf, p, len + 1);
-    free(p);
-
     ESP_LOGI(TAG,
-             "lte_json_data_payload: enviados %u registros (MAX=%d).",
-             (unsigned)(*counter_out), MAX_POINTS_TO_SEND);
+             "lte_json_data_payload: %u registros em %u bytes (buffer %u).",
+             (unsigned)(*counter_out), (unsigned)len, (unsigned)bufSize);
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+// ---------------------------------------------------------------------------
+// Payload binário (CBOR)
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t cursor_before;   // para devolver o registro se não couber
+    int64_t  secs;
+    uint8_t  channel;
+    bool     has_value;
+    uint8_t  dec;
+    int64_t  mant;
+} lte_cbor_rec_t;
+
+static uint32_t device_info_crc(void)
+{
+    const char *f[] = { get_name(), get_serial_number(), get_phone() };
+    uint32_t crc = 0;
+    for (size_t i = 0; i < sizeof(f) / sizeof(f[0]); i++) {
+        const char *v = f[i] ? f[i] : "";
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)v, strlen(v) + 1);
+    }
+    return crc;
+}
+
+// Bytes do registro no array, na escala dele: o mínimo que ele ocupa no
+// payload (a escala do canal no lote só pode aumentar o valor)
+static size_t cbor_rec_min_len(const lte_cbor_rec_t *r, int64_t prev_secs)
+{
+    cbor_writer_t m;
+    cw_init(&m, NULL, 0);
+    cw_array(&m, r->has_value ? 3 : 2);
+    cw_int(&m, r->secs - prev_secs);
+    cw_uint(&m, r->channel);
+    if (r->has_value) cw_int(&m, r->mant);
+    return m.len;
+}
+
+static void cbor_encode(cbor_writer_t *w,
+                        const lte_cbor_rec_t *recs, size_t n,
+                        bool with_info, uint32_t info_crc,
+                        uint32_t centivolts, uint8_t flags)
+{
+    bool with_user  = has_network_user_enabled()  && !has_network_http_enabled();
+    bool with_pw    = has_network_pw_enabled()    && !has_network_http_enabled();
+    bool with_token = has_network_token_enabled() && !has_network_http_enabled();
+
+    // Casas decimais por canal: a maior do lote (valores re-escalados para ela)
+    uint8_t ch_dec[256] = {0};
+    size_t n_dec = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (recs[i].has_value && recs[i].dec > ch_dec[recs[i].channel]) {
+            if (ch_dec[recs[i].channel] == 0) n_dec++;
+            ch_dec[recs[i].channel] = recs[i].dec;
+        }
+    }
+
+    size_t keys = 8 + (with_info ? 3 : 0) + with_user + with_pw + with_token
+                + (n_dec ? 1 : 0);
+    cw_map(w, keys);
+
+    cw_uint(w, LTE_CBOR_K_VERSION);  cw_uint(w, LTE_CBOR_VERSION);
+    cw_uint(w, LTE_CBOR_K_ID);       cw_text(w, get_device_id());
+    if (with_info) {
+        cw_uint(w, LTE_CBOR_K_NAME);   cw_text(w, get_name());
+        cw_uint(w, LTE_CBOR_K_SERIAL); cw_text(w, get_serial_number());
+        cw_uint(w, LTE_CBOR_K_PHONE);  cw_text(w, get_phone());
+    }
+    cw_uint(w, LTE_CBOR_K_CSQ);      cw_uint(w, get_csq());
+    cw_uint(w, LTE_CBOR_K_BATTERY);  cw_uint(w, centivolts);
+    if (with_user) {
+        cw_uint(w, LTE_CBOR_K_USER);     cw_text(w, get_network_user());
+    }
+    if (with_pw) {
+        cw_uint(w, LTE_CBOR_K_PASSWORD); cw_text(w, get_network_pw());
+    }
+    if (with_token) {
+        cw_uint(w, LTE_CBOR_K_TOKEN);    cw_text(w, get_network_token());
+    }
+    cw_uint(w, LTE_CBOR_K_FLAGS);    cw_uint(w, flags);
+    cw_uint(w, LTE_CBOR_K_INFO_CRC); cw_uint(w, info_crc);
+    cw_uint(w, LTE_CBOR_K_BASE_TIME);
+    cw_int(w, n ? recs[0].secs : 0);
+
+    if (n_dec) {
+        cw_uint(w, LTE_CBOR_K_DECIMALS);
+        cw_map(w, n_dec);
+        for (int ch = 0; ch < 256; ch++) {
+            if (ch_dec[ch]) {
+                cw_uint(w, (uint64_t)ch);
+                cw_uint(w, ch_dec[ch]);
+            }
+        }
+    }
+
+    cw_uint(w, LTE_CBOR_K_RECORDS);
+    cw_array(w, n);
+    int64_t prev = n ? recs[0].secs : 0;
+    for (size_t i = 0; i < n; i++) {
+        const lte_cbor_rec_t *r = &recs[i];
+        cw_array(w, r->has_value ? 3 : 2);
+        cw_int(w, r->secs - prev);
+        cw_uint(w, r->channel);
+        if (r->has_value) {
+            cw_int(w, r->mant * pow10_i64(ch_dec[r->channel] - r->dec));
+        }
+        prev = r->secs;
+    }
+}
+
+esp_err_t lte_cbor_data_payload(uint8_t *buf,
+                                size_t bufSize,
+                                struct record_index_config rec_index,
+                                uint32_t *counter_out,
+                                uint32_t *cursor_position,
+                                size_t *len_out)
+{
+    if (!buf || bufSize == 0 || !counter_out || !cursor_position || !len_out) {
+        return ESP_FAIL;
+    }
+
+    *counter_out = 0;
+    *len_out = 0;
+
+    battery_monitor_update();
+    float v_src = battery_monitor_get_power_source_voltage();
+    uint32_t centivolts = v_src > 0.0f ? (uint32_t)lroundf(v_src * 100.0f) : 0;
+
+    // 1) Lê os registros (mesma caminhada do JSON) enquanto ainda podem
+    //    caber: a soma dos tamanhos mínimos já passa de bufSize => para
+    lte_cbor_rec_t *recs = NULL;
+    size_t n = 0, n_cap = 0;
+    size_t min_len = 0;
+
+    uint32_t index;
+    if (rec_index.total_idx == 0) {
+        index = 0;
+    } else {
+        index = (rec_index.last_read_idx + 1) % rec_index.total_idx;
+    }
+    *cursor_position = rec_index.cursor_position;
+
+    for (;;) {
+        struct record_data_saved database;
+        uint32_t cursor_before = *cursor_position;
+
+        if (n == n_cap) {
+            lte_cbor_rec_t *grown = realloc(recs, (n_cap + LTE_CBOR_RECS_CHUNK) * sizeof(*recs));
+            if (!grown) {
+                ESP_LOGW(TAG, "lte_cbor_data_payload: sem memória com %u registros", (unsigned)n);
+                break;
+            }
+            recs = grown;
+            n_cap += LTE_CBOR_RECS_CHUNK;
+        }
+
+        if (read_record_sd(cursor_position, &database) != ESP_OK) {
+            ESP_LOGW(TAG, "lte_cbor_data_payload: falha ao ler registro SD no index %u", index);
+            break;
+        }
+
+        int64_t datetime_ms = 0;
+        if (!sd_datetime_to_ms_no_tz(database.date, database.time, &datetime_ms)) {
+            ESP_LOGE(TAG,
+                     "lte_cbor_data_payload: falha na conversão Data/Hora -> ms (%s %s)",
+                     database.date, database.time);
+            break;
+        }
+
+        lte_cbor_rec_t *r = &recs[n];
+        r->cursor_before = cursor_before;
+        r->secs      = datetime_ms / 1000;
+        r->channel   = database.channel;
+        r->has_value = false;
+        if (has_meaningful_value(database.data)) {
+            r->has_value = true;
+            if (!parse_decimal(database.data, &r->mant, &r->dec)) {
+                // Texto fora do padrão: mesmo valor que o atof() do JSON, 3 casas
+                r->mant = llround(atof(database.data) * 1000.0);
+                r->dec  = 3;
+            }
+        }
+
+        min_len += cbor_rec_min_len(r, n ? recs[n - 1].secs : r->secs);
+        if (min_len > bufSize) {
+            *cursor_position = cursor_before;   // já não cabe: fica para o próximo lote
+            break;
+        }
+        n++;
+
+        if (rec_index.last_write_idx == UNSPECIFIC_RECORD) {
+            if (index == rec_index.total_idx - 1) {
+                break;
+            }
+        } else {
+            if (index == rec_index.last_write_idx) {
+                break;
+            }
+        }
+
+        if (rec_index.total_idx == 0) {
+            break;
+        }
+        index = (index + 1) % rec_index.total_idx;
+    }
+
+    // 2) Codifica; se não couber, devolve registros do fim até caber
+    uint32_t info_crc = device_info_crc();
+    bool with_info = (info_crc != s_info_crc_sent) || (s_info_age >= LTE_CBOR_INFO_EVERY);
+    uint8_t flags = has_timestamp_mode() ? LTE_CBOR_FLAG_TIMESTAMP : 0;
+
+    // O tamanho só cresce com n: procura o maior n que cabe medindo
+    cbor_writer_t w;
+    cw_init(&w, NULL, 0);
+    cbor_encode(&w, recs, n, with_info, info_crc, centivolts, flags);
+    if (w.len > bufSize && n > 0) {
+        size_t lo = 0, hi = n;   // cabe com lo, não cabe com hi
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            cw_init(&w, NULL, 0);
+            cbor_encode(&w, recs, mid, with_info, info_crc, centivolts, flags);
+            if (w.len <= bufSize) lo = mid;
+            else                  hi = mid;
+        }
+        n = lo;
+        *cursor_position = recs[n].cursor_before;
+    }
+
+    cw_init(&w, buf, bufSize);
+    cbor_encode(&w, recs, n, with_info, info_crc, centivolts, flags);
+    free(recs);
+
+    size_t len = 0;
+    if (cw_finish(&w, &len) != ESP_OK) {
+        ESP_LOGE(TAG, "lte_cbor_data_payload: buffer insuficiente (%u < %u).",
+                 (unsigned)bufSize, (unsigned)len);
+        return ESP_FAIL;
+    }
+
+    s_info_crc_pending = info_crc;
+    s_info_pending     = with_info;
+
+    *counter_out = n;
+    *len_out = len;
+
+    ESP_LOGI(TAG, "lte_cbor_data_payload: %u registros em %u bytes%s.",
+             (unsigned)n, (unsigned)len, with_info ? " (com identificação)" : "");
+    return ESP_OK;
+}
+
+esp_err_t lte_data_payload(char *buf,
+                           size_t bufSize,
+                           struct record_index_config rec_index,
+                           uint32_t *counter_out,
+                           uint32_t *cursor_position,
+                           size_t *len_out,
+                           const char **content_type_out)
+{
+    if (!len_out) {
+        return ESP_FAIL;
+    }
+
+    if (has_binary_payload()) {
+        if (content_type_out) *content_type_out = LTE_PAYLOAD_CONTENT_TYPE_CBOR;
+        return lte_cbor_data_payload((uint8_t *)buf, bufSize, rec_index,
+                                     counter_out, cursor_position, len_out);
+    }
+
+    if (content_type_out) *content_type_out = LTE_PAYLOAD_CONTENT_TYPE_JSON;
+    esp_err_t err = lte_json_data_payload(buf, bufSize, rec_index, counter_out, cursor_position);
+    *len_out = (err == ESP_OK) ? strlen(buf) : 0;
+    s_info_pending = false;
+    return err;
+}
+
+void lte_payload_delivered(void)
+{
+    if (!has_binary_payload()) {
+        return;
+    }
+    if (s_info_pending) {
+        s_info_crc_sent = s_info_crc_pending;
+        s_info_age = 0;
+    } else if (s_info_age < UINT8_MAX) {
+        s_info_age++;
+    }
+    s_info_pending = false;
+}
@@ -134,7 +134,10 @@
 //#define U_CELL_FILE_NAME "server_data.txt"
 #define U_CELL_FILE_NAME  "server_data.json"
 
-#define MAX_POINTS_TO_SEND 10
+// Corpo do POST (arquivo no módulo): o lote leva quantos registros couberem
+#ifndef LTE_HTTP_PAYLOAD_MAX
+#define LTE_HTTP_PAYLOAD_MAX 8192
+#endif
 
 #define TAGOIO            1
 
@@ -410,7 +413,7 @@ static bool waitCheckHttpResponse(uint32_t timeoutSeconds,
 /** Writing data into file.
  */
 //static void cellFileWrite(uDeviceHandle_t devHandle, char *data)
-static void setup_file_params(uDeviceHandle_t devHandle, char *server_payload)
+static void setup_file_params(uDeviceHandle_t devHandle, char *server_payload, size_t length)
 {
 /*struct record_index_config rec_index = {0};
 char server_payload[5000] = {0};*/
@@ -431,7 +434,6 @@ printf(">>>>>>CURSOR POSITION<<<<<<%d \n", cursor_position);*/
  //============================================   
     int32_t result;
     size_t y = 1;
-    size_t length = strlen(server_payload);
 
     // Make sure the test file name has been deleted in case a
     // previous test was aborted half way
@@ -537,7 +539,6 @@ static void cellFileRead(uDeviceHandle_t devHandle)
 bool ucell_Http_connection(uDeviceHandle_t devHandle)
 {
  struct record_index_config rec_index = {0};
- char server_payload[5000] = {0};
  uint32_t counter = 0;
 
     int32_t error;
@@ -649,7 +650,13 @@ printf(">>>>>>Last Write Index= %d\n",rec_index.last_write_idx);*/
 
 
 
-esp_err_t err = lte_json_data_payload(server_payload, sizeof(server_payload),rec_index, &counter, &cursor_position);
+size_t payload_len = 0;
+const char *content_type = LTE_PAYLOAD_CONTENT_TYPE_JSON;
+char *server_payload = malloc(LTE_HTTP_PAYLOAD_MAX);
+esp_err_t err = server_payload
+              ? lte_data_payload(server_payload, LTE_HTTP_PAYLOAD_MAX, rec_index, &counter, &cursor_position,
+                                 &payload_len, &content_type)
+              : ESP_ERR_NO_MEM;
     
     if (err != ESP_OK) {
         printf("Erro ao montar o payload JSON: %d", err);
@@ -658,7 +665,10 @@ esp_err_t err = lte_json_data_payload(server_payload, sizeof(server_payload),rec
 printf(">>>>>>CURSOR POSITION<<<<<<%d \n", cursor_position);
   
  
-   setup_file_params(devHandle,server_payload);
+   if (server_payload) {
+       setup_file_params(devHandle, server_payload, payload_len);
+       free(server_payload);
+   }
 
       uPortTaskBlock(500);    
                           
@@ -681,7 +691,7 @@ printf(">>>>>>CURSOR POSITION<<<<<<%d \n", cursor_position);
                                     U_CELL_HTTP_REQUEST_POST,
                                     pathBuffer, NULL,
                                     U_CELL_FILE_NAME,
-                                    "application/json");
+                                    content_type);
                                     
         printf(">>>>>>>>>>Erro http request = %ld<<<<<<<<<<<\n", error);
                                                                                                                                
@@ -728,6 +738,7 @@ printf(">>>>>>CURSOR POSITION<<<<<<%d \n", cursor_position);
         rec_index.cursor_position= cursor_position;
 
         save_index_config(&rec_index);
+        lte_payload_delivered();
         printf("+++++SUCESSO++++\n");
         http_request_delivery=true;
     }
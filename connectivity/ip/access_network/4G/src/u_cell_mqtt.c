@@ -40,6 +40,8 @@
 # include "u_wifi_test_cfg.h"
 #endif
 
+#include "u_cell_private.h" // So that we can get at some innards
+
 #include "sara_r422.h"
 #include "datalogger_control.h"
 
@@ -47,9 +49,26 @@
 
 #include "sdmmc_driver.h"
 #include "lte_payload_builder.h"
+#include "battery_monitor.h"
+#include "esp_timer.h"
 
 static const char *TAG = "MQTT_CELL";
 
+// Sessão de envio: mesma política do mqtt_tcp.c (Wi-Fi). O SARA confirma
+// cada publish antes de devolver, então os lotes vão em sequência (sem janela).
+#ifndef LTE_MQTT_STREAM_BUDGET_MS
+#define LTE_MQTT_STREAM_BUDGET_MS    60000    // tempo máximo de sessão
+#endif
+#ifndef LTE_MQTT_STREAM_MAX_BATCHES
+#define LTE_MQTT_STREAM_MAX_BATCHES  500
+#endif
+#define LTE_MQTT_STREAM_LOW_SOC      0.20f    // na bateria, abaixo disso envia só 1 lote
+
+static bool lte_stream_low_energy(void)
+{
+    return !battery_monitor_power_source_ok() && battery_monitor_get_soc() < LTE_MQTT_STREAM_LOW_SOC;
+}
+
 /** The string to put at the start of all prints from this test.
  */
 #define U_TEST_PREFIX "U_CELL_HTTP_TEST: "
@@ -448,7 +467,16 @@ bool ucell_MqttClient_connection (uDeviceHandle_t devHandle){
     uSecurityTlsSettings_t tlsSettings = U_SECURITY_TLS_SETTINGS_DEFAULT;
 
     struct record_index_config rec_mqtt_index = {0};
-    const size_t MQTT_PAYLOAD_SIZE = 5000;
+    // Lote = o maior publish que o módulo aceita (binário 1024 B; sem o modo
+    // binário o texto vai em hex, 512 B de dados). O builder enche até aí.
+    const uCellPrivateModule_t *pModule = pUCellPrivateGetModule(devHandle);
+    const size_t publish_max =
+        ((pModule && U_CELL_PRIVATE_HAS(pModule, U_CELL_PRIVATE_FEATURE_MQTT_BINARY_PUBLISH)) ||
+         !has_binary_payload())
+            ? U_CELL_MQTT_PUBLISH_BIN_MAX_LENGTH_BYTES
+            : U_CELL_MQTT_PUBLISH_HEX_MAX_LENGTH_BYTES;
+    // JSON precisa do '\0' no buffer; CBOR não
+    const size_t MQTT_PAYLOAD_SIZE = publish_max + (has_binary_payload() ? 0 : 1);
     char *mqtt_payload = malloc(MQTT_PAYLOAD_SIZE * sizeof(char));
     if (mqtt_payload == NULL) {
         printf("Falha ao alocar memória para mqtt_payload\n");
@@ -457,6 +485,7 @@ bool ucell_MqttClient_connection (uDeviceHandle_t devHandle){
 
     uint32_t counter = 0;
     uint32_t cursor_position = 0;
+    size_t payload_len = 0;
     char buffer[512];
     size_t bufferSize;
     char MY_BROKER[64];
@@ -509,18 +538,24 @@ bool ucell_MqttClient_connection (uDeviceHandle_t devHandle){
     get_index_config(&rec_mqtt_index);
     
 //    esp_err_t err = json_data_payload(mqtt_payload, MQTT_PAYLOAD_SIZE, rec_mqtt_index, &counter, &cursor_position);
-       esp_err_t err = lte_json_data_payload(mqtt_payload,
+       esp_err_t err = lte_data_payload(mqtt_payload,
                          MQTT_PAYLOAD_SIZE,
                          rec_mqtt_index,
                          &counter,
-                         &cursor_position);
+                         &cursor_position,
+                         &payload_len,
+                         NULL);
     if (err != ESP_OK) {
         uPortLog("Erro ao montar o payload JSON: %d\n", err);
         free(mqtt_payload);
         return mqtt_publish_delivery=false; ;
     }   
         
-    ESP_LOGI(TAG, "MQTT Payload JSON: %s", mqtt_payload);  
+    if (has_binary_payload()) {
+        ESP_LOGI(TAG, "MQTT Payload CBOR: %u bytes, %u registros", (unsigned)payload_len, (unsigned)counter);
+    } else {
+        ESP_LOGI(TAG, "MQTT Payload JSON: %s", mqtt_payload);
+    }
 
     pContext = pUMqttClientOpen(devHandle, NULL);
     if (pContext != NULL) {
@@ -542,7 +577,7 @@ bool ucell_MqttClient_connection (uDeviceHandle_t devHandle){
 
             uPortLog("Subscribing to topic \"%s\" (QoS %u)...\n", receive_topic, qos_cfg);
             if (uMqttClientSubscribe(pContext, receive_topic, qos_enum) >= 0) {
-                uPortLog("Publishing \"%s\" to topic \"%s\" (QoS %u)...\n", mqtt_payload, send_topic, qos_cfg);
+                uPortLog("Publishing %u bytes to topic \"%s\" (QoS %u)...\n", (unsigned)payload_len, send_topic, qos_cfg);
   //-------------------------------------------------------------------------------                
          /*       timeoutStart = uTimeoutStart();
                 if (uMqttClientPublish(pContext, send_topic, mqtt_payload, strlen(mqtt_payload),
@@ -552,19 +587,50 @@ bool ucell_MqttClient_connection (uDeviceHandle_t devHandle){
 // então mqtt_should_retain(send_topic) retornará false (pois não termina com "/confirm").
 bool retain_flag_send = mqtt_should_retain(send_topic);
 
+                 // Drena o backlog na mesma conexão: cada lote aceito avança o
+                 // índice de leitura; para no fim dos dados, no orçamento de
+                 // tempo/lotes ou com bateria baixa
+                 uint64_t t0_us = esp_timer_get_time();
+                 uint32_t max_batches = lte_stream_low_energy() ? 1 : LTE_MQTT_STREAM_MAX_BATCHES;
+                 uint32_t sent_batches = 0, sent_points = 0;
+                 struct record_index_config stage = rec_mqtt_index;   // posição de montagem
+
                  timeoutStart = uTimeoutStart();
-                 if (uMqttClientPublish(pContext,
-                       send_topic,
-                       mqtt_payload,
-                       strlen(mqtt_payload),
-                       qos_enum,
-                       retain_flag_send) == 0) {                       
+                 for (;;) {
+                     if (uMqttClientPublish(pContext, send_topic, mqtt_payload, payload_len,
+                                            qos_enum, retain_flag_send) != 0) {
+                         uPortLog("Unable to publish our message (%u bytes)!\n", (unsigned)payload_len);
+                         break;
+                     }
+                     advance_read_index(counter, cursor_position);
+                     lte_payload_delivered();
+                     sent_batches++;
+                     sent_points += counter;
+                     ESP_LOGI(TAG, "MQTT lote %u: %u registro(s), %u bytes",
+                              (unsigned)sent_batches, (unsigned)counter, (unsigned)payload_len);
+
+                     if (sent_batches >= max_batches ||
+                         (esp_timer_get_time() - t0_us) / 1000ULL >= LTE_MQTT_STREAM_BUDGET_MS) {
+                         break;
+                     }
+                     stage.cursor_position = cursor_position;
+                     counter = 0;
+                     if (lte_data_payload(mqtt_payload, MQTT_PAYLOAD_SIZE, stage, &counter,
+                                          &cursor_position, &payload_len, NULL) != ESP_OK ||
+                         counter == 0) {
+                         break;
+                     }
+                 }
+
+                 uint64_t session_ms = (esp_timer_get_time() - t0_us) / 1000ULL;
+                 ESP_LOGI("MQTT/TIME", "LTE session=%llums batches=%u points=%u rate=%u pts/s",
+                          (unsigned long long)session_ms, (unsigned)sent_batches, (unsigned)sent_points,
+                          (unsigned)(session_ms ? (sent_points * 1000ULL) / session_ms : sent_points));
+
+                 if (sent_batches > 0) {
                     success = true;
                     uPortLog("Message successfully published on topic \"%s\".\n", send_topic);
                     
-                    size_t payload_len = strlen(mqtt_payload);
-                    ESP_LOGI(TAG, "MQTT Payload (%u bytes): %s",(unsigned)payload_len, mqtt_payload);
-                    
                     uPortLog("Checking for pending MQTT commands (retain/confirm)...\n");
                     
                     // Processar mensagens recebidas
@@ -606,9 +672,6 @@ bool retain_flag_send = mqtt_should_retain(send_topic);
                             }*/
                         }
                     }
-                } else {
-                    uPortLog("Unable to publish our message \"%s\"!\n", mqtt_payload);
-                   
                 }
             } else {
                 uPortLog("Unable to subscribe to topic \"%s\"!\n", receive_topic);
@@ -636,15 +699,7 @@ bool retain_flag_send = mqtt_should_retain(send_topic);
 	    time_t now;
         time(&now);
         set_last_data_sent(now);
-        
-        if (rec_mqtt_index.total_idx == 0) {
-            printf("Erro: total_idx é zero, evitando divisão por zero\n");
-        } else {
-            rec_mqtt_index.last_read_idx = ((rec_mqtt_index.last_read_idx + counter) & UNSPECIFIC_RECORD) % rec_mqtt_index.total_idx;
-        }
-        rec_mqtt_index.cursor_position = cursor_position;
-
-        save_index_config(&rec_mqtt_index);
+        // índice e identificação já avançados por lote dentro da sessão
         printf("++++MQTT SUCESSO++++\n");
         mqtt_publish_delivery=true;
     } else {
@@ -0,0 +1,88 @@
+/*
+ * wifi_fast_connect.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Reconexão rápida do STA entre deep sleeps.
+ *
+ * Depois de um GOT_IP bem-sucedido guardamos em RTC (RTC_DATA_ATTR) o BSSID
+ * e o canal do AP, o PMK já derivado da senha e o lease DHCP (IP, máscara,
+ * gateway, DNS). Na ativação seguinte o STA associa direto naquele BSSID/
+ * canal (sem varredura de todos os canais), usa o PMK em hex (sem as 4096
+ * iterações do PBKDF2) e, acordando do deep sleep antes do T1 do lease (o
+ * prazo de renovação que o servidor deu), sobe com IP fixo (sem a troca
+ * DHCP). Qualquer falha no caminho rápido invalida
+ * o cache e volta ao caminho completo: varredura + senha + DHCP.
+ *
+ * O cache também guarda os endereços resolvidos dos servidores, com TTL:
+ * o publicador conecta direto no endereço guardado, sem esperar o DNS a
+ * cada ativação.
+ */
+
+#ifndef CONNECTIVITY_IP_ACCESS_NETWORK_WIFI_INCLUDE_WIFI_FAST_CONNECT_H_
+#define CONNECTIVITY_IP_ACCESS_NETWORK_WIFI_INCLUDE_WIFI_FAST_CONNECT_H_
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_netif.h"
+#include "esp_wifi_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WIFI_FAST_DNS_TTL_S       3600   // endereço resolvido vale 1 h
+#define WIFI_FAST_TIMEOUT_MS      3000   // caminho rápido sem associar → fallback
+
+/**
+ * @brief Se há cache válido para estas credenciais, prepara o caminho rápido:
+ *        BSSID/canal/PMK em 'wc' e, com lease recente, IP fixo em 'sta'.
+ * @return true se o caminho rápido foi armado.
+ */
+bool wifi_fast_connect_prepare(wifi_config_t *wc, esp_netif_t *sta,
+                               const char *ssid, const char *pwd);
+
+/** @brief Caminho rápido armado e ainda não confirmado/descartado. */
+bool wifi_fast_connect_active(void);
+
+/** @brief Reaplica BSSID/canal/PMK em 'wc' enquanto o caminho rápido estiver ativo. */
+void wifi_fast_connect_apply(wifi_config_t *wc);
+
+/** @brief Chamar no GOT_IP: grava AP/lease no cache e encerra o caminho rápido. */
+void wifi_fast_connect_on_got_ip(esp_netif_t *sta, const esp_netif_ip_info_t *ip);
+
+/**
+ * @brief Caminho rápido falhou: invalida o cache e volta ao DHCP.
+ * @return true se havia caminho rápido ativo (o chamador refaz a config completa).
+ */
+bool wifi_fast_connect_fallback(esp_netif_t *sta);
+
+/** @brief Esquece AP/lease (ex.: credenciais trocadas no portal). */
+void wifi_fast_connect_invalidate(void);
+
+/** @brief ms desde o wake até o último GOT_IP (0 = ainda sem IP). */
+uint32_t wifi_fast_connect_link_ms(void);
+
+/** @brief true se o último GOT_IP veio do caminho rápido. */
+bool wifi_fast_connect_last_was_fast(void);
+
+/**
+ * @brief Resolve 'host' usando o cache com TTL; só consulta o DNS quando o
+ *        endereço não está no cache ou venceu.
+ * @param ipv4_out  endereço em ordem de rede (pode ser NULL).
+ * @param timeout_ms  <= 0: só o cache, sem consulta.
+ * @return ESP_OK, ESP_ERR_TIMEOUT se o DNS não respondeu em 'timeout_ms'.
+ */
+esp_err_t wifi_fast_resolve(const char *host, uint32_t *ipv4_out, int timeout_ms);
+
+/** @brief Descarta o endereço guardado de 'host' (ex.: conexão nele falhou). */
+void wifi_fast_dns_forget(const char *host);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_IP_ACCESS_NETWORK_WIFI_INCLUDE_WIFI_FAST_CONNECT_H_ */
@@ -0,0 +1,350 @@
+/*
+ * wifi_fast_connect.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "wifi_fast_connect.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/pkcs5.h"
+#include <lwip/dhcp.h>
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+
+static const char *TAG = "WiFi Fast";
+
+#define FAST_MAGIC          0x57464332u   // "WFC2" (v1 não guardava o T1)
+#define FAST_DNS_SLOTS      2
+#define FAST_TIME_VALID     1600000000    // relógio ainda não acertado → sem lease
+
+typedef struct {
+    uint32_t magic;
+    uint32_t cred_crc;      // ssid+senha: troca no portal invalida tudo
+    uint8_t  bssid[6];
+    uint8_t  channel;
+    uint8_t  has_pmk;
+    uint8_t  pmk[32];
+    uint32_t ip, netmask, gw, dns;
+    int64_t  lease_at;      // epoch do último DHCP (0 = sem lease)
+    uint32_t lease_t1_s;    // T1 (renovação) dado pelo servidor; 0 = desconhecido
+    uint32_t crc;
+} fast_cache_t;
+
+typedef struct {
+    char     host[64];
+    uint32_t ip;            // ordem de rede
+    int64_t  expires;       // epoch
+} fast_dns_t;
+
+// Zeram no power-on, atravessam o deep sleep
+RTC_DATA_ATTR static fast_cache_t s_fc;
+RTC_DATA_ATTR static fast_dns_t   s_dns[FAST_DNS_SLOTS];
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool s_active;        // caminho rápido armado nesta ativação
+static volatile bool s_last_fast;
+static volatile uint32_t s_link_ms;
+static uint32_t s_cred_crc;
+static char s_ssid[33];
+static char s_pwd[65];
+static volatile bool s_pmk_inflight;
+
+static uint32_t cache_crc(const fast_cache_t *c)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)c, offsetof(fast_cache_t, crc));
+}
+
+static bool cache_valid(void)
+{
+    return s_fc.magic == FAST_MAGIC && s_fc.crc == cache_crc(&s_fc) &&
+           s_fc.cred_crc == s_cred_crc && s_fc.channel != 0;
+}
+
+static void cache_seal(void)
+{
+    s_fc.magic = FAST_MAGIC;
+    s_fc.crc   = cache_crc(&s_fc);
+}
+
+// O IP fixo não passa pelo servidor DHCP: só vale acordando do deep sleep
+// e antes do T1 do lease, quando o próprio cliente DHCP já iria renovar
+// (metade do lease, se o servidor não mandou a opção 58). Depois de um reset
+// (WDT, panic, brown-out) a RTC também sobrevive, mas o tempo fora do ar é
+// desconhecido: DHCP de novo.
+static bool lease_fresh(void)
+{
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP) return false;
+    time_t now = time(NULL);
+    return s_fc.lease_at > 0 && s_fc.ip != 0 && s_fc.lease_t1_s != 0 && now > FAST_TIME_VALID &&
+           now >= s_fc.lease_at && (now - s_fc.lease_at) < (int64_t)s_fc.lease_t1_s;
+}
+
+// T1 do lease em vigor, como o lwIP o guardou do ACK (lease/2 sem a opção 58).
+// Lido no GOT_IP, logo depois do ACK que o preencheu.
+static uint32_t dhcp_lease_t1_s(esp_netif_t *sta)
+{
+    struct netif *nif = sta ? esp_netif_get_netif_impl(sta) : NULL;
+    struct dhcp *d = nif ? netif_dhcp_data(nif) : NULL;
+    if (!d || d->offered_t0_lease == 0) return 0;
+    uint32_t t1 = d->offered_t1_renew;
+    if (t1 == 0 || t1 > d->offered_t0_lease) t1 = d->offered_t0_lease / 2;
+    return t1;
+}
+
+static void pmk_to_hex(const uint8_t *pmk, uint8_t *out, size_t out_len)
+{
+    static const char hex[] = "0123456789abcdef";
+    memset(out, 0, out_len);
+    for (int i = 0; i < 32 && (size_t)(2 * i + 1) < out_len; i++) {
+        out[2 * i]     = hex[pmk[i] >> 4];
+        out[2 * i + 1] = hex[pmk[i] & 0x0f];
+    }
+}
+
+bool wifi_fast_connect_prepare(wifi_config_t *wc, esp_netif_t *sta,
+                               const char *ssid, const char *pwd)
+{
+    memset(s_ssid, 0, sizeof(s_ssid));
+    memset(s_pwd,  0, sizeof(s_pwd));
+    if (ssid) strncpy(s_ssid, ssid, sizeof(s_ssid) - 1);
+    if (pwd)  strncpy(s_pwd,  pwd,  sizeof(s_pwd)  - 1);
+    s_cred_crc = esp_rom_crc32_le(0, (const uint8_t *)s_ssid, sizeof(s_ssid));
+    s_cred_crc = esp_rom_crc32_le(s_cred_crc, (const uint8_t *)s_pwd, sizeof(s_pwd));
+
+    s_active = false;
+    s_link_ms = 0;
+    if (!wc || !cache_valid()) {
+        ESP_LOGI(TAG, "Sem cache de AP; varredura completa + DHCP");
+        return false;
+    }
+
+    s_active = true;
+    wifi_fast_connect_apply(wc);
+
+    bool static_ip = false;
+    if (sta && lease_fresh()) {
+        esp_netif_ip_info_t info = {
+            .ip.addr      = s_fc.ip,
+            .netmask.addr = s_fc.netmask,
+            .gw.addr      = s_fc.gw,
+        };
+        esp_netif_dhcpc_stop(sta);
+        if (esp_netif_set_ip_info(sta, &info) == ESP_OK) {
+            static_ip = true;
+            if (s_fc.dns) {
+                esp_netif_dns_info_t dns = { 0 };
+                dns.ip.type = ESP_IPADDR_TYPE_V4;
+                dns.ip.u_addr.ip4.addr = s_fc.dns;
+                esp_netif_set_dns_info(sta, ESP_NETIF_DNS_MAIN, &dns);
+            }
+        } else {
+            esp_netif_dhcpc_start(sta);
+        }
+    }
+
+    ESP_LOGI(TAG, "Caminho rapido: BSSID " MACSTR " canal %u, PMK %s, IP %s",
+             MAC2STR(s_fc.bssid), s_fc.channel, s_fc.has_pmk ? "cache" : "senha",
+             static_ip ? "lease em cache" : "DHCP");
+    return true;
+}
+
+bool wifi_fast_connect_active(void)
+{
+    return s_active;
+}
+
+void wifi_fast_connect_apply(wifi_config_t *wc)
+{
+    if (!wc || !s_active) return;
+    memcpy(wc->sta.bssid, s_fc.bssid, sizeof(wc->sta.bssid));
+    wc->sta.bssid_set   = 1;
+    wc->sta.channel     = s_fc.channel;
+    wc->sta.scan_method = WIFI_FAST_SCAN;
+    if (s_fc.has_pmk) {
+        // 64 caracteres hex = PSK já derivado; o driver pula o PBKDF2
+        pmk_to_hex(s_fc.pmk, wc->sta.password, sizeof(wc->sta.password));
+    }
+}
+
+// PBKDF2-SHA1 (4096 iterações) custa centenas de ms: roda uma vez por
+// credencial, fora do event handler, depois que o link já subiu. Prioridade
+// mínima e no core 0: a aquisição (TimeManager) roda no core 1 e não espera
+static void pmk_task(void *arg)
+{
+    (void)arg;
+    uint8_t pmk[32];
+    int rc = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1,
+                                           (const unsigned char *)s_pwd, strlen(s_pwd),
+                                           (const unsigned char *)s_ssid, strlen(s_ssid),
+                                           4096, sizeof(pmk), pmk);
+    if (rc == 0) {
+        portENTER_CRITICAL(&s_mux);
+        if (cache_valid()) {
+            memcpy(s_fc.pmk, pmk, sizeof(pmk));
+            s_fc.has_pmk = 1;
+            cache_seal();
+        }
+        portEXIT_CRITICAL(&s_mux);
+        ESP_LOGI(TAG, "PMK derivado e guardado");
+    } else {
+        ESP_LOGW(TAG, "PBKDF2 falhou: %d", rc);
+    }
+    memset(pmk, 0, sizeof(pmk));
+    s_pmk_inflight = false;
+    vTaskDelete(NULL);
+}
+
+void wifi_fast_connect_on_got_ip(esp_netif_t *sta, const esp_netif_ip_info_t *ip)
+{
+    s_link_ms   = (uint32_t)(esp_timer_get_time() / 1000);
+    s_last_fast = s_active;
+
+    wifi_ap_record_t ap = { 0 };
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        s_active = false;
+        return;
+    }
+
+    esp_netif_dns_info_t dns = { 0 };
+    if (sta) esp_netif_get_dns_info(sta, ESP_NETIF_DNS_MAIN, &dns);
+
+    // Lease só conta quando veio do DHCP; o reaproveitado mantém a data original
+    bool dhcp = false;
+    esp_netif_dhcp_status_t st = ESP_NETIF_DHCP_INIT;
+    if (sta && esp_netif_dhcpc_get_status(sta, &st) == ESP_OK) dhcp = (st == ESP_NETIF_DHCP_STARTED);
+    uint32_t t1_s = dhcp ? dhcp_lease_t1_s(sta) : 0;
+    time_t now = time(NULL);
+
+    bool need_pmk;
+    portENTER_CRITICAL(&s_mux);
+    if (!cache_valid()) {
+        memset(&s_fc, 0, sizeof(s_fc));
+        s_fc.cred_crc = s_cred_crc;
+    }
+    memcpy(s_fc.bssid, ap.bssid, 6);
+    s_fc.channel = ap.primary;
+    if (dhcp && ip) {
+        s_fc.ip       = ip->ip.addr;
+        s_fc.netmask  = ip->netmask.addr;
+        s_fc.gw       = ip->gw.addr;
+        s_fc.dns      = (dns.ip.type == ESP_IPADDR_TYPE_V4) ? dns.ip.u_addr.ip4.addr : 0;
+        s_fc.lease_at = (now > FAST_TIME_VALID) ? (int64_t)now : 0;
+        s_fc.lease_t1_s = t1_s;
+    }
+    cache_seal();
+    need_pmk = !s_fc.has_pmk && s_pwd[0] && !s_pmk_inflight;
+    if (need_pmk) s_pmk_inflight = true;
+    s_active = false;
+    portEXIT_CRITICAL(&s_mux);
+
+    if (need_pmk && xTaskCreatePinnedToCore(pmk_task, "wifi_pmk", 4096, NULL,
+                                            tskIDLE_PRIORITY + 1, NULL, 0) != pdPASS) {
+        s_pmk_inflight = false;
+    }
+}
+
+bool wifi_fast_connect_fallback(esp_netif_t *sta)
+{
+    if (!s_active) return false;
+    s_active = false;
+    wifi_fast_connect_invalidate();
+    if (sta) esp_netif_dhcpc_start(sta);
+    ESP_LOGW(TAG, "Caminho rapido falhou; voltando a varredura completa + DHCP");
+    return true;
+}
+
+void wifi_fast_connect_invalidate(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    memset(&s_fc, 0, sizeof(s_fc));
+    portEXIT_CRITICAL(&s_mux);
+}
+
+uint32_t wifi_fast_connect_link_ms(void)
+{
+    return s_link_ms;
+}
+
+bool wifi_fast_connect_last_was_fast(void)
+{
+    return s_last_fast;
+}
+
+static fast_dns_t *dns_slot(const char *host)
+{
+    for (int i = 0; i < FAST_DNS_SLOTS; i++) {
+        if (strncmp(s_dns[i].host, host, sizeof(s_dns[i].host)) == 0) return &s_dns[i];
+    }
+    return NULL;
+}
+
+void wifi_fast_dns_forget(const char *host)
+{
+    if (!host) return;
+    portENTER_CRITICAL(&s_mux);
+    fast_dns_t *e = dns_slot(host);
+    if (e) memset(e, 0, sizeof(*e));
+    portEXIT_CRITICAL(&s_mux);
+}
+
+esp_err_t wifi_fast_resolve(const char *host, uint32_t *ipv4_out, int timeout_ms)
+{
+    if (!host || !host[0]) return ESP_ERR_INVALID_ARG;
+    time_t now = time(NULL);
+
+    portENTER_CRITICAL(&s_mux);
+    fast_dns_t *e = dns_slot(host);
+    bool hit = e && e->ip && now > FAST_TIME_VALID && now < e->expires;
+    uint32_t ip = hit ? e->ip : 0;
+    portEXIT_CRITICAL(&s_mux);
+    if (hit) {
+        if (ipv4_out) *ipv4_out = ip;
+        ESP_LOGD(TAG, "DNS cache: %s", host);
+        return ESP_OK;
+    }
+
+    const struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    const int step_ms = 500;
+    for (int waited = 0; waited < timeout_ms; waited += step_ms) {
+        struct addrinfo *ai = NULL;
+        if (getaddrinfo(host, NULL, &hints, &ai) == 0 && ai) {
+            ip = ((struct sockaddr_in *)ai->ai_addr)->sin_addr.s_addr;
+            freeaddrinfo(ai);
+            if (ipv4_out) *ipv4_out = ip;
+
+            // Nome longo demais para o slot: resolve, mas não guarda
+            if (strlen(host) < sizeof(s_dns[0].host) && now > FAST_TIME_VALID) {
+                portENTER_CRITICAL(&s_mux);
+                e = dns_slot(host);
+                if (!e) {
+                    // Sem slot do host: substitui o que vence primeiro
+                    e = &s_dns[0];
+                    for (int i = 1; i < FAST_DNS_SLOTS; i++) {
+                        if (s_dns[i].expires < e->expires) e = &s_dns[i];
+                    }
+                    memset(e, 0, sizeof(*e));
+                    strncpy(e->host, host, sizeof(e->host) - 1);
+                }
+                e->ip      = ip;
+                e->expires = (int64_t)now + WIFI_FAST_DNS_TTL_S;
+                portEXIT_CRITICAL(&s_mux);
+            }
+            return ESP_OK;
+        }
+        vTaskDelay(pdMS_TO_TICKS(step_ms));
+    }
+    return ESP_ERR_TIMEOUT;
+}
@@ -10,9 +10,11 @@
 #include "esp_netif.h"
 #include "esp_wifi.h"
 #include <string.h>
+#include <inttypes.h>
 #include <lwip/ip4_addr.h>
 #include <lwip/netdb.h>
 #include "wifi_softap_sta.h"   // seu start_wifi_ap_sta(), wifi_ap_force_disable()
+#include "wifi_fast_connect.h"
 #include "esp_log.h"
 
 static const char *TAG = "wifi_link";
@@ -21,7 +23,9 @@ bool wifi_link_has_ip(void) {
     esp_netif_ip_info_t ip;
     memset(&ip, 0, sizeof(ip));
     esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    return (netif && esp_netif_get_ip_info(netif, &ip) == ESP_OK && ip.ip.addr != 0);
+    // Com o lease em cache o IP já está no netif antes de associar: exige link up
+    return (netif && esp_netif_is_netif_up(netif) &&
+            esp_netif_get_ip_info(netif, &ip) == ESP_OK && ip.ip.addr != 0);
 }
 
 esp_err_t wifi_link_ensure_ready_sta(int timeout_ms, bool force_sta_only)
@@ -57,5 +61,10 @@ esp_err_t wifi_link_ensure_ready_sta(int timeout_ms, bool force_sta_only)
         vTaskDelay(pdMS_TO_TICKS(step_ms));
         waited += step_ms;
     }
+    if (waited > 0) {
+        ESP_LOGI(TAG, "GOT_IP em %" PRIu32 " ms desde o wake (caminho %s)",
+                 wifi_fast_connect_link_ms(),
+                 wifi_fast_connect_last_was_fast() ? "rapido" : "completo");
+    }
     return ESP_OK;
 }
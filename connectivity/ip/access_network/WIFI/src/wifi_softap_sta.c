@@ -29,6 +29,7 @@
 #include "lwip/sys.h"
 
 #include "time_sync_sntp.h"   // <— novo include
+#include "wifi_fast_connect.h"
 #include "system.h"
 
 
@@ -127,6 +128,7 @@ static uint64_t      s_ap_suspend_until_us = 0;    // timestamp (us) do fim da s
 // [NEW] Timers
 static TimerHandle_t     s_sta_reconn_timer   = NULL;  // FreeRTOS timer (backoff STA)
 static esp_timer_handle_t s_ap_resume_timer   = NULL;  // oneshot para religar AP
+static esp_timer_handle_t s_sta_fast_timer    = NULL;  // prazo do caminho rápido (BSSID/canal em cache)
 
 static TimerHandle_t s_time_resync_timer = NULL;
 static volatile bool s_time_sync_inflight = false;
@@ -300,6 +302,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
             if (ssid && pwd && strlen(ssid) > 0) {
                 strncpy((char*)wc.sta.ssid,     ssid, sizeof(wc.sta.ssid)-1);
                 strncpy((char*)wc.sta.password, pwd,  sizeof(wc.sta.password)-1);
+                wifi_fast_connect_apply(&wc);
                 ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wc));
                 ESP_LOGI(TAG_STA, "Conectando STA ao SSID: %s", ssid);
                 esp_wifi_connect();
@@ -318,6 +321,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
             s_retry_num = 0;
             s_sta_intentional_disconnect = false;
             if (s_sta_reconn_timer) xTimerStop(s_sta_reconn_timer, 0);
+            if (s_sta_fast_timer) esp_timer_stop(s_sta_fast_timer);
             xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
             break;
 
@@ -334,6 +338,14 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
                 break;
             }
 
+            // AP em cache não respondeu (mudou de canal, saiu do ar...): refaz já
+            // com varredura completa + DHCP, sem esperar o backoff
+            if (wifi_fast_connect_fallback(s_netif_sta)) {
+                if (s_sta_fast_timer) esp_timer_stop(s_sta_fast_timer);
+                wifi_sta_force_connect_if_enabled(s_boot_ssid, s_boot_pwd);
+                break;
+            }
+
             // [NEW] backoff exponencial infinito (cap 60 s)
             uint32_t delay_ms = RECONNECT_BACKOFF_BASE_MS << (s_retry_num < 16 ? s_retry_num : 16);
             delay_ms = clamp_u32(delay_ms, RECONNECT_BACKOFF_BASE_MS, RECONNECT_BACKOFF_CAP_MS);
@@ -362,6 +374,8 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
         case IP_EVENT_STA_GOT_IP: {
             ip_event_got_ip_t *e = (ip_event_got_ip_t *)event_data;
             ESP_LOGI(TAG_STA, "STA GOT IP: " IPSTR, IP2STR(&e->ip_info.ip));
+            if (s_sta_fast_timer) esp_timer_stop(s_sta_fast_timer);
+            wifi_fast_connect_on_got_ip(s_netif_sta, &e->ip_info);
             s_sta_connected = true;
             s_retry_num = 0;
             s_sta_intentional_disconnect = false;
@@ -422,6 +436,7 @@ static void wifi_sta_force_connect_if_enabled(const char *ssid, const char *pwd)
     sta.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
     strncpy((char*)sta.sta.ssid, ssid, sizeof(sta.sta.ssid)-1);
     if (pwd) strncpy((char*)sta.sta.password, pwd, sizeof(sta.sta.password)-1);
+    wifi_fast_connect_apply(&sta);
 
     esp_err_t e1 = esp_wifi_set_config(WIFI_IF_STA, &sta);
     ESP_LOGI(TAG_STA, "Aplicando STA cfg (ssid_len=%u, pwd_len=%u): %s",
@@ -438,6 +453,15 @@ static void sta_kick_timer_cb(TimerHandle_t xTimer) {
     if (s_sta_worker_task) xTaskNotifyGive(s_sta_worker_task);
 }
 
+// Caminho rápido sem associar no prazo: descarta o cache e refaz completo
+static void sta_fast_timeout_cb(void *arg) {
+    if (s_sta_connected) return;
+    if (wifi_fast_connect_fallback(s_netif_sta)) {
+        esp_wifi_disconnect();
+        wifi_sta_force_connect_if_enabled(s_boot_ssid, s_boot_pwd);
+    }
+}
+
 static inline void apply_tz_brt_once(void){
     static bool s_done = false;
     if (!s_done) {
@@ -612,10 +636,26 @@ esp_err_t start_wifi_ap_sta(void)
         sta.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
         strncpy((char*)sta.sta.ssid, s_boot_ssid, sizeof(sta.sta.ssid)-1);
         strncpy((char*)sta.sta.password, s_boot_pwd, sizeof(sta.sta.password)-1);
+        // BSSID/canal/PMK/lease da ativação anterior (RTC), se ainda valem
+        if (has_activate_sta()) {
+            wifi_fast_connect_prepare(&sta, s_netif_sta, s_boot_ssid, s_boot_pwd);
+        }
         ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &sta));
     }
 
+    if (!s_sta_fast_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = &sta_fast_timeout_cb,
+            .name = "sta_fast",
+            .dispatch_method = ESP_TIMER_TASK
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&args, &s_sta_fast_timer));
+    }
+
     ESP_ERROR_CHECK(esp_wifi_start());   // Wi-Fi ON
+    if (wifi_fast_connect_active()) {
+        esp_timer_start_once(s_sta_fast_timer, (uint64_t)WIFI_FAST_TIMEOUT_MS * 1000ULL);
+    }
     
     if (!s_sta_worker_task) {
     // 3072 bytes costumam ser suficientes; ajuste se usar logs muito verbosos
@@ -685,6 +725,11 @@ void stop_wifi_ap_sta(void)
         esp_timer_delete(s_ap_resume_timer);
         s_ap_resume_timer = NULL;
     }
+    if (s_sta_fast_timer)    {
+        esp_timer_stop(s_sta_fast_timer);
+        esp_timer_delete(s_sta_fast_timer);
+        s_sta_fast_timer = NULL;
+    }
 
     // --- Fase 2: calar loggers e handlers de evento antes do vendaval do stop() ---
     // Logger diagnóstico (já existia no seu projeto)
@@ -10,6 +10,8 @@
 
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -33,6 +35,39 @@ esp_err_t http_client_esp_post_json(const http_conn_cfg_t *cfg,
                                     const char *json,
                                     int *out_status);
 
+// ---- Sessão: vários POSTs na mesma conexão (keep-alive) ----
+typedef void *http_esp_handle_t;
+
+typedef struct {
+    uint32_t connects;          // conexões TCP/TLS abertas (1 = keep-alive aproveitado)
+    uint32_t connect_ms_first;  // setup (DNS+TCP+TLS) da primeira conexão
+    uint32_t connect_ms_total;
+    uint32_t requests;
+} http_esp_stats_t;
+
+/** Prepara o cliente esp_http_client (não conecta; a conexão abre no
+ *  primeiro POST e fica aberta entre os POSTs da sessão). */
+http_esp_handle_t http_client_esp_open(const http_conn_cfg_t *cfg);
+
+/** POST do corpo; reaproveita a conexão se o servidor mantiver keep-alive.
+ *  Retorna ESP_OK se status 2xx. */
+esp_err_t http_client_esp_post(http_esp_handle_t h, const char *body, int len,
+                               int *out_status);
+
+/** POST com o corpo em fluxo (sem buffer do tamanho do corpo):
+ *  begin() abre o pedido com Content-Length = len, write() manda os pedaços
+ *  (mesma assinatura de json_writer_sink_t) e end() lê a resposta.
+ *  write() recusa bytes além de len; end() falha se faltou corpo e, nesse
+ *  caso, fecha a conexão (o servidor ainda espera o resto).
+ *  end() retorna ESP_OK se status 2xx. */
+esp_err_t http_client_esp_begin(http_esp_handle_t h, int len);
+esp_err_t http_client_esp_write(http_esp_handle_t h, const char *data, size_t len);
+esp_err_t http_client_esp_end(http_esp_handle_t h, int *out_status);
+
+void http_client_esp_get_stats(http_esp_handle_t h, http_esp_stats_t *out);
+
+void http_client_esp_close(http_esp_handle_t h);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,6 +9,7 @@
 #define CONNECTIVITY_IP_MESSAGING_HTTP_WIFI_INCLUDE_HTTP_PUBLISHER_H_
 
 #pragma once
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -18,9 +19,10 @@ extern "C" {
 // Inicializa jitter/diagnósticos (opcional — igual ao mqtt)
 void http_publisher_init(void);
 
-// Publica UM pacote agora via HTTP(S) usando a STA conectada.
+// Publica agora via HTTP(S) usando a STA conectada, lote a lote.
 // Monta o payload a partir do SD (mesma diretiva do MQTT) e, se OK, avança índices.
-esp_err_t http_wifi_publish_now(void);
+// budget_ms: teto da sessão inteira (0 = HTTP_STREAM_BUDGET_MS)
+esp_err_t http_wifi_publish_now(uint32_t budget_ms);
 
 // ====== Getters fracos (override pelo seu front/NVS) ======
 const char *get_http_url(void);      // ex.: "https://api.exemplo.com/ingest"
@@ -7,6 +7,7 @@
 #include "http_client_esp.h"
 #include "esp_http_client.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -16,6 +17,14 @@
 
 static const char *TAG = "HTTP/ESP";
 
+typedef struct {
+    esp_http_client_handle_t client;
+    uint64_t                 t_perform_us;   // início do perform() corrente
+    int                      body_len;       // corpo em fluxo: Content-Length anunciado
+    int                      body_sent;
+    http_esp_stats_t         stats;
+} http_esp_ctx_t;
+
 static inline void http_set_basic_auth(esp_http_client_handle_t h,
                                        const char *user, const char *pass) {
 #if ESP_IDF_VERSION_MAJOR >= 5
@@ -28,9 +37,18 @@ static inline void http_set_basic_auth(esp_http_client_handle_t h,
 }
 
 static esp_err_t _http_event(esp_http_client_event_t *evt) {
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)evt->user_data;
+
     switch (evt->event_id) {
         case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGD(TAG, "CONNECTED");
+            // Só dispara quando abre conexão nova (keep-alive reaproveitado não passa aqui)
+            if (ctx) {
+                uint32_t ms = (uint32_t)((esp_timer_get_time() - ctx->t_perform_us) / 1000ULL);
+                if (ctx->stats.connects == 0) ctx->stats.connect_ms_first = ms;
+                ctx->stats.connects++;
+                ctx->stats.connect_ms_total += ms;
+                ESP_LOGD(TAG, "CONNECTED em %ums", (unsigned)ms);
+            }
             break;
         case HTTP_EVENT_HEADERS_SENT:
             ESP_LOGD(TAG, "HEADERS_SENT");
@@ -57,22 +75,24 @@ static esp_err_t _http_event(esp_http_client_event_t *evt) {
     return ESP_OK;
 }
 
-esp_err_t http_client_esp_post_json(const http_conn_cfg_t *cfg,
-                                    const char *json,
-                                    int *out_status)
+http_esp_handle_t http_client_esp_open(const http_conn_cfg_t *cfg)
 {
-    if (!cfg || !cfg->url || !cfg->url[0] || !json) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    if (!cfg || !cfg->url || !cfg->url[0]) return NULL;
+
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)calloc(1, sizeof(*ctx));
+    if (!ctx) return NULL;
 
     esp_http_client_config_t hc = {
         .url          = cfg->url,
         .method       = HTTP_METHOD_POST,
         .timeout_ms   = (cfg->timeout_ms > 0 ? cfg->timeout_ms : 10000),
         .event_handler= _http_event,  // seu handler (em v5.x use header_key/header_value)
+        .user_data    = ctx,
+        .keep_alive_enable = true,
     };
 
-    // HTTPS: usa bundle se habilitado, ou o PEM explícito se fornecido
+    // HTTPS: usa bundle se habilitado, ou o PEM explícito se fornecido.
+    // Com keep-alive a CA é parseada uma vez por sessão (por conexão aberta)
     if (strncmp(cfg->url, "https://", 8) == 0) {
     #if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
         if (!cfg->ca_cert_pem || !cfg->ca_cert_pem[0]) {
@@ -84,8 +104,12 @@ esp_err_t http_client_esp_post_json(const http_conn_cfg_t *cfg,
         }
     }
 
-    esp_http_client_handle_t h = esp_http_client_init(&hc);
-    if (!h) return ESP_FAIL;
+    ctx->client = esp_http_client_init(&hc);
+    if (!ctx->client) {
+        free(ctx);
+        return NULL;
+    }
+    esp_http_client_handle_t h = ctx->client;
 
     // Headers básicos
     const char *ct = (cfg->content_type && cfg->content_type[0])
@@ -102,15 +126,23 @@ esp_err_t http_client_esp_post_json(const http_conn_cfg_t *cfg,
     http_set_basic_auth(h, cfg->basic_user, cfg->basic_pass);
     }
 
-    // Corpo JSON
-    size_t len = strlen(json);
-    esp_err_t err = esp_http_client_set_post_field(h, json, (int)len);
-    if (err != ESP_OK) {
-        esp_http_client_cleanup(h);
-        return err;
-    }
+    return (http_esp_handle_t)ctx;
+}
+
+esp_err_t http_client_esp_post(http_esp_handle_t handle, const char *body, int len,
+                               int *out_status)
+{
+    if (!handle || !body) return ESP_ERR_INVALID_ARG;
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)handle;
+    esp_http_client_handle_t h = ctx->client;
+
+    if (len < 0) len = (int)strlen(body);
+    esp_err_t err = esp_http_client_set_post_field(h, body, len);
+    if (err != ESP_OK) return err;
 
     // Executa
+    ctx->t_perform_us = esp_timer_get_time();
+    ctx->stats.requests++;
     err = esp_http_client_perform(h);
     int status = -1;
 
@@ -126,9 +158,113 @@ esp_err_t http_client_esp_post_json(const http_conn_cfg_t *cfg,
     }
 
     if (out_status) *out_status = status;
-    esp_http_client_cleanup(h);
     return err;
 }
 
+esp_err_t http_client_esp_begin(http_esp_handle_t handle, int len)
+{
+    if (!handle || len < 0) return ESP_ERR_INVALID_ARG;
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)handle;
+    esp_http_client_handle_t h = ctx->client;
+
+    ctx->body_len  = len;
+    ctx->body_sent = 0;
+    ctx->t_perform_us = esp_timer_get_time();
+    ctx->stats.requests++;
+
+    esp_err_t err = esp_http_client_open(h, len);
+    if (err != ESP_OK) {
+        // Servidor fechou o keep-alive entre dois lotes: reabre uma vez
+        esp_http_client_close(h);
+        err = esp_http_client_open(h, len);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "open() erro: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t http_client_esp_write(http_esp_handle_t handle, const char *data, size_t len)
+{
+    if (!handle || (!data && len)) return ESP_ERR_INVALID_ARG;
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)handle;
 
+    if (len > (size_t)(ctx->body_len - ctx->body_sent)) {
+        ESP_LOGE(TAG, "Corpo maior que o Content-Length (%d)", ctx->body_len);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    while (len > 0) {
+        int n = esp_http_client_write(ctx->client, data, (int)len);
+        if (n <= 0) {
+            ESP_LOGE(TAG, "write() falhou após %d/%d bytes", ctx->body_sent, ctx->body_len);
+            return ESP_FAIL;
+        }
+        ctx->body_sent += n;
+        data += n;
+        len  -= (size_t)n;
+    }
+    return ESP_OK;
+}
 
+esp_err_t http_client_esp_end(http_esp_handle_t handle, int *out_status)
+{
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)handle;
+    esp_http_client_handle_t h = ctx->client;
+
+    esp_err_t err = ESP_OK;
+    int status = -1;
+
+    if (ctx->body_sent != ctx->body_len) {
+        ESP_LOGE(TAG, "Corpo incompleto: %d/%d bytes", ctx->body_sent, ctx->body_len);
+        err = ESP_ERR_INVALID_SIZE;
+    } else if (esp_http_client_fetch_headers(h) < 0) {
+        ESP_LOGE(TAG, "Sem resposta do servidor");
+        err = ESP_FAIL;
+    } else {
+        status = esp_http_client_get_status_code(h);
+        esp_http_client_flush_response(h, NULL);   // deixa a conexão pronta para o próximo
+        ESP_LOGI(TAG, "HTTP status=%d, body=%d", status, ctx->body_len);
+        if (status < 200 || status >= 300) err = ESP_FAIL;
+    }
+
+    // Sem resposta, a conexão ficou no meio de um pedido: não serve mais
+    if (status < 0) esp_http_client_close(h);
+
+    if (out_status) *out_status = status;
+    return err;
+}
+
+void http_client_esp_get_stats(http_esp_handle_t handle, http_esp_stats_t *out)
+{
+    if (!out) return;
+    if (!handle) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = ((http_esp_ctx_t *)handle)->stats;
+}
+
+void http_client_esp_close(http_esp_handle_t handle)
+{
+    http_esp_ctx_t *ctx = (http_esp_ctx_t *)handle;
+    if (!ctx) return;
+    if (ctx->client) esp_http_client_cleanup(ctx->client);
+    free(ctx);
+}
+
+esp_err_t http_client_esp_post_json(const http_conn_cfg_t *cfg,
+                                    const char *json,
+                                    int *out_status)
+{
+    if (!cfg || !cfg->url || !cfg->url[0] || !json) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    http_esp_handle_t h = http_client_esp_open(cfg);
+    if (!h) return ESP_FAIL;
+
+    esp_err_t err = http_client_esp_post(h, json, -1, out_status);
+    http_client_esp_close(h);
+    return err;
+}
@@ -15,6 +15,24 @@
 #include "http_wifi_cfg.h"
 
 #include "adaptive_delay.h"         // mesmo jitter usado no mqtt_wifi (opcional)
+#include "battery_monitor.h"
+
+// Mesmo orçamento de sessão do mqtt_wifi (POSTs sequenciais)
+#ifndef HTTP_STREAM_BUDGET_MS
+#define HTTP_STREAM_BUDGET_MS    60000
+#endif
+#ifndef HTTP_STREAM_MAX_BATCHES
+#define HTTP_STREAM_MAX_BATCHES  200
+#endif
+#define HTTP_STREAM_LOW_SOC      0.20f
+
+// Lote genérico: o corpo vai em fluxo para o socket, então o limite é só do
+// servidor (não há buffer do tamanho do corpo)
+#ifndef HTTP_WIFI_BODY_MAX
+#define HTTP_WIFI_BODY_MAX       16384
+#endif
+#define HTTP_WIFI_CHUNK_SZ       512      // pedaço entregue ao esp_http_client
+#define HTTP_WIFI_SNAPSHOT_SZ    512      // Ubidots/WEG: um snapshot pequeno
 
 static const char *TAG = "HTTP/WIFI";
 static adaptive_delay_t s_pub_jitter;
@@ -57,8 +75,64 @@ static bool wifi_sta_connected(void) {
     return esp_wifi_sta_get_ap_info(&ap) == ESP_OK;
 }
 
-esp_err_t http_wifi_publish_now(void)
+static bool is_snapshot_format(void)
+{
+    return http_payload_is_ubidots() || http_payload_is_weg();
+}
+
+// Ubidots/WEG: um snapshot pequeno, montado em buffer
+static esp_err_t build_snapshot(char *topic, size_t topic_sz,
+                                char *payload, size_t payload_sz,
+                                const struct record_index_config *rec_idx,
+                                uint32_t *points, uint32_t *new_cur)
+{
+    if (http_payload_is_ubidots()) {
+        return mqtt_payload_build_from_sd_ubidots(topic, topic_sz, payload, payload_sz,
+                                                  rec_idx, points, new_cur);
+    }
+    return mqtt_payload_build_from_sd_weg_energy(topic, topic_sz, payload, payload_sz,
+                                                 rec_idx, points, new_cur);
+}
+
+// Lote genérico, passo 1: quantos pontos cabem em HTTP_WIFI_BODY_MAX e o
+// tamanho exato do corpo (Content-Length), sem guardar o corpo
+static esp_err_t measure_batch(const struct record_index_config *rec_idx,
+                               uint32_t *points, uint32_t *new_cur, size_t *len)
+{
+    json_writer_t w;
+    jw_init(&w, NULL, HTTP_WIFI_BODY_MAX);
+    esp_err_t err = mqtt_payload_write_from_sd(&w, rec_idx, 0, points, new_cur);
+    if (err != ESP_OK) return err;
+    return jw_finish(&w, len);
+}
+
+// Lote genérico, passo 2: relê os mesmos 'points' registros e escreve o JSON
+// direto no socket. Se o SD der outro texto, o cliente HTTP recusa o excesso
+// ou a falta em relação ao Content-Length e o lote falha sem avançar índice.
+static esp_err_t stream_batch(http_esp_handle_t conn,
+                              const struct record_index_config *rec_idx,
+                              uint32_t points, size_t len,
+                              uint32_t *sent_points, uint32_t *sent_cur, int *status)
+{
+    *status = -1;
+    esp_err_t err = http_client_esp_begin(conn, (int)len);
+    if (err != ESP_OK) return err;
+
+    char chunk[HTTP_WIFI_CHUNK_SZ];
+    json_writer_t w;
+    jw_init_sink(&w, http_client_esp_write, conn, chunk, sizeof(chunk));
+    err = mqtt_payload_write_from_sd(&w, rec_idx, points, sent_points, sent_cur);
+    esp_err_t ferr = jw_finish(&w, NULL);
+    if (err == ESP_OK) err = ferr;
+
+    esp_err_t eerr = http_client_esp_end(conn, status);
+    return (err != ESP_OK) ? err : eerr;
+}
+
+esp_err_t http_wifi_publish_now(uint32_t budget_ms)
 {
+    if (budget_ms == 0 || budget_ms > HTTP_STREAM_BUDGET_MS) budget_ms = HTTP_STREAM_BUDGET_MS;
+
     // 0) STA precisa estar conectada
     if (!wifi_sta_connected()) {
         ESP_LOGW(TAG, "STA não conectada; abortando envio HTTP.");
@@ -70,25 +144,16 @@ esp_err_t http_wifi_publish_now(void)
     get_index_config(&rec_idx);
 
     char     topic[192]    = {0};   // alguns backends HTTP querem um "topic" no corpo
-    char     payload[2048] = {0};
+    char     payload[HTTP_WIFI_SNAPSHOT_SZ] = {0};
     uint32_t points        = 0;
     uint32_t new_cur       = rec_idx.cursor_position;
+    size_t   body_len      = 0;
 
     // 2) Escolhe o builder (mesmas heurísticas do MQTT)
-    esp_err_t err = ESP_OK;
-    if (http_payload_is_ubidots()) {
-        err = mqtt_payload_build_from_sd_ubidots(topic, sizeof(topic),
-                                                 payload, sizeof(payload),
-                                                 &rec_idx, &points, &new_cur);
-    } else if (http_payload_is_weg()) {
-        err = mqtt_payload_build_from_sd_weg_energy(topic, sizeof(topic),
-                                             payload, sizeof(payload),
-                                             &rec_idx, &points, &new_cur);
-    } else {
-        err = mqtt_payload_build_from_sd(topic, sizeof(topic),
-                                         payload, sizeof(payload),
-                                         &rec_idx, &points, &new_cur);
-    }
+    bool snapshot = is_snapshot_format();
+    esp_err_t err = snapshot
+        ? build_snapshot(topic, sizeof(topic), payload, sizeof(payload), &rec_idx, &points, &new_cur)
+        : measure_batch(&rec_idx, &points, &new_cur, &body_len);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Falha ao montar payload: %s", esp_err_to_name(err));
         return err;
@@ -98,7 +163,7 @@ esp_err_t http_wifi_publish_now(void)
         return ESP_OK;
     }
 
-    log_payload_preview("build", payload, sizeof(payload));
+    if (snapshot) log_payload_preview("build", payload, sizeof(payload));
 
     // 3) Monta URL a partir do front/NVS
     const char *host   = http_cfg_host();
@@ -134,36 +199,70 @@ esp_err_t http_wifi_publish_now(void)
     http_conn_cfg_t hc = {
         .url          = url,
         .ca_cert_pem  = ca_pem,
-        .timeout_ms   = 10000,
+        .timeout_ms   = (budget_ms < 10000) ? (int)budget_ms : 10000,   // por connect/write/read
         .auth_bearer  = bearer,
         .basic_user   = basic_user,
         .basic_pass   = basic_pass,
         .content_type = "application/json",
     };
 
-    // 4) Publica (POST JSON)
+    // 4) Publica (POST JSON) lote a lote até acabar o backlog ou o orçamento.
+    //    Cada POST 2xx avança o índice; uma falha encerra a sessão.
+    //    Todos os lotes vão no mesmo handle: um handshake TLS por sessão.
     uint64_t t0 = esp_timer_get_time();
+    http_esp_handle_t conn = http_client_esp_open(&hc);
+    if (!conn) {
+        ESP_LOGE(TAG, "Falha ao criar cliente HTTP.");
+        return ESP_FAIL;
+    }
+    uint32_t max_batches = (!battery_monitor_power_source_ok() &&
+                            battery_monitor_get_soc() < HTTP_STREAM_LOW_SOC) ? 1 : HTTP_STREAM_MAX_BATCHES;
+    uint32_t batches = 0, sent_points = 0;
+    struct record_index_config stage = rec_idx;
     int status = -1;
-    err = http_client_esp_post_json(&hc, payload, &status);
 
-    if (err == ESP_OK) {
-        // 5) Avança índices igual ao MQTT
-        if (rec_idx.total_idx > 0) {
-            rec_idx.last_read_idx = (rec_idx.last_read_idx + points) % rec_idx.total_idx;
+    for (;;) {
+        if (snapshot) {
+            err = http_client_esp_post(conn, payload, -1, &status);
+        } else {
+            err = stream_batch(conn, &stage, points, body_len, &points, &new_cur, &status);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "HTTP falhou (status=%d). Índices NÃO avançados.", status);
+            break;
         }
-        rec_idx.cursor_position = new_cur;
-        save_index_config(&rec_idx);
-        ESP_LOGI(TAG, "HTTP OK (status=%d): +%u ponto(s)", status, (unsigned)points);
-    } else {
-        ESP_LOGE(TAG, "HTTP falhou (status=%d). Índices NÃO avançados.", status);
-    }
-
-    ESP_LOGI("HTTP/TIME", "post_cost=%llums",
-             (unsigned long long)((esp_timer_get_time() - t0)/1000ULL));
 
-    return err;
-}
+        // 5) Avança índices igual ao MQTT
+        advance_read_index(points, new_cur);
+        batches++;
+        sent_points += points;
+        ESP_LOGI(TAG, "HTTP OK (status=%d): +%u ponto(s)%s", status, (unsigned)points,
+                 snapshot ? "" : " em fluxo");
 
+        // Um POST a mais pode custar até timeout_ms: não começa sem isso de folga
+        uint64_t used_ms = (esp_timer_get_time() - t0) / 1000ULL;
+        if (batches >= max_batches || used_ms + (uint64_t)hc.timeout_ms > budget_ms) {
+            break;
+        }
+        stage.cursor_position = new_cur;
+        points = 0;
+        err = snapshot
+            ? build_snapshot(topic, sizeof(topic), payload, sizeof(payload), &stage, &points, &new_cur)
+            : measure_batch(&stage, &points, &new_cur, &body_len);
+        if (err != ESP_OK || points == 0) {
+            break;   // backlog drenado
+        }
+    }
 
+    http_esp_stats_t cst;
+    http_client_esp_get_stats(conn, &cst);
+    http_client_esp_close(conn);
 
+    ESP_LOGI("HTTP/TIME", "post_cost=%llums connect=%ums conns=%u/%u batches=%u points=%u",
+             (unsigned long long)((esp_timer_get_time() - t0)/1000ULL),
+             (unsigned)cst.connect_ms_first,
+             (unsigned)cst.connects, (unsigned)cst.requests,
+             (unsigned)batches, (unsigned)sent_points);
 
+    return (batches > 0) ? ESP_OK : err;
+}
@@ -17,6 +17,7 @@ typedef void* mqtt_esp_handle_t;
 
 typedef struct {
     const char *host;          // Ex: "broker.exemplo.com"
+    const char *host_ip;       // IPv4 já resolvido (cache): conecta nele; TLS valida 'host'
     int         port;          // 1883 (sem TLS) / 8883 (TLS)
     bool        use_tls;       // true se for TLS (recomendado quando port=8883)
     const char *ca_cert_pem;   // PEM da CA (NULL => não usa TLS)
@@ -25,6 +26,7 @@ typedef struct {
     const char *password;      // "" quando token
     int         keepalive;     // default 60
     bool        clean_session; // default true
+    bool        manual_reconnect; // true => sem reconexão automática do esp-mqtt (quem chama decide)
 } mqtt_conn_cfg_t;
 
 // Cria e inicia o cliente (faz esp_mqtt_client_start e aguarda CONNECTED)
@@ -40,6 +42,23 @@ esp_err_t mqtt_client_esp_publish(mqtt_esp_handle_t h,
                                   int timeout_ms,
                                   int *out_msg_id);
 
+// ---- Pipeline QoS1 (sessão de envio com vários publishes em voo) ----
+#define MQTT_ESP_ACK_QUEUE_LEN 16
+
+// Publica QoS1 e retorna logo (não espera PUBACK). *out_msg_id identifica o envio.
+esp_err_t mqtt_client_esp_publish_nowait(mqtt_esp_handle_t h,
+                                         const char *topic,
+                                         const char *payload,
+                                         bool retain,
+                                         int *out_msg_id);
+
+// Aguarda o próximo PUBACK (qualquer msg_id) até timeout_ms.
+// Retorna ESP_ERR_TIMEOUT se nada chegou.
+esp_err_t mqtt_client_esp_wait_ack(mqtt_esp_handle_t h, int timeout_ms, int *out_msg_id);
+
+// true enquanto a conexão com o broker estiver ativa
+bool mqtt_client_esp_is_connected(mqtt_esp_handle_t h);
+
 // Para e destrói o cliente com segurança
 void mqtt_client_esp_stop_and_destroy(mqtt_esp_handle_t h);
 
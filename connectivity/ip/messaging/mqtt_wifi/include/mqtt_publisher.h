@@ -7,12 +7,47 @@
 #define CONNECTIVITY_IP_MESSAGING_MQTT_WIFI_INCLUDE_MQTT_PUBLISHER_H_
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "mqtt_client_esp.h"
+
+struct record_index_config; // forward
 
 // Inicialização do publicador (chame UMA vez no boot do Wi-Fi/MQTT)
 //void mqtt_publisher_init(void);
 
-// Publica UM pacote agora (monta payload, conecta se preciso e publica)
-esp_err_t mqtt_wifi_publish_now(void);
+// Publica agora (monta payload, conecta se preciso e drena o backlog).
+// budget_ms: teto da sessão inteira, conexão e PUBACKs incluídos
+// (0 = MQTT_STREAM_BUDGET_MS)
+esp_err_t mqtt_wifi_publish_now(uint32_t budget_ms);
+
+// ---- Compartilhado com a sessão persistente (mqtt_session.c) ----
+
+// Buffer de um lote (alocado no heap): o builder enche até este limite.
+// Acima do buffer_size o esp-mqtt manda o publish em fragmentos.
+#ifndef MQTT_WIFI_PAYLOAD_MAX
+#define MQTT_WIFI_PAYLOAD_MAX  8192
+#endif
+
+typedef struct {
+    bool is_ubidots;
+    bool is_weg;
+} mqtt_wifi_target_t;
+
+// Destino detectado pelo host/tópico configurados
+void mqtt_wifi_detect_target(mqtt_wifi_target_t *t);
+
+// Monta um lote (topic + payload) a partir de rec_idx->cursor_position
+esp_err_t mqtt_wifi_build_batch(const mqtt_wifi_target_t *t,
+                                char *topic, size_t topic_sz,
+                                char *payload, size_t payload_sz,
+                                const struct record_index_config *rec_idx,
+                                uint32_t *points, uint32_t *new_cur);
+
+// Preenche host/porta/TLS/credenciais/client_id (topic: usado no client_id da WEG)
+esp_err_t mqtt_wifi_fill_conn_cfg(const mqtt_wifi_target_t *t, const char *topic,
+                                  mqtt_conn_cfg_t *cfg);
 
 #endif /* CONNECTIVITY_IP_MESSAGING_MQTT_WIFI_INCLUDE_MQTT_PUBLISHER_H_ */
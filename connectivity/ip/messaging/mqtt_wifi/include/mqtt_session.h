@@ -0,0 +1,65 @@
+/*
+ * mqtt_session.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Sessão MQTT persistente (Wi-Fi) para dispositivos sempre ligados.
+ *
+ * Em vez de conectar/desconectar a cada envio (handshake TCP/TLS completo),
+ * uma task mantém a conexão com o broker:
+ *  - reconecta com backoff exponencial (com sal) quando cai;
+ *  - acompanha a queda/volta do STA pelos eventos de Wi-Fi/IP;
+ *  - publica lotes montados do SD com até MQTT_SESSION_WINDOW em voo
+ *    (fila limitada em RAM; o SD continua sendo a fila durável: o índice
+ *    de leitura só avança com PUBACK);
+ *  - mantém contadores de latência de conexão e de publish->PUBACK.
+ */
+
+#ifndef CONNECTIVITY_IP_MESSAGING_MQTT_WIFI_INCLUDE_MQTT_SESSION_H_
+#define CONNECTIVITY_IP_MESSAGING_MQTT_WIFI_INCLUDE_MQTT_SESSION_H_
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    bool     connected;
+    uint32_t connects;            // conexões bem-sucedidas
+    uint32_t connect_failures;
+    uint32_t disconnects;         // quedas (broker, Wi-Fi ou PUBACK perdido)
+    uint32_t connect_ms_last;
+    uint32_t connect_ms_avg;      // média móvel (1/8)
+    uint32_t connect_ms_max;
+    uint32_t publish_ms_last;     // publish -> PUBACK
+    uint32_t publish_ms_avg;
+    uint32_t publish_ms_max;
+    uint32_t publish_timeouts;
+    uint32_t batches_acked;
+    uint32_t points_acked;
+    uint32_t inflight;            // lotes em voo agora
+} mqtt_session_stats_t;
+
+/** @brief Sobe a task da sessão (idempotente). */
+esp_err_t mqtt_session_start(void);
+
+/** @brief Encerra a sessão (desconecta e finaliza a task). */
+void mqtt_session_stop(void);
+
+bool mqtt_session_is_running(void);
+
+/** @brief Avisa que há registros novos no SD para publicar. */
+void mqtt_session_kick(void);
+
+void mqtt_session_get_stats(mqtt_session_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONNECTIVITY_IP_MESSAGING_MQTT_WIFI_INCLUDE_MQTT_SESSION_H_ */
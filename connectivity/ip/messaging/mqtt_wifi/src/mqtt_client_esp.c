@@ -3,13 +3,11 @@
 #include <string.h>
 #include "esp_log.h"
 #include "mqtt_client.h"
+#include "tls_transport.h"
 #include "esp_event.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-
-#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
-#include "esp_crt_bundle.h"
-#endif
+#include "freertos/queue.h"
 
 // Mantido por compatibilidade (não usamos fallback automático de porta aqui)
 #ifndef MQTT_WIFI_FALLBACK_PORT1883
@@ -21,6 +19,7 @@ typedef struct {
     SemaphoreHandle_t        ev_mutex;
     SemaphoreHandle_t        ev_connected;
     SemaphoreHandle_t        ev_puback;
+    QueueHandle_t            ev_acks;      // msg_id de cada PUBACK (modo pipeline)
     volatile int             last_msg_id;
     volatile bool            connected;
 } mqtt_esp_ctx_t;
@@ -48,6 +47,7 @@ static void _mqtt_event(void *arg, esp_event_base_t base, int32_t event_id, void
         if (e && e->msg_id == ctx->last_msg_id) {
             xSemaphoreGive(ctx->ev_puback);
         }
+        if (e) xQueueSend(ctx->ev_acks, &e->msg_id, 0);  // cheio => descarta (ninguém consumindo)
         ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED msg_id=%d", e ? e->msg_id : -1);
         break;
 
@@ -76,11 +76,13 @@ static mqtt_esp_ctx_t* _ctx_new(void) {
     ctx->ev_mutex     = xSemaphoreCreateMutex();
     ctx->ev_connected = xSemaphoreCreateBinary();
     ctx->ev_puback    = xSemaphoreCreateBinary();
+    ctx->ev_acks      = xQueueCreate(MQTT_ESP_ACK_QUEUE_LEN, sizeof(int));
 
-    if (!ctx->ev_mutex || !ctx->ev_connected || !ctx->ev_puback) {
+    if (!ctx->ev_mutex || !ctx->ev_connected || !ctx->ev_puback || !ctx->ev_acks) {
         if (ctx->ev_mutex)     vSemaphoreDelete(ctx->ev_mutex);
         if (ctx->ev_connected) vSemaphoreDelete(ctx->ev_connected);
         if (ctx->ev_puback)    vSemaphoreDelete(ctx->ev_puback);
+        if (ctx->ev_acks)      vQueueDelete(ctx->ev_acks);
         free(ctx);
         return NULL;
     }
@@ -97,6 +99,7 @@ static void _ctx_free(mqtt_esp_ctx_t *ctx) {
     if (ctx->ev_mutex)     vSemaphoreDelete(ctx->ev_mutex);
     if (ctx->ev_connected) vSemaphoreDelete(ctx->ev_connected);
     if (ctx->ev_puback)    vSemaphoreDelete(ctx->ev_puback);
+    if (ctx->ev_acks)      vQueueDelete(ctx->ev_acks);
     free(ctx);
 }
 
@@ -111,8 +114,8 @@ mqtt_esp_handle_t mqtt_client_esp_create_and_connect(const mqtt_conn_cfg_t *cfg,
 
     esp_mqtt_client_config_t mc = {0};
 
-    // Endereço & credenciais
-    mc.broker.address.hostname  = cfg->host;
+    // Endereço & credenciais (com IP em cache o esp-mqtt não consulta o DNS)
+    mc.broker.address.hostname  = (cfg->host_ip && cfg->host_ip[0]) ? cfg->host_ip : cfg->host;
     mc.broker.address.port      = cfg->port;
     mc.credentials.client_id    = (cfg->client_id && cfg->client_id[0]) ? cfg->client_id : NULL;
     mc.credentials.username     = cfg->username;
@@ -122,14 +125,18 @@ mqtt_esp_handle_t mqtt_client_esp_create_and_connect(const mqtt_conn_cfg_t *cfg,
     mc.broker.address.transport = cfg->use_tls ? MQTT_TRANSPORT_OVER_SSL
                                                : MQTT_TRANSPORT_OVER_TCP;
 
-    // TLS (apenas quando SSL)
+    // TLS (apenas quando SSL): transporte próprio que retoma a sessão com o
+    // ticket guardado em RTC (sem handshake completo a cada wake). A CA do
+    // front/config vem do cache por referência; sem PEM, usa o bundle.
+    esp_transport_handle_t tls = NULL;
     if (cfg->use_tls) {
-        if (cfg->ca_cert_pem && cfg->ca_cert_pem[0]) {
-            // CA específica fornecida pelo front/config (opcional)
-            mc.broker.verification.certificate = cfg->ca_cert_pem;
+        tls = tls_transport_new(cfg->ca_cert_pem);
+        if (!tls) {
+            _ctx_free(ctx);
+            return NULL;
         }
-        // Se certificate == NULL e o bundle estiver habilitado no projeto,
-        // o esp-tls usará o bundle automaticamente.
+        if (cfg->host_ip && cfg->host_ip[0]) tls_transport_set_server_name(tls, cfg->host);
+        mc.network.transport = tls;
     }
 
     // Session (API nova do IDF 5.x)
@@ -137,11 +144,12 @@ mqtt_esp_handle_t mqtt_client_esp_create_and_connect(const mqtt_conn_cfg_t *cfg,
     mc.session.disable_clean_session  = !cfg->clean_session;  // invertido
 
     // Network/session extras
-    mc.network.disable_auto_reconnect = false;
+    mc.network.disable_auto_reconnect = cfg->manual_reconnect;
 
     // Inicializa cliente
     ctx->client = esp_mqtt_client_init(&mc);
     if (!ctx->client) {
+        if (tls) esp_transport_destroy(tls);   // sem cliente, ninguém mais o destrói
         _ctx_free(ctx);
         return NULL;
     }
@@ -203,6 +211,48 @@ esp_err_t mqtt_client_esp_publish(mqtt_esp_handle_t handle,
     return ESP_OK;
 }
 
+// Publica QoS1 sem esperar o PUBACK (o esp-mqtt guarda a cópia no outbox)
+esp_err_t mqtt_client_esp_publish_nowait(mqtt_esp_handle_t handle,
+                                         const char *topic,
+                                         const char *payload,
+                                         bool retain,
+                                         int *out_msg_id)
+{
+    if (!handle || !topic || !payload || !out_msg_id) return ESP_ERR_INVALID_ARG;
+    mqtt_esp_ctx_t *ctx = (mqtt_esp_ctx_t *)handle;
+
+    if (!ctx->connected) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(ctx->ev_mutex, portMAX_DELAY);
+    int msg_id = esp_mqtt_client_publish(ctx->client, topic, payload, 0 /*auto-len*/, 1, retain);
+    xSemaphoreGive(ctx->ev_mutex);
+
+    *out_msg_id = msg_id;
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar (pipeline)");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t mqtt_client_esp_wait_ack(mqtt_esp_handle_t handle, int timeout_ms, int *out_msg_id)
+{
+    if (!handle || !out_msg_id) return ESP_ERR_INVALID_ARG;
+    mqtt_esp_ctx_t *ctx = (mqtt_esp_ctx_t *)handle;
+
+    if (timeout_ms <= 0) timeout_ms = 10000;
+    if (xQueueReceive(ctx->ev_acks, out_msg_id, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        ESP_LOGE(TAG, "Timeout aguardando PUBACK (pipeline)");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+bool mqtt_client_esp_is_connected(mqtt_esp_handle_t handle)
+{
+    return handle && ((mqtt_esp_ctx_t *)handle)->connected;
+}
+
 void mqtt_client_esp_stop_and_destroy(mqtt_esp_handle_t h) {
     _ctx_free((mqtt_esp_ctx_t *)h);
 }
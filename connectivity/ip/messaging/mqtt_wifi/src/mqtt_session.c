@@ -0,0 +1,364 @@
+/*
+ * mqtt_session.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "mqtt_session.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+#include "mqtt_client_esp.h"
+#include "mqtt_publisher.h"
+#include "datalogger_control.h"
+#include "datalogger_driver.h"
+#include "sdmmc_driver.h"
+
+static const char *TAG = "MQTT/SESSION";
+
+#ifndef MQTT_SESSION_WINDOW
+#define MQTT_SESSION_WINDOW          4        // lotes QoS1 em voo (fila em RAM)
+#endif
+#define MQTT_SESSION_CONNECT_TMO_MS  10000
+#define MQTT_SESSION_ACK_TMO_MS      15000
+#define MQTT_SESSION_IDLE_POLL_MS    60000    // confere o SD mesmo sem kick
+#define MQTT_SESSION_BACKOFF_MIN_MS  1000
+#define MQTT_SESSION_BACKOFF_MAX_MS  60000
+#define MQTT_SESSION_TASK_STACK      6144
+#define MQTT_SESSION_TASK_PRIO       4
+
+#define BIT_LINK_UP   BIT0
+#define BIT_KICK      BIT1
+#define BIT_STOP      BIT2
+
+typedef struct {
+    int      msg_id;
+    uint32_t points;
+    uint32_t new_cur;
+    uint64_t t_pub_us;
+    bool     acked;
+} session_batch_t;
+
+static TaskHandle_t       s_task;
+static EventGroupHandle_t s_events;
+static esp_event_handler_instance_t s_ip_evt;
+static esp_event_handler_instance_t s_lost_evt;
+static esp_event_handler_instance_t s_wifi_evt;
+
+static portMUX_TYPE         s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_session_stats_t s_stats;
+
+static char s_topic[192];
+static char *s_payload;   // MQTT_WIFI_PAYLOAD_MAX, alocado pela task
+
+// -------------------- Eventos de rede --------------------
+static void link_event(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    if (!s_events) return;
+
+    if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+        xEventGroupSetBits(s_events, BIT_LINK_UP | BIT_KICK);
+    } else {
+        // IP_EVENT_STA_LOST_IP / WIFI_EVENT_STA_DISCONNECTED
+        xEventGroupClearBits(s_events, BIT_LINK_UP);
+        xEventGroupSetBits(s_events, BIT_KICK);   // acorda a task para largar a conexão
+    }
+}
+
+static bool sta_has_ip(void)
+{
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    esp_netif_ip_info_t ip = {0};
+    return netif && esp_netif_get_ip_info(netif, &ip) == ESP_OK && ip.ip.addr != 0;
+}
+
+// -------------------- Estatísticas --------------------
+static inline uint32_t ewma8(uint32_t avg, uint32_t x)
+{
+    return avg ? (avg * 7 + x) / 8 : x;
+}
+
+static void stats_connected(uint32_t ms)
+{
+    portENTER_CRITICAL(&s_stats_mux);
+    s_stats.connected = true;
+    s_stats.connects++;
+    s_stats.connect_ms_last = ms;
+    s_stats.connect_ms_avg  = ewma8(s_stats.connect_ms_avg, ms);
+    if (ms > s_stats.connect_ms_max) s_stats.connect_ms_max = ms;
+    portEXIT_CRITICAL(&s_stats_mux);
+}
+
+static void stats_acked(uint32_t ms, uint32_t points)
+{
+    portENTER_CRITICAL(&s_stats_mux);
+    s_stats.publish_ms_last = ms;
+    s_stats.publish_ms_avg  = ewma8(s_stats.publish_ms_avg, ms);
+    if (ms > s_stats.publish_ms_max) s_stats.publish_ms_max = ms;
+    s_stats.batches_acked++;
+    s_stats.points_acked += points;
+    portEXIT_CRITICAL(&s_stats_mux);
+}
+
+static void stats_log(const char *phase)
+{
+    mqtt_session_stats_t st;
+    mqtt_session_get_stats(&st);
+    ESP_LOGI("MQTT/TIME",
+             "%s: connect last=%ums avg=%ums max=%ums (%u ok/%u falhas/%u quedas) "
+             "puback last=%ums avg=%ums max=%ums lotes=%u pts=%u",
+             phase,
+             (unsigned)st.connect_ms_last, (unsigned)st.connect_ms_avg, (unsigned)st.connect_ms_max,
+             (unsigned)st.connects, (unsigned)st.connect_failures, (unsigned)st.disconnects,
+             (unsigned)st.publish_ms_last, (unsigned)st.publish_ms_avg, (unsigned)st.publish_ms_max,
+             (unsigned)st.batches_acked, (unsigned)st.points_acked);
+}
+
+// Impressão digital da config do broker: mudou no portal => reconecta
+static uint32_t broker_cfg_hash(void)
+{
+    const char *f[] = { get_mqtt_url(), get_mqtt_topic(), get_network_user(),
+                        get_network_pw(), get_network_token() };
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(f) / sizeof(f[0]); i++) {
+        const unsigned char *p = (const unsigned char *)(f[i] ? f[i] : "");
+        do { h ^= *p; h *= 16777619u; } while (*p++);
+    }
+    h ^= get_mqtt_port();
+    h ^= ((uint32_t)has_network_token_enabled() << 1) |
+         ((uint32_t)has_network_user_enabled() << 2) |
+         ((uint32_t)has_network_pw_enabled() << 3);
+    return h;
+}
+
+static uint32_t next_backoff(uint32_t cur)
+{
+    uint32_t b = cur ? cur * 2 : MQTT_SESSION_BACKOFF_MIN_MS;
+    if (b > MQTT_SESSION_BACKOFF_MAX_MS) b = MQTT_SESSION_BACKOFF_MAX_MS;
+    return b;
+}
+
+// -------------------- Task --------------------
+static void session_task(void *arg)
+{
+    mqtt_esp_handle_t h = NULL;
+    mqtt_wifi_target_t target = {0};
+    session_batch_t inflight[MQTT_SESSION_WINDOW];
+    size_t   n_inflight = 0;
+    uint32_t backoff_ms = 0;
+    uint32_t cfg_hash   = 0;
+    bool     ack_lost   = false;
+    struct record_index_config stage = {0};   // posição de montagem (à frente do índice)
+
+    s_payload = malloc(MQTT_WIFI_PAYLOAD_MAX);
+    if (!s_payload) {
+        ESP_LOGE(TAG, "Sem memória para o payload (%u B)", (unsigned)MQTT_WIFI_PAYLOAD_MAX);
+        s_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Sessão persistente iniciada");
+
+    for (;;) {
+        EventBits_t bits = xEventGroupWaitBits(s_events, BIT_LINK_UP | BIT_KICK | BIT_STOP,
+                                               pdFALSE, pdFALSE, portMAX_DELAY);
+        if (bits & BIT_STOP) break;
+
+        // 1) Conexão caiu / Wi-Fi caiu / config mudou => larga a sessão.
+        //    Lotes sem PUBACK serão remontados do SD a partir do índice confirmado.
+        bool drop = h && (!(bits & BIT_LINK_UP) || ack_lost ||
+                          !mqtt_client_esp_is_connected(h) ||
+                          broker_cfg_hash() != cfg_hash);
+        if (drop) {
+            ESP_LOGW(TAG, "Sessão encerrada (%u lote(s) sem PUBACK voltam para o SD)",
+                     (unsigned)n_inflight);
+            mqtt_client_esp_stop_and_destroy(h);
+            h = NULL;
+            n_inflight = 0;
+            ack_lost = false;
+            portENTER_CRITICAL(&s_stats_mux);
+            s_stats.connected = false;
+            s_stats.disconnects++;
+            s_stats.inflight = 0;
+            portEXIT_CRITICAL(&s_stats_mux);
+            backoff_ms = MQTT_SESSION_BACKOFF_MIN_MS;
+        }
+        if (!(xEventGroupGetBits(s_events) & BIT_LINK_UP)) {
+            xEventGroupClearBits(s_events, BIT_KICK);   // sem link: espera o GOT_IP
+            continue;
+        }
+
+        // 2) Conecta (com backoff)
+        if (!h) {
+            if (backoff_ms) {
+                uint32_t wait_ms = backoff_ms + (esp_random() % (backoff_ms / 4 + 1));
+                bits = xEventGroupWaitBits(s_events, BIT_STOP, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(wait_ms));
+                if (bits & BIT_STOP) break;
+                if (!(bits & BIT_LINK_UP)) continue;
+            }
+
+            mqtt_wifi_detect_target(&target);
+            mqtt_conn_cfg_t cfg;
+            if (mqtt_wifi_fill_conn_cfg(&target, s_topic[0] ? s_topic : get_mqtt_topic(), &cfg) != ESP_OK) {
+                backoff_ms = MQTT_SESSION_BACKOFF_MAX_MS;
+                continue;
+            }
+            cfg.manual_reconnect = true;   // reconexão é desta task (com backoff)
+
+            uint64_t t0 = esp_timer_get_time();
+            h = mqtt_client_esp_create_and_connect(&cfg, MQTT_SESSION_CONNECT_TMO_MS);
+            if (!h) {
+                portENTER_CRITICAL(&s_stats_mux);
+                s_stats.connect_failures++;
+                portEXIT_CRITICAL(&s_stats_mux);
+                backoff_ms = next_backoff(backoff_ms);
+                ESP_LOGW(TAG, "Broker indisponível; nova tentativa em ~%u ms", (unsigned)backoff_ms);
+                continue;
+            }
+            stats_connected((uint32_t)((esp_timer_get_time() - t0) / 1000ULL));
+            stats_log("conectado");
+            backoff_ms = 0;
+            cfg_hash = broker_cfg_hash();
+            get_index_config(&stage);
+        }
+
+        // 3) Enche a janela a partir do SD
+        while (n_inflight < MQTT_SESSION_WINDOW) {
+            uint32_t points = 0, new_cur = stage.cursor_position;
+            if (mqtt_wifi_build_batch(&target, s_topic, sizeof(s_topic), s_payload, MQTT_WIFI_PAYLOAD_MAX,
+                                      &stage, &points, &new_cur) != ESP_OK || points == 0) {
+                break;
+            }
+            int msg_id = -1;
+            if (mqtt_client_esp_publish_nowait(h, s_topic, s_payload, /*retain*/false, &msg_id) != ESP_OK) {
+                break;   // conexão caiu: detectado no topo do laço
+            }
+            inflight[n_inflight++] = (session_batch_t){ msg_id, points, new_cur,
+                                                        esp_timer_get_time(), false };
+            stage.cursor_position = new_cur;
+        }
+        portENTER_CRITICAL(&s_stats_mux);
+        s_stats.inflight = n_inflight;
+        portEXIT_CRITICAL(&s_stats_mux);
+
+        // 4) Sem nada em voo: dorme até kick, queda de link, stop ou poll periódico
+        if (n_inflight == 0) {
+            xEventGroupWaitBits(s_events, BIT_KICK | BIT_STOP, pdFALSE, pdFALSE,
+                                pdMS_TO_TICKS(MQTT_SESSION_IDLE_POLL_MS));
+            xEventGroupClearBits(s_events, BIT_KICK);
+            continue;
+        }
+
+        // 5) Próximo PUBACK; os lotes da frente confirmados avançam o índice (ordem do SD)
+        int acked_id = -1;
+        if (mqtt_client_esp_wait_ack(h, MQTT_SESSION_ACK_TMO_MS, &acked_id) != ESP_OK) {
+            portENTER_CRITICAL(&s_stats_mux);
+            s_stats.publish_timeouts++;
+            portEXIT_CRITICAL(&s_stats_mux);
+            ack_lost = true;   // o topo do laço reconecta e remonta do SD
+            continue;
+        }
+        uint64_t now = esp_timer_get_time();
+        for (size_t i = 0; i < n_inflight; ++i) {
+            if (inflight[i].msg_id == acked_id && !inflight[i].acked) {
+                inflight[i].acked = true;
+                stats_acked((uint32_t)((now - inflight[i].t_pub_us) / 1000ULL), inflight[i].points);
+            }
+        }
+        while (n_inflight > 0 && inflight[0].acked) {
+            advance_read_index(inflight[0].points, inflight[0].new_cur);
+            n_inflight--;
+            memmove(&inflight[0], &inflight[1], n_inflight * sizeof(inflight[0]));
+        }
+        if (n_inflight == 0) {
+            set_last_data_sent(time(NULL));
+        }
+    }
+
+    if (h) mqtt_client_esp_stop_and_destroy(h);
+    portENTER_CRITICAL(&s_stats_mux);
+    s_stats.connected = false;
+    s_stats.inflight = 0;
+    portEXIT_CRITICAL(&s_stats_mux);
+    stats_log("encerrada");
+
+    free(s_payload);
+    s_payload = NULL;
+    s_task = NULL;
+    vTaskDelete(NULL);
+}
+
+// -------------------- API --------------------
+esp_err_t mqtt_session_start(void)
+{
+    if (s_task) return ESP_OK;
+
+    if (!s_events) {
+        s_events = xEventGroupCreate();
+        if (!s_events) return ESP_ERR_NO_MEM;
+    }
+    xEventGroupClearBits(s_events, BIT_STOP | BIT_KICK | BIT_LINK_UP);
+    if (sta_has_ip()) xEventGroupSetBits(s_events, BIT_LINK_UP | BIT_KICK);
+
+    if (!s_ip_evt) {
+        esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, link_event, NULL, &s_ip_evt);
+        esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_LOST_IP, link_event, NULL, &s_lost_evt);
+        esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, link_event, NULL, &s_wifi_evt);
+    }
+
+    if (xTaskCreate(session_task, "mqtt_session", MQTT_SESSION_TASK_STACK, NULL,
+                    MQTT_SESSION_TASK_PRIO, &s_task) != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void mqtt_session_stop(void)
+{
+    if (!s_task) return;
+
+    xEventGroupSetBits(s_events, BIT_STOP);
+    for (int i = 0; i < 100 && s_task; ++i) {   // até ~ACK_TMO + 5 s
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+
+    if (s_ip_evt) {
+        esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, s_ip_evt);
+        esp_event_handler_instance_unregister(IP_EVENT, IP_EVENT_STA_LOST_IP, s_lost_evt);
+        esp_event_handler_instance_unregister(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, s_wifi_evt);
+        s_ip_evt = s_lost_evt = s_wifi_evt = NULL;
+    }
+}
+
+bool mqtt_session_is_running(void)
+{
+    return s_task != NULL;
+}
+
+void mqtt_session_kick(void)
+{
+    if (s_events) xEventGroupSetBits(s_events, BIT_KICK);
+}
+
+void mqtt_session_get_stats(mqtt_session_stats_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&s_stats_mux);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_stats_mux);
+}
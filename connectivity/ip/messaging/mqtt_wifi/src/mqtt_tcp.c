@@ -1,17 +1,34 @@
 #include "adaptive_delay.h"
 #include "mqtt_publisher.h"
 #include "mqtt_client_esp.h"
+#include "mqtt_session.h"
 #include "payload_builder.h"
 #include "esp_wifi.h"
 #include "esp_log.h"
+#include "esp_netif.h"
+#include "wifi_fast_connect.h"
+#include <stdlib.h>
 
 // header dos índices/SD (ajuste nome se preciso)
 #include "sdmmc_driver.h"
+#include "battery_monitor.h"
 
 static const char *TAG = "MQTT/WIFI";
 
 static adaptive_delay_t s_pub_jitter;  // estado do delay adaptativo (1 por tarefa)
 
+// Sessão de envio (drena o backlog numa conexão só)
+#ifndef MQTT_STREAM_WINDOW
+#define MQTT_STREAM_WINDOW       4        // publishes QoS1 em voo
+#endif
+#ifndef MQTT_STREAM_BUDGET_MS
+#define MQTT_STREAM_BUDGET_MS    60000    // tempo máximo de rádio por sessão
+#endif
+#ifndef MQTT_STREAM_MAX_BATCHES
+#define MQTT_STREAM_MAX_BATCHES  500
+#endif
+#define MQTT_STREAM_LOW_SOC      0.20f    // na bateria, abaixo disso envia só 1 lote
+
 // --- Diag helpers para payload ---
 static uint32_t fnv1a32(const char *s) {
     uint32_t h = 2166136261u;
@@ -62,89 +79,58 @@ static bool wifi_sta_connected(void) {
     return esp_wifi_sta_get_ap_info(&ap) == ESP_OK;
 }
 
-// mqtt_tcp.c
-esp_err_t mqtt_wifi_publish_now(void)
+// Autodeteção do destino pelo host/tópico configurados
+void mqtt_wifi_detect_target(mqtt_wifi_target_t *t)
 {
-    // 0) STA precisa estar conectada
-    wifi_ap_record_t ap;
-    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
-        ESP_LOGW("MQTT/WIFI", "STA não conectada; abortando envio MQTT.");
-        return ESP_ERR_INVALID_STATE;
-    }
-       mqtt_publisher_init_once();
-       
-    // 1) Carrega índices e buffers
-    struct record_index_config rec_idx = {0};
-    get_index_config(&rec_idx);
-
-    char     topic[192]    = {0};
-    char     payload[2048] = {0};
-    uint32_t points        = 0;
-    uint32_t new_cur       = rec_idx.cursor_position;
-
     const char *host     = get_mqtt_url();
     const char *topic_ui = get_mqtt_topic();
 
-    // 2) Autodeteção do destino
-    bool is_ubidots = false;
+    t->is_ubidots = false;
     if ((host && strstr(host, "ubidots.com") != NULL) ||
         (topic_ui && strncmp(topic_ui, "/v1.6/devices/", 14) == 0)) {
-        is_ubidots = true;
+        t->is_ubidots = true;
     }
 
-    bool is_weg = false;
+    t->is_weg = false;
     if ((topic_ui && (strncmp(topic_ui, "wnology/", 8) == 0 ||
                       strncmp(topic_ui, "losant/", 7)  == 0)) ||
         (host && (strstr(host, "wnology")   != NULL ||
                   strstr(host, "wegnology") != NULL ||
                   strstr(host, "losant")    != NULL))) {
-        is_weg = true;
+        t->is_weg = true;
     }
+}
 
-    // 3) Monta topic/payload a partir do SD
-    esp_err_t err = ESP_OK;
-    if (is_ubidots) {
-        err = mqtt_payload_build_from_sd_ubidots(topic, sizeof(topic),
-                                                 payload, sizeof(payload),
-                                                 &rec_idx, &points, &new_cur);
-      } else if (is_weg) {
-         // <<< NOVO: escolhe entre energia x água >>>
-             uint8_t mode = get_weg_payload_mode(); // 0=energia (default), 1=água
-              if (mode == 1) {
-                              err = mqtt_payload_build_from_sd_weg_water(topic, sizeof(topic),
-                                                   payload, sizeof(payload),
-                                                   &rec_idx, &points, &new_cur);
-       } else {
-        err = mqtt_payload_build_from_sd_weg_energy(topic, sizeof(topic),
-                                                    payload, sizeof(payload),
-                                                    &rec_idx, &points, &new_cur);
-            }
-    } else {
-        err = mqtt_payload_build_from_sd(topic, sizeof(topic),
-                                         payload, sizeof(payload),
-                                         &rec_idx, &points, &new_cur);
-    }
-    if (err != ESP_OK) {
-        ESP_LOGE("MQTT/WIFI", "Falha ao montar payload: %s", esp_err_to_name(err));
-        return err;
+// Escolhe o builder conforme o destino e monta um lote a partir de rec_idx->cursor_position
+esp_err_t mqtt_wifi_build_batch(const mqtt_wifi_target_t *t,
+                                char *topic, size_t topic_sz,
+                                char *payload, size_t payload_sz,
+                                const struct record_index_config *rec_idx,
+                                uint32_t *points, uint32_t *new_cur)
+{
+    if (t->is_ubidots) {
+        return mqtt_payload_build_from_sd_ubidots(topic, topic_sz, payload, payload_sz,
+                                                  rec_idx, points, new_cur);
     }
-    if (points == 0) {
-        ESP_LOGI("MQTT/WIFI", "Nenhum ponto para enviar.");
-        return ESP_OK;
+    if (t->is_weg) {
+        // <<< NOVO: escolhe entre energia x água >>>
+        uint8_t mode = get_weg_payload_mode(); // 0=energia (default), 1=água
+        if (mode == 1) {
+            return mqtt_payload_build_from_sd_weg_water(topic, topic_sz, payload, payload_sz,
+                                                        rec_idx, points, new_cur);
+        }
+        return mqtt_payload_build_from_sd_weg_energy(topic, topic_sz, payload, payload_sz,
+                                                     rec_idx, points, new_cur);
     }
-    
-    ESP_LOGI("MQTT/WIFI", "topic='%s' points=%u payload_len=%u",
-         topic, (unsigned)points, (unsigned)strlen(payload));
-
-// [NOVO] Preview, e checagem de “quase lotado”
-log_payload_preview(topic, payload, sizeof(payload));
-
-if (strlen(payload) >= sizeof(payload) - 1) {
-    ESP_LOGW("MQTT/DBG", "payload encostou no limite do buffer (%u). Considere aumentar.",
-             (unsigned)sizeof(payload));
+    return mqtt_payload_build_from_sd(topic, topic_sz, payload, payload_sz,
+                                      rec_idx, points, new_cur);
 }
 
-    // 4) Configura conexão MQTT
+// Configuração da conexão (host/porta/TLS/credenciais/client_id) a partir da config
+esp_err_t mqtt_wifi_fill_conn_cfg(const mqtt_wifi_target_t *t, const char *topic,
+                                  mqtt_conn_cfg_t *cfg)
+{
+    const char *host = get_mqtt_url();
     int port = (int)get_mqtt_port();
     if (!host || !host[0]) {
         ESP_LOGE("MQTT/WIFI", "Host do broker vazio.");
@@ -167,11 +153,11 @@ if (strlen(payload) >= sizeof(payload) - 1) {
         if (has_network_pw_enabled())   password = get_network_pw();
     }
     // Ubidots aceita senha vazia se usar token como username
-    if (host && strstr(host, "ubidots.com") != NULL) {
+    if (strstr(host, "ubidots.com") != NULL) {
         if (!password) password = "";
     }
 
-    mqtt_conn_cfg_t cfg = {
+    *cfg = (mqtt_conn_cfg_t){
         .host          = host,
         .port          = port,
         .use_tls       = use_tls,
@@ -183,8 +169,8 @@ if (strlen(payload) >= sizeof(payload) - 1) {
         .clean_session = true,
     };
 
-    // 4.1) [WEG] Força ClientID = DeviceID extraído do tópico "wnology/<ID>/state"
-    if (is_weg) {
+    // [WEG] Força ClientID = DeviceID extraído do tópico "wnology/<ID>/state"
+    if (t->is_weg && topic) {
         static char weg_client_id[64];
         const char *p  = strchr(topic, '/');           // após "wnology"
         const char *id = p ? p + 1 : NULL;             // início do <ID>
@@ -194,47 +180,200 @@ if (strlen(payload) >= sizeof(payload) - 1) {
             if (n > 0 && n < sizeof(weg_client_id)) {
                 memcpy(weg_client_id, id, n);
                 weg_client_id[n] = '\0';
-                cfg.client_id = weg_client_id;
+                cfg->client_id = weg_client_id;
             }
         }
     }
 
-    // 4.2) Log de config (não vaza segredos)
+    // Log de config (não vaza segredos)
     ESP_LOGI("MQTT/CFG",
              "host=%s port=%d tls=%d client_id=%s topic='%s' user_len=%d pw_len=%d",
-             cfg.host, cfg.port, cfg.use_tls, cfg.client_id, topic,
-             cfg.username ? (int)strlen(cfg.username) : 0,
-             cfg.password ? (int)strlen(cfg.password) : 0);
+             cfg->host, cfg->port, cfg->use_tls, cfg->client_id, topic ? topic : "",
+             cfg->username ? (int)strlen(cfg->username) : 0,
+             cfg->password ? (int)strlen(cfg->password) : 0);
+    return ESP_OK;
+}
+
+// Na bateria e com carga baixa a sessão volta ao comportamento antigo (1 lote)
+static bool stream_low_energy(void)
+{
+    return !battery_monitor_power_source_ok() && battery_monitor_get_soc() < MQTT_STREAM_LOW_SOC;
+}
+
+// Tempo que sobra da sessão, limitado a 'cap_ms' (0 = acabou)
+static uint32_t budget_left_ms(uint64_t t0_us, uint32_t budget_ms, uint32_t cap_ms)
+{
+    uint64_t used_ms = (esp_timer_get_time() - t0_us) / 1000ULL;
+    if (used_ms >= budget_ms) return 0;
+    uint32_t left = budget_ms - (uint32_t)used_ms;
+    return (left < cap_ms) ? left : cap_ms;
+}
+
+// mqtt_tcp.c
+esp_err_t mqtt_wifi_publish_now(uint32_t budget_ms)
+{
+    if (budget_ms == 0 || budget_ms > MQTT_STREAM_BUDGET_MS) budget_ms = MQTT_STREAM_BUDGET_MS;
+
+    // 0) STA precisa estar conectada
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        ESP_LOGW("MQTT/WIFI", "STA não conectada; abortando envio MQTT.");
+        return ESP_ERR_INVALID_STATE;
+    }
+       mqtt_publisher_init_once();
+
+    // Sessão persistente ativa (sempre ligado): ela publica; só avisa que há dados
+    if (mqtt_session_is_running()) {
+        mqtt_session_kick();
+        return ESP_OK;
+    }
+       
+    // 1) Carrega índices e buffers
+    struct record_index_config rec_idx = {0};
+    get_index_config(&rec_idx);
+
+    char     topic[192]    = {0};
+    uint32_t points        = 0;
+    uint32_t new_cur       = rec_idx.cursor_position;
+
+    // O lote enche o buffer: quantos pontos cabem depende só do tamanho dele
+    char *payload = malloc(MQTT_WIFI_PAYLOAD_MAX);
+    if (!payload) {
+        ESP_LOGE("MQTT/WIFI", "Sem memória para o payload (%u B).", (unsigned)MQTT_WIFI_PAYLOAD_MAX);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 2) Autodeteção do destino
+    mqtt_wifi_target_t target;
+    mqtt_wifi_detect_target(&target);
+
+    // 3) Monta topic/payload a partir do SD
+    esp_err_t err = mqtt_wifi_build_batch(&target, topic, sizeof(topic),
+                                          payload, MQTT_WIFI_PAYLOAD_MAX, &rec_idx, &points, &new_cur);
+    if (err != ESP_OK) {
+        ESP_LOGE("MQTT/WIFI", "Falha ao montar payload: %s", esp_err_to_name(err));
+        free(payload);
+        return err;
+    }
+    if (points == 0) {
+        ESP_LOGI("MQTT/WIFI", "Nenhum ponto para enviar.");
+        free(payload);
+        return ESP_OK;
+    }
+    
+    ESP_LOGI("MQTT/WIFI", "topic='%s' points=%u payload_len=%u",
+         topic, (unsigned)points, (unsigned)strlen(payload));
+
+// [NOVO] Preview
+log_payload_preview(topic, payload, MQTT_WIFI_PAYLOAD_MAX);
+
+    // 4) Configura conexão MQTT
+    mqtt_conn_cfg_t cfg;
+    err = mqtt_wifi_fill_conn_cfg(&target, topic, &cfg);
+    if (err != ESP_OK) {
+        free(payload);
+        return err;
+    }
 
-    // 5) Conecta e publica QoS1
+    // Endereço resolvido antes (cache em RTC com TTL): conecta direto nele
+    char     host_ip[16];
+    uint32_t ip4 = 0;
+    if (wifi_fast_resolve(cfg.host, &ip4, 0) == ESP_OK) {
+        esp_ip4_addr_t a = { .addr = ip4 };
+        cfg.host_ip = esp_ip4addr_ntoa(&a, host_ip, sizeof(host_ip));
+    }
+
+    // 5) Conecta uma vez e drena o backlog em lotes consecutivos.
+    //    Até MQTT_STREAM_WINDOW publishes QoS1 ficam em voo; cada PUBACK, na
+    //    ordem dos lotes, avança o índice de leitura. Para no fim dos dados,
+    //    no orçamento de tempo/lotes ou com bateria baixa.
     uint64_t t0_us = esp_timer_get_time();
-    mqtt_esp_handle_t h = mqtt_client_esp_create_and_connect(&cfg, 10000);
+    mqtt_esp_handle_t h = mqtt_client_esp_create_and_connect(&cfg, (int)budget_left_ms(t0_us, budget_ms, 10000));
     if (!h) {
-        ESP_LOGE("MQTT/WIFI", "Broker MQTT indisponível.");
+        ESP_LOGE("MQTT/WIFI", "Broker MQTT indisponível%s.", cfg.host_ip ? " no endereço em cache" : "");
+        // O servidor pode ter mudado de endereço: a próxima tentativa consulta o DNS
+        if (cfg.host_ip) wifi_fast_dns_forget(cfg.host);
+        free(payload);
         return ESP_FAIL;
     }
+    uint64_t t_conn_us = esp_timer_get_time();
 
-    err = mqtt_client_esp_publish(h, topic, payload,
-                                  /*qos*/1, /*retain*/false,
-                                  /*timeout_ms*/10000, NULL);
+    typedef struct {
+        int      msg_id;
+        uint32_t points;
+        uint32_t new_cur;
+        bool     acked;
+    } stream_batch_t;
 
-    mqtt_client_esp_stop_and_destroy(h);
+    stream_batch_t inflight[MQTT_STREAM_WINDOW];
+    size_t   n_inflight   = 0;
+    bool     ready        = true;    // já existe um lote montado em payload
+    uint32_t max_batches  = stream_low_energy() ? 1 : MQTT_STREAM_MAX_BATCHES;
+    uint32_t sent_batches = 0, acked_batches = 0, acked_points = 0;
+    struct record_index_config stage = rec_idx;   // posição de montagem (à frente do índice)
+
+    while (ready || n_inflight > 0) {
+        // 5.1) Enche a janela
+        while (ready && n_inflight < MQTT_STREAM_WINDOW) {
+            int msg_id = -1;
+            err = mqtt_client_esp_publish_nowait(h, topic, payload, /*retain*/false, &msg_id);
+            if (err != ESP_OK) { ready = false; break; }
 
-    // 6) Avança índices só se sucesso
-    if (err == ESP_OK) {
-        if (rec_idx.total_idx > 0) {
-            rec_idx.last_read_idx = (rec_idx.last_read_idx + points) % rec_idx.total_idx;
+            inflight[n_inflight++] = (stream_batch_t){ msg_id, points, new_cur, false };
+            sent_batches++;
+            stage.cursor_position = new_cur;
+
+            ready = false;
+            if (sent_batches >= max_batches || budget_left_ms(t0_us, budget_ms, UINT32_MAX) == 0) {
+                break;   // orçamento: só espera os PUBACKs pendentes
+            }
+            points = 0;
+            if (mqtt_wifi_build_batch(&target, topic, sizeof(topic),
+                                      payload, MQTT_WIFI_PAYLOAD_MAX, &stage, &points, &new_cur) == ESP_OK &&
+                points > 0) {
+                ready = true;
+            }
+        }
+        if (n_inflight == 0) break;
+
+        // 5.2) Próximo PUBACK
+        int acked_id = -1;
+        uint32_t ack_ms = budget_left_ms(t0_us, budget_ms, 10000);
+        if (ack_ms == 0) { err = ESP_ERR_TIMEOUT; break; }
+        err = mqtt_client_esp_wait_ack(h, (int)ack_ms, &acked_id);
+        if (err != ESP_OK) break;
+        for (size_t i = 0; i < n_inflight; ++i) {
+            if (inflight[i].msg_id == acked_id) inflight[i].acked = true;
+        }
+
+        // 5.3) Confirma os lotes da frente já reconhecidos (mantém a ordem do SD)
+        while (n_inflight > 0 && inflight[0].acked) {
+            advance_read_index(inflight[0].points, inflight[0].new_cur);
+            acked_batches++;
+            acked_points += inflight[0].points;
+            n_inflight--;
+            memmove(&inflight[0], &inflight[1], n_inflight * sizeof(inflight[0]));
         }
-        rec_idx.cursor_position = new_cur;
-        save_index_config(&rec_idx);
-        ESP_LOGI("MQTT/WIFI", "Envio OK: +%u ponto(s)", (unsigned)points);
-    } else {
-        ESP_LOGE("MQTT/WIFI", "Falha no publish; índices NÃO avançados.");
     }
 
-    ESP_LOGI("MQTT/TIME", "publish_cost=%llums",
-             (unsigned long long)((esp_timer_get_time() - t0_us)/1000ULL));
-    return err;
-}
+    mqtt_client_esp_stop_and_destroy(h);
+    free(payload);
 
+    // 6) Só os lotes confirmados avançaram o índice
+    if (n_inflight > 0) {
+        ESP_LOGE("MQTT/WIFI", "Sessão interrompida: %u lote(s) sem PUBACK; índices NÃO avançados para eles.",
+                 (unsigned)n_inflight);
+    }
+    ESP_LOGI("MQTT/WIFI", "Envio: %u/%u lote(s) confirmados, +%u ponto(s)",
+             (unsigned)acked_batches, (unsigned)sent_batches, (unsigned)acked_points);
+
+    uint64_t now_us     = esp_timer_get_time();
+    uint64_t session_ms = (now_us - t_conn_us) / 1000ULL;
+    ESP_LOGI("MQTT/TIME", "publish_cost=%llums connect=%llums session=%llums rate=%u pts/s",
+             (unsigned long long)((now_us - t0_us)/1000ULL),
+             (unsigned long long)((t_conn_us - t0_us)/1000ULL),
+             (unsigned long long)session_ms,
+             (unsigned)(session_ms ? (acked_points * 1000ULL) / session_ms : acked_points));
 
+    return (acked_batches > 0) ? ESP_OK : (err != ESP_OK ? err : ESP_FAIL);
+}
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "datalogger_control.h"
+#include "json_writer.h"
 
 // =================== Getters vindos do seu FRONT/NVS ===================
 // Suas implementações existentes irão sobrescrever as WEAK do .c
@@ -38,6 +39,15 @@ esp_err_t mqtt_payload_build_from_sd(char *topic_out,  size_t topic_sz,
                                      uint32_t *points_out,
                                      uint32_t *cursor_out);
 
+// Mesmo JSON do builder acima, escrito em 'w' (buffer, medição ou sink).
+// Para no fim dos dados, no limite do writer (registro que não cabe volta
+// para o SD) ou em max_points (0 = sem limite). Não fecha o writer.
+esp_err_t mqtt_payload_write_from_sd(json_writer_t *w,
+                                     const struct record_index_config *rec_index_in,
+                                     uint32_t max_points,
+                                     uint32_t *points_out,
+                                     uint32_t *cursor_out);
+
 // Callback opcional para injetar campos adicionais em "data" do JSON canônico.
 // (Se não implementar, uma versão WEAK adiciona {"heartbeat":1})
 int mqtt_payload_fill_data(void *cjson_data_object /* cJSON* */);
@@ -65,6 +65,10 @@ int64_t epoch_s_utc(void);
 // Retorna true se adicionou com sucesso.
 bool payload_add_time_iso(cJSON *root, const char *date, const char *time_str);
 
+// Mesmo texto de payload_add_time_iso(), só que em 'out' (para o json_writer).
+// out_sz >= 40 cobre os dois formatos.
+bool payload_time_iso(const char *date, const char *time_str, char *out, size_t out_sz);
+
 // Macro “azucar sintáctico”
 #define PAYLOAD_ADD_TIME(root_, date_, time_)  \
     (void)payload_add_time_iso((root_), (date_), (time_))
@@ -13,14 +13,10 @@
 #include "esp_log.h"
 #include <stdlib.h>
 #include "payload_time.h"
+#include "json_writer.h"
 // === Ajuste o nome do header conforme seu projeto (índices/SD) ===
 #include "sdmmc_driver.h"   // precisa fornecer: record_index_config, record_data_saved, read_record_sd(), get_index_config(), save_index_config(), UNSPECIFIC_RECORD
 
-// =================== Builder a partir do SD (com índice) ===================
-#ifndef MAX_POINTS_TO_SEND
-#define MAX_POINTS_TO_SEND 10
-#endif
-
 static const char *TAG = "MQTT/BUILDER";
 
 __attribute__((weak)) const char *get_mqtt_ca_pem(void)            { return NULL; }
@@ -135,46 +131,40 @@ int mqtt_subchannel_for(int canal, const struct record_data_saved *rec)
 
 // =================== Builder a partir do SD (com índice) ===================
 
-esp_err_t mqtt_payload_build_from_sd(char *topic_out,  size_t topic_sz,
-                                     char *payload_out,size_t payload_sz,
+esp_err_t mqtt_payload_write_from_sd(json_writer_t *w,
                                      const struct record_index_config *rec_index_in,
+                                     uint32_t max_points,
                                      uint32_t *points_out,
                                      uint32_t *cursor_out)
 {
-    if (!topic_out || !payload_out || !rec_index_in || !points_out || !cursor_out) {
+    if (!w || !rec_index_in || !points_out || !cursor_out) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 1) Tópico
-    const char *topic_ui = get_mqtt_topic();
-    if (topic_ui && topic_ui[0]) snprintf(topic_out, topic_sz, "%s", topic_ui);
-    else                         default_topic(topic_out, topic_sz);
-
-    // 2) Cabeçalho do payload
-    cJSON *root = cJSON_CreateObject();
-    if (!root) return ESP_ERR_NO_MEM;
+    // 1) Cabeçalho do payload (sem árvore cJSON)
+    jw_obj_begin(w, NULL);
 
     const char *dev = get_device_id(); if (!dev || !dev[0]) dev = "esp32";
-    cJSON_AddStringToObject(root, "id", dev);
-    if (get_name() && get_name()[0])                   cJSON_AddStringToObject(root, "Nome", get_name());
-    if (get_serial_number() && get_serial_number()[0]) cJSON_AddStringToObject(root, "Número Serial", get_serial_number());
-    if (get_phone() && get_phone()[0])                 cJSON_AddStringToObject(root, "Telefone", get_phone());
-    cJSON_AddNumberToObject(root, "CSQ", get_csq());
+    jw_str(w, "id", dev);
+    if (get_name() && get_name()[0])                   jw_str(w, "Nome", get_name());
+    if (get_serial_number() && get_serial_number()[0]) jw_str(w, "Número Serial", get_serial_number());
+    if (get_phone() && get_phone()[0])                 jw_str(w, "Telefone", get_phone());
+    jw_num(w, "CSQ", get_csq());
 
-    if (has_network_user_enabled())  cJSON_AddStringToObject(root, "Usuario", get_network_user());
-    if (has_network_pw_enabled())    cJSON_AddStringToObject(root, "Senha",   get_network_pw());
-    if (has_network_token_enabled()) cJSON_AddStringToObject(root, "Token",   get_network_token());
+    if (has_network_user_enabled())  jw_str(w, "Usuario", get_network_user());
+    if (has_network_pw_enabled())    jw_str(w, "Senha",   get_network_pw());
+    if (has_network_token_enabled()) jw_str(w, "Token",   get_network_token());
 
-    cJSON *meas_array = cJSON_CreateArray();
-    if (!meas_array) { cJSON_Delete(root); return ESP_ERR_NO_MEM; }
-    cJSON_AddItemToObject(root, "measurements", meas_array);
+    jw_arr_begin(w, "measurements");
 
-    // 3) Varredura do SD
+    // 2) Varredura do SD: vai até o fim dos dados ou até o próximo registro
+    //    não caber no limite do writer (o tamanho do lote vem do transporte)
     *cursor_out = rec_index_in->cursor_position;
     *points_out = 0;
 
-    for (int i = 0; i < MAX_POINTS_TO_SEND; ++i) {
+    while (max_points == 0 || *points_out < max_points) {
         struct record_data_saved db;
+        uint32_t cursor_before = *cursor_out;
         if (read_record_sd(cursor_out, &db) != ESP_OK) break;
 
         // Mapeia Canal/Subcanal (31..39 -> 3.1..3.9; fallback XY -> X.Y)
@@ -190,36 +180,67 @@ esp_err_t mqtt_payload_build_from_sd(char *topic_out,  size_t topic_sz,
             sub  = ch % 10;
         }
 
-        cJSON *rec = cJSON_CreateObject();
-        if (!rec) { ESP_LOGE(TAG, "cJSON_CreateObject falhou"); break; }
+        json_writer_mark_t mark;
+        jw_mark(w, &mark);
 
         // db.date/time já vêm limpos do read_record_sd()
-        cJSON_AddStringToObject(rec, "Data",  db.date);
-        cJSON_AddStringToObject(rec, "Hora",  db.time);
-        PAYLOAD_ADD_TIME(rec, db.date, db.time);
-        cJSON_AddNumberToObject(rec, "Canal", base);
+        char iso[40];
+        payload_time_iso(db.date, db.time, iso, sizeof iso);
+        jw_obj_begin(w, NULL);
+        jw_str(w, "Data",  db.date);
+        jw_str(w, "Hora",  db.time);
+        jw_str(w, "time",  iso);
+        jw_num(w, "Canal", base);
         if (sub > 0) {                       // <— só envia quando existir subcanal
-            cJSON_AddNumberToObject(rec, "Subcanal", sub);
+            jw_num(w, "Subcanal", sub);
+        }
+        jw_num(w, "Dados", atof(db.data));
+        jw_obj_end(w);
+
+        // Não coube: devolve o registro para o próximo lote
+        if (!jw_can_close(w)) {
+            jw_rewind(w, &mark);
+            *cursor_out = cursor_before;
+            ESP_LOGD(TAG, "Limite do lote com %u ponto(s); restante fica para o próximo",
+                     (unsigned)*points_out);
+            break;
         }
-        cJSON_AddNumberToObject(rec, "Dados", atof(db.data));
-
-        cJSON_AddItemToArray(meas_array, rec);
         (*points_out)++;
     }
 
-    // 4) Serialização
-    char *txt = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    if (!txt) return ESP_ERR_NO_MEM;
+    jw_arr_end(w);
+    jw_obj_end(w);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_payload_build_from_sd(char *topic_out,  size_t topic_sz,
+                                     char *payload_out,size_t payload_sz,
+                                     const struct record_index_config *rec_index_in,
+                                     uint32_t *points_out,
+                                     uint32_t *cursor_out)
+{
+    if (!topic_out || !payload_out || !rec_index_in || !points_out || !cursor_out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 1) Tópico
+    const char *topic_ui = get_mqtt_topic();
+    if (topic_ui && topic_ui[0]) snprintf(topic_out, topic_sz, "%s", topic_ui);
+    else                         default_topic(topic_out, topic_sz);
 
-    size_t need = strlen(txt) + 1;
-    if (need > payload_sz) {
-        ESP_LOGE(TAG, "Payload insuficiente: need=%u have=%u", (unsigned)need, (unsigned)payload_sz);
-        cJSON_free(txt);
+    // 2) Payload direto em payload_out: cabe quantos pontos o buffer comportar
+    json_writer_t w;
+    jw_init(&w, payload_out, payload_sz);
+    esp_err_t err = mqtt_payload_write_from_sd(&w, rec_index_in, 0, points_out, cursor_out);
+    if (err != ESP_OK) return err;
+
+    // 3) Fecha o texto
+    size_t len = 0;
+    err = jw_finish(&w, &len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Payload insuficiente: need=%u have=%u", (unsigned)(len + 1), (unsigned)payload_sz);
         return ESP_ERR_NO_MEM;
     }
-    memcpy(payload_out, txt, need);
-    cJSON_free(txt);
 
     return ESP_OK;
 }
@@ -423,16 +444,27 @@ esp_err_t mqtt_payload_build_from_sd_weg_energy(char *topic_out,  size_t topic_s
     int64_t  ts_ms      = 0;       // manteremos o MAIS RECENTE em UTC (ms)
     uint32_t consumed   = 0;
 
-    for (int i = 0; i < MAX_POINTS_TO_SEND; ++i) {
+    // Um snapshot = no máximo uma leitura de cada grandeza: a segunda leitura
+    // de um canal já visto abre o próximo snapshot e fica no SD
+    for (;;) {
         struct record_data_saved db;
+        uint32_t cursor_before = *cursor_out;
         if (read_record_sd(cursor_out, &db) != ESP_OK) {
             break;
         }
-        consumed++;
 
         int base = 0, sub = 0;
         split_channel((int)db.channel, &base, &sub);  // mapeia 31.39 -> 3.1.3.9
 
+        bool seen = (base == 3 && ((sub == 1 && have_a) || (sub == 2 && have_b) ||
+                                   (sub == 3 && have_c))) ||
+                    (base == 1 && have_pulse);
+        if (seen) {
+            *cursor_out = cursor_before;
+            break;
+        }
+        consumed++;
+
         if (base == 3) {
             // 3.x → correntes
             if      (sub == 1) { val_a = atof(db.data); have_a = true; }
@@ -474,46 +506,36 @@ esp_err_t mqtt_payload_build_from_sd_weg_energy(char *topic_out,  size_t topic_s
     }
 
     // 3) Monta o "state" da WEGnology
-    cJSON *root = cJSON_CreateObject();
-    if (!root) return ESP_ERR_NO_MEM;
+    json_writer_t w;
+    jw_init(&w, payload_out, payload_sz);
+    jw_obj_begin(&w, NULL);
 
     // Campo obrigatório da plataforma: epoch em milissegundos (UTC)
-    cJSON_AddNumberToObject(root, "time", (double)ts_ms);
+    jw_num(&w, "time", (double)ts_ms);
 
     // Opcional: metadata com carimbos em UTC (seguro para ingestion e útil para auditoria)
     {
-        cJSON *meta = cJSON_CreateObject();
-        if (meta) {
-            char ts_iso[25];
-            iso8601_utc(ts_iso, sizeof ts_iso);            // "YYYY-MM-DDTHH:MM:SSZ"
-            cJSON_AddStringToObject(meta, "ts_iso", ts_iso);
-            cJSON_AddNumberToObject(meta, "ts_s", (double)(ts_ms / 1000));
-            cJSON_AddItemToObject(root, "metadata", meta);
-        }
+        char ts_iso[25];
+        iso8601_utc(ts_iso, sizeof ts_iso);            // "YYYY-MM-DDTHH:MM:SSZ"
+        jw_obj_begin(&w, "metadata");
+        jw_str(&w, "ts_iso", ts_iso);
+        jw_num(&w, "ts_s", (double)(ts_ms / 1000));
+        jw_obj_end(&w);
     }
 
     // Dados do snapshot
-    cJSON *data = cJSON_CreateObject();
-    if (!data) { cJSON_Delete(root); return ESP_ERR_NO_MEM; }
-    cJSON_AddItemToObject(root, "data", data);
-
-    if (have_a)     cJSON_AddNumberToObject(data, "i_a",        val_a);
-    if (have_b)     cJSON_AddNumberToObject(data, "i_b",        val_b);
-    if (have_c)     cJSON_AddNumberToObject(data, "i_c",        val_c);
-    if (have_pulse) cJSON_AddNumberToObject(data, "pulse_count", val_pulse);   // <<< NOVO
-
-    // Serializa para o buffer de saída
-    char *txt = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    if (!txt) return ESP_ERR_NO_MEM;
-
-    size_t need = strlen(txt) + 1;
-    if (need > payload_sz) {
-        cJSON_free(txt);
+    jw_obj_begin(&w, "data");
+    if (have_a)     jw_num(&w, "i_a",        val_a);
+    if (have_b)     jw_num(&w, "i_b",        val_b);
+    if (have_c)     jw_num(&w, "i_c",        val_c);
+    if (have_pulse) jw_num(&w, "pulse_count", val_pulse);   // <<< NOVO
+    jw_obj_end(&w);
+    jw_obj_end(&w);
+
+    // Fecha o texto no buffer de saída
+    if (jw_finish(&w, NULL) != ESP_OK) {
         return ESP_ERR_NO_MEM;
     }
-    memcpy(payload_out, txt, need);
-    cJSON_free(txt);
 
     // quantos registros do SD foram consumidos neste ciclo
     *points_out = consumed;
@@ -547,9 +569,17 @@ esp_err_t mqtt_payload_build_from_sd_weg_water(char *topic_out,  size_t topic_sz
     int64_t  ts_ms   = 0;     // mais recente observado entre os registros
     uint32_t consumed = 0;
 
-    for (int i = 0; i < MAX_POINTS_TO_SEND; ++i) {
+    // Mesmo critério do snapshot de energia: canal repetido fica para o próximo
+    for (;;) {
         struct record_data_saved db;
+        uint32_t cursor_before = *cursor_out;
         if (read_record_sd(cursor_out, &db) != ESP_OK) break;
+
+        if (((int)db.channel == 0 && have_p1) || ((int)db.channel == 2 && have_p2) ||
+            ((int)db.channel == 1 && have_flow)) {
+            *cursor_out = cursor_before;
+            break;
+        }
         consumed++;
 
         // ===== MAPA DE CANAIS =====
@@ -577,38 +607,32 @@ esp_err_t mqtt_payload_build_from_sd_weg_water(char *topic_out,  size_t topic_sz
     if (ts_ms <= 0) ts_ms = epoch_ms_utc();
 
     // 3) Monta o "state" da WEGnology/Losant
-    cJSON *root = cJSON_CreateObject();
-    if (!root) return ESP_ERR_NO_MEM;
+    json_writer_t w;
+    jw_init(&w, payload_out, payload_sz);
+    jw_obj_begin(&w, NULL);
 
     // Campo obrigatório para WEG/Losant: sempre em ms UTC
-    cJSON_AddNumberToObject(root, "time", ts_ms);
+    jw_num(&w, "time", (double)ts_ms);
 
     // Carimbos extras (opc.: úteis no debug/traço)
     {
         char ts_iso[25];
         iso8601_utc(ts_iso, sizeof ts_iso);              // "YYYY-MM-DDTHH:MM:SSZ"
-        cJSON_AddStringToObject(root, "timestamp", ts_iso);
-        cJSON_AddNumberToObject(root, "ts_ms", (double)ts_ms);
+        jw_str(&w, "timestamp", ts_iso);
+        jw_num(&w, "ts_ms", (double)ts_ms);
     }
 
-    cJSON *data = cJSON_CreateObject();
-    if (!data) { cJSON_Delete(root); return ESP_ERR_NO_MEM; }
-    cJSON_AddItemToObject(root, "data", data);
+    jw_obj_begin(&w, "data");
 
     // ===== ATRIBUTOS DO DEVICE (precisam existir lá) =====
-    if (have_p1)   cJSON_AddNumberToObject(data, "press_1", val_p1);
-    if (have_p2)   cJSON_AddNumberToObject(data, "press_2", val_p2);
-    if (have_flow) cJSON_AddNumberToObject(data, "flow",    val_flow);
-
-    // Serializa
-    char *txt = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    if (!txt) return ESP_ERR_NO_MEM;
-
-    size_t need = strlen(txt) + 1;
-    if (need > payload_sz) { cJSON_free(txt); return ESP_ERR_NO_MEM; }
-    memcpy(payload_out, txt, need);
-    cJSON_free(txt);
+    if (have_p1)   jw_num(&w, "press_1", val_p1);
+    if (have_p2)   jw_num(&w, "press_2", val_p2);
+    if (have_flow) jw_num(&w, "flow",    val_flow);
+    jw_obj_end(&w);
+    jw_obj_end(&w);
+
+    // Fecha o texto
+    if (jw_finish(&w, NULL) != ESP_OK) return ESP_ERR_NO_MEM;
 
     *points_out = consumed; // quantos registros do SD foram consumidos
     ESP_LOGI("MQTT/BUILDER", "[WEG/WATER] topic=%s ts_ms=%lld press_1=%g press_2=%g flow=%g",
@@ -60,9 +60,9 @@ static void format_offset_from_minutes(int minutes, char *buf, size_t n) {
 // ------------------------------------------------------------------
 // IMPLEMENTAÇÃO PRINCIPAL
 // ------------------------------------------------------------------
-bool payload_add_time_iso(cJSON *root, const char *date, const char *time_str)
+bool payload_time_iso(const char *date, const char *time_str, char *out, size_t out_sz)
 {
-    if (!root) return false;
+    if (!out || out_sz == 0) return false;
 
 #if CONFIG_PAYLOAD_TIMESTAMP_UTC
 
@@ -72,9 +72,7 @@ bool payload_add_time_iso(cJSON *root, const char *date, const char *time_str)
     if (ts_ms <= 0) ts_ms = epoch_ms_utc();
     ts_ms = apply_minutes_offset_ms(ts_ms);
 
-    char iso_utc[32];
-    iso8601_utc_from_ms(ts_ms, iso_utc, sizeof iso_utc);  // garante o 'Z' no final
-    cJSON_AddStringToObject(root, "time", iso_utc);
+    iso8601_utc_from_ms(ts_ms, out, out_sz);  // garante o 'Z' no final
     return true;
 
 #else // CONFIG_PAYLOAD_TIMESTAMP_LOCAL
@@ -85,9 +83,7 @@ bool payload_add_time_iso(cJSON *root, const char *date, const char *time_str)
     if (!parse_ddmmyyyy_hhmmss(date, time_str, &Y, &M, &D, &h, &m, &s)) {
         // fallback: gera UTC Z se parsing falhar
         int64_t ts_ms = epoch_ms_utc();
-        char iso_utc[32];
-        iso8601_utc_from_ms(ts_ms, iso_utc, sizeof iso_utc);
-        cJSON_AddStringToObject(root, "time", iso_utc);
+        iso8601_utc_from_ms(ts_ms, out, out_sz);
         return true;
     }
 
@@ -100,18 +96,25 @@ bool payload_add_time_iso(cJSON *root, const char *date, const char *time_str)
     format_offset_from_minutes(-180, tz_off, sizeof tz_off);
 #endif
 
-    char iso_local[40];
     // "YYYY-MM-DDTHH:MM:SS±HH:MM"
-    snprintf(iso_local, sizeof iso_local,
+    snprintf(out, out_sz,
              "%04d-%02d-%02dT%02d:%02d:%02d%s",
              Y, M, D, h, m, s, tz_off);
-
-    cJSON_AddStringToObject(root, "time", iso_local);
     return true;
 
 #endif
 }
 
+bool payload_add_time_iso(cJSON *root, const char *date, const char *time_str)
+{
+    if (!root) return false;
+
+    char iso[40];
+    payload_time_iso(date, time_str, iso, sizeof iso);
+    cJSON_AddStringToObject(root, "time", iso);
+    return true;
+}
+
 void utc_selftest_once(void)
 {
     const char *TAG = "UTC/SELFTEST";
@@ -28,6 +28,9 @@
 #define POWER_SOURCE_MIN_OK   4.5f
 #define POWER_SOURCE_MAX_OK   18.0f
 
+// Abaixo disso (sem fonte externa) dados em RAM/RTC são gravados antes de dormir
+#define BATT_POWER_RISK_PERCENT 15
+
 // Fatores de escala do divisor
 #define BATTERY_SCALE_FACTOR        2.0f                        // divisor 10k/10k
 #define POWER_SOURCE_SCALE_FACTOR  ((10000.0f + 2200.0f) / 2200.0f) // ≈5.545 divisor 10k/2.2k
@@ -51,7 +54,7 @@
 // Inicializa o monitor (carrega estado do NVS)
 void battery_monitor_init(bool enable_interactive_calibration);
 
-// Atualiza leituras de bateria e fonte, preenche self_monitoring_data e grava JSON
+// Atualiza leituras de bateria e fonte, preenche self_monitoring_data (cópia em RTC)
 void battery_monitor_update(void);
 
 // Retorna tensão medida da bateria (volts)
@@ -69,6 +72,14 @@ float battery_monitor_get_power_source_voltage(void);
 // Indica se a fonte está dentro da faixa aceitável
 bool battery_monitor_power_source_ok(void);
 
+// Sem fonte externa e bateria abaixo de BATT_POWER_RISK_PERCENT. Usa a última
+// medição (desta ativação ou de antes do deep sleep); bateria nunca medida
+// ou ausente => false
+bool battery_monitor_power_at_risk(void);
+
+// Teste rápido de carga (queda de tensão); chamar após battery_monitor_update()
+void battery_health_check_under_load(void);
+
 // Deve ser chamada quando detectar carregamento completo (para resetar aging)
 void battery_monitor_mark_full_charge(void);
 
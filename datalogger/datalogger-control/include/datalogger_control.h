@@ -71,6 +71,7 @@ time_t get_last_pulse_milisec(void);*/
 //CONFIG FUNCTIONS
 void init_config_control(void);
 void save_config(void);
+void reload_config(void);
 void save_system_config_data_time(void);
 char * get_apn(void);
 void set_apn(char* apn);
@@ -185,6 +186,8 @@ bool has_device_active(void);
 void set_device_active(bool turn_on_off);
 bool has_timestamp_mode(void);
 void set_timestamp_mode(bool timestamp);
+bool has_binary_payload(void);
+void set_binary_payload(bool binary);
 void config_system_time(void);
 void log_system_time(void);
 
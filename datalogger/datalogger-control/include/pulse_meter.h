@@ -22,6 +22,7 @@ struct record_pulse_config {
     uint32_t    last_pulse_count;
     uint32_t    current_pulse_count;
     uint32_t    last_saved_daykey; 
+    uint64_t    pulse_total;        // totalizador de 64 bits (0 em arquivos antigos)
 };
 
 struct record_pulse {
@@ -57,6 +58,13 @@ void init_pulse_meter_task(void);
 float flow(uint32_t count);
 uint32_t get_measured_pulse_count(void);
 void pulse_meter_prepare_for_sleep(void);
+// Zera o contador se o dia mudou e o reset diário estiver habilitado
+bool pulse_meter_check_daily_reset(void);
+
+// Totalizador em RTC (sobrevive ao deep sleep; flash só na virada do dia)
+uint64_t pulse_totalizer_count(void);
+uint32_t pulse_totalizer_get_checkpoint(void);
+void pulse_totalizer_set_checkpoint(uint32_t counter);
 
 esp_err_t save_pulse_measurement(int);
 
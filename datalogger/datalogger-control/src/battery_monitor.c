@@ -9,6 +9,7 @@
 #include <string.h>
 #include <errno.h>
 #include "freertos/semphr.h"
+#include "esp_attr.h"
 #include "datalogger_control.h"
 #include "datalogger_driver.h"
 
@@ -34,7 +35,10 @@ static float prev_voltage_battery = -1.0f;
 static float voltage_battery = 0.0f;
 static float voltage_power_source = 0.0f;
 
-static int64_t last_self_mon_save_ts = 0; // em ticks de ms
+// Resultado da última medição, atravessa o deep sleep (ciclos que não medem
+// continuam sabendo se há bateria). Zero no cold boot = nunca medido.
+enum { BATT_MEAS_NONE = 0, BATT_MEAS_ABSENT, BATT_MEAS_PRESENT };
+RTC_DATA_ATTR static uint8_t s_batt_meas = BATT_MEAS_NONE;
 
 static float battery_absence_baseline = 0.0f;
 static float battery_presence_threshold = 0.15f; // fallback inicial
@@ -476,6 +480,18 @@ bool battery_monitor_power_source_ok(void)
     return (voltage_power_source >= POWER_SOURCE_MIN_OK && voltage_power_source <= POWER_SOURCE_MAX_OK);
 }
 
+bool battery_monitor_power_at_risk(void)
+{
+    // 0% em self_monitoring_data também é "nunca medido" (default) e "sem
+    // bateria": nos dois casos não há carga a proteger de um brown-out
+    if (s_batt_meas != BATT_MEAS_PRESENT) {
+        return false;
+    }
+    float    vsrc    = get_power_source_volts();
+    uint32_t percent = get_battery();
+    return vsrc < POWER_SOURCE_MIN_OK && percent < BATT_POWER_RISK_PERCENT;
+}
+
 void battery_monitor_mark_full_charge(void)
 {
     float soc = battery_monitor_get_soc();
@@ -500,7 +516,6 @@ void battery_monitor_save_state(void)
 void battery_monitor_update(void)
 {
 	ESP_LOGI(TAG, "Battery Monitor Update");
-    static int64_t last_self_mon_save_ts = 0;
     static int64_t last_health_check_ts = 0;
 
     // 1. Leituras raw únicas
@@ -615,6 +630,7 @@ void battery_monitor_update(void)
         batt_percent = 0;
         smoothed_soc = 0.0f;
     }
+    s_batt_meas = battery_present ? BATT_MEAS_PRESENT : BATT_MEAS_ABSENT;
 
     // 7. Atualiza struct compartilhada
     set_battery(batt_percent);
@@ -636,11 +652,8 @@ void battery_monitor_update(void)
     printf("ADC raw fonte: %.3fV -> uncalibrated: %.3fV calibrated: %.3fV (factor=%.4f)\n",
            raw_src_adc, voltage_power_source_uncal, voltage_power_source, power_source_scale_correction);
 
-    // 9. Salvamento com debounce
-    if (now_ms - last_self_mon_save_ts >= 500) {
-        if (save_self_monitoring_data(&self_monitoring_data) != ESP_OK) {
-            ESP_LOGW(TAG, "Falha ao salvar self monitoring data");
-        }
-        last_self_mon_save_ts = now_ms;
+    // 9. Cópia em RTC (não toca a flash: a leitura não vai para o config.bin)
+    if (save_self_monitoring_data(&self_monitoring_data) != ESP_OK) {
+        ESP_LOGW(TAG, "Falha ao salvar self monitoring data");
     }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "pressure_meter.h"
 #include "energy_meter.h"
 #include "esp_log.h"
+#include "config_store.h"
 #include "time.h"
 #include <sys/time.h>
 
@@ -116,6 +117,22 @@ void init_config_control(void)
       	   get_pressure_data(&pressure_data);
          }
 
+    // Defaults recém-criados (ou migração do JSON) vão para a flash de uma vez
+    config_store_commit();
+}
+
+// Recarrega as cópias locais após uma importação (config_import_json)
+void reload_config(void)
+{
+    xSemaphoreTake(myMutex, portMAX_DELAY);
+    if (has_network_config())        get_network_config(&net_config);
+    if (has_device_config())         get_device_config(&dev_config);
+    if (has_operation_config())      get_operation_config(&op_config);
+    if (has_system_config())         get_system_config(&system_config);
+    if (has_record_last_unit_time()) get_record_last_unit_time(&record_last_unit_time);
+    if (has_self_monitoring_data())  load_self_monitoring_data(&self_monitoring_data);
+    if (has_pressure_data())         get_pressure_data(&pressure_data);
+    xSemaphoreGive(myMutex);
 }
 
 void save_config(void) {
@@ -127,8 +144,10 @@ void save_config(void) {
     save_operation_config(&op_config);
     save_system_config(&system_config);
     save_record_last_unit_time(&record_last_unit_time);
-    save_self_monitoring_data(&self_monitoring_data);
-    save_pressure_data(&pressure_data);
+    save_self_monitoring_data(&self_monitoring_data);   // só RTC, não suja a imagem
+    // pressure_data não: a leitura vive em RTC e a cópia local pode estar velha
+    // Uma única gravação, e só se alguma seção mudou
+    config_store_commit();
     xSemaphoreGive(myMutex);
 }
 
@@ -139,6 +158,7 @@ void save_system_config_data_time(void)
     time(&system_time);
     set_last_sys_time(system_time);
 	save_system_config(&system_config);
+    config_store_commit();
     xSemaphoreGive(myMutex);
 }
 
@@ -224,6 +244,7 @@ static void save_default_device_config(void)
     
      // modo timestamp (padrão desativado; ajuste se quiser o contrário)
     dev_config.timestamp_mode = false;
+    dev_config.binary_payload = false;
    
     save_device_config(&dev_config);
 
@@ -803,6 +824,16 @@ void set_timestamp_mode(bool timestamp)
     dev_config.timestamp_mode = timestamp;
 }
 
+bool has_binary_payload(void)
+{
+    return dev_config.binary_payload;
+}
+
+void set_binary_payload(bool binary)
+{
+    dev_config.binary_payload = binary;
+}
+
 bool should_save_pulse_zero(void)
 {
     return dev_config.save_pulse_zero;
@@ -813,15 +844,15 @@ void save_pulse_zero(bool save_pulse_zero)
     dev_config.save_pulse_zero = save_pulse_zero;
 }
 //+++++++++++++++++++++++++++++++++++++
+// Checkpoint do último registro: fica no totalizador em RTC (pulse_meter.c),
+// que só escreve a flash na virada do dia ou com risco de brown-out
 void set_last_pulse_count(uint32_t counter)
 {
-	pulse.last_pulse_count = counter;
-	save_record_pulse_config(&pulse);
+	pulse_totalizer_set_checkpoint(counter);
 }
 uint32_t get_last_pulse_count(void)
 {
-    get_record_pulse_config(&pulse);
-    return pulse.last_pulse_count;
+    return pulse_totalizer_get_checkpoint();
 }
 
 void set_current_pulse_count(uint32_t counter)
@@ -52,6 +52,10 @@
   #include "rs485_hw.h" 
   #include "rs485_registry.h"
   #include "xy_md02_driver.h"
+  #include "modbus_dev_profile.h"
+  #include "rs485_scan.h"
+  #include "rs485_model.h"
+  #include "rs485_central.h"
 
 #endif
 
@@ -160,6 +164,10 @@ static esp_err_t rs485_config_get_handler(httpd_req_t *req);
 static esp_err_t rs485_config_post_handler(httpd_req_t *req);
 static esp_err_t rs485_ping_get_handler(httpd_req_t *req);
 static esp_err_t rs485_config_delete_handler(httpd_req_t *req);
+static esp_err_t rs485_health_get_handler(httpd_req_t *req);
+static esp_err_t rs485_scan_get_handler(httpd_req_t *req);
+static esp_err_t rs485_models_get_handler(httpd_req_t *req);
+static esp_err_t rs485_models_post_handler(httpd_req_t *req);
 
 //------------------------------------------------------------------
 
@@ -171,6 +179,8 @@ static esp_err_t rele_activate(httpd_req_t *req);
 //------------------------------------------------------------------
 static esp_err_t load_registers_get_handler(httpd_req_t *req);
 static esp_err_t delete_registers_get_handler(httpd_req_t *req);
+static esp_err_t config_backup_get_handler(httpd_req_t *req);
+static esp_err_t config_backup_post_handler(httpd_req_t *req);
 
 // Variável global para armazenar o último tick de interação
 static TickType_t last_interaction_ticks;
@@ -473,7 +483,7 @@ static esp_err_t start_server(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = 80;
     config.stack_size = 10240; // Aumenta a pilha para evitar falhas
-    config.max_uri_handlers = 25;
+    config.max_uri_handlers = 31;
     config.max_open_sockets = 7; // Mais sockets para múltiplas conexões
     config.lru_purge_enable = true; // Limpa sockets ociosos
     config.uri_match_fn = httpd_uri_match_wildcard;
@@ -686,6 +696,41 @@ httpd_uri_t rs485_cfg_delete_uri = {
 };
 httpd_register_uri_handler(server, &rs485_cfg_delete_uri);
 
+    // ---------------- RS485 HEALTH (GET) ----------------
+    httpd_uri_t rs485_health_get_uri = {
+        .uri      = "/rs485Health",
+        .method   = HTTP_GET,
+        .handler  = rs485_health_get_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &rs485_health_get_uri);
+
+    // ---------------- RS485 SCAN (GET, resposta em chunks) ----------------
+    httpd_uri_t rs485_scan_get_uri = {
+        .uri      = "/rs485Scan",
+        .method   = HTTP_GET,
+        .handler  = rs485_scan_get_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &rs485_scan_get_uri);
+
+    // ---------------- RS485 MODELOS (GET lista / POST novo JSON) ----------------
+    httpd_uri_t rs485_models_get_uri = {
+        .uri      = "/rs485Models",
+        .method   = HTTP_GET,
+        .handler  = rs485_models_get_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &rs485_models_get_uri);
+
+    httpd_uri_t rs485_models_post_uri = {
+        .uri      = "/rs485Models",
+        .method   = HTTP_POST,
+        .handler  = rs485_models_post_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &rs485_models_post_uri);
+
 #endif  
 //----------------------------------------------------------
 //           Delete the file
@@ -698,6 +743,26 @@ httpd_register_uri_handler(server, &rs485_cfg_delete_uri);
         .user_ctx = rest_context
     };
     httpd_register_uri_handler(server, &delete_registers_get_uri);
+
+//----------------------------------------------------------
+//           Backup / restauração da configuração
+//----------------------------------------------------------
+
+    httpd_uri_t config_backup_get_uri = {
+        .uri = "/configBackup",
+        .method = HTTP_GET,
+        .handler = config_backup_get_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &config_backup_get_uri);
+
+    httpd_uri_t config_backup_post_uri = {
+        .uri = "/configBackup",
+        .method = HTTP_POST,
+        .handler = config_backup_post_handler,
+        .user_ctx = rest_context
+    };
+    httpd_register_uri_handler(server, &config_backup_post_uri);
  
 //----------------------------------------------------------
 // AP monitoring by ping
@@ -1029,6 +1094,7 @@ static esp_err_t config_device_post_handler(httpd_req_t *req) {
     set_always_on(cJSON_IsTrue(cJSON_GetObjectItem(root, "always_on")));
     set_device_active(cJSON_IsTrue(cJSON_GetObjectItem(root, "device_active")));
     set_timestamp_mode(cJSON_IsTrue(cJSON_GetObjectItem(root, "timestamp_mode")));
+    set_binary_payload(cJSON_IsTrue(cJSON_GetObjectItem(root, "binary_payload")));
 //    send_value(cJSON_IsTrue(cJSON_GetObjectItem(root, "send_value")));
     // novo: timestamp_mode (opcional no JSON)
 /*    cJSON *ts_item = cJSON_GetObjectItem(root, "timestamp_mode");
@@ -1567,6 +1633,7 @@ static esp_err_t rs485_config_post_handler(httpd_req_t *req)
 
     // Persiste binário consolidado
     esp_err_t ret = save_rs485_config(map, count);
+    rs485_central_invalidate_config();
     if (ret != ESP_OK) {
         cJSON_Delete(root);
         cJSON_Delete(ui_root);
@@ -1759,6 +1826,44 @@ static bool rs485_addr_is_used(const sensor_map_t *map, size_t count, uint8_t ad
     return false;
 }
 
+// Coleta do scan do auto-bind: só interessa o mesmo tipo do cadastro
+typedef struct {
+    rs485_type_t req_type;
+    int          found_addr;    // -1 = nenhum, -2 = mais de um
+    uint8_t      found_fc;
+    const char  *found_drv;
+} rs485_auto_scan_ctx_t;
+
+static bool rs485_auto_scan_cb(rs485_scan_event_t ev, uint8_t addr,
+                               const rs485_scan_hit_t *hit, void *ctx)
+{
+    rs485_auto_scan_ctx_t *c = (rs485_auto_scan_ctx_t *)ctx;
+    if (ev != RS485_SCAN_EV_IDENTIFIED || !hit->identified) return true;
+
+    if (hit->type != c->req_type) {
+        ESP_LOGI("RS485_AUTO",
+                 "SCAN: ignorando addr=%u (tipo=%d diferente do requisitado %d).",
+                 (unsigned)addr, (int)hit->type, (int)c->req_type);
+        return true;
+    }
+
+    ESP_LOGI("RS485_AUTO",
+             "SCAN: candidato encontrado addr=%u tipo=%d drv=%s fc=0x%02X%s",
+             (unsigned)addr, (int)hit->type,
+             hit->driver ? hit->driver : "NULL", (unsigned)hit->used_fc,
+             hit->cached ? " (cache)" : "");
+
+    if (c->found_addr == -1) {
+        c->found_addr = addr;
+        c->found_fc   = hit->used_fc;
+        c->found_drv  = hit->driver;
+        return true;
+    }
+    // Já havia um candidato -> mais de um dispositivo novo de mesmo tipo
+    c->found_addr = -2;
+    return false;
+}
+
 /*
  * rs485_auto_bind_or_readdress()
  *
@@ -1777,7 +1882,7 @@ static bool rs485_addr_is_used(const sensor_map_t *map, size_t count, uint8_t ad
  *  - Se o endereço escolhido já estiver em uso na lista cadastrada, não mexe em nada:
  *      -> *io_final_addr = requested_addr; *out_readdress_done = false; ESP_ERR_INVALID_STATE.
  *    (Em teoria o front já evita isso escondendo endereços ocupados.)
- *  - Faz um scan leve no barramento, usando rs485_registry_probe_any() em uma faixa reduzida,
+ *  - Faz um scan leve no barramento (rs485_scan_run) em uma faixa reduzida,
  *    ignorando endereços já cadastrados em map (para não confundir sensores antigos).
  *  - Procura por exatamente 1 NOVO dispositivo do mesmo tipo:
  *      * Se não encontrar nenhum -> uso endereço escolhido, sem reendereçar nada.
@@ -1856,57 +1961,34 @@ static esp_err_t rs485_auto_bind_or_readdress(int                requested_chann
     }
 
     // -------- Scan leve no barramento, ignorando enderecos ja cadastrados --------
+    // Sondagem universal com janela curta + fingerprint só em quem respondeu
     const uint8_t SCAN_MIN_ADDR = 1;
-    const uint8_t SCAN_MAX_ADDR = 32;  // faixa enxuta para manter ping rapido
-
-    int       found_addr = -1;  // -1 = nenhum, -2 = mais de um
-    uint8_t   found_fc   = 0;
-    const char *found_drv = NULL;
-
-    for (uint8_t addr = SCAN_MIN_ADDR; addr <= SCAN_MAX_ADDR; ++addr) {
-        // Não tente "descobrir" sensores que já estão cadastrados (antigos)
-        if (rs485_addr_is_used(map, count, addr)) {
-            continue;
-        }
-
-        rs485_type_t     probed_type    = RS485_TYPE_INVALID;
-        rs485_subtype_t  probed_subtype = RS485_SUBTYPE_NONE;
-        uint8_t          used_fc        = 0;
-        const char      *drv_name       = NULL;
+    const uint8_t SCAN_MAX_ADDR = 32;  // faixa enxuta para manter o cadastro rapido
 
-        bool ok = rs485_registry_probe_any(addr,
-                                           &probed_type,
-                                           &probed_subtype,
-                                           &used_fc,
-                                           &drv_name);
-        if (!ok) {
-            continue; // nada reconhecido neste endereço
-        }
+    rs485_auto_scan_ctx_t sc = { .req_type = req_type, .found_addr = -1 };
 
-        // Só nos interessam dispositivos do mesmo tipo (energia/JSY)
-        if (probed_type != req_type) {
-            ESP_LOGI("RS485_AUTO",
-                     "SCAN: ignorando addr=%u (tipo=%d diferente do requisitado %d).",
-                     (unsigned)addr, (int)probed_type, (int)req_type);
-            continue;
-        }
+    rs485_scan_cfg_t scfg;
+    rs485_scan_cfg_defaults(&scfg);
+    scfg.first = SCAN_MIN_ADDR;
+    scfg.last  = SCAN_MAX_ADDR;
+    scfg.cb    = rs485_auto_scan_cb;
+    scfg.ctx   = &sc;
+    // Não tente "descobrir" sensores que já estão cadastrados (antigos)
+    for (size_t i = 0; i < count; ++i) {
+        if (map[i].address >= 1 && map[i].address <= 247) rs485_scan_skip_addr(&scfg, map[i].address);
+    }
 
-        ESP_LOGI("RS485_AUTO",
-                 "SCAN: candidato encontrado addr=%u tipo=%d drv=%s fc=0x%02X",
-                 (unsigned)addr, (int)probed_type,
-                 drv_name ? drv_name : "NULL", (unsigned)used_fc);
-
-        if (found_addr < 0) {
-            found_addr = addr;
-            found_fc   = used_fc;
-            found_drv  = drv_name;
-        } else {
-            // Já havia um candidato -> mais de um dispositivo novo de mesmo tipo
-            found_addr = -2;
-            break;
-        }
+    esp_err_t scan_err = rs485_scan_run(&scfg, NULL);
+    if (scan_err != ESP_OK) {
+        ESP_LOGW("RS485_AUTO", "SCAN: varredura indisponivel (%s); usando endereco solicitado=%d.",
+                 esp_err_to_name(scan_err), requested_addr);
+        return ESP_OK;
     }
 
+    int         found_addr = sc.found_addr;  // -1 = nenhum, -2 = mais de um
+    uint8_t     found_fc   = sc.found_fc;
+    const char *found_drv  = sc.found_drv;
+
     if (found_addr == -1) {
         ESP_LOGI("RS485_AUTO",
                  "SCAN: nenhum novo dispositivo de tipo '%s' encontrado. "
@@ -1948,6 +2030,7 @@ static esp_err_t rs485_auto_bind_or_readdress(int                requested_chann
              requested_type_str, found_addr, requested_addr);
 
     int rc = jsy_mk333_change_address((uint8_t)found_addr, (uint8_t)requested_addr);
+    rs485_scan_cache_forget((uint8_t)found_addr);
     if (rc == 0) {
         ESP_LOGW("RS485_AUTO",
                  "Reenderecamento JSY concluido: %d -> %d. "
@@ -2015,8 +2098,10 @@ for (size_t i = 0; i < count; ++i) {
         }
         out[wr++] = map[i];
     }
+    if (removed) rs485_scan_cache_forget((uint8_t)addr);
 
     esp_err_t ret = save_rs485_config(out, wr);
+    rs485_central_invalidate_config();
     if (ret != ESP_OK) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "save_failed");
         return ret;
@@ -2094,6 +2179,236 @@ for (size_t i = 0; i < wr; ++i) {
     return ESP_OK;
 }
 
+// ===== handler: GET /rs485Scan?from=1&to=247[&window=ms][&id=0] =====
+// Varre o barramento (rs485_scan_run) e devolve uma linha JSON por evento,
+// em chunks, à medida que acontecem (NDJSON):
+//   {"ev":"progress","addr":N,"alive":K}
+//   {"ev":"alive","addr":N,"fc":3,"exception":false,"ms":12}
+//   {"ev":"id","addr":N,"found":true,"type":"energia","subtype":"monofasico","driver":"JSY_MK_333","fc":3,"cached":false}
+//   {"ev":"done","scanned":..,"alive":..,"identified":..,"cache_hits":..,"sweep_ms":..,"id_ms":..,"cancelled":false}
+typedef struct {
+    httpd_req_t *req;
+    uint16_t     alive;
+} rs485_scan_http_ctx_t;
+
+static bool rs485_scan_http_cb(rs485_scan_event_t ev, uint8_t addr,
+                               const rs485_scan_hit_t *hit, void *ctx)
+{
+    rs485_scan_http_ctx_t *c = (rs485_scan_http_ctx_t *)ctx;
+    char line[192];
+    int n = 0;
+
+    switch (ev) {
+    case RS485_SCAN_EV_PROGRESS:
+        update_last_interaction();      // varredura longa não derruba o modo fábrica
+        n = snprintf(line, sizeof(line), "{\"ev\":\"progress\",\"addr\":%u,\"alive\":%u}\n",
+                     addr, c->alive);
+        break;
+    case RS485_SCAN_EV_ALIVE:
+        c->alive++;
+        n = snprintf(line, sizeof(line),
+                     "{\"ev\":\"alive\",\"addr\":%u,\"fc\":%u,\"exception\":%s,\"ms\":%u}\n",
+                     addr, hit->used_fc, hit->exception ? "true" : "false", hit->latency_ms);
+        break;
+    case RS485_SCAN_EV_IDENTIFIED:
+        n = snprintf(line, sizeof(line),
+                     "{\"ev\":\"id\",\"addr\":%u,\"found\":%s,\"type\":\"%s\",\"subtype\":\"%s\","
+                     "\"driver\":\"%s\",\"fc\":%u,\"cached\":%s}\n",
+                     addr, hit->identified ? "true" : "false",
+                     hit->identified ? rs485_type_to_str(hit->type) : "",
+                     hit->identified ? rs485_subtype_to_str(hit->subtype) : "",
+                     hit->driver ? hit->driver : "", hit->used_fc,
+                     hit->cached ? "true" : "false");
+        break;
+    }
+    if (n <= 0 || n >= (int)sizeof(line)) return true;
+    // falha no envio = navegador fechou: cancela a varredura
+    return httpd_resp_send_chunk(c->req, line, n) == ESP_OK;
+}
+
+static esp_err_t rs485_scan_get_handler(httpd_req_t *req)
+{
+    update_last_interaction();
+
+    if (!wifi_ap_is_running()) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"error\":\"ap_suspended\"}");
+        return ESP_OK;
+    }
+
+    rs485_scan_cfg_t cfg;
+    rs485_scan_cfg_defaults(&cfg);
+
+    // Faixa lida em int e validada antes de estreitar para uint8_t
+    // (from=257 viraria 1 e to=-1 viraria 255)
+    int first = cfg.first, last = cfg.last;
+    char qbuf[96], param[16];
+    if (httpd_req_get_url_query_str(req, qbuf, sizeof(qbuf)) == ESP_OK) {
+        if (httpd_query_key_value(qbuf, "from", param, sizeof(param)) == ESP_OK)
+            first = atoi(param);
+        if (httpd_query_key_value(qbuf, "to", param, sizeof(param)) == ESP_OK)
+            last = atoi(param);
+        if (httpd_query_key_value(qbuf, "window", param, sizeof(param)) == ESP_OK) {
+            int w = atoi(param);
+            if (w >= 10 && w <= 1000) cfg.turnaround_ms = (uint16_t)w;
+        }
+        if (httpd_query_key_value(qbuf, "id", param, sizeof(param)) == ESP_OK)
+            cfg.fingerprint = (atoi(param) != 0);
+    }
+    if (first < 1 || first > 247 || last < 1 || last > 247 || first > last) {
+        httpd_resp_set_status(req, "400 Bad Request");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"error\":\"invalid_range\"}");
+        return ESP_OK;
+    }
+    cfg.first = (uint8_t)first;
+    cfg.last  = (uint8_t)last;
+
+    rs485_scan_http_ctx_t ctx = { .req = req };
+    cfg.cb  = rs485_scan_http_cb;
+    cfg.ctx = &ctx;
+
+    httpd_resp_set_type(req, "application/x-ndjson");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+
+    rs485_scan_stats_t st;
+    esp_err_t err = rs485_scan_run(&cfg, &st);
+
+    char line[224];
+    int n;
+    if (err != ESP_OK) {
+        n = snprintf(line, sizeof(line), "{\"ev\":\"error\",\"error\":\"%s\"}\n", esp_err_to_name(err));
+    } else {
+        n = snprintf(line, sizeof(line),
+                     "{\"ev\":\"done\",\"scanned\":%u,\"alive\":%u,\"identified\":%u,"
+                     "\"cache_hits\":%u,\"sweep_ms\":%lu,\"id_ms\":%lu,\"cancelled\":%s}\n",
+                     st.scanned, st.alive, st.identified, st.cache_hits,
+                     (unsigned long)st.sweep_ms, (unsigned long)st.fingerprint_ms,
+                     st.cancelled ? "true" : "false");
+    }
+    if (n > 0 && n < (int)sizeof(line)) httpd_resp_send_chunk(req, line, n);
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// ===== handler: GET /rs485Health =====
+// Saúde por escravo (tabela em RAM do modbus_dev_profile): não toca o barramento.
+static esp_err_t rs485_health_get_handler(httpd_req_t *req)
+{
+    update_last_interaction();
+
+    mb_dev_profile_t prof[MB_PROF_MAX_DEVICES];
+    size_t n = mb_prof_snapshot(prof, MB_PROF_MAX_DEVICES);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *arr  = cJSON_AddArrayToObject(root, "devices");
+    for (size_t i = 0; i < n; ++i) {
+        const mb_dev_profile_t *p = &prof[i];
+        cJSON *d = cJSON_CreateObject();
+        cJSON_AddNumberToObject(d, "address",     p->addr);
+        cJSON_AddNumberToObject(d, "used_fc",     p->used_fc);
+        cJSON_AddNumberToObject(d, "ok",          p->ok_total);
+        cJSON_AddNumberToObject(d, "fail",        p->fail_total);
+        cJSON_AddNumberToObject(d, "fail_streak", p->fail_streak);
+        cJSON_AddNumberToObject(d, "srtt_ms",     p->srtt_ms);
+        cJSON_AddNumberToObject(d, "p50_ms",      mb_prof_latency_pct(p, 50));
+        cJSON_AddNumberToObject(d, "p95_ms",      mb_prof_latency_pct(p, 95));
+        cJSON_AddNumberToObject(d, "timeout_ms",  mb_prof_timeout_ms(p->addr));
+        cJSON_AddNumberToObject(d, "backoff",     p->skip_level ? (1u << p->skip_level) : 0);
+        cJSON_AddNumberToObject(d, "skipped",     p->skipped_total);
+        cJSON_AddItemToArray(arr, d);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr(req, json ? json : "{\"devices\":[]}");
+    free(json);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// ===== handler: GET /rs485Models =====
+// Modelos compilados (rs485_model): nome, tipo e plano de leitura resultante.
+static esp_err_t rs485_models_get_handler(httpd_req_t *req)
+{
+    update_last_interaction();
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *arr  = cJSON_AddArrayToObject(root, "models");
+    size_t n = rs485_models_count();
+    for (size_t i = 0; i < n; ++i) {
+        rs485_model_t m;
+        if (rs485_model_get((int)i, &m) != ESP_OK) break;
+        cJSON *d = cJSON_CreateObject();
+        cJSON_AddStringToObject(d, "name",    m.name);
+        cJSON_AddStringToObject(d, "type",    rs485_type_to_str((rs485_type_t)m.type));
+        cJSON_AddStringToObject(d, "subtype", rs485_subtype_to_str((rs485_subtype_t)m.subtype));
+        cJSON_AddNumberToObject(d, "fc",      m.fc);
+        cJSON_AddNumberToObject(d, "values",  m.n_values);
+        cJSON_AddNumberToObject(d, "blocks",  m.plan.n_blocks);
+        cJSON_AddNumberToObject(d, "words",   m.plan.words);
+        cJSON_AddBoolToObject(d,   "probe",   m.has_id);
+        cJSON_AddItemToArray(arr, d);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr(req, json ? json : "{\"models\":[]}");
+    free(json);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// ===== handler: POST /rs485Models =====
+// Corpo = conteúdo completo do rs485_models.json. Só grava se compilar.
+static esp_err_t rs485_models_post_handler(httpd_req_t *req)
+{
+    update_last_interaction();
+
+    if (req->content_len <= 0 || req->content_len > 8192) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "body missing/too large");
+        return ESP_FAIL;
+    }
+    char *buf = malloc(req->content_len + 1);
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no mem");
+        return ESP_FAIL;
+    }
+    int got = 0;
+    while (got < (int)req->content_len) {
+        int r = httpd_req_recv(req, buf + got, req->content_len - got);
+        if (r == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (r <= 0) {
+            free(buf);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "recv");
+            return ESP_FAIL;
+        }
+        got += r;
+    }
+    buf[got] = '\0';
+
+    esp_err_t err = rs485_models_save_json(buf, (size_t)got);
+    free(buf);
+    rs485_central_invalidate_config();   // índices dos modelos mudaram
+    if (err == ESP_ERR_INVALID_ARG) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "modelo invalido");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+
+    char resp[48];
+    snprintf(resp, sizeof(resp), "{\"ok\":true,\"models\":%u}", (unsigned)rs485_models_count());
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, resp);
+    return ESP_OK;
+}
+
 #endif
 //--------------------------------------------------------------------
 static esp_err_t config_maintenance_get_handler(httpd_req_t *req) {
@@ -2746,6 +3061,15 @@ else if (is_send_mode_time()) {                                           // equ
     {
         cJSON_AddFalseToObject(root, "timestamp_mode");
     }
+
+    if(has_binary_payload())
+    {
+        cJSON_AddTrueToObject(root, "binary_payload");
+    }
+    else
+    {
+        cJSON_AddFalseToObject(root, "binary_payload");
+    }
     
    // === novo: modo TimeStamp ===
    // cJSON_AddBoolToObject(root, "timestamp_mode", s_timestamp_mode);
@@ -3140,6 +3464,66 @@ static esp_err_t delete_registers_get_handler(httpd_req_t *req)
         }
 }
 //----------------------------------------------------------
+static esp_err_t config_backup_get_handler(httpd_req_t *req)
+{
+    update_last_interaction();
+
+    char *json = config_export_json();
+    if (!json) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no mem");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"config.json\"");
+    httpd_resp_sendstr(req, json);
+    free(json);
+    return ESP_OK;
+}
+
+// Importa o JSON do backup (pode conter só algumas seções) e grava uma vez
+static esp_err_t config_backup_post_handler(httpd_req_t *req)
+{
+    update_last_interaction();
+
+    if (req->content_len <= 0 || req->content_len > 4096) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "body missing/too large");
+        return ESP_FAIL;
+    }
+    char *buf = malloc(req->content_len + 1);
+    if (!buf) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no mem");
+        return ESP_FAIL;
+    }
+    int got = 0;
+    while (got < (int)req->content_len) {
+        int r = httpd_req_recv(req, buf + got, req->content_len - got);
+        if (r == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (r <= 0) {
+            free(buf);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "recv");
+            return ESP_FAIL;
+        }
+        got += r;
+    }
+    buf[got] = '\0';
+
+    esp_err_t err = config_import_json(buf, (size_t)got);
+    free(buf);
+    if (err == ESP_ERR_INVALID_ARG || err == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "backup invalido");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+
+    reload_config();
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"ok\":true}");
+    return ESP_OK;
+}
+//----------------------------------------------------------
 // Handler para o endpoint /ping
 static esp_err_t ping_handler(httpd_req_t *req)
 {
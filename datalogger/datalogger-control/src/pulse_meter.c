@@ -3,13 +3,18 @@
 #include "esp_timer.h"
 #include "esp_sleep.h"
 #include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
 #include "ulp_datalogger-control.h"
 #include "pulse_meter.h"
-#include "sdmmc_driver.h"      // para save_record_sd()
+#include "sdmmc_driver.h"      // para record_batch_add()
 #include "datalogger_control.h"
 #include "datalogger_driver.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "battery_monitor.h"
+#include <stddef.h>
 
 
 #define FLOW_DATA_FILE "/littlefs/flow_data.bin"
@@ -23,13 +28,10 @@ RTC_DATA_ATTR static int64_t  prev_time_us = 0;*/
 static int64_t  last_edge_time_us   = 0;
 
 //static uint32_t current_volume = 0;
-static uint32_t current_pulse_count = 0;   // Pulso sendo medido em tempo real
 static uint16_t last_pulse_pcnt_count = 0; // Pulso do contador pcnt
 static bool s_pulse_is_optical = false;   // mesmo critério do ULP
 
-RTC_DATA_ATTR static uint32_t s_pulse_accum_rtc = 0;
 static void pulse_meter_config_init(void);
-static void save_default_record_pulse_config(void);
 static void pulse_meter_ulp_defaults(void);
 
 #define PULSE_INACTIVITY_TIME   35
@@ -49,7 +51,174 @@ static const char *TAG = "Pulse_Meter";
 //--------------------------------------
 static SemaphoreHandle_t Mutex_pulse_meter;
 //--------------------------------------
-struct record_pulse_config rec_config = {0};
+
+//==============================================================
+//  Totalizador de pulsos em memória RTC
+//--------------------------------------------------------------
+// Total de 64 bits, checkpoint (total no último registro gravado no SD)
+// e dia do último checkpoint diário ficam em RTC_NOINIT com CRC: passam
+// pelo deep sleep e por resets de software/brown-out sem tocar a flash.
+// rec_pulse_config.json só é lido após power-on (RTC inválida) e só é
+// escrito na virada do dia, no reset do contador, após reset por
+// brown-out ou com a alimentação em risco antes de dormir.
+//==============================================================
+#define PULSE_TOTALIZER_MAGIC   0x544C5550u   // "PULT"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t daykey;        // AAAAMMDD do último checkpoint diário (0 = ainda não semeado)
+    uint64_t count;         // total acumulado
+    uint64_t checkpoint;    // total no último registro gravado
+    uint32_t dirty;         // mudou desde a última gravação na flash
+    uint32_t crc;
+} pulse_totalizer_t;
+
+RTC_NOINIT_ATTR static pulse_totalizer_t s_tot;
+static portMUX_TYPE s_tot_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t tot_crc(const pulse_totalizer_t *t)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)t, offsetof(pulse_totalizer_t, crc));
+}
+
+static inline bool tot_valid(void)
+{
+    return s_tot.magic == PULSE_TOTALIZER_MAGIC && s_tot.crc == tot_crc(&s_tot);
+}
+
+// Chamar dentro de s_tot_mux
+static inline void tot_seal(bool dirty)
+{
+    s_tot.dirty = dirty ? 1 : 0;
+    s_tot.crc   = tot_crc(&s_tot);
+}
+
+// Grava o totalizador na flash se mudou (ou se force)
+static void pulse_totalizer_flush(bool force)
+{
+    pulse_totalizer_t t;
+    portENTER_CRITICAL(&s_tot_mux);
+    t = s_tot;
+    portEXIT_CRITICAL(&s_tot_mux);
+
+    if (!force && !t.dirty) {
+        return;
+    }
+    if (!config_fs_ready()) {
+        return;
+    }
+
+    struct record_pulse_config cfg = {
+        .last_write_idx      = UNSPECIFIC_RECORD,
+        .last_read_idx       = UNSPECIFIC_RECORD,
+        .last_pulse_count    = (uint32_t)t.checkpoint,
+        .current_pulse_count = (uint32_t)t.count,
+        .last_saved_daykey   = t.daykey,
+        .pulse_total         = t.count,
+    };
+    save_record_pulse_config(&cfg);
+
+    portENTER_CRITICAL(&s_tot_mux);
+    // Só limpa se nada mudou durante a escrita
+    if (s_tot.count == t.count && s_tot.checkpoint == t.checkpoint && s_tot.daykey == t.daykey) {
+        tot_seal(false);
+    }
+    portEXIT_CRITICAL(&s_tot_mux);
+
+    ESP_LOGI(TAG, "Totalizador gravado na flash: total=%llu checkpoint=%llu dia=%lu",
+             (unsigned long long)t.count, (unsigned long long)t.checkpoint, (unsigned long)t.daykey);
+}
+
+// Cópia em RTC válida: nada a fazer. Senão (power-on) carrega da flash.
+// @return true se não havia registro na flash (primeiro boot)
+static bool pulse_totalizer_ensure(void)
+{
+    if (tot_valid()) {
+        return false;
+    }
+
+    struct record_pulse_config cfg = {0};
+    bool fresh = !has_record_pulse_config();
+    if (!fresh) {
+        get_record_pulse_config(&cfg);
+    }
+
+    portENTER_CRITICAL(&s_tot_mux);
+    s_tot.magic      = PULSE_TOTALIZER_MAGIC;
+    s_tot.daykey     = cfg.last_saved_daykey;
+    // arquivos antigos não têm pulse_total: o total era o último checkpoint
+    s_tot.count      = cfg.pulse_total ? cfg.pulse_total : cfg.last_pulse_count;
+    s_tot.checkpoint = cfg.last_pulse_count;
+    tot_seal(fresh);
+    portEXIT_CRITICAL(&s_tot_mux);
+
+    ESP_LOGI(TAG, "Totalizador carregado da flash: total=%llu",
+             (unsigned long long)(cfg.pulse_total ? cfg.pulse_total : cfg.last_pulse_count));
+    if (fresh) {
+        pulse_totalizer_flush(true);
+    }
+    return fresh;
+}
+
+static void pulse_totalizer_add(uint32_t pulses)
+{
+    if (pulses == 0) {
+        return;
+    }
+    portENTER_CRITICAL(&s_tot_mux);
+    s_tot.count += pulses;
+    tot_seal(true);
+    portEXIT_CRITICAL(&s_tot_mux);
+}
+
+// Grava o dia e devolve o anterior (0 = ainda não semeado); ler e trocar
+// na mesma seção crítica evita dois resets para a mesma virada
+static uint32_t pulse_totalizer_swap_daykey(uint32_t daykey)
+{
+    portENTER_CRITICAL(&s_tot_mux);
+    uint32_t prev = s_tot.daykey;
+    if (prev != daykey) {
+        s_tot.daykey = daykey;
+        tot_seal(true);
+    }
+    portEXIT_CRITICAL(&s_tot_mux);
+    return prev;
+}
+
+uint64_t pulse_totalizer_count(void)
+{
+    pulse_totalizer_ensure();
+    portENTER_CRITICAL(&s_tot_mux);
+    uint64_t c = s_tot.count;
+    portEXIT_CRITICAL(&s_tot_mux);
+    return c;
+}
+
+uint32_t pulse_totalizer_get_checkpoint(void)
+{
+    pulse_totalizer_ensure();
+    portENTER_CRITICAL(&s_tot_mux);
+    uint64_t c = s_tot.checkpoint;
+    portEXIT_CRITICAL(&s_tot_mux);
+    return (uint32_t)c;
+}
+
+// O checkpoint só vai para a flash junto com o próximo flush
+void pulse_totalizer_set_checkpoint(uint32_t counter)
+{
+    pulse_totalizer_ensure();
+    portENTER_CRITICAL(&s_tot_mux);
+    // counter vem do total de 32 bits: reconstrói a parte alta a partir do total
+    uint64_t cp = (s_tot.count & ~(uint64_t)UINT32_MAX) | counter;
+    if (cp > s_tot.count) {
+        cp -= (uint64_t)1 << 32;
+    }
+    if (cp != s_tot.checkpoint) {
+        s_tot.checkpoint = cp;
+        tot_seal(true);
+    }
+    portEXIT_CRITICAL(&s_tot_mux);
+}
 
 static inline bool time_is_valid(void) {
     // considera “válido” se passamos de 2020-01-01
@@ -89,16 +258,16 @@ static void pulse_meter_config_init(void)
 {
 	Mutex_pulse_meter = xSemaphoreCreateMutex();
 
-    if (!has_record_pulse_config())
+    if (pulse_totalizer_ensure())
     {
-        save_default_record_pulse_config();
             // alinha os registradores do ULP com o que o .S realmente exporta
         pulse_meter_ulp_defaults();
     }
-
-    get_record_pulse_config(&rec_config);
-    current_pulse_count = rec_config.last_pulse_count;
-
+    else if (esp_reset_reason() == ESP_RST_BROWNOUT)
+    {
+        // a RTC sobreviveu a este brown-out; pode não sobreviver ao próximo
+        pulse_totalizer_flush(false);
+    }
 }
 
 //----------------------------------------------------------
@@ -156,19 +325,6 @@ void pulse_meter_ulp_start(uint32_t rtc_io_num)
 }
 
 
-static void save_default_record_pulse_config(void)
-{
-	xSemaphoreTake(Mutex_pulse_meter,portMAX_DELAY);
-
-    rec_config.last_write_idx = UNSPECIFIC_RECORD;
-    rec_config.last_read_idx = UNSPECIFIC_RECORD;
-    rec_config.total = 0;
-    rec_config.last_pulse_count = 0;
-    rec_config.current_pulse_count = 0;
-    save_record_pulse_config(&rec_config);
-    xSemaphoreGive(Mutex_pulse_meter);
-}
-
 // Encapsula a lógica de "reset diário se for dia novo"
 static bool maybe_daily_reset_if_needed(void)
 {
@@ -188,14 +344,14 @@ static bool maybe_daily_reset_if_needed(void)
         return false;
     }
 
+    pulse_totalizer_ensure();
+    // marca o dia de hoje já na leitura, pra não ficar resetando em loop
     const int today = current_daykey();
-    const int last  = rec_config.last_saved_daykey;   // pode ser 0 no boot limpo
+    const int last  = (int)pulse_totalizer_swap_daykey((uint32_t)today);   // pode ser 0 no boot limpo
 
     // 4) primeira vez depois de apagar a flash → só semeia o dia e salva 1x
     if (last == 0) {
-        rec_config.last_saved_daykey = today;
-        // aqui podemos salvar direto, porque estamos num caminho sem mutex
-        save_record_pulse_config(&rec_config);
+        pulse_totalizer_flush(false);
         return false;
     }
 
@@ -203,18 +359,18 @@ static bool maybe_daily_reset_if_needed(void)
     if (today != last) {
         ESP_LOGI(TAG, "Mudou o dia (%d -> %d). Zerando contador...", last, today);
 
-        // essa função deve continuar do jeito que você já tem
+        // o reset grava tudo na flash numa escrita só
         reset_pulse_meter();  // <- aqui dentro tem o Mutex_pulse_meter
-
-        // depois de resetar, marca o dia de hoje pra não ficar resetando em loop
-        get_record_pulse_config(&rec_config);       // recarrega o que o reset escreveu
-        rec_config.last_saved_daykey = today;
-        save_record_pulse_config(&rec_config);
         return true; 
        }
    return false;
 }
 
+bool pulse_meter_check_daily_reset(void)
+{
+    return maybe_daily_reset_if_needed();
+}
+
 //-----------------------------------------------------------------------------
 // 1) Extrai _só_ os pulsos do ULP (sleep) e mantém meia-aresta.
 //-----------------------------------------------------------------------------
@@ -253,14 +409,18 @@ bool pulse_meter_inactivity_task_time(void) //Se parado, inatividade =1, senão
 
 void pulse_meter_prepare_for_sleep(void)
 {
-    uint32_t ulp_p = fetch_ulp_pulses();
-    current_pulse_count += ulp_p;
-
-    // só grava se mudou de fato
-    if (current_pulse_count != get_last_pulse_count()) {
-        last_pulse_pcnt_count = get_pulse_count();
-        last_edge_time_us     = esp_timer_get_time();
-        set_last_pulse_count(current_pulse_count);
+    pulse_totalizer_ensure();
+    pulse_totalizer_add(fetch_ulp_pulses());
+
+    // O total já está na RTC e atravessa o sono; a flash só se houver risco
+    last_pulse_pcnt_count = get_pulse_count();
+    last_edge_time_us     = esp_timer_get_time();
+    // Sem fonte externa e com bateria baixa um brown-out durante o sono
+    // perderia a RTC: melhor pagar uma escrita agora
+    if (battery_monitor_power_at_risk()) {
+        ESP_LOGW(TAG, "Alimentação em risco (bat=%lu%%): checkpoint na flash",
+                 (unsigned long)get_battery());
+        pulse_totalizer_flush(false);
     }
 }
 
@@ -293,21 +453,35 @@ float flow(uint32_t total_count)
 void reset_pulse_meter(void)
 {
 	xSemaphoreTake(Mutex_pulse_meter,portMAX_DELAY);
-    get_record_pulse_config(&rec_config);
-
-    rec_config.last_pulse_count = 0;
-    rec_config.current_pulse_count = 0;
-
- //   current_pulse_count = rec_config.current_pulse_count;
-    save_record_pulse_config(&rec_config);
+    pulse_totalizer_ensure();
+
+    portENTER_CRITICAL(&s_tot_mux);
+    s_tot.count      = 0;
+    s_tot.checkpoint = 0;
+    tot_seal(true);
+    portEXIT_CRITICAL(&s_tot_mux);
+    pulse_totalizer_flush(false);
     
-    current_pulse_count = 0;
     last_pulse_pcnt_count = 0;
     last_edge_time_us = 0;
       
     xSemaphoreGive(Mutex_pulse_meter);
 }
 
+// Registro do pulso gravado: avança o checkpoint (RTC) e, na virada do dia,
+// faz a única gravação rotineira do totalizador na flash
+static void pulse_checkpoint_commit(uint32_t current_pulse_count)
+{
+    set_last_pulse_count(current_pulse_count);
+
+    if (time_is_valid()) {
+        const uint32_t today = (uint32_t)current_daykey();
+        if (pulse_totalizer_swap_daykey(today) != today) {
+            pulse_totalizer_flush(false);
+        }
+    }
+}
+
 //-------------------------------------------------------------------
 // função para salvar na tabela e flash último pulso
 esp_err_t save_pulse_measurement(int channel) {
@@ -316,7 +490,7 @@ esp_err_t save_pulse_measurement(int channel) {
     // 1) vê se hoje precisou zerar
     bool did_daily_reset = maybe_daily_reset_if_needed();
   
-    uint32_t previous  = get_last_pulse_count();
+    uint32_t previous  = get_last_pulse_count();   // RTC, sem LittleFS
 //    char     vazao_str[16];
     char     value_str[16];
   
@@ -330,7 +504,8 @@ esp_err_t save_pulse_measurement(int channel) {
     }
 
     // 4) agora sim acumula o que sobrou da ULP
-    current_pulse_count += ulp_p;
+    pulse_totalizer_add(ulp_p);
+    const uint32_t current_pulse_count = (uint32_t)pulse_totalizer_count();
     
         // DEBUG: mostra os dois valores
     printf("Current = %u   Previous = %u\n",
@@ -366,22 +541,11 @@ esp_err_t save_pulse_measurement(int channel) {
 #endif
   
 // 4) Grava no SD
-    error = save_record_sd(channel, value_str);   
-// 5) SÃ³ atualiza o checkpoint se a gravaÃ§Ã£o foi bem-sucedida
+    error = record_batch_add(channel, 0, value_str);   
+// 5) SÃ³ atualiza o checkpoint se a gravaÃ§Ã£o foi bem-sucedida: dentro de um
+//    lote isso é no commit, não quando o valor entra na fila
      if (error == ESP_OK) {
-            // atualiza o checkpoint na flash
-        set_last_pulse_count(current_pulse_count);
-                // *** NOVO: manter RTC acompanhado do Ãºltimo bom ***
-        s_pulse_accum_rtc = current_pulse_count;
-        
-        if (time_is_valid()) {
-            const uint32_t today = (uint32_t)current_daykey();
-            get_record_pulse_config(&rec_config);
-            if (rec_config.last_saved_daykey != today) {
-                rec_config.last_saved_daykey = today;
-                save_record_pulse_config(&rec_config); // 1x/dia tÃ­pico
-               }
-           }
+        error = record_batch_on_commit(pulse_checkpoint_commit, current_pulse_count);
         }  
         
 ESP_LOGI(TAG,
@@ -434,10 +598,10 @@ init_pcnt();
             }
       // só aceita esse pulso se tiver passado ao menos DEBOUNCE_US
      if (pulses > 0) {
-                      current_pulse_count += pulses;      
+                      pulse_totalizer_add(pulses);
                       PM_LOGI("***>>> Pulsos neste intervalo: %u", pulses);
                  
-                       PM_LOGI(">>>>total acumulado = %u", current_pulse_count);
+                       PM_LOGI(">>>>total acumulado = %llu", (unsigned long long)pulse_totalizer_count());
                      }
 
 // atualizar o baseline conforme o modo
@@ -342,6 +342,9 @@ static void hibernate(void) {
 
 void start_deep_sleep(void)
 {
+	// Registros ainda no write-behind vão para o cartão (fsync) antes de dormir
+	flush_record_sd();
+
 	  if(!has_device_active()||!has_factory_config())
 	    {
 	     hibernate();
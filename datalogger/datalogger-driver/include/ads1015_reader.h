@@ -22,6 +22,19 @@ along with a wide operating supply range, are useful for power- and space-constr
 
 #define ADS1015_ADDR_GND 0x48  //!< I2C device address with ADDR pin connected to ground
 
+// Pino ALERT/RDY ligado ao ESP32 (-1 = não ligado: fim de conversão pelo bit OS)
+#ifndef ADS1015_RDY_GPIO
+#define ADS1015_RDY_GPIO (-1)
+#endif
+
+// Estabilização dos sensores analógicos após activate_mosfet(enable_analog_sensors)
+#ifndef ADS1015_SENSOR_SETTLE_MS
+#define ADS1015_SENSOR_SETTLE_MS 50
+#endif
+
+#define ADS1015_SCAN_MAX_CH  4
+#define ADS1015_SCAN_MAX_OS  16
+
 typedef enum {  // Register addresses
     ADS1015_CONVERSION_REGISTER_ADDR = 0,
     ADS1015_CONFIG_REGISTER_ADDR,
@@ -104,11 +117,37 @@ typedef struct {
     TickType_t max_ticks;                   // Tempo máximo de espera para operações I2C
 } ads1015_t;
 
+/**
+ * Varredura: cada canal da lista é convertido 'oversample' vezes (single-shot,
+ * fim de conversão pelo ALERT/RDY ou pelo bit OS, sem vTaskDelay por
+ * conversão); as amostras são ordenadas, 'trim' são descartadas em cada
+ * ponta (picos/outliers) e o resto é promediado.
+ */
+typedef struct {
+    uint8_t       oversample;   // conversões por canal (1..ADS1015_SCAN_MAX_OS)
+    uint8_t       trim;         // descartadas em cada ponta após ordenar
+    ads1015_sps_t sps;
+} ads1015_scan_cfg_t;
+
+#define ADS1015_SCAN_CFG_DEFAULT { .oversample = 8, .trim = 2, .sps = ADS1015_SPS_1600 }
+
 // Funções
 void adc_init(int adc_pin);
 void adc_del_init(void);
 
 float oneshot_analog_read(sensor_t tipo);
+
+/**
+ * @brief Lê todos os canais de 'ch' numa só tomada do ADS (cfg NULL = padrão).
+ *        analog_1/analog_2 passam pela mesma média móvel do oneshot_analog_read.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_TIMEOUT (sem fim de conversão)
+ *         ou o erro do I2C. Em erro, volts[] não é válido.
+ */
+esp_err_t ads1015_scan(const sensor_t *ch, size_t n, const ads1015_scan_cfg_t *cfg, float *volts);
+
+/** @brief Chamados pelo activate_mosfet: a 1ª conversão espera ADS1015_SENSOR_SETTLE_MS. */
+void ads1015_note_power_on(void);
+void ads1015_note_power_off(void);
 void voltage_calibrated(int adc_channel, int *voltage);
 
 // Inicializar dispositivo
@@ -0,0 +1,90 @@
+/*
+ * config_store.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Imagem única e binária da configuração (/littlefs/config.bin) com cache
+ * em RAM.
+ *
+ * Cada seção (dispositivo, rede, operação, sistema, ...) é a própria struct
+ * do datalogger_driver.h, gravada com id, tamanho e CRC32. O boot lê o
+ * arquivo uma vez; depois disso has_*() e get_*() só tocam a RAM.
+ *
+ * config_store_set() compara com o cache e só marca a seção como suja se
+ * algo mudou; config_store_commit() não faz nada sem seção suja. Quando
+ * grava, grava a imagem inteira em arquivo temporário + rename (a imagem
+ * cabe num bloco do LittleFS, que é copy-on-write: remendar uma seção no
+ * lugar custaria o mesmo bloco e perderia a atomicidade).
+ *
+ * Cada seção grava também a versão do seu layout (CFG_SEC_VER_*). Uma seção
+ * com CRC, tamanho ou versão de layout diferente do firmware atual fica
+ * ausente e o config_driver cai para o JSON legado ou para os defaults do
+ * config_control. Mudou o significado de uma struct sem mudar o tamanho
+ * (campo reordenado, unidade trocada)? Incremente a versão dela.
+ *
+ * Só entra aqui o que é configuração: leituras (pressão, bateria, CSQ,
+ * pulsos, ...) ficam em RTC ou no log de registros, senão cada amostra
+ * sujaria a imagem.
+ * JSON fica só para importar/exportar.
+ */
+
+#ifndef DATALOGGER_DATALOGGER_DRIVER_INCLUDE_CONFIG_STORE_H_
+#define DATALOGGER_DATALOGGER_DRIVER_INCLUDE_CONFIG_STORE_H_
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONFIG_STORE_PATH      "/littlefs/config.bin"
+#define CONFIG_STORE_VERSION   2      // formato da imagem (1: sem versão por seção)
+
+typedef enum {
+    CFG_SEC_DEVICE = 0,        // struct device_config
+    CFG_SEC_NETWORK,           // struct network_config
+    CFG_SEC_OPERATION,         // struct operation_config
+    CFG_SEC_SYSTEM,            // struct system_config
+    CFG_SEC_LAST_UNIT_TIME,    // struct record_last_unit_time
+    CFG_SEC_COUNT              // ids 5 (self monitoring) e 6 (pressão) não são mais usados
+} cfg_section_t;
+
+// Versão do layout de cada struct gravada na imagem
+#define CFG_SEC_VER_DEVICE           1
+#define CFG_SEC_VER_NETWORK          1
+#define CFG_SEC_VER_OPERATION        1
+#define CFG_SEC_VER_SYSTEM           1
+#define CFG_SEC_VER_LAST_UNIT_TIME   1
+
+/** @brief Lê a imagem para o cache. Sem arquivo => nenhuma seção (ESP_ERR_NOT_FOUND). */
+esp_err_t config_store_load(void);
+
+bool config_store_has(cfg_section_t sec);
+
+/** @brief Cópia da seção. @return ESP_ERR_NOT_FOUND se ausente. */
+esp_err_t config_store_get(cfg_section_t sec, void *out, size_t len);
+
+/**
+ * @brief Atualiza a seção no cache.
+ * @return true se o conteúdo mudou (seção fica suja até o próximo commit).
+ */
+bool config_store_set(cfg_section_t sec, const void *data, size_t len);
+
+/** @brief Grava a imagem se houver seção suja; sem mudança não toca a flash. */
+esp_err_t config_store_commit(void);
+
+/** @brief Bits (1 << cfg_section_t) das seções sujas. */
+uint32_t config_store_dirty_mask(void);
+
+const char *config_store_section_name(cfg_section_t sec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATALOGGER_DATALOGGER_DRIVER_INCLUDE_CONFIG_STORE_H_ */
@@ -119,6 +119,7 @@ struct device_config {
     bool        always_on;
     bool        device_active;
     bool        timestamp_mode;   // novo: usar timestamp no payload
+    bool        binary_payload;   // payload CBOR compacto no LTE
 };
 
 struct network_config {
@@ -256,6 +257,11 @@ void get_record_last_unit_time(struct record_last_unit_time *config);
 esp_err_t save_self_monitoring_data(struct self_monitoring_data *config);
 esp_err_t load_self_monitoring_data(struct self_monitoring_data *config);
 
+// Backup da configuração pelo portal: JSON com uma chave por seção.
+// config_export_json() devolve string alocada (liberar com free()).
+char *config_export_json(void);
+esp_err_t config_import_json(const char *json, size_t len);
+
 /*void save_pressure_data_set(struct pressure_dataset *config);
 void get_pressure_data_set(struct pressure_dataset *config);*/
 
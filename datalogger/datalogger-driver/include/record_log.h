@@ -0,0 +1,158 @@
+/*
+ * record_log.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Log binário de registros no SD (substitui o registro.csv no caminho quente).
+ *
+ * - Cada amostra ocupa um slot fixo de RECORD_LOG_ENTRY_SIZE bytes.
+ * - Os slots ficam em arquivos de segmento pré-alocados (/sdcard/rec/sNNNN.bin),
+ *   com RECORD_LOG_SEGMENT_RECORDS slots cada. Registro N está sempre em:
+ *       segmento  = N / RECORD_LOG_SEGMENT_RECORDS
+ *       offset    = HEADER + (N % RECORD_LOG_SEGMENT_RECORDS) * ENTRY_SIZE
+ *   ou seja, seek O(1) pelo número do registro.
+ * - Cada slot tem CRC32; slot não gravado (zeros) ou corrompido é detectado
+ *   na leitura e pulado.
+ * - O segmento corrente fica aberto durante o wake e os appends passam por
+ *   um buffer em RAM (write-behind). Só record_log_sync() garante que os
+ *   dados estão no cartão (um único fsync).
+ * - O CSV virou apenas uma "visão" de exportação gerada sob demanda
+ *   (linhas de largura fixa) para o portal /loadRegisters.
+ *
+ * A política de índice (write/read/total/cursor) continua em sdcard_mmc.c;
+ * este módulo só sabe gravar/ler o slot N.
+ */
+
+#ifndef DATALOGGER_DATALOGGER_DRIVER_INCLUDE_RECORD_LOG_H_
+#define DATALOGGER_DATALOGGER_DRIVER_INCLUDE_RECORD_LOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECORD_LOG_DIR               "/sdcard/rec"
+#define RECORD_LOG_SEGMENT_RECORDS   4096u     // 64 KiB por segmento
+#define RECORD_LOG_MAX_SEGMENTS      1024u     // 4M registros (~64 MiB) antes de reciclar
+#define RECORD_LOG_CAPACITY          (RECORD_LOG_SEGMENT_RECORDS * RECORD_LOG_MAX_SEGMENTS)
+
+// Tipo do valor guardado em record_log_entry_t.raw (bits 0..1 de flags)
+#define RECORD_LOG_KIND_FLOAT        0x00u    // float32: registros antigos e |valor| >= 2^31 com casas
+#define RECORD_LOG_KIND_INT32        0x01u
+#define RECORD_LOG_KIND_UINT32       0x02u
+#define RECORD_LOG_KIND_DECIMAL      0x03u    // mantissa int32; valor = raw / 10^decimals
+#define RECORD_LOG_KIND_MASK         0x03u
+
+// Write-behind: registros mantidos em RAM antes do fwrite (16 B cada)
+#define RECORD_LOG_WB_RECORDS        64u
+
+// Linha de exportação CSV (largura fixa, inclui '\n')
+#define RECORD_LOG_EXPORT_VALUE_LEN  12u     // coluna DADOS: "-2.147483648"
+#define RECORD_LOG_EXPORT_LINE_LEN   48u
+
+/**
+ * @brief Registro binário de tamanho fixo (16 bytes, little-endian).
+ *
+ * raw guarda o valor como int32 / uint32 / mantissa decimal / float conforme
+ * flags; decimals é o nº de casas decimais original (para reproduzir a
+ * string exata: "12.50" volta como "12.50").
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t epoch;        // segundos UTC
+    uint8_t  channel;      // canal base (0, 1, 2, 3, 4, ...)
+    uint8_t  subchannel;   // 0 = sem subcanal; 1..9 = fase/subcanal
+    uint8_t  flags;        // RECORD_LOG_KIND_*
+    uint8_t  decimals;     // casas decimais (KIND_DECIMAL e KIND_FLOAT)
+    uint32_t raw;          // valor (bits do float ou inteiro)
+    uint32_t crc;          // CRC32 dos 12 bytes anteriores
+} record_log_entry_t;
+
+#define RECORD_LOG_ENTRY_SIZE        ((uint32_t)sizeof(record_log_entry_t))
+
+_Static_assert(sizeof(record_log_entry_t) == 16, "record_log_entry_t deve ter 16 bytes");
+
+/**
+ * @brief Prepara o diretório do log no SD (chamar após montar o cartão).
+ * @param created_out  true se o log não existia e foi criado agora
+ *                     (o chamador deve zerar o índice nesse caso).
+ */
+esp_err_t record_log_init(bool *created_out);
+
+/** @brief Capacidade total (em registros) antes de reciclar. */
+uint32_t record_log_capacity(void);
+
+/** @brief Grava o slot 'recno' (cria/pré-aloca o segmento se preciso). */
+esp_err_t record_log_write(uint32_t recno, const record_log_entry_t *entry);
+
+/**
+ * @brief Grava 'count' registros consecutivos a partir de 'recno'.
+ *
+ * Registros consecutivos se acumulam no write-behind; o fwrite acontece
+ * quando o buffer enche, numa gravação fora de sequência ou no sync.
+ * O chamador garante que recno + count não ultrapassa record_log_capacity().
+ */
+esp_err_t record_log_write_many(uint32_t recno, const record_log_entry_t *entries, size_t count);
+
+/**
+ * @brief Lê o slot 'recno'.
+ * @return ESP_OK, ESP_ERR_NOT_FOUND (segmento inexistente) ou
+ *         ESP_ERR_INVALID_CRC (slot vazio/corrompido).
+ */
+esp_err_t record_log_read(uint32_t recno, record_log_entry_t *entry);
+
+/**
+ * @brief Descarrega o write-behind e faz fsync do segmento aberto.
+ *        Chamar antes de dormir e antes de enviar dados.
+ */
+esp_err_t record_log_sync(void);
+
+/** @brief record_log_sync() + fecha o handle (antes de desmontar o SD). */
+esp_err_t record_log_close(void);
+
+/** @brief Apaga todos os segmentos (mantém o diretório). */
+esp_err_t record_log_erase(void);
+
+/**
+ * @brief Monta um registro a partir da string de valor usada pelos produtores
+ *        ("12.345", "6", "-3"...). Calcula o CRC.
+ *
+ * Com ponto decimal o valor vira mantissa int32 + casas (exato, sem float);
+ * se a mantissa não cabe, casas finais são arredondadas até caber.
+ * @return ESP_OK, ou ESP_ERR_INVALID_ARG se a string não é número
+ *         ("nan", "ERR", vazio...): nada é gravado em vez de um 0 falso.
+ */
+esp_err_t record_log_entry_make(record_log_entry_t *entry, time_t ts,
+                                uint8_t channel, uint8_t subchannel,
+                                const char *value_str);
+
+/** @brief Valida o CRC do registro. */
+bool record_log_entry_valid(const record_log_entry_t *entry);
+
+/** @brief Valor como texto, com as mesmas casas decimais da origem. */
+size_t record_log_format_value(const record_log_entry_t *entry, char *out, size_t out_sz);
+
+/** @brief Data "dd/mm/aaaa" e hora "hh:mm:ss" no fuso local (GMT-3). */
+void record_log_format_date_time(const record_log_entry_t *entry,
+                                 char *date_out, size_t date_sz,
+                                 char *time_out, size_t time_sz);
+
+/** @brief Canal como texto: "3" ou "4.2". */
+size_t record_log_format_channel(const record_log_entry_t *entry, char *out, size_t out_sz);
+
+/**
+ * @brief Linha CSV de largura fixa (RECORD_LOG_EXPORT_LINE_LEN bytes + '\0').
+ * @param out  buffer com pelo menos RECORD_LOG_EXPORT_LINE_LEN + 1 bytes.
+ */
+void record_log_export_line(const record_log_entry_t *entry, char *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATALOGGER_DATALOGGER_DRIVER_INCLUDE_RECORD_LOG_H_ */
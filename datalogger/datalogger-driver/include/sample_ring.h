@@ -0,0 +1,70 @@
+/*
+ * sample_ring.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Anel de amostras em memória RTC (slow) entre ativações.
+ *
+ * Os produtores (pressão, pulsos, RS485) continuam chamando
+ * record_batch_add()/save_record_sd*(); enquanto o SD não estiver montado
+ * nesta ativação as amostras vão para cá, já no formato do log
+ * (record_log_entry_t, 16 B com CRC próprio). O sdcard_mmc.c descarrega o
+ * anel no SD num único lote quando:
+ *   - o anel passa de SAMPLE_RING_HIGH_WATER (quase cheio);
+ *   - antes de um envio (record_ring_flush());
+ *   - com a alimentação em risco (bateria baixa sem fonte externa);
+ *   - quando alguém precisa ler o log (portal, payload builders).
+ *
+ * Semântica em queda de energia:
+ *   - deep sleep, reset por software/WDT/panic e brown-out: o anel fica em
+ *     RTC_NOINIT e é validado por CRC no cabeçalho + CRC de cada amostra;
+ *     nada se perde.
+ *   - perda total de alimentação (bateria removida/esgotada): as amostras
+ *     ainda no anel são perdidas (até SAMPLE_RING_CAPACITY; passar do high
+ *     water não esvazia o anel se o SD não montar). É o motivo do
+ *     descarregamento antecipado com bateria baixa.
+ *   - reset entre a gravação no SD e o descarte do anel: o lote é
+ *     regravado no próximo descarregamento (duplica, não perde).
+ *   - push interrompido: o cabeçalho só é atualizado depois das amostras,
+ *     então o anel volta ao estado anterior ao push.
+ */
+
+#ifndef DATALOGGER_DATALOGGER_DRIVER_INCLUDE_SAMPLE_RING_H_
+#define DATALOGGER_DATALOGGER_DRIVER_INCLUDE_SAMPLE_RING_H_
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "record_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SAMPLE_RING_CAPACITY     120u   // 16 B cada: ~1,9 KiB de RTC slow
+#define SAMPLE_RING_HIGH_WATER   96u    // acima disso o próximo lote vai para o SD
+
+/** @brief Valida o anel em RTC; após power-on (CRC inválido) começa vazio. */
+void sample_ring_init(void);
+
+uint32_t sample_ring_count(void);
+
+/**
+ * @brief Acrescenta 'count' amostras (tudo ou nada).
+ * @return ESP_ERR_NO_MEM se não couber.
+ */
+esp_err_t sample_ring_push(const record_log_entry_t *entries, size_t count);
+
+/** @brief Copia até 'max' amostras, da mais antiga para a mais nova, sem remover. */
+size_t sample_ring_peek(record_log_entry_t *out, size_t max);
+
+/** @brief Remove as 'count' amostras mais antigas (após gravá-las no SD). */
+void sample_ring_drop(size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATALOGGER_DATALOGGER_DRIVER_INCLUDE_SAMPLE_RING_H_ */
@@ -17,6 +17,9 @@ struct record_data_saved {
 };
 
 esp_err_t mount_sd_card(void);
+// Boot sem montar o SD: amostras ficam no anel RTC (sample_ring.h) e o
+// cartão é montado sob demanda
+esp_err_t sdcard_init_deferred(void);
 esp_err_t mount_sdcard_littlefs(void);
 void unmount_sd_card(void);
 esp_err_t unmount_sdcard_littlefs(void);
@@ -39,7 +42,27 @@ esp_err_t save_record_sd(int channel, char *data);
 esp_err_t save_record_sd_rs485(int channel, int subindex, const char *value_str);
 esp_err_t read_record_sd(uint32_t *cursor_pos, struct record_data_saved* record_data);
 esp_err_t delete_record_sd(void);
+esp_err_t flush_record_sd(void);
+// Confirma 'points' registros enviados: avança last_read_idx e o cursor
+// sobre o índice atual (não sobrescreve o que o gravador mudou nesse meio tempo)
+esp_err_t advance_read_index(uint32_t points, uint32_t new_cursor);
 void index_config_init(void);
 
+// Lote de registros de um ciclo de aquisição: um único acesso ao SD
+// (mutex, escrita contígua e 1 atualização de índice) no commit.
+// Fora de um lote aberto, record_batch_add() grava na hora.
+#define RECORD_BATCH_MAX 48
+esp_err_t record_batch_begin(void);
+esp_err_t record_batch_add(int channel, int subindex, const char *value_str);
+esp_err_t record_batch_commit(void);
+// Executa 'cb(arg)' só depois que o lote aberto for gravado com sucesso
+// (descartado se o commit falhar); fora de um lote, executa na hora.
+typedef void (*record_batch_done_cb_t)(uint32_t arg);
+esp_err_t record_batch_on_commit(record_batch_done_cb_t cb, uint32_t arg);
+
+// Descarrega o anel RTC no SD (monta o cartão se preciso). Chamar antes de
+// enviar dados e com bateria baixa; anel vazio não liga o cartão.
+esp_err_t record_ring_flush(void);
+
 
 #endif /* DATALOGGER_DATALOGGER_DRIVER_INC_DATA_REGISTER_H_ */
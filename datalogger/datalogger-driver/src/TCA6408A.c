@@ -1,5 +1,6 @@
 #include "TCA6408A.h"
 #include "i2c_dev_master.h"
+#include "ads1015_reader.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -270,6 +271,11 @@ esp_err_t activate_mosfet(enum mosfet expander_port) {
         }
     }
 
+    // O ADS1015 conta a estabilização dos sensores a partir daqui
+    if (expander_port == enable_analog_sensors) ads1015_note_power_on();
+    else if (expander_port == disable_analog_sensors || expander_port == disable_sensors ||
+             expander_port == enable_pulse_analog) ads1015_note_power_off();   // P3 em alto = desligado
+
     ESP_LOGI(TAG, "MOSFET configurado: modo %d, configuration=0x%02x, output=0x%02x",
              expander_port, config_val, output_val);
     return ESP_OK;
@@ -5,6 +5,8 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 
 #define GPIO_PIN_INTR_NEGEDGE 2
 
@@ -232,58 +234,207 @@ double ads1015_get_voltage(ads1015_t* ads) {
 }
 //Fazer depois --> Antes de desligar pelo MOSFET: feche o handle do ADS (remova o device do barramento) e pare leituras.
 //Depois de ligar pelo MOSFET: dê um pequeno delay de estabilização e deixe o lazy-init recriar o handle na 1ª leitura.
-float oneshot_analog_read(sensor_t tipo) {
-    ads_lock();
 
-    // lazy-init do device 0x48 uma única vez
+static const uint16_t s_sps_hz[] = {128, 250, 490, 920, 1600, 2400, 3300, 3300};
+
+static int64_t s_power_on_us;      // 0 = sensores desligados (nada a esperar)
+static bool    s_rdy_armed;        // limiares do modo "conversion ready" gravados
+
+void ads1015_note_power_on(void)
+{
+    s_power_on_us = esp_timer_get_time();
+    if (s_power_on_us == 0) s_power_on_us = 1;
+    s_rdy_armed = false;           // o ADS pode ter perdido os limiares
+}
+
+void ads1015_note_power_off(void)
+{
+    s_power_on_us = 0;
+}
+
+// Espera só o que falta da estabilização desde o activate_mosfet
+static void wait_sensor_settle(void)
+{
+    int64_t on = s_power_on_us;
+    if (on == 0) return;
+    int64_t left_us = on + (int64_t)ADS1015_SENSOR_SETTLE_MS * 1000 - esp_timer_get_time();
+    if (left_us <= 0) return;
+    const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    vTaskDelay((TickType_t)((left_us + tick_us - 1) / tick_us));
+}
+
+// Tempo de conversão com folga de 10% (oscilador interno) + 20 µs
+static uint32_t conv_time_us(ads1015_sps_t dr)
+{
+    return (1100000u / s_sps_hz[dr & 7]) + 20;
+}
+
+static int mux_for(sensor_t tipo)
+{
+    switch (tipo) {
+        case analog_1: return ADS1015_MUX_3_GND;
+        case analog_2: return ADS1015_MUX_2_GND;
+        case fonte:    return ADS1015_MUX_1_GND;
+        case bateria:  return ADS1015_MUX_0_GND;
+        default:       return -1;
+    }
+}
+
+static float raw_to_volts(const ads1015_t *ads, float raw)
+{
+    static const float fsr[] = {6.144f, 4.096f, 2.048f, 1.024f, 0.512f, 0.256f, 0.256f, 0.256f};
+    return raw * fsr[ads->config.bit.PGA] / 32767.0f;
+}
+
+// Média móvel dos canais de pressão (mesma janela para oneshot e scan)
+static float channel_filter(sensor_t tipo, float v)
+{
+    switch (tipo) {
+        case analog_1: return apply_moving_average(v, raw_buffer_ch1, &buffer_idx_ch1, &buffer_count_ch1);
+        case analog_2: return apply_moving_average(v, raw_buffer_ch2, &buffer_idx_ch2, &buffer_count_ch2);
+        default:       return v;
+    }
+}
+
+// lazy-init do device 0x48 (e do ALERT/RDY, se ligado); chamar com ads_lock
+static esp_err_t ads_ensure_dev(void)
+{
     if (!s_adc.dev_handle) {
         s_adc = ads1015_config(ADS1015_ADDR_GND);   // add no barramento
-        if (!s_adc.dev_handle) { ads_unlock(); return 0.0f; }
+        if (!s_adc.dev_handle) return ESP_FAIL;
+#if ADS1015_RDY_GPIO >= 0
+        ads1015_set_rdy_pin(&s_adc, (gpio_num_t)ADS1015_RDY_GPIO);
+        gpio_isr_handler_add(s_adc.rdy_pin.pin, gpio_isr_handler, (void*)s_adc.rdy_pin.gpio_evt_queue);
+        s_rdy_armed = true;
+#endif
+    }
+#if ADS1015_RDY_GPIO >= 0
+    if (!s_rdy_armed) {
+        // Lo_thresh MSB = 0 e Hi_thresh MSB = 1: ALERT/RDY vira "conversão pronta"
+        esp_err_t err = ads1015_write_register(&s_adc, ADS1015_LO_THRESH_REGISTER_ADDR, 0);
+        if (err == ESP_OK) err = ads1015_write_register(&s_adc, ADS1015_HI_THRESH_REGISTER_ADDR, 0xFFFF);
+        if (err != ESP_OK) return err;
+        s_rdy_armed = true;
     }
+#endif
+    return ESP_OK;
+}
 
-    int16_t get_raw;
-    float voltage = 0;
+/*
+ * Uma conversão single-shot. O fim vem pelo ALERT/RDY (fila do ISR) ou,
+ * sem o pino, por espera curta + leitura do bit OS. Nada de vTaskDelay por
+ * conversão: a 1600 SPS ela leva ~0,7 ms e o tick é de 10 ms.
+ */
+static esp_err_t ads_convert(ads1015_mux_t mux, ads1015_sps_t dr, int16_t *raw)
+{
+    s_adc.config.bit.MUX  = mux;
+    s_adc.config.bit.DR   = dr;
+    s_adc.config.bit.MODE = ADS1015_MODE_SINGLE;
+    s_adc.config.bit.OS   = 1;
+
+    if (s_adc.rdy_pin.in_use) xQueueReset(s_adc.rdy_pin.gpio_evt_queue);
+
+    esp_err_t err = ads1015_write_register(&s_adc, ADS1015_CONFIG_REGISTER_ADDR, s_adc.config.reg);
+    if (err != ESP_OK) return err;
+    s_adc.changed = 0;
+
+    const uint32_t t_conv = conv_time_us(dr);
+    if (s_adc.rdy_pin.in_use) {
+        bool tmp;
+        TickType_t to = pdMS_TO_TICKS(t_conv / 1000) + 2;
+        if (xQueueReceive(s_adc.rdy_pin.gpio_evt_queue, &tmp, to) != pdTRUE) return ESP_ERR_TIMEOUT;
+    } else {
+        if (t_conv >= (uint32_t)portTICK_PERIOD_MS * 1000) vTaskDelay(pdMS_TO_TICKS(t_conv / 1000));
+        else                                                esp_rom_delay_us(t_conv);
+        uint8_t cfg[2];
+        for (int tries = 0; ; ++tries) {
+            err = ads1015_read_register(&s_adc, ADS1015_CONFIG_REGISTER_ADDR, cfg, 2);
+            if (err != ESP_OK) return err;
+            if (cfg[0] & 0x80) break;                 // OS = 1: sem conversão em curso
+            if (tries >= 20) return ESP_ERR_TIMEOUT;
+            esp_rom_delay_us(t_conv / 8 + 20);
+        }
+    }
 
-    switch (tipo) {
-      case analog_1:
-        ads1015_set_mux(&s_adc, ADS1015_MUX_3_GND);
-        get_raw = ads1015_get_raw(&s_adc);
-        voltage = apply_moving_average(ads1015_get_voltage(&s_adc),
-                                       raw_buffer_ch1, &buffer_idx_ch1, &buffer_count_ch1);
-       ESP_LOGI(TAG,"###### Analog 1 #####\n");
-        ESP_LOGI(TAG,"Raw ADC value: %d voltage: %.04f volts\n", get_raw, voltage);
-        break;
-
-      case analog_2:
-        ads1015_set_mux(&s_adc, ADS1015_MUX_2_GND);
-        get_raw = ads1015_get_raw(&s_adc);
-        voltage = apply_moving_average(ads1015_get_voltage(&s_adc),
-                                       raw_buffer_ch2, &buffer_idx_ch2, &buffer_count_ch2);
-        ESP_LOGI(TAG,"###### Analog 2 #####\n");
-        ESP_LOGI(TAG,"Raw ADC value: %d voltage: %.04f volts\n", get_raw, voltage);
-        break;
-
-      case fonte:
-        ads1015_set_mux(&s_adc, ADS1015_MUX_1_GND);
-        get_raw = ads1015_get_raw(&s_adc);
-        voltage = ads1015_get_voltage(&s_adc);
-        ESP_LOGI(TAG,"###### Analog 3 #####\n");
-        ESP_LOGI(TAG,"Raw ADC value: %d voltage: %.04f volts\n", get_raw, voltage);
-        break;
-
-      case bateria:
-        ads1015_set_mux(&s_adc, ADS1015_MUX_0_GND);
-        get_raw = ads1015_get_raw(&s_adc);
-        voltage = ads1015_get_voltage(&s_adc);
-        ESP_LOGI(TAG,"###### Analog 4 #####\n");
-        ESP_LOGI(TAG,"Raw ADC value: %d voltage: %.04f volts\n", get_raw, voltage);
-        break;
-
-      default:
+    uint8_t data[2];
+    err = ads1015_read_register(&s_adc, ADS1015_CONVERSION_REGISTER_ADDR, data, 2);
+    if (err != ESP_OK) return err;
+    *raw = (int16_t)(((uint16_t)data[0] << 8) | (uint16_t)data[1]);
+    return ESP_OK;
+}
+
+// Ordena (n <= ADS1015_SCAN_MAX_OS), descarta 'trim' em cada ponta e tira a média
+static float trimmed_mean(int16_t *v, uint8_t n, uint8_t trim)
+{
+    for (uint8_t i = 1; i < n; i++) {
+        int16_t x = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > x) { v[j + 1] = v[j]; j--; }
+        v[j + 1] = x;
+    }
+    if (2 * trim >= n) trim = (uint8_t)((n - 1) / 2);
+    int32_t sum = 0;
+    for (uint8_t i = trim; i < n - trim; i++) sum += v[i];
+    return (float)sum / (float)(n - 2 * trim);
+}
+
+esp_err_t ads1015_scan(const sensor_t *ch, size_t n, const ads1015_scan_cfg_t *cfg, float *volts)
+{
+    static const ads1015_scan_cfg_t def = ADS1015_SCAN_CFG_DEFAULT;
+    if (!ch || !volts || n == 0 || n > ADS1015_SCAN_MAX_CH) return ESP_ERR_INVALID_ARG;
+    if (!cfg) cfg = &def;
+
+    uint8_t os = cfg->oversample;
+    if (os == 0) os = 1;
+    if (os > ADS1015_SCAN_MAX_OS) os = ADS1015_SCAN_MAX_OS;
+
+    ads_lock();
+    esp_err_t err = ads_ensure_dev();
+    if (err == ESP_OK) wait_sensor_settle();
+
+    const int64_t t0 = esp_timer_get_time();
+    for (size_t i = 0; i < n && err == ESP_OK; ++i) {
+        int mux = mux_for(ch[i]);
+        if (mux < 0) { err = ESP_ERR_INVALID_ARG; break; }
+
+        int16_t s[ADS1015_SCAN_MAX_OS];
+        for (uint8_t k = 0; k < os && err == ESP_OK; ++k) {
+            err = ads_convert((ads1015_mux_t)mux, cfg->sps, &s[k]);
+        }
+        if (err != ESP_OK) break;
+        volts[i] = channel_filter(ch[i], raw_to_volts(&s_adc, trimmed_mean(s, os, cfg->trim)));
+    }
+    const int64_t t1 = esp_timer_get_time();
+    ads_unlock();
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Varredura do ADS1015 falhou: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Varredura: %u canal(is) x %u conversões em %lld us",
+             (unsigned)n, os, (long long)(t1 - t0));
+    return ESP_OK;
+}
+
+float oneshot_analog_read(sensor_t tipo) {
+    int mux = mux_for(tipo);
+    if (mux < 0) {
         ESP_LOGI(TAG,"Sensor inexistente!\n");
-        voltage = 0.0f;
-        break;
+        return 0.0f;
+    }
+
+    ads_lock();
+    if (ads_ensure_dev() != ESP_OK) { ads_unlock(); return 0.0f; }
+    wait_sensor_settle();
+
+    // uma única conversão (antes: get_raw + get_voltage = duas)
+    int16_t get_raw = 0;
+    float voltage = 0.0f;
+    if (ads_convert((ads1015_mux_t)mux, s_adc.config.bit.DR, &get_raw) == ESP_OK) {
+        voltage = channel_filter(tipo, raw_to_volts(&s_adc, get_raw));
     }
+    ESP_LOGI(TAG,"###### Analog %d #####\n", (int)tipo);
+    ESP_LOGI(TAG,"Raw ADC value: %d voltage: %.04f volts\n", get_raw, voltage);
 
     ads_unlock();
     return voltage;
@@ -14,12 +14,52 @@
 #include "nvs.h"
 
 #include <dirent.h>
+#include <stddef.h>
 #include "system.h"
+#include "esp_attr.h"
+#include "esp_rom_crc.h"
+#include "config_store.h"
 
 static const char *TAG = "Config_Driver";
 
 static SemaphoreHandle_t file_mutex = NULL;
 
+// Última leitura de pressão (ver save_pressure_data)
+typedef struct {
+    struct pressure_data data;
+    uint32_t             crc;
+} pressure_rtc_t;
+
+RTC_DATA_ATTR static pressure_rtc_t s_press_rtc;
+
+static inline uint32_t pressure_rtc_crc(const pressure_rtc_t *p)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&p->data, sizeof(p->data));
+}
+
+static inline bool pressure_rtc_valid(void)
+{
+    return s_press_rtc.crc == pressure_rtc_crc(&s_press_rtc);
+}
+
+// Última telemetria (CSQ, fonte, bateria; ver save_self_monitoring_data)
+typedef struct {
+    struct self_monitoring_data data;
+    uint32_t                    crc;
+} self_mon_rtc_t;
+
+RTC_DATA_ATTR static self_mon_rtc_t s_self_mon_rtc;
+
+static inline uint32_t self_mon_rtc_crc(const self_mon_rtc_t *p)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&p->data, sizeof(p->data));
+}
+
+static inline bool self_mon_rtc_valid(void)
+{
+    return s_self_mon_rtc.crc == self_mon_rtc_crc(&s_self_mon_rtc);
+}
+
 #define littlefs_base_path "/littlefs"
 
 #define DEVICE_CONFIG_FILE  "/littlefs/dev_config.json"
@@ -28,9 +68,10 @@ static SemaphoreHandle_t file_mutex = NULL;
 #define RECORD_PULSE_CONFIG_FILE  "/littlefs/rec_pulse_config.json"
 #define SYSTEM_CONFIG_FILE  "/littlefs/system_config.json"
 #define RECORD_LAST_UNIT_TIME_FILE  "/littlefs/record_last_unit_time.json"
-#define SELF_MONITORING_DATA  "/littlefs/self_monitoring_data.json"
-#define PRESSURE_DATA_SET "/littlefs/pressure_data_set.json"
-#define INDEX_CONTROL "/littlefs/index_control.json"
+#define INDEX_CONTROL "/littlefs/index_control.json"       // legado (só migração)
+#define INDEX_JOURNAL "/littlefs/index_jn.bin"
+#define INDEX_JOURNAL_TMP "/littlefs/index_jn.tmp"
+#define INDEX_JOURNAL_SLOTS 128                              // compacta ao atingir
 #define PRESSURE_INDEX_CONTROL "/littlefs/pressure_index_control.json"
 #define ENERGY_INDEX_CONTROL "/littlefs/energy_index_control.json"
 #define ENERGY_MEASURED "/littlefs/energy_measured.json"
@@ -44,6 +85,8 @@ static SemaphoreHandle_t file_mutex = NULL;
 #define CFG_MAX_JSON 4096
 static char g_cfg_io_buf[CFG_MAX_JSON + 1];
 
+static void config_migrate_legacy(void);
+
 SemaphoreHandle_t config_get_file_mutex(void)
 {
     return file_mutex;
@@ -56,74 +99,23 @@ bool config_fs_ready(void)
 
 bool has_device_config(void)
 {
-    struct stat st;
-    bool exists = false;
-
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(DEVICE_CONFIG_FILE, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_device_config: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return config_store_has(CFG_SEC_DEVICE);
 }
 
 bool has_network_config(void)
 {
-    struct stat st;
-    bool exists = false;
-  
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(NETWORK_CONFIG_FILE, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_network_config: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return config_store_has(CFG_SEC_NETWORK);
 }
 
 bool has_operation_config(void)
 {
-    struct stat st;
-    bool exists = false;
-    
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(OPERATION_CONFIG_FILE, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_operation_config: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return config_store_has(CFG_SEC_OPERATION);
 }
 
 bool has_record_index_config(void)
 {
-    struct stat st;
-    bool exists = false;
-    
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(INDEX_CONTROL, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_record_index_config: timeout ao obter mutex\n");
-    }
-    
-    return exists;
+    struct record_index_config cfg;
+    return get_index_config(&cfg) == ESP_OK;
 }
 
 bool has_record_pulse_config(void)
@@ -152,75 +144,22 @@ bool has_record_pulse_config(void)
 
 bool has_system_config(void)
 {
-    struct stat st;
-    bool exists = false;
-    
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(SYSTEM_CONFIG_FILE, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_system_config: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return config_store_has(CFG_SEC_SYSTEM);
 }
-//**********
+
 bool has_record_last_unit_time(void)
 {
-    struct stat st;
-    bool exists = false;
-    
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(RECORD_LAST_UNIT_TIME_FILE, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_record_last_unit_time: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return config_store_has(CFG_SEC_LAST_UNIT_TIME);
 }
 
 bool has_self_monitoring_data(void)
 {
-    struct stat st;
-    bool exists = false;
-    
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(SELF_MONITORING_DATA, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        // opcional: logar timeout
-        printf("has_self_monitoring_data: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return self_mon_rtc_valid();
 }
 
 bool has_pressure_data(void)
 {
-    struct stat st;
-    bool exists = false;
-    
-    if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        if (stat(PRESSURE_DATA_SET, &st) == 0) {
-            exists = true;
-        }
-        xSemaphoreGive(file_mutex);
-        
-    } else {
-        // opcional: logar timeout
-        printf("has_pressure_data: timeout ao obter mutex\n");
-    }
-
-    return exists;
+    return pressure_rtc_valid();
 }
 
 
@@ -242,341 +181,159 @@ void mount_driver(void)
     ESP_LOGE(TAG, "Failed to create file mutex");
     return;
        }
+
+    config_store_load();
+    config_migrate_legacy();
 }
 
-void save_device_config(struct device_config *config)
+//==============================================================
+//  Configuração: imagem binária em RAM (config_store)
+//--------------------------------------------------------------
+// save_*() só atualizam o cache (seção fica suja se mudou); quem precisa
+// de persistência chama config_store_commit() (save_config, fim do
+// init_config_control, ...), que grava tudo de uma vez e só se algo mudou.
+// get_*() e has_*() não tocam a flash.
+// O JSON abaixo serve para importar/exportar pelo portal e para migrar os
+// arquivos *.json de firmwares anteriores.
+//==============================================================
+
+typedef union {
+    struct device_config         dev;
+    struct network_config        net;
+    struct operation_config      op;
+    struct system_config         sys;
+    struct record_last_unit_time last_unit;
+} cfg_any_t;
+
+static void json_str(const cJSON *root, const char *key, char *dst, size_t cap)
 {
+    const cJSON *it = cJSON_GetObjectItem(root, key);
+    if (cJSON_IsString(it) && it->valuestring) {
+        snprintf(dst, cap, "%s", it->valuestring);
+    }
+}
+
+static void json_bool(const cJSON *root, const char *key, bool *dst)
+{
+    const cJSON *it = cJSON_GetObjectItem(root, key);
+    if (cJSON_IsBool(it))        *dst = cJSON_IsTrue(it);
+    else if (cJSON_IsNumber(it)) *dst = (it->valueint != 0);     // system_config grava 0/1
+}
+
+// Campo ausente (ou de outro tipo) mantém o valor atual da struct
+#define JSON_NUM(_root, _key, _dst) do { \
+        const cJSON *_it = cJSON_GetObjectItem((_root), (_key)); \
+        if (cJSON_IsNumber(_it)) { (_dst) = (__typeof__(_dst)) _it->valuedouble; } \
+    } while (0)
+
+// ---------------- device ----------------
+static cJSON *device_config_to_json(const void *cfg)
+{
+    const struct device_config *config = cfg;
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "id", config->id);
     cJSON_AddStringToObject(root, "name", config->name);
     cJSON_AddStringToObject(root, "phone", config->phone);
     cJSON_AddStringToObject(root, "ssid_ap", config->ssid_ap);
     cJSON_AddStringToObject(root, "wifi_password_ap", config->wifi_password_ap);
-     if(config->activate_sta)
-    {
-        cJSON_AddTrueToObject(root, "activate_sta");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "activate_sta");
-    }
+    cJSON_AddBoolToObject(root, "activate_sta", config->activate_sta);
     cJSON_AddStringToObject(root, "ssid_sta", config->ssid_sta);
     cJSON_AddStringToObject(root, "wifi_password_sta", config->wifi_password_sta);
-    
-    // sempre serialize o campo send_mode, send_period e send_times
     cJSON_AddStringToObject(root, "send_mode", config->send_mode);
     cJSON_AddNumberToObject(root, "send_period", config->send_period);
-    {
-      int times_int[4];
-      for (int i = 0; i < 4; i++) {
+    int times_int[4];
+    for (int i = 0; i < 4; i++) {
         times_int[i] = config->send_times[i];
-      }
-      cJSON *arr = cJSON_CreateIntArray(times_int, 4);
-      cJSON_AddItemToObject(root, "send_times", arr);
-}
-
-    cJSON_AddNumberToObject(root, "deep_sleep_period", config->deep_sleep_period);
-    
-    if(config->save_pulse_zero)
-    {
-        cJSON_AddTrueToObject(root, "save_pulse_zero");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "save_pulse_zero");
     }
+    cJSON_AddItemToObject(root, "send_times", cJSON_CreateIntArray(times_int, 4));
+    cJSON_AddNumberToObject(root, "deep_sleep_period", config->deep_sleep_period);
+    cJSON_AddBoolToObject(root, "save_pulse_zero", config->save_pulse_zero);
     cJSON_AddNumberToObject(root, "scale", config->scale);
     cJSON_AddNumberToObject(root, "flow_rate", config->flow_rate);
     cJSON_AddStringToObject(root, "date", config->date);
     cJSON_AddStringToObject(root, "time", config->time);
-    
-    if(config->finished_factory)
-    {
-        cJSON_AddTrueToObject(root, "finished_factory");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "finished_factory");
-    }
-    
-    if(config->always_on)
-    {
-        cJSON_AddTrueToObject(root, "always_on");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "always_on");
-    }
-    
-     if(config->device_active)
-    {
-        cJSON_AddTrueToObject(root, "device_active");
-    }
-     else
-    {
-        cJSON_AddFalseToObject(root, "device_active");
-    }
-    
-     if(config->timestamp_mode)
-    {
-        cJSON_AddTrueToObject(root, "timestamp_mode");
-    }
-     else
-    {
-        cJSON_AddFalseToObject(root, "timestamp_mode");
-    }
-    
-/*    if(config->send_value)
-    {
-        cJSON_AddTrueToObject(root, "send_value");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "send_value");
-    }*/
- 
-    char *device_config = cJSON_PrintUnformatted(root);
-    
- if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-    FILE *f = fopen(DEVICE_CONFIG_FILE, "w");
-    if (f != NULL){
-       if (fputs(device_config, f) == EOF) {
-                printf("*** save_device_config --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(device_config);
-                cJSON_Delete(root);
-                return;
-            }
-        // fecha e checa erro ao fechar
-            if (fclose(f) != 0) {
-                printf("*** save_device_config --> Error closing file: %s ***\n", strerror(errno));
-                xSemaphoreGive(file_mutex);
-                free(device_config);
-                cJSON_Delete(root);
-                return;
-                }
-    }else{
-    	  printf ("*** save_device_config --> File = Null (is /littlefs mounted?) ***\n");
-         }
-    xSemaphoreGive(file_mutex);
-  } // end if-take
-  
-    free(device_config);
-    cJSON_Delete(root);  
-  
+    cJSON_AddBoolToObject(root, "finished_factory", config->finished_factory);
+    cJSON_AddBoolToObject(root, "always_on", config->always_on);
+    cJSON_AddBoolToObject(root, "device_active", config->device_active);
+    cJSON_AddBoolToObject(root, "timestamp_mode", config->timestamp_mode);
+    cJSON_AddBoolToObject(root, "binary_payload", config->binary_payload);
+    return root;
 }
 
-void get_device_config(struct device_config *config)
+static void device_config_defaults(void *cfg)
 {
-    // Lê o arquivo TODO em buffer global (sem stack grande, sem malloc)
-    xSemaphoreTake(file_mutex, portMAX_DELAY);
-
-    FILE *f = fopen(DEVICE_CONFIG_FILE, "r");
-    if (f == NULL) {
-        printf("### get_device_config --> File = Null ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
-    }
-
-    vTaskDelay(pdMS_TO_TICKS(10));  // mantém seu pequeno debounce de I/O
-
-    // Descobre tamanho real do arquivo
-    fseek(f, 0L, SEEK_END);
-    long size = ftell(f);
-    rewind(f);
-
-    if (size <= 0 || size > CFG_MAX_JSON) {
-        // [FIX] Recusa arquivo vazio/negativo e também maior que o limite
-        //       (evita truncamento e JSON parcial)
-        fclose(f);
-        printf("### get_device_config --> SIZE = %ld (max=%d) ###\n", size, CFG_MAX_JSON);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return;
-    }
-
-    // Lê exatamente 'size' bytes (ou o que houver) para o buffer global
-    size_t n = fread(g_cfg_io_buf, 1, (size_t)size, f);
-    g_cfg_io_buf[n] = '\0';
-    fclose(f);
-
-    // [FIX] Parse com comprimento conhecido (não depende do '\0' nem de buffer “grande o suficiente”)
-    cJSON *root = cJSON_ParseWithLength(g_cfg_io_buf, n);
-    if (root == NULL) {
-        printf("### get_device_config --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
-    }
-
-    // ---------- Copias seguras de strings ----------
-    // Observação: usamos snprintf(...) para garantir terminação e evitar overflow
-    // (se preferir e seu toolchain tiver, pode trocar por strlcpy(...))
-
-    cJSON *it;
-
-    it = cJSON_GetObjectItem(root, "id");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->id, sizeof(config->id), "%s", it->valuestring);
-    } else {
-        config->id[0] = '\0';
-    }
-
-    it = cJSON_GetObjectItem(root, "name");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->name, sizeof(config->name), "%s", it->valuestring);
-    } else {
-        config->name[0] = '\0';
-    }
-
-    it = cJSON_GetObjectItem(root, "phone");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->phone, sizeof(config->phone), "%s", it->valuestring);
-    } else {
-        config->phone[0] = '\0';
-    }
+    struct device_config *config = cfg;
+    snprintf(config->send_mode, sizeof(config->send_mode), "%s", "freq");
+}
 
-    it = cJSON_GetObjectItem(root, "ssid_ap");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->ssid_ap, sizeof(config->ssid_ap), "%s", it->valuestring);
-    } else {
-        config->ssid_ap[0] = '\0';
-    }
+static void device_config_from_json(const cJSON *root, void *cfg)
+{
+    struct device_config *config = cfg;
+    json_str(root, "id", config->id, sizeof(config->id));
+    json_str(root, "name", config->name, sizeof(config->name));
+    json_str(root, "phone", config->phone, sizeof(config->phone));
+    json_str(root, "ssid_ap", config->ssid_ap, sizeof(config->ssid_ap));
 
-    it = cJSON_GetObjectItem(root, "wifi_password_ap");
+    const cJSON *it = cJSON_GetObjectItem(root, "wifi_password_ap");
     if (cJSON_IsString(it) && it->valuestring) {
         size_t pwlen = strlen(it->valuestring);
-
-        if (pwlen == 0) {
-            // Sem senha -> AP aberto
-            config->wifi_password_ap[0] = '\0';
-        } else if (pwlen < 8) {
-            // Senha curta -> não salva, força vazio
+        if (pwlen > 0 && pwlen < 8) {
+            // Senha curta -> não salva, força vazio (AP aberto)
             ESP_LOGW("CONFIG_DRIVER",
                      "Senha AP muito curta (%d chars). Armazenando vazia (AP aberto).",
                      (int)pwlen);
             config->wifi_password_ap[0] = '\0';
         } else {
-            // Senha válida (>= 8)
-            snprintf(config->wifi_password_ap,
-                     sizeof(config->wifi_password_ap),
-                     "%s", it->valuestring);
+            snprintf(config->wifi_password_ap, sizeof(config->wifi_password_ap), "%s", it->valuestring);
         }
-    } else {
-        config->wifi_password_ap[0] = '\0';
     }
 
-    // Booleans
-    it = cJSON_GetObjectItem(root, "activate_sta");
-    config->activate_sta = (it && cJSON_IsBool(it)) ? cJSON_IsTrue(it) : false;
-
-    it = cJSON_GetObjectItem(root, "ssid_sta");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->ssid_sta, sizeof(config->ssid_sta), "%s", it->valuestring);
-    } else {
-        config->ssid_sta[0] = '\0';
-    }
-
-    it = cJSON_GetObjectItem(root, "wifi_password_sta");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->wifi_password_sta, sizeof(config->wifi_password_sta), "%s", it->valuestring);
-    } else {
-        config->wifi_password_sta[0] = '\0';
-    }
+    json_bool(root, "activate_sta", &config->activate_sta);
+    json_str(root, "ssid_sta", config->ssid_sta, sizeof(config->ssid_sta));
+    json_str(root, "wifi_password_sta", config->wifi_password_sta, sizeof(config->wifi_password_sta));
+    json_str(root, "send_mode", config->send_mode, sizeof(config->send_mode));
+    JSON_NUM(root, "send_period", config->send_period);
 
-    // ---------- Campos adicionais ----------
-    // send_mode
-    it = cJSON_GetObjectItem(root, "send_mode");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->send_mode, sizeof(config->send_mode), "%s", it->valuestring);
-    } else {
-        // padrão
-        snprintf(config->send_mode, sizeof(config->send_mode), "%s", "freq");
-    }
-
-    // send_period
-    it = cJSON_GetObjectItem(root, "send_period");
-    if (cJSON_IsNumber(it)) {
-        config->send_period = it->valueint;
-    } // se faltar, mantém valor anterior da struct
-
-    // send_times[0..3]
-    cJSON *arr = cJSON_GetObjectItem(root, "send_times");
-    if (arr && cJSON_IsArray(arr)) {
+    const cJSON *arr = cJSON_GetObjectItem(root, "send_times");
+    if (cJSON_IsArray(arr)) {
         int len = cJSON_GetArraySize(arr);
         for (int i = 0; i < len && i < 4; i++) {
-            cJSON *t = cJSON_GetArrayItem(arr, i);
-            if (t && cJSON_IsNumber(t)) {
+            const cJSON *t = cJSON_GetArrayItem(arr, i);
+            if (cJSON_IsNumber(t)) {
                 config->send_times[i] = (uint8_t)t->valueint;
             }
         }
     }
 
-    // deep_sleep_period
-    it = cJSON_GetObjectItem(root, "deep_sleep_period");
-    if (cJSON_IsNumber(it)) {
-        config->deep_sleep_period = it->valueint;
-    }
-
-    // save_pulse_zero
-    it = cJSON_GetObjectItem(root, "save_pulse_zero");
-    config->save_pulse_zero = (it && cJSON_IsBool(it)) ? cJSON_IsTrue(it) : false;
-
-    // scale
-    it = cJSON_GetObjectItem(root, "scale");
-    if (cJSON_IsNumber(it)) {
-        config->scale = it->valueint;
-    }
-
-    // flow_rate
-    it = cJSON_GetObjectItem(root, "flow_rate");
-    if (cJSON_IsNumber(it)) {
-        config->flow_rate = (float)it->valuedouble;
-    } else {
-        ESP_LOGW("DeviceConfig", "Campo 'flow_rate' não encontrado ou inválido");
-        config->flow_rate = 0.0f;
-    }
+    JSON_NUM(root, "deep_sleep_period", config->deep_sleep_period);
+    json_bool(root, "save_pulse_zero", &config->save_pulse_zero);
+    JSON_NUM(root, "scale", config->scale);
+    JSON_NUM(root, "flow_rate", config->flow_rate);
+    json_str(root, "date", config->date, sizeof(config->date));
+    json_str(root, "time", config->time, sizeof(config->time));
+    json_bool(root, "finished_factory", &config->finished_factory);
+    json_bool(root, "always_on", &config->always_on);
+    json_bool(root, "device_active", &config->device_active);
+    json_bool(root, "timestamp_mode", &config->timestamp_mode);
+    json_bool(root, "binary_payload", &config->binary_payload);   // ausente em configs antigas => JSON
+}
 
-    // date
-    it = cJSON_GetObjectItem(root, "date");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->date, sizeof(config->date), "%s", it->valuestring);
-    } else {
-        config->date[0] = '\0';
-    }
+void save_device_config(struct device_config *config)
+{
+    (void)config_store_set(CFG_SEC_DEVICE, config, sizeof(*config));
+}
 
-    // time
-    it = cJSON_GetObjectItem(root, "time");
-    if (cJSON_IsString(it) && it->valuestring) {
-        snprintf(config->time, sizeof(config->time), "%s", it->valuestring);
-    } else {
-        config->time[0] = '\0';
+void get_device_config(struct device_config *config)
+{
+    if (config_store_get(CFG_SEC_DEVICE, config, sizeof(*config)) != ESP_OK) {
+        printf("### get_device_config --> sem configuração ###\n");
     }
-
-    // finished_factory
-    it = cJSON_GetObjectItem(root, "finished_factory");
-    config->finished_factory = (it && cJSON_IsBool(it)) ? cJSON_IsTrue(it) : false;
-
-    // always_on
-    it = cJSON_GetObjectItem(root, "always_on");
-    config->always_on = (it && cJSON_IsBool(it)) ? cJSON_IsTrue(it) : false;
-
-    // device_active
-    it = cJSON_GetObjectItem(root, "device_active");
-    config->device_active = (it && cJSON_IsBool(it)) ? cJSON_IsTrue(it) : false;
-    
-    // timestamp_mode
-    it = cJSON_GetObjectItem(root, "timestamp_mode");
-    config->timestamp_mode = (it && cJSON_IsBool(it)) ? cJSON_IsTrue(it) : false;
-
-    // Libera JSON e mutex
-    cJSON_Delete(root);
-    xSemaphoreGive(file_mutex);
 }
 
-
-void save_network_config(struct network_config *config)
+// ---------------- network ----------------
+static cJSON *network_config_to_json(const void *cfg)
 {
+    const struct network_config *config = cfg;
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "apn", config->apn);
     cJSON_AddStringToObject(root, "lte_user", config->lte_user);
@@ -584,498 +341,339 @@ void save_network_config(struct network_config *config)
     cJSON_AddStringToObject(root, "data_server_url", config->data_server_url);
     cJSON_AddNumberToObject(root, "data_server_port", config->data_server_port);
     cJSON_AddStringToObject(root, "data_server_path", config->data_server_path);
-    
     cJSON_AddStringToObject(root, "user", config->user);
     cJSON_AddStringToObject(root, "token", config->token);
     cJSON_AddStringToObject(root, "pw", config->pw);
-    
     cJSON_AddStringToObject(root, "mqtt_url", config->mqtt_url);
     cJSON_AddNumberToObject(root, "mqtt_port", config->mqtt_port);
     cJSON_AddStringToObject(root, "mqtt_topic", config->mqtt_topic);
- //   printf("@@@ Save MQTT TOPIC =%s\n", config->mqtt_topic);
     cJSON_AddNumberToObject(root, "mqtt_qos", config->mqtt_qos);
- 
-     if(config->http_en)
-    {
-        cJSON_AddTrueToObject(root, "http_enable");
-    }
-     else
-    {
-        cJSON_AddFalseToObject(root, "http_enable");
-    }
-     
-    if(config->user_en)
-    {
-        cJSON_AddTrueToObject(root, "user_en");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "user_en");
-    }
-    if(config->token_en)
-    {
-        cJSON_AddTrueToObject(root, "token_en");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "token_en");
-    }
-    if(config->pw_en)
-    {
-        cJSON_AddTrueToObject(root, "pw_en");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "pw_en");
-    }
-    
-    if(config->mqtt_en)
-    {
-        cJSON_AddTrueToObject(root, "mqtt_enable");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "mqtt_enable");
-    }
-    
-    char *network_config = cJSON_PrintUnformatted(root);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-    FILE *f = fopen(NETWORK_CONFIG_FILE, "w");
-    if (f != NULL)
-    {
-//          fputs(network_config, f);
-        if (fputs(network_config, f) == EOF) {
-                printf("*** save_network_config --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(network_config);
-                cJSON_Delete(root);
-                return;
-            }
-        fclose(f);
-    }
-    else{
-    	 printf ("*** save_network_config --> File = Null ***\n");
-         }
-      xSemaphoreGive(file_mutex);  
-     }
-     
-    free(network_config);
-    cJSON_Delete(root);  
+    cJSON_AddBoolToObject(root, "http_enable", config->http_en);
+    cJSON_AddBoolToObject(root, "user_en", config->user_en);
+    cJSON_AddBoolToObject(root, "token_en", config->token_en);
+    cJSON_AddBoolToObject(root, "pw_en", config->pw_en);
+    cJSON_AddBoolToObject(root, "mqtt_enable", config->mqtt_en);
+    return root;
 }
 
-void get_network_config(struct network_config *config)
+static void network_config_defaults(void *cfg)
 {
-    xSemaphoreTake(file_mutex,portMAX_DELAY);
-        // Tenta abrir o arquivo de configuração
-    FILE *f = fopen(NETWORK_CONFIG_FILE, "r");
+    struct network_config *config = cfg;
+    config->mqtt_qos = 1;          // default para arquivos antigos
+}
 
-    if (f == NULL){  
-        printf ("### get_network_config --> File = Null ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
+static void network_config_from_json(const cJSON *root, void *cfg)
+{
+    struct network_config *config = cfg;
+    json_str(root, "apn", config->apn, sizeof(config->apn));
+    json_str(root, "lte_user", config->lte_user, sizeof(config->lte_user));
+    json_str(root, "lte_pw", config->lte_pw, sizeof(config->lte_pw));
+    json_str(root, "data_server_url", config->data_server_url, sizeof(config->data_server_url));
+    JSON_NUM(root, "data_server_port", config->data_server_port);
+    json_str(root, "data_server_path", config->data_server_path, sizeof(config->data_server_path));
+    json_str(root, "user", config->user, sizeof(config->user));
+    json_str(root, "token", config->token, sizeof(config->token));
+    json_str(root, "pw", config->pw, sizeof(config->pw));
+    json_str(root, "mqtt_url", config->mqtt_url, sizeof(config->mqtt_url));
+    JSON_NUM(root, "mqtt_port", config->mqtt_port);
+    json_str(root, "mqtt_topic", config->mqtt_topic, sizeof(config->mqtt_topic));
+
+    const cJSON *item = cJSON_GetObjectItem(root, "mqtt_qos");
+    if (cJSON_IsNumber(item)) {
+        int q = item->valueint;
+        if (q < 0) q = 0;
+        if (q > 2) q = 2;
+        config->mqtt_qos = (uint8_t)q;
     }
 
-       vTaskDelay(pdMS_TO_TICKS(10));
-       fseek(f, 0L, SEEK_END);
-       long size = ftell(f);
-       rewind(f);
-       
-        if (size <= 0) {
-        // Arquivo vazio ou erro de tamanho
-        fclose(f);
-        printf("### get_network_config --> SIZE = %ld ###\n", size);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return;
-        }
+    json_bool(root, "http_enable", &config->http_en);
+    json_bool(root, "user_en", &config->user_en);
+    json_bool(root, "token_en", &config->token_en);
+    json_bool(root, "pw_en", &config->pw_en);
+    json_bool(root, "mqtt_enable", &config->mqtt_en);
+}
 
- char buf[1024];
-      size_t bytes_read = fread(buf, 1, (size_t) (size < (long)sizeof(buf) - 1 ? size : (long)sizeof(buf) - 1), f);
-      buf[bytes_read] = '\0';
-    // Fecha o arquivo agora que a leitura foi concluída
-      fclose(f);
-      
-    // Parse do JSON
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        printf("### get_network_config --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
-    }
-    cJSON *item;
-        
-        strcpy(config->apn, cJSON_GetObjectItem(root, "apn")->valuestring);
-        strcpy(config->lte_user, cJSON_GetObjectItem(root, "lte_user")->valuestring);
-        strcpy(config->lte_pw, cJSON_GetObjectItem(root, "lte_pw")->valuestring);
-        strcpy(config->data_server_url, cJSON_GetObjectItem(root, "data_server_url")->valuestring);
-        config->data_server_port = cJSON_GetObjectItem(root, "data_server_port")->valueint;
-        strcpy(config->data_server_path, cJSON_GetObjectItem(root, "data_server_path")->valuestring);
-        strcpy(config->user, cJSON_GetObjectItem(root, "user")->valuestring);
-        strcpy(config->token, cJSON_GetObjectItem(root, "token")->valuestring);
-        strcpy(config->pw, cJSON_GetObjectItem(root, "pw")->valuestring);
-        
-//-------------------------------------------------------------------------------------------------------        
-        strcpy(config->mqtt_url, cJSON_GetObjectItem(root, "mqtt_url")->valuestring);
-        config->mqtt_port = cJSON_GetObjectItem(root, "mqtt_port")->valueint;
-        strcpy(config->mqtt_topic, cJSON_GetObjectItem(root, "mqtt_topic")->valuestring);
- //       printf("@@@ Load MQTT TOPIC =%s\n", config->mqtt_topic);
-  item = cJSON_GetObjectItem(root, "mqtt_qos");
-        if (item && cJSON_IsNumber(item)) {
-            int q = item->valueint;
-            if (q < 0) q = 0;
-            if (q > 2) q = 2;
-            config->mqtt_qos = (uint8_t)q;
-        } else {
-            config->mqtt_qos = 1; // default para arquivos antigos
-        }
- 
-//-------------------------------------------------------------------------------------------------------    
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "http_enable")))
-        {
-            config->http_en = true;
-        }
-        else
-        {
-            config->http_en = false;
-        }
-         
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "user_en")))
-        {
-            config->user_en = true;
-        }
-        else
-        {
-            config->user_en = false;
-        }
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "token_en")))
-        {
-            config->token_en = true;
-        }
-        else
-        {
-            config->token_en = false;
-        }
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "pw_en")))
-        {
-            config->pw_en = true;
-        }
-        else
-        {
-            config->pw_en = false;
-        }
-        
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "mqtt_enable")))
-        {
-            config->mqtt_en = true;
-        }
-        else
-        {
-            config->mqtt_en = false;
-        } 
-        
-        cJSON_Delete(root);
+void save_network_config(struct network_config *config)
+{
+    (void)config_store_set(CFG_SEC_NETWORK, config, sizeof(*config));
+}
 
-    xSemaphoreGive(file_mutex);
+void get_network_config(struct network_config *config)
+{
+    if (config_store_get(CFG_SEC_NETWORK, config, sizeof(*config)) != ESP_OK) {
+        printf("### get_network_config --> sem configuração ###\n");
+    }
 }
 
-void save_operation_config(struct operation_config *config)
+// ---------------- operation ----------------
+static cJSON *operation_config_to_json(const void *cfg)
 {
+    const struct operation_config *config = cfg;
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "serial_number", config->serial_number);
     cJSON_AddStringToObject(root, "company", config->company);
     cJSON_AddStringToObject(root, "ds_start", config->deep_sleep_start);
     cJSON_AddStringToObject(root, "ds_end", config->deep_sleep_end);
-    if(config->reset_count)
-    {
-        cJSON_AddTrueToObject(root, "reset_count");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "reset_count");
-    }
+    cJSON_AddBoolToObject(root, "reset_count", config->reset_count);
     cJSON_AddStringToObject(root, "keep_alive", config->keep_alive);
-/*    
-    if(config->log_level_1)
-    {
-        cJSON_AddTrueToObject(root, "log1");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "log1");
-    }
-    if(config->log_level_2)
-    {
-        cJSON_AddTrueToObject(root, "log2");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "log2");
-    }
-*/
-
-//------------------------------------------
-    if(config->enable_post)
-    {
-        cJSON_AddTrueToObject(root, "en_post");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "en_post");
-    }
-    if(config->enable_get)
-    {
-        cJSON_AddTrueToObject(root, "en_get");
-    }
-    else
-    {
-        cJSON_AddFalseToObject(root, "en_get");
-    }
-
+    cJSON_AddBoolToObject(root, "en_post", config->enable_post);
+    cJSON_AddBoolToObject(root, "en_get", config->enable_get);
     cJSON_AddStringToObject(root, "config_server_url", config->config_server_url);
     cJSON_AddNumberToObject(root, "config_server_port", config->config_server_port);
     cJSON_AddStringToObject(root, "config_server_path", config->config_server_path);
-    
     cJSON_AddNumberToObject(root, "level_min", config->level_min);
     cJSON_AddNumberToObject(root, "level_max", config->level_max);
+    return root;
+}
 
-    char *operation_config = cJSON_PrintUnformatted(root);
-    
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-    FILE *f = fopen(OPERATION_CONFIG_FILE, "w");
-    if (f != NULL)
-    {
-//        fputs(operation_config, f);
-          if (fputs(operation_config, f) == EOF) {
-                printf("*** save_operation_config --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(operation_config);
-                cJSON_Delete(root);
-                return;
-            }
-        fclose(f);
-    }
-    else{
-    	 printf ("*** save_operation_config --> File = Null ***\n");
-         }
-      xSemaphoreGive(file_mutex);
-     }
-    free(operation_config);
-    cJSON_Delete(root);
+static void operation_config_from_json(const cJSON *root, void *cfg)
+{
+    struct operation_config *config = cfg;
+    json_str(root, "serial_number", config->serial_number, sizeof(config->serial_number));
+    json_str(root, "company", config->company, sizeof(config->company));
+    json_str(root, "ds_start", config->deep_sleep_start, sizeof(config->deep_sleep_start));
+    json_str(root, "ds_end", config->deep_sleep_end, sizeof(config->deep_sleep_end));
+    json_bool(root, "reset_count", &config->reset_count);
+    json_str(root, "keep_alive", config->keep_alive, sizeof(config->keep_alive));
+    json_bool(root, "en_post", &config->enable_post);
+    json_bool(root, "en_get", &config->enable_get);
+    json_str(root, "config_server_url", config->config_server_url, sizeof(config->config_server_url));
+    JSON_NUM(root, "config_server_port", config->config_server_port);
+    json_str(root, "config_server_path", config->config_server_path, sizeof(config->config_server_path));
+    JSON_NUM(root, "level_min", config->level_min);
+    JSON_NUM(root, "level_max", config->level_max);
+}
+
+void save_operation_config(struct operation_config *config)
+{
+    (void)config_store_set(CFG_SEC_OPERATION, config, sizeof(*config));
 }
 
 void get_operation_config(struct operation_config *config)
 {
-    xSemaphoreTake(file_mutex,portMAX_DELAY);
-    
-    FILE *f = fopen(OPERATION_CONFIG_FILE, "r");
-    
-    if (f == NULL)
-     {
-   	  printf ("### get_operation_config --> File = Null ###\n");
-   	  xSemaphoreGive(file_mutex);
-      return;
-     }
-    	vTaskDelay(pdMS_TO_TICKS(10));
-        fseek(f, 0L, SEEK_END);
-        long size = ftell(f);
-        rewind(f);
-        
-         if (size <= 0) {
-        // Arquivo vazio ou erro de tamanho
-        fclose(f);
-        printf("### get_operation_config --> SIZE = %ld ###\n", size);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return;
-        }
-  
-		char buf[1024];   
-        size_t bytes_read = fread(buf, 1, (size_t) (size < (long)sizeof(buf) - 1 ? size : (long)sizeof(buf) - 1), f);
-        buf[bytes_read] = '\0';
-        // Fecha o arquivo agora que a leitura foi concluída
-        fclose(f);
-    // Parse do JSON
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        printf("### get_operation_config --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
+    if (config_store_get(CFG_SEC_OPERATION, config, sizeof(*config)) != ESP_OK) {
+        printf("### get_operation_config --> sem configuração ###\n");
     }
-    cJSON *item;
-    
-        strcpy(config->serial_number, cJSON_GetObjectItem(root, "serial_number")->valuestring);
-        strcpy(config->company, cJSON_GetObjectItem(root, "company")->valuestring);
-        strcpy(config->deep_sleep_start, cJSON_GetObjectItem(root, "ds_start")->valuestring);
-        strcpy(config->deep_sleep_end, cJSON_GetObjectItem(root, "ds_end")->valuestring);
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "reset_count")))
-        {
-            config->reset_count = true;
-        }
-        else
-        {
-            config->reset_count = false;
-        }
-        strcpy(config->keep_alive, cJSON_GetObjectItem(root, "keep_alive")->valuestring);
-        
-/*        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "log1")))
-        {
-            config->log_level_1 = true;
-        }
-        else
-        {
-            config->log_level_1 = false;
-        }
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "log2")))
-        {
-            config->log_level_2 = true;
-        }
-        else
-        {
-            config->log_level_2 = false;
-        }
-//---------------------------------------------------
- */
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "en_post")))
-        {
-            config->enable_post = true;
-        }
-        else
-        {
-            config->enable_post = false;
-        }
-        if(cJSON_IsTrue(cJSON_GetObjectItem(root, "en_get")))
-        {
-            config->enable_get = true;
-        }
-        else
-        {
-            config->enable_get = false;
-        }
+}
 
-        strcpy(config->config_server_url, cJSON_GetObjectItem(root, "config_server_url")->valuestring);
-        config->config_server_port = cJSON_GetObjectItem(root, "config_server_port")->valueint;
-        strcpy(config->config_server_path, cJSON_GetObjectItem(root, "config_server_path")->valuestring);
-        
-        config->level_min = cJSON_GetObjectItem(root, "level_min")->valueint;
-        config->level_max = cJSON_GetObjectItem(root, "level_max")->valueint;
+//==============================================================
+//  Índice de registros: journal binário + cópia em RTC
+//--------------------------------------------------------------
+// Cada save_index_config() acrescenta um slot fixo (24 bytes) ao journal
+// em vez de reescrever um JSON. Na recuperação vale o slot com CRC válido
+// e maior sequência (um append interrompido é simplesmente ignorado).
+// Ao atingir INDEX_JOURNAL_SLOTS o journal é compactado para 1 slot via
+// arquivo temporário + rename (atômico no LittleFS).
+// A cópia em RTC sobrevive ao deep sleep: get_index_config() só lê a
+// flash após um cold boot.
+//==============================================================
+typedef struct __attribute__((packed)) {
+    uint32_t last_write_idx;
+    uint32_t last_read_idx;
+    uint32_t total_idx;
+    uint32_t cursor_position;
+    uint32_t seq;
+    uint32_t crc;
+} index_journal_slot_t;
+
+RTC_DATA_ATTR static index_journal_slot_t s_idx_rtc;
+RTC_DATA_ATTR static uint32_t s_idx_jn_slots;
+
+static inline uint32_t idx_slot_crc(const index_journal_slot_t *slot)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)slot, offsetof(index_journal_slot_t, crc));
+}
 
-    cJSON_Delete(root);
-    xSemaphoreGive(file_mutex);
+static inline bool idx_slot_valid(const index_journal_slot_t *slot)
+{
+    return slot->seq != 0 && slot->crc == idx_slot_crc(slot);
 }
 
-//==============================================================
-esp_err_t save_index_config(struct record_index_config *config)
+static inline void idx_slot_to_config(const index_journal_slot_t *slot, struct record_index_config *config)
 {
-    cJSON *root = cJSON_CreateObject();
-    if (!root) {
-        printf("*** save_index_config --> Falha ao criar JSON ***\n");
-        return ESP_FAIL;
-    }
-    cJSON_AddNumberToObject(root, "last_write_idx", config->last_write_idx);
-    cJSON_AddNumberToObject(root, "last_read_idx", config->last_read_idx);
-    cJSON_AddNumberToObject(root, "total_idx", config->total_idx);
-    cJSON_AddNumberToObject(root, "cursor_position", config->cursor_position);
+    config->last_write_idx  = slot->last_write_idx;
+    config->last_read_idx   = slot->last_read_idx;
+    config->total_idx       = slot->total_idx;
+    config->cursor_position = slot->cursor_position;
+}
 
-    char *general_index = cJSON_PrintUnformatted(root);
-    
-    if (!general_index) {
-        printf("*** save_index_config --> Falha ao criar string JSON ***\n");
-        cJSON_Delete(root);
+// Reescreve o journal com um único slot (chamar com file_mutex)
+static esp_err_t index_journal_compact(const index_journal_slot_t *slot)
+{
+    FILE *f = fopen(INDEX_JOURNAL_TMP, "wb");
+    if (f == NULL) {
+        printf("*** index_journal_compact --> File = Null ***\n");
         return ESP_FAIL;
     }
- 
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-       FILE *f = fopen(INDEX_CONTROL, "w");
-    if (f != NULL) {
-        
- //       fprintf(f, "%s",general_index);
-//        fputs(general_index, f);
-        if (fputs(general_index, f) == EOF) {
-                printf("*** save_index_config --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(general_index);
-                cJSON_Delete(root);
-                return ESP_FAIL;
-            }
+    if (fwrite(slot, sizeof(*slot), 1, f) != 1) {
+        printf("*** index_journal_compact --> Error writing to file: %s ***\n", strerror(errno));
         fclose(f);
-     }else{
-		   printf("*** save_index_config --> File = Null ***\n");
-		   }
-        xSemaphoreGive(file_mutex);
-      }
-         
-    free(general_index);
-//------------------------------------------------
-//        Print Json File
-//------------------------------------------------
-       char *my_json_string = cJSON_Print(root);
-        ESP_LOGI(TAG, ">>>save_index_config<<<\n%s",my_json_string);      
-//------------------------------------------------   
-    cJSON_Delete(root);
-    
+        unlink(INDEX_JOURNAL_TMP);
+        return ESP_FAIL;
+    }
+    fclose(f);
+    if (rename(INDEX_JOURNAL_TMP, INDEX_JOURNAL) != 0) {
+        printf("*** index_journal_compact --> rename failed: %s ***\n", strerror(errno));
+        unlink(INDEX_JOURNAL_TMP);
+        return ESP_FAIL;
+    }
+    s_idx_jn_slots = 1;
     return ESP_OK;
 }
 
-esp_err_t get_index_config(struct record_index_config *config)
+// Lê o index_control.json antigo (firmwares anteriores ao journal)
+static esp_err_t index_config_load_legacy_json(struct record_index_config *config)
 {
-    xSemaphoreTake(file_mutex,portMAX_DELAY);
     FILE *f = fopen(INDEX_CONTROL, "r");
     if (f == NULL) {
-        printf("### get_index_config --> File = Null ###\n");
-        xSemaphoreGive(file_mutex);
-        return ESP_FAIL;
-    } 
-        fseek(f, 0L, SEEK_END);
-        long size = ftell(f);
-        rewind(f);
-      
-    if (size <= 0) {
-        // Arquivo vazio ou erro de tamanho
-        fclose(f);
-        printf("### get_index_config --> SIZE = %ld ###\n", size);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return ESP_FAIL;
-    } 
-    
+        return ESP_ERR_NOT_FOUND;
+    }
     char buf[256];
-    size_t bytes_read = fread(buf, 1, (size_t) (size < (long)sizeof(buf) - 1 ? size : (long)sizeof(buf) - 1), f);
+    size_t bytes_read = fread(buf, 1, sizeof(buf) - 1, f);
     buf[bytes_read] = '\0';
-    // Fecha o arquivo agora que a leitura foi concluída
     fclose(f);
-    
-    // Parse do JSON
+
     cJSON *root = cJSON_Parse(buf);
     if (root == NULL) {
-        printf("### get_index_config --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
+        printf("### index_config_load_legacy_json --> JSON Parse Error ###\n");
         return ESP_FAIL;
-     }
-     
-    cJSON *item;
-    
-        config->last_write_idx = cJSON_GetObjectItem(root, "last_write_idx")->valueint;
-        config->last_read_idx = cJSON_GetObjectItem(root, "last_read_idx")->valueint;
-        config->total_idx = cJSON_GetObjectItem(root, "total_idx")->valueint;
-        config->cursor_position = cJSON_GetObjectItem(root, "cursor_position")->valueint;
-        
-//------------------------------------------------
-//        Print Json File
-//------------------------------------------------
-   /*    char *my_json_string = cJSON_Print(root);
-        ESP_LOGI(TAG, "<<<get_index_config>>>\n%s",my_json_string);
-        */      
-//------------------------------------------------   
-        cJSON_Delete(root);
+    }
+    cJSON *w = cJSON_GetObjectItem(root, "last_write_idx");
+    cJSON *r = cJSON_GetObjectItem(root, "last_read_idx");
+    cJSON *t = cJSON_GetObjectItem(root, "total_idx");
+    cJSON *c = cJSON_GetObjectItem(root, "cursor_position");
+    esp_err_t ret = ESP_FAIL;
+    if (cJSON_IsNumber(w) && cJSON_IsNumber(r) && cJSON_IsNumber(t) && cJSON_IsNumber(c)) {
+        config->last_write_idx  = (uint32_t)w->valuedouble;
+        config->last_read_idx   = (uint32_t)r->valuedouble;
+        config->total_idx       = (uint32_t)t->valuedouble;
+        config->cursor_position = (uint32_t)c->valuedouble;
+        ret = ESP_OK;
+    }
+    cJSON_Delete(root);
+    return ret;
+}
+
+// Recupera o último slot válido do journal para a RTC (chamar com file_mutex)
+static esp_err_t index_journal_recover(void)
+{
+    index_journal_slot_t best = {0};
+    index_journal_slot_t slot;
+    uint32_t slots = 0;
+
+    FILE *f = fopen(INDEX_JOURNAL, "rb");
+    if (f != NULL) {
+        while (fread(&slot, sizeof(slot), 1, f) == 1) {
+            slots++;
+            if (idx_slot_valid(&slot) && slot.seq > best.seq) {
+                best = slot;
+            }
+        }
+        fclose(f);
+    }
+
+    if (best.seq != 0) {
+        s_idx_rtc = best;
+        s_idx_jn_slots = slots;
+        ESP_LOGI(TAG, "Índice recuperado do journal: seq=%u slots=%u",
+                 (unsigned)best.seq, (unsigned)slots);
+        return ESP_OK;
+    }
+
+    // Sem journal válido: migra do JSON antigo, se existir
+    struct record_index_config legacy = {0};
+    if (index_config_load_legacy_json(&legacy) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    best.last_write_idx  = legacy.last_write_idx;
+    best.last_read_idx   = legacy.last_read_idx;
+    best.total_idx       = legacy.total_idx;
+    best.cursor_position = legacy.cursor_position;
+    best.seq             = 1;
+    best.crc             = idx_slot_crc(&best);
+    s_idx_rtc = best;
+    if (index_journal_compact(&best) == ESP_OK) {
+        unlink(INDEX_CONTROL);
+        ESP_LOGI(TAG, "index_control.json migrado para o journal");
+    }
+    return ESP_OK;
+}
+
+esp_err_t save_index_config(struct record_index_config *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xSemaphoreTake(file_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    // Após cold boot a sequência precisa continuar a do journal existente
+    if (!idx_slot_valid(&s_idx_rtc)) {
+        (void)index_journal_recover();
+    }
+
+    index_journal_slot_t slot = {
+        .last_write_idx  = config->last_write_idx,
+        .last_read_idx   = config->last_read_idx,
+        .total_idx       = config->total_idx,
+        .cursor_position = config->cursor_position,
+        .seq             = s_idx_rtc.seq + 1,
+    };
+    if (slot.seq == 0) slot.seq = 1;
+    slot.crc = idx_slot_crc(&slot);
+
+    // RAM/RTC primeiro: mesmo com falha de flash o ciclo atual segue coerente
+    s_idx_rtc = slot;
+
+    esp_err_t ret = ESP_OK;
+    if (s_idx_jn_slots >= INDEX_JOURNAL_SLOTS) {
+        ret = index_journal_compact(&slot);
+    } else {
+        FILE *f = fopen(INDEX_JOURNAL, "ab");
+        if (f != NULL) {
+            if (fwrite(&slot, sizeof(slot), 1, f) != 1) {
+                printf("*** save_index_config --> Error writing to file: %s ***\n", strerror(errno));
+                ret = ESP_FAIL;
+            } else {
+                s_idx_jn_slots++;
+            }
+            fclose(f);
+        } else {
+            printf("*** save_index_config --> File = Null ***\n");
+            ret = ESP_FAIL;
+        }
+    }
+    xSemaphoreGive(file_mutex);
+
+    ESP_LOGD(TAG, "save_index_config: w=%u r=%u t=%u c=%u seq=%u",
+             (unsigned)slot.last_write_idx, (unsigned)slot.last_read_idx,
+             (unsigned)slot.total_idx, (unsigned)slot.cursor_position, (unsigned)slot.seq);
+    return ret;
+}
 
-   xSemaphoreGive(file_mutex);
-   return ESP_OK;
+esp_err_t get_index_config(struct record_index_config *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Caminho comum: cópia em RTC válida, sem tocar no LittleFS
+    if (idx_slot_valid(&s_idx_rtc)) {
+        idx_slot_to_config(&s_idx_rtc, config);
+        return ESP_OK;
+    }
 
+    if (file_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(file_mutex, portMAX_DELAY);
+    esp_err_t ret = idx_slot_valid(&s_idx_rtc) ? ESP_OK : index_journal_recover();
+    if (ret == ESP_OK) {
+        idx_slot_to_config(&s_idx_rtc, config);
+    } else {
+        printf("### get_index_config --> journal ausente ###\n");
+    }
+    xSemaphoreGive(file_mutex);
+    return ret;
 }
 
 //==============================================================
@@ -1096,6 +694,7 @@ void save_record_pulse_config(struct record_pulse_config *config)
     cJSON_AddNumberToObject(root, "last_pulse_count", config->last_pulse_count);
     cJSON_AddNumberToObject(root, "current_pulse_count", config->current_pulse_count);
     cJSON_AddNumberToObject(root, "last_saved_daykey",   config->last_saved_daykey);
+    cJSON_AddNumberToObject(root, "pulse_total",         (double)config->pulse_total);
 
     char *pulse_counter_dataset = cJSON_PrintUnformatted(root);
     
@@ -1207,14 +806,22 @@ void get_record_pulse_config(struct record_pulse_config *config)
 
     #undef READ_NUM
 
+    // total de 64 bits (double é exato até 2^53)
+    cJSON *tot = cJSON_GetObjectItemCaseSensitive(root, "pulse_total");
+    if (cJSON_IsNumber(tot) && tot->valuedouble > 0) {
+        config->pulse_total = (uint64_t)tot->valuedouble;
+    }
+
     cJSON_Delete(root);
     xSemaphoreGive(file_mutex);
 }
 
 //---------------------------------------------------------
 
-void save_system_config(struct system_config *config)
+// ---------------- system ----------------
+static cJSON *system_config_to_json(const void *cfg)
 {
+    const struct system_config *config = cfg;
     cJSON *root = cJSON_CreateObject();
     cJSON_AddNumberToObject(root, "error_gsm_count", config->connection_gsm_network_error_count);
     cJSON_AddNumberToObject(root, "error_server_count", config->connection_server_error_count);
@@ -1222,301 +829,88 @@ void save_system_config(struct system_config *config)
     cJSON_AddNumberToObject(root, "last_sys_time", config->last_sys_time);
     cJSON_AddNumberToObject(root, "modem_enabled", config->modem_enabled ? 1 : 0);
     cJSON_AddNumberToObject(root, "led_enabled", config->led_enabled ? 1 : 0);
+    return root;
+}
 
-    char *system_config = cJSON_PrintUnformatted(root);
-    
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-    FILE *f = fopen(SYSTEM_CONFIG_FILE, "w");
-    if (f != NULL)
-    {
-//        fputs(system_config, f);
-        if (fputs(system_config, f) == EOF) {
-                printf("*** save_system_config --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(system_config);
-                cJSON_Delete(root);
-                return;
-            }
-        fclose(f);
-    }
-    else{
-    	 printf ("*** save_system_config --> File = Null ***\n");
-         }
-     xSemaphoreGive(file_mutex);    
-    }
-    free(system_config);
-    cJSON_Delete(root);
+static void system_config_from_json(const cJSON *root, void *cfg)
+{
+    struct system_config *config = cfg;
+    JSON_NUM(root, "error_gsm_count", config->connection_gsm_network_error_count);
+    JSON_NUM(root, "error_server_count", config->connection_server_error_count);
+    JSON_NUM(root, "last_sent_data", config->last_data_sent);
+    JSON_NUM(root, "last_sys_time", config->last_sys_time);
+    json_bool(root, "modem_enabled", &config->modem_enabled);
+    json_bool(root, "led_enabled", &config->led_enabled);
 }
 
-void get_system_config(struct system_config *config)
+void save_system_config(struct system_config *config)
 {
-    xSemaphoreTake(file_mutex,portMAX_DELAY);
-    FILE *f = fopen(SYSTEM_CONFIG_FILE, "r");
-    
- if (f == NULL)
-   {
-   	printf ("### get_system_config --> File = Null\n");
-    xSemaphoreGive(file_mutex);
-    return;
-    }
+    (void)config_store_set(CFG_SEC_SYSTEM, config, sizeof(*config));
+}
 
-	    vTaskDelay(pdMS_TO_TICKS(10));
-        fseek(f, 0L, SEEK_END);
-        long size = ftell(f);
-        rewind(f);
-        
-  if (size <= 0) {
-        // Arquivo vazio ou erro de tamanho
-        fclose(f);
-        printf("### get_system_config --> SIZE = %ld ###\n", size);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return;
+void get_system_config(struct system_config *config)
+{
+    if (config_store_get(CFG_SEC_SYSTEM, config, sizeof(*config)) != ESP_OK) {
+        printf("### get_system_config --> sem configuração ###\n");
     }
-
-		char buf[256];
-        size_t bytes_read = fread(buf, 1, (size_t) (size < (long)sizeof(buf) - 1 ? size : (long)sizeof(buf) - 1), f);
-        buf[bytes_read] = '\0';
-    // Fecha o arquivo agora que a leitura foi concluída
-        fclose(f);
-        
-           // Parse do JSON
-        cJSON *root = cJSON_Parse(buf);
-        if (root == NULL) {
-        printf("### get_device_config --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
-        }
-
-    cJSON *item;
-
-        config->connection_gsm_network_error_count = cJSON_GetObjectItem(root, "error_gsm_count")->valueint;
-        config->connection_server_error_count = cJSON_GetObjectItem(root, "error_server_count")->valueint;
-        config->last_data_sent = cJSON_GetObjectItem(root, "last_sent_data")->valueint;
-        config->last_sys_time = cJSON_GetObjectItem(root, "last_sys_time")->valueint;
-        config->modem_enabled = cJSON_GetObjectItem(root, "modem_enabled")->valueint == 1;
-        config->led_enabled = cJSON_GetObjectItem(root, "led_enabled")->valueint == 1;
-        
-    cJSON_Delete(root);
-    xSemaphoreGive(file_mutex);
 }
-//**************
-void save_record_last_unit_time(struct record_last_unit_time *config)
+
+// ---------------- last unit time ----------------
+static cJSON *record_last_unit_time_to_json(const void *cfg)
 {
+    const struct record_last_unit_time *config = cfg;
     cJSON *root = cJSON_CreateObject();
-
     cJSON_AddNumberToObject(root, "error_last_minute", config->last_minute);
+    return root;
+}
 
-    char *record_last_unit_time = cJSON_PrintUnformatted(root);
-    
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-    FILE *f = fopen(RECORD_LAST_UNIT_TIME_FILE, "w");
-    if (f != NULL)
-    {
-//        fputs(record_last_unit_time, f);
-         if (fputs(record_last_unit_time, f) == EOF) {
-                printf("*** save_record_last_unit_time --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(record_last_unit_time);
-                cJSON_Delete(root);
-                return;
-            }
-        fclose(f);
-    }
-    else{
-    	 printf ("*** save_record_last_unit_time --> File = Null ***\n");
-         }
-    xSemaphoreGive(file_mutex); 
-    }
-    free(record_last_unit_time);
-    cJSON_Delete(root); 
+static void record_last_unit_time_from_json(const cJSON *root, void *cfg)
+{
+    struct record_last_unit_time *config = cfg;
+    JSON_NUM(root, "error_last_minute", config->last_minute);
+}
+
+void save_record_last_unit_time(struct record_last_unit_time *config)
+{
+    (void)config_store_set(CFG_SEC_LAST_UNIT_TIME, config, sizeof(*config));
 }
 
 void get_record_last_unit_time(struct record_last_unit_time *config)
 {
-    xSemaphoreTake(file_mutex,portMAX_DELAY);
-    FILE *f = fopen(RECORD_LAST_UNIT_TIME_FILE, "r");
-    
- if (f == NULL) {
-        // Se não conseguir abrir, loga e retorna liberando o mutex
-        printf("### get_record_last_unit_time --> File = Null ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
-    }
-    	vTaskDelay(pdMS_TO_TICKS(10));
-        fseek(f, 0L, SEEK_END);
-        long size = ftell(f);
-        rewind(f);
-        
-      if (size <= 0) {
-        // Arquivo vazio ou erro de tamanho
-        fclose(f);
-        printf("### get_record_last_unit_time --> SIZE = %ld ###\n", size);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return;
-    }
-		char buf[64];
-       size_t bytes_read = fread(buf, 1, (size_t) (size < (long)sizeof(buf) - 1 ? size : (long)sizeof(buf) - 1), f);
-       buf[bytes_read] = '\0';
-       // Fecha o arquivo agora que a leitura foi concluída
-       fclose(f);
-       
-    // Parse do JSON
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        printf("### get_record_last_unit_time --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
-        return;
+    if (config_store_get(CFG_SEC_LAST_UNIT_TIME, config, sizeof(*config)) != ESP_OK) {
+        printf("### get_record_last_unit_time --> sem configuração ###\n");
     }
-    cJSON *item;
-
-        config->last_minute = cJSON_GetObjectItem(root, "error_last_minute")->valueint;
-
-    cJSON_Delete(root);
-    xSemaphoreGive(file_mutex);
 }
 
-//**************
-
-esp_err_t  save_self_monitoring_data(struct self_monitoring_data *config)
+// ---------------- self monitoring ----------------
+// Telemetria (CSQ, fonte em mV, bateria em %): muda a cada medição, não é
+// configuração. Fica só em RTC (sobrevive ao deep sleep), como a pressão;
+// num boot a frio volta aos defaults até a próxima leitura.
+esp_err_t save_self_monitoring_data(struct self_monitoring_data *config)
 {
-	if (config == NULL) {
+    if (config == NULL) {
         ESP_LOGE(TAG, "config is NULL");
         return ESP_ERR_INVALID_ARG;
-        }
-	
-    cJSON *root = cJSON_CreateObject();
-    
-    if (!root) {
-        ESP_LOGE(TAG, "cJSON_CreateObject failed");
-        return ESP_ERR_NO_MEM;
-       }
-
-    cJSON_AddNumberToObject(root, "csq", config->csq);
-    cJSON_AddNumberToObject(root, "power_source", config->power_source);
-    cJSON_AddNumberToObject(root, "battery", config->battery);
-    
-    char *self_monitoring_data = cJSON_PrintUnformatted(root);
-    if (!self_monitoring_data) {
-        ESP_LOGE(TAG, "cJSON_PrintUnformatted failed");
-        cJSON_Delete(root);
-        return ESP_ERR_NO_MEM;
-      }
-     
-     esp_err_t ret = ESP_OK;
-    
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-    FILE *f = fopen(SELF_MONITORING_DATA, "w");
-    if (f != NULL) {
-            if (fputs(self_monitoring_data, f) == EOF) {
-                printf("*** save_self_monitoring_data --> Error writing to file: %s ***\n", strerror(errno));
-                ret = ESP_FAIL;
-            } else {
-                fflush(f); // garante que dados vão para o backend do FS
-                // littlefs não expõe fsync facilmente; fclose costuma flushar
-            }
-            fclose(f);
-        } else {
-            printf("*** save_self_monitoring_data --> fopen failed: %s ***\n", strerror(errno));
-            ret = ESP_FAIL;
-        }
-        xSemaphoreGive(file_mutex);
-    } else {
-        printf("*** save_self_monitoring_data --> failed to take file_mutex ***\n");
-        ret = ESP_ERR_TIMEOUT;
     }
-
-    free(self_monitoring_data);
-    cJSON_Delete(root);
-    return ret;
-       
+    s_self_mon_rtc.data = *config;
+    s_self_mon_rtc.crc  = self_mon_rtc_crc(&s_self_mon_rtc);
+    return ESP_OK;
 }
 
 esp_err_t load_self_monitoring_data(struct self_monitoring_data *config)
 {
-	if (config == NULL) {
+    if (config == NULL) {
         ESP_LOGE(TAG, "### get_self_monitoring_data --> config is NULL ###\n");
         return ESP_ERR_INVALID_ARG;
-       }
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) != pdTRUE) {
-        printf("### get_self_monitoring_data --> failed to take file_mutex ###\n");
-        return ESP_ERR_TIMEOUT;
-       }
-       
-    FILE *f = fopen(SELF_MONITORING_DATA, "r");
-    
-if (f == NULL) {
-        printf("### get_self_monitoring_data --> File = Null (%s) ###\n", strerror(errno));
-        xSemaphoreGive(file_mutex);
-        return ESP_FAIL;
-    }
-
-    // lê todo o conteúdo dinamicamente
-    if (fseek(f, 0L, SEEK_END) != 0) {
-        printf("### get_self_monitoring_data --> fseek failed ###\n");
-        fclose(f);
-        xSemaphoreGive(file_mutex);
-        return ESP_FAIL;
     }
-    long size = ftell(f);
-    if (size <= 0) {
-        printf("### get_self_monitoring_data --> SIZE = %ld ###\n", size);
-        fclose(f);
-        xSemaphoreGive(file_mutex);
-        return ESP_FAIL;
-    }
-    rewind(f);
-
-    char *buf = malloc((size_t)size + 1);
-    if (!buf) {
-        printf("### get_self_monitoring_data --> malloc failed ###\n");
-        fclose(f);
-        xSemaphoreGive(file_mutex);
-        return ESP_ERR_NO_MEM;
-    }
-
-    size_t bytes_read = fread(buf, 1, (size_t)size, f);
-    buf[bytes_read] = '\0';
-    fclose(f);
-
-    cJSON *root = cJSON_Parse(buf);
-    free(buf);
-    if (root == NULL) {
-        printf("### get_self_monitoring_data --> JSON Parse Error ###\n");
-        xSemaphoreGive(file_mutex);
+    if (!self_mon_rtc_valid()) {
+        printf("### get_self_monitoring_data --> sem dados ###\n");
         return ESP_FAIL;
     }
-
-    cJSON *item;
-
-    item = cJSON_GetObjectItem(root, "csq");
-    if (cJSON_IsNumber(item)) {
-        config->csq = item->valueint;
-    } else {
-        printf("### get_self_monitoring_data --> csq missing or invalid ###\n");
-    }
-
-    item = cJSON_GetObjectItem(root, "power_source");
-    if (cJSON_IsNumber(item)) {
-        config->power_source = item->valueint;
-    } else {
-        printf("### get_self_monitoring_data --> power_source missing or invalid ###\n");
-    }
-
-    item = cJSON_GetObjectItem(root, "battery");
-    if (cJSON_IsNumber(item)) {
-        config->battery = item->valueint;
-    } else {
-        printf("### get_self_monitoring_data --> battery missing or invalid ###\n");
-    }
-
-    cJSON_Delete(root);
-    xSemaphoreGive(file_mutex);
+    *config = s_self_mon_rtc.data;
     return ESP_OK;
 }
+
 //=======================================================
 //            RS485
 //=======================================================
@@ -1588,6 +982,8 @@ esp_err_t load_rs485_config(sensor_map_t *map, size_t *count) {
 
 // ======================================================================
 // RS485 UI Hints (used_fc) — persistidos em /littlefs/rs485_map_ui.json
+// Os drivers usam a tabela em RAM (modbus_dev_profile); isto aqui só
+// semeia a tabela no primeiro boot e atende o portal.
 // ======================================================================
 
 // Retorna ESP_OK e *out_fc=0x03/0x04 se encontrado; ESP_ERR_NOT_FOUND se ausente.
@@ -1686,87 +1082,156 @@ esp_err_t rs485_hint_set_used_fc(uint8_t addr, uint8_t used_fc)
 }
 
 
+// ---------------- pressure ----------------
+// Última leitura de pressão: muda a cada amostra, não é configuração. Fica
+// só em RTC (sobrevive ao deep sleep); o valor que importa já foi para o
+// log de registros em save_pressure_measurement().
 void save_pressure_data(struct pressure_data *config)
 {
-	 
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "pressure1", config->pressure1);
-    cJSON_AddStringToObject(root, "pressure2", config->pressure2);
-
-    char *pressure_dataset = cJSON_PrintUnformatted(root);
-    
-    if (xSemaphoreTake(file_mutex, portMAX_DELAY) == pdTRUE) {
-    FILE *f = fopen(PRESSURE_DATA_SET, "w");
-    if (f != NULL)
-    {
-//        fputs(pressure_dataset, f);
-         if (fputs(pressure_dataset, f) == EOF) {
-                printf("*** save_pressure_data --> Error writing to file: %s ***\n", strerror(errno));
-                fclose(f);
-                xSemaphoreGive(file_mutex);
-                free(pressure_dataset);
-                cJSON_Delete(root);
-                return;
-            }
-        fclose(f);
-    }
-    else{
-    	 printf ("*** pressure_data_set --> File = Null ***\n");
-         }
-     xSemaphoreGive(file_mutex);    
+    if (config == NULL) {
+        return;
     }
-    
-    free((void *) pressure_dataset);
-    cJSON_Delete(root);
+    s_press_rtc.data = *config;
+    s_press_rtc.crc  = pressure_rtc_crc(&s_press_rtc);
 }
 
 void get_pressure_data(struct pressure_data *config)
 {
-    xSemaphoreTake(file_mutex,portMAX_DELAY);
-    FILE *f = fopen(PRESSURE_DATA_SET, "r");
-   
-    if (f == NULL) {
-        // Se não conseguir abrir, loga e retorna liberando o mutex
-        printf("### get_pressure_data --> File = Null ###\n");
-        xSemaphoreGive(file_mutex);
+    if (!pressure_rtc_valid()) {
+        printf("### get_pressure_data --> sem dados ###\n");
         return;
     }
-	    vTaskDelay(pdMS_TO_TICKS(10));
-        fseek(f, 0L, SEEK_END);
-        long size = ftell(f);
-        rewind(f);
-        
-    if (size <= 0) {
-        // Arquivo vazio ou erro de tamanho
-        fclose(f);
-        printf("### get_pressure_data --> SIZE = %ld ###\n", size);
-        vTaskDelay(pdMS_TO_TICKS(100));
-        xSemaphoreGive(file_mutex);
-        return;
+    *config = s_press_rtc.data;
+}
+
+//==============================================================
+//  Tabela de seções: JSON legado, exportação e importação
+//==============================================================
+static const struct {
+    cfg_section_t sec;
+    const char   *legacy_path;      // arquivo de firmwares anteriores
+    size_t        len;
+    cJSON      *(*to_json)(const void *cfg);
+    void        (*from_json)(const cJSON *root, void *cfg);
+    void        (*defaults)(void *cfg);   // campos que o parser antigo preenchia quando ausentes
+} s_cfg_json[] = {
+    { CFG_SEC_DEVICE,          DEVICE_CONFIG_FILE,         sizeof(struct device_config),         device_config_to_json,         device_config_from_json,         device_config_defaults },
+    { CFG_SEC_NETWORK,         NETWORK_CONFIG_FILE,        sizeof(struct network_config),        network_config_to_json,        network_config_from_json,        network_config_defaults },
+    { CFG_SEC_OPERATION,       OPERATION_CONFIG_FILE,      sizeof(struct operation_config),      operation_config_to_json,      operation_config_from_json,      NULL },
+    { CFG_SEC_SYSTEM,          SYSTEM_CONFIG_FILE,         sizeof(struct system_config),         system_config_to_json,         system_config_from_json,         NULL },
+    { CFG_SEC_LAST_UNIT_TIME,  RECORD_LAST_UNIT_TIME_FILE, sizeof(struct record_last_unit_time), record_last_unit_time_to_json, record_last_unit_time_from_json, NULL },
+};
+#define CFG_JSON_COUNT (sizeof(s_cfg_json) / sizeof(s_cfg_json[0]))
+
+// Lê um arquivo JSON inteiro para g_cfg_io_buf (chamar com file_mutex)
+static cJSON *read_json_file_locked(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return NULL;
     }
-		char buf[256];
-        size_t bytes_read = fread(buf, 1, (size_t) (size < (long)sizeof(buf) - 1 ? size : (long)sizeof(buf) - 1), f);
-        buf[bytes_read] = '\0';
-    // Fecha o arquivo agora que a leitura foi concluída
-        fclose(f);
-        
-            // Parse do JSON
-        cJSON *root = cJSON_Parse(buf);
-        if (root == NULL) {
-        printf("### get_pressure_data --> JSON Parse Error ###\n");
+    size_t n = fread(g_cfg_io_buf, 1, CFG_MAX_JSON, f);
+    fclose(f);
+    g_cfg_io_buf[n] = '\0';
+    return (n > 0) ? cJSON_Parse(g_cfg_io_buf) : NULL;
+}
+
+// Seções ausentes na imagem binária são importadas dos *.json antigos.
+// Os arquivos antigos ficam onde estão (voltar de firmware continua possível).
+static void config_migrate_legacy(void)
+{
+    bool migrated = false;
+
+    for (size_t i = 0; i < CFG_JSON_COUNT; i++) {
+        if (config_store_has(s_cfg_json[i].sec)) {
+            continue;
+        }
+        if (xSemaphoreTake(file_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            ESP_LOGW(TAG, "migração: timeout ao obter mutex");
+            return;
+        }
+        cJSON *root = read_json_file_locked(s_cfg_json[i].legacy_path);
         xSemaphoreGive(file_mutex);
-        return;
+        if (root == NULL) {
+            continue;
         }
-        cJSON *item;
 
-        strcpy(config->pressure1, cJSON_GetObjectItem(root, "pressure1")->valuestring);
-        strcpy(config->pressure2, cJSON_GetObjectItem(root, "pressure2")->valuestring);
- 
+        cfg_any_t u;
+        memset(&u, 0, sizeof(u));
+        if (s_cfg_json[i].defaults) {
+            s_cfg_json[i].defaults(&u);
+        }
+        s_cfg_json[i].from_json(root, &u);
+        cJSON_Delete(root);
+
+        config_store_set(s_cfg_json[i].sec, &u, s_cfg_json[i].len);
+        ESP_LOGI(TAG, "migração: %s -> %s", s_cfg_json[i].legacy_path,
+                 config_store_section_name(s_cfg_json[i].sec));
+        migrated = true;
+    }
+
+    if (migrated) {
+        config_store_commit();
+    }
+}
+
+char *config_export_json(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return NULL;
+    }
+    cJSON_AddNumberToObject(root, "version", CONFIG_STORE_VERSION);
+
+    cfg_any_t u;
+    for (size_t i = 0; i < CFG_JSON_COUNT; i++) {
+        if (config_store_get(s_cfg_json[i].sec, &u, s_cfg_json[i].len) != ESP_OK) {
+            continue;
+        }
+        cJSON_AddItemToObject(root, config_store_section_name(s_cfg_json[i].sec),
+                              s_cfg_json[i].to_json(&u));
+    }
+
+    char *out = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
- 
-    xSemaphoreGive(file_mutex);
+    return out;
 }
 
+esp_err_t config_import_json(const char *json, size_t len)
+{
+    if (json == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Importação parcial: só as seções presentes; campos ausentes mantêm o valor atual
+    int applied = 0;
+    cfg_any_t u;
+    for (size_t i = 0; i < CFG_JSON_COUNT; i++) {
+        const cJSON *sec = cJSON_GetObjectItem(root, config_store_section_name(s_cfg_json[i].sec));
+        if (!cJSON_IsObject(sec)) {
+            continue;
+        }
+        memset(&u, 0, sizeof(u));
+        if (config_store_get(s_cfg_json[i].sec, &u, s_cfg_json[i].len) != ESP_OK &&
+            s_cfg_json[i].defaults) {
+            s_cfg_json[i].defaults(&u);
+        }
+        s_cfg_json[i].from_json(sec, &u);
+        config_store_set(s_cfg_json[i].sec, &u, s_cfg_json[i].len);
+        applied++;
+    }
+    cJSON_Delete(root);
+
+    if (applied == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return config_store_commit();
+}
 
 
 //----------------------------------------------------------------
@@ -0,0 +1,257 @@
+/*
+ * config_store.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "config_store.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "datalogger_driver.h"
+
+#define CONFIG_STORE_TMP    "/littlefs/config.tmp"
+#define CONFIG_STORE_MAGIC  0x31474643u     // "CFG1"
+
+static const char *TAG = "Config_Store";
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t n_sections;
+    uint32_t seq;           // incrementa a cada commit (diagnóstico)
+    uint32_t crc;           // dos campos acima
+} cfg_img_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  id;            // cfg_section_t
+    uint8_t  ver;           // CFG_SEC_VER_* (imagem v1: sempre 0)
+    uint16_t len;
+    uint32_t crc;           // do conteúdo
+} cfg_sec_hdr_t;
+
+typedef struct {
+    struct device_config         dev;
+    struct network_config        net;
+    struct operation_config      op;
+    struct system_config         sys;
+    struct record_last_unit_time last_unit;
+} cfg_cache_t;
+
+static const struct {
+    const char *name;
+    size_t      off;
+    size_t      len;
+    uint8_t     ver;
+} s_sec[CFG_SEC_COUNT] = {
+    [CFG_SEC_DEVICE]          = { "device",          offsetof(cfg_cache_t, dev),       sizeof(struct device_config),         CFG_SEC_VER_DEVICE },
+    [CFG_SEC_NETWORK]         = { "network",         offsetof(cfg_cache_t, net),       sizeof(struct network_config),        CFG_SEC_VER_NETWORK },
+    [CFG_SEC_OPERATION]       = { "operation",       offsetof(cfg_cache_t, op),        sizeof(struct operation_config),      CFG_SEC_VER_OPERATION },
+    [CFG_SEC_SYSTEM]          = { "system",          offsetof(cfg_cache_t, sys),       sizeof(struct system_config),         CFG_SEC_VER_SYSTEM },
+    [CFG_SEC_LAST_UNIT_TIME]  = { "last_unit_time",  offsetof(cfg_cache_t, last_unit), sizeof(struct record_last_unit_time), CFG_SEC_VER_LAST_UNIT_TIME },
+};
+
+static cfg_cache_t       s_cache;
+static uint32_t          s_present;     // bit por seção
+static uint32_t          s_dirty;
+static uint32_t          s_seq;
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock;
+static portMUX_TYPE      s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void lock(void)
+{
+    if (!s_lock) {
+        portENTER_CRITICAL(&s_init_mux);
+        if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+        portEXIT_CRITICAL(&s_init_mux);
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void) { xSemaphoreGive(s_lock); }
+
+static inline uint8_t *sec_ptr(cfg_section_t sec)
+{
+    return (uint8_t *)&s_cache + s_sec[sec].off;
+}
+
+static inline uint32_t hdr_crc(const cfg_img_hdr_t *h)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)h, offsetof(cfg_img_hdr_t, crc));
+}
+
+const char *config_store_section_name(cfg_section_t sec)
+{
+    return (sec < CFG_SEC_COUNT) ? s_sec[sec].name : "?";
+}
+
+esp_err_t config_store_load(void)
+{
+    lock();
+    memset(&s_cache, 0, sizeof(s_cache));
+    s_present = 0;
+    s_dirty   = 0;
+
+    FILE *f = fopen(CONFIG_STORE_PATH, "rb");
+    if (f == NULL) {
+        unlock();
+        ESP_LOGI(TAG, "%s ausente", CONFIG_STORE_PATH);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    cfg_img_hdr_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != CONFIG_STORE_MAGIC ||
+        hdr.crc != hdr_crc(&hdr) || hdr.version == 0 || hdr.version > CONFIG_STORE_VERSION) {
+        fclose(f);
+        unlock();
+        ESP_LOGW(TAG, "%s inválido (cabeçalho/versão)", CONFIG_STORE_PATH);
+        return ESP_ERR_INVALID_CRC;
+    }
+    s_seq = hdr.seq;
+
+    // Lê cada seção num buffer e só copia para o cache se o CRC bater:
+    // uma seção inválida não deixa lixo para trás
+    union {
+        struct device_config         dev;
+        struct network_config        net;
+        struct operation_config      op;
+        struct system_config         sys;
+        struct record_last_unit_time last_unit;
+    } u;
+    uint8_t *buf = (uint8_t *)&u;
+    for (uint16_t i = 0; i < hdr.n_sections; i++) {
+        cfg_sec_hdr_t sh;
+        if (fread(&sh, sizeof(sh), 1, f) != 1) break;
+        if (sh.len > sizeof(u)) {                           // seção desconhecida/maior
+            if (fseek(f, sh.len, SEEK_CUR) != 0) break;
+            continue;
+        }
+        if (sh.len && fread(buf, sh.len, 1, f) != 1) break;
+        if (sh.id >= CFG_SEC_COUNT || sh.len != s_sec[sh.id].len) {
+            ESP_LOGW(TAG, "seção %u ignorada (tamanho %u)", sh.id, sh.len);
+            continue;
+        }
+        // A imagem v1 não gravava versão: os layouts de então são a versão 1
+        uint8_t ver = (hdr.version == 1) ? 1 : sh.ver;
+        if (ver != s_sec[sh.id].ver) {
+            ESP_LOGW(TAG, "seção %s ignorada (layout v%u, esperado v%u)",
+                     s_sec[sh.id].name, ver, s_sec[sh.id].ver);
+            continue;
+        }
+        if (esp_rom_crc32_le(0, buf, sh.len) != sh.crc) {
+            ESP_LOGW(TAG, "seção %s com CRC inválido", s_sec[sh.id].name);
+            continue;
+        }
+        memcpy(sec_ptr((cfg_section_t)sh.id), buf, sh.len);
+        s_present |= 1u << sh.id;
+    }
+    fclose(f);
+    uint32_t present = s_present;
+    unlock();
+
+    ESP_LOGI(TAG, "imagem seq=%lu carregada, seções=0x%02lx",
+             (unsigned long)hdr.seq, (unsigned long)present);
+    return ESP_OK;
+}
+
+bool config_store_has(cfg_section_t sec)
+{
+    if (sec >= CFG_SEC_COUNT) return false;
+    lock();
+    bool has = (s_present >> sec) & 1u;
+    unlock();
+    return has;
+}
+
+esp_err_t config_store_get(cfg_section_t sec, void *out, size_t len)
+{
+    if (sec >= CFG_SEC_COUNT || !out || len != s_sec[sec].len) return ESP_ERR_INVALID_ARG;
+    lock();
+    bool has = (s_present >> sec) & 1u;
+    if (has) memcpy(out, sec_ptr(sec), len);
+    unlock();
+    return has ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+bool config_store_set(cfg_section_t sec, const void *data, size_t len)
+{
+    if (sec >= CFG_SEC_COUNT || !data || len != s_sec[sec].len) return false;
+    lock();
+    bool changed = !((s_present >> sec) & 1u) || memcmp(sec_ptr(sec), data, len) != 0;
+    if (changed) {
+        memcpy(sec_ptr(sec), data, len);
+        s_present |= 1u << sec;
+        s_dirty   |= 1u << sec;
+    }
+    unlock();
+    return changed;
+}
+
+uint32_t config_store_dirty_mask(void)
+{
+    lock();
+    uint32_t d = s_dirty;
+    unlock();
+    return d;
+}
+
+esp_err_t config_store_commit(void)
+{
+    lock();
+    if (s_dirty == 0) {
+        unlock();
+        return ESP_OK;
+    }
+
+    cfg_img_hdr_t hdr = {
+        .magic   = CONFIG_STORE_MAGIC,
+        .version = CONFIG_STORE_VERSION,
+        .seq     = s_seq + 1,
+    };
+    for (int i = 0; i < CFG_SEC_COUNT; i++) {
+        if ((s_present >> i) & 1u) hdr.n_sections++;
+    }
+    hdr.crc = hdr_crc(&hdr);
+
+    FILE *f = fopen(CONFIG_STORE_TMP, "wb");
+    bool ok = f && fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    for (int i = 0; ok && i < CFG_SEC_COUNT; i++) {
+        if (!((s_present >> i) & 1u)) continue;
+        const uint8_t *p = sec_ptr((cfg_section_t)i);
+        cfg_sec_hdr_t sh = {
+            .id  = (uint8_t)i,
+            .ver = s_sec[i].ver,
+            .len = (uint16_t)s_sec[i].len,
+            .crc = esp_rom_crc32_le(0, p, s_sec[i].len),
+        };
+        ok = fwrite(&sh, sizeof(sh), 1, f) == 1 && fwrite(p, s_sec[i].len, 1, f) == 1;
+    }
+    if (f && fclose(f) != 0) ok = false;
+    if (ok && rename(CONFIG_STORE_TMP, CONFIG_STORE_PATH) != 0) ok = false;
+
+    uint32_t dirty = s_dirty;
+    if (ok) {
+        s_seq   = hdr.seq;
+        s_dirty = 0;
+    } else {
+        unlink(CONFIG_STORE_TMP);
+    }
+    unlock();
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Falha ao gravar %s: %s", CONFIG_STORE_PATH, strerror(errno));
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "imagem seq=%lu gravada (seções alteradas=0x%02lx)",
+             (unsigned long)hdr.seq, (unsigned long)dirty);
+    return ESP_OK;
+}
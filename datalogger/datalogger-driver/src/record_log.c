@@ -0,0 +1,483 @@
+/*
+ * record_log.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Log binário de registros em segmentos pré-alocados no SD.
+ * Ver record_log.h para o layout.
+ */
+
+#include "record_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/unistd.h>
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "REC_LOG";
+
+#define RECORD_LOG_MAGIC      0x474F4C52u   // "RLOG"
+#define RECORD_LOG_VERSION    1u
+
+// Cabeçalho de cada segmento (16 bytes, mesmo tamanho de um slot)
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint32_t segment;
+    uint32_t records;
+} record_log_seg_hdr_t;
+
+#define RECORD_LOG_HDR_SIZE   ((uint32_t)sizeof(record_log_seg_hdr_t))
+
+// Buffer de zeros para pré-alocar segmentos (evita alocação de cluster a cada append)
+static const uint8_t s_zero_block[512] = {0};
+
+static inline void seg_path(uint32_t seg, char *out, size_t out_sz)
+{
+    // 8.3 (FATFS sem LFN): "s0000.bin"
+    snprintf(out, out_sz, RECORD_LOG_DIR "/s%04u.bin", (unsigned)seg);
+}
+
+static inline uint32_t entry_crc(const record_log_entry_t *e)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)e, offsetof(record_log_entry_t, crc));
+}
+
+// BRT fixo, mesmo deslocamento do JOB_LOCAL_UTC_OFFSET_S; aplicado direto
+// no epoch para não mexer no TZ global do processo
+#define RECORD_LOG_UTC_OFFSET_S   (-3 * 3600)
+
+uint32_t record_log_capacity(void)
+{
+    return RECORD_LOG_CAPACITY;
+}
+
+esp_err_t record_log_init(bool *created_out)
+{
+    struct stat st;
+    if (created_out) *created_out = false;
+
+    if (stat(RECORD_LOG_DIR, &st) == 0) {
+        return ESP_OK;
+    }
+    if (mkdir(RECORD_LOG_DIR, 0775) != 0) {
+        ESP_LOGE(TAG, "Falha ao criar %s (errno=%d)", RECORD_LOG_DIR, errno);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Log binário criado em %s (%u registros/segmento)",
+             RECORD_LOG_DIR, (unsigned)RECORD_LOG_SEGMENT_RECORDS);
+    if (created_out) *created_out = true;
+    return ESP_OK;
+}
+
+// Cria o segmento com cabeçalho + slots zerados
+static FILE *seg_create(uint32_t seg, const char *path)
+{
+    FILE *f = fopen(path, "w+b");
+    if (!f) {
+        ESP_LOGE(TAG, "Falha ao criar segmento %s", path);
+        return NULL;
+    }
+
+    record_log_seg_hdr_t hdr = {
+        .magic      = RECORD_LOG_MAGIC,
+        .version    = RECORD_LOG_VERSION,
+        .entry_size = RECORD_LOG_ENTRY_SIZE,
+        .segment    = seg,
+        .records    = RECORD_LOG_SEGMENT_RECORDS,
+    };
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, f) == 1);
+
+    uint32_t left = RECORD_LOG_SEGMENT_RECORDS * RECORD_LOG_ENTRY_SIZE;
+    while (ok && left > 0) {
+        size_t n = left < sizeof(s_zero_block) ? left : sizeof(s_zero_block);
+        ok = (fwrite(s_zero_block, 1, n, f) == n);
+        left -= n;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Falha ao pré-alocar segmento %s", path);
+        fclose(f);
+        unlink(path);
+        return NULL;
+    }
+    ESP_LOGI(TAG, "Segmento %u pré-alocado", (unsigned)seg);
+    return f;
+}
+
+//---------------------------------------------------------------
+//  Handle persistente + write-behind
+//
+//  O segmento corrente fica aberto durante todo o wake (o FATFS não
+//  precisa percorrer a cadeia de clusters a cada append). Registros
+//  consecutivos ficam em RAM até record_log_sync(), até encher o buffer
+//  ou até uma gravação fora de sequência. O fsync só acontece no sync.
+//---------------------------------------------------------------
+static FILE    *s_seg_file = NULL;
+static uint32_t s_seg_no   = UINT32_MAX;
+static bool     s_seg_dirty = false;          // fwrite feito e ainda sem fsync
+
+static record_log_entry_t s_wb[RECORD_LOG_WB_RECORDS];
+static uint32_t s_wb_first = 0;               // nº do registro em s_wb[0]
+static size_t   s_wb_len   = 0;
+
+static void seg_close(void)
+{
+    if (s_seg_file) {
+        if (fclose(s_seg_file) != 0) {
+            ESP_LOGE(TAG, "Falha ao fechar segmento %u", (unsigned)s_seg_no);
+        }
+    }
+    s_seg_file  = NULL;
+    s_seg_no    = UINT32_MAX;
+    s_seg_dirty = false;
+}
+
+// Devolve o handle do segmento 'seg', reaproveitando o que estiver aberto
+static FILE *seg_open(uint32_t seg, bool create)
+{
+    if (s_seg_file && s_seg_no == seg) return s_seg_file;
+
+    seg_close();   // fclose já sincroniza o segmento anterior
+
+    char path[32];
+    seg_path(seg, path, sizeof(path));
+
+    FILE *f = fopen(path, "r+b");
+    if (!f && create) f = seg_create(seg, path);
+    if (!f) return NULL;
+
+    s_seg_file = f;
+    s_seg_no   = seg;
+    return f;
+}
+
+static esp_err_t seg_write_at(uint32_t recno, const record_log_entry_t *entries, size_t count)
+{
+    const uint32_t seg  = recno / RECORD_LOG_SEGMENT_RECORDS;
+    const uint32_t slot = recno % RECORD_LOG_SEGMENT_RECORDS;
+
+    FILE *f = seg_open(seg, true);
+    if (!f) return ESP_FAIL;
+
+    if (fseek(f, (long)(RECORD_LOG_HDR_SIZE + slot * RECORD_LOG_ENTRY_SIZE), SEEK_SET) != 0 ||
+        fwrite(entries, RECORD_LOG_ENTRY_SIZE, count, f) != count) {
+        ESP_LOGE(TAG, "Falha ao gravar registros %u..%u",
+                 (unsigned)recno, (unsigned)(recno + count - 1));
+        seg_close();
+        return ESP_FAIL;
+    }
+    s_seg_dirty = true;
+    return ESP_OK;
+}
+
+static esp_err_t wb_flush(void)
+{
+    if (s_wb_len == 0) return ESP_OK;
+    esp_err_t ret = seg_write_at(s_wb_first, s_wb, s_wb_len);
+    s_wb_len = 0;
+    return ret;
+}
+
+esp_err_t record_log_write(uint32_t recno, const record_log_entry_t *entry)
+{
+    return record_log_write_many(recno, entry, 1);
+}
+
+esp_err_t record_log_write_many(uint32_t recno, const record_log_entry_t *entries, size_t count)
+{
+    if (!entries || count == 0 || recno >= RECORD_LOG_CAPACITY ||
+        count > RECORD_LOG_CAPACITY - recno) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    while (count > 0) {
+        const uint32_t seg  = recno / RECORD_LOG_SEGMENT_RECORDS;
+        const uint32_t slot = recno % RECORD_LOG_SEGMENT_RECORDS;
+        size_t run = RECORD_LOG_SEGMENT_RECORDS - slot;
+        if (run > count) run = count;
+
+        // Só acumula se for continuação exata do que já está no buffer
+        if (s_wb_len > 0 &&
+            (recno != s_wb_first + s_wb_len ||
+             seg != s_wb_first / RECORD_LOG_SEGMENT_RECORDS ||
+             s_wb_len + run > RECORD_LOG_WB_RECORDS)) {
+            ESP_RETURN_ON_ERROR(wb_flush(), TAG, "flush");
+        }
+
+        if (run > RECORD_LOG_WB_RECORDS) {
+            ESP_RETURN_ON_ERROR(seg_write_at(recno, entries, run), TAG, "write");
+        } else {
+            if (s_wb_len == 0) s_wb_first = recno;
+            memcpy(&s_wb[s_wb_len], entries, run * RECORD_LOG_ENTRY_SIZE);
+            s_wb_len += run;
+            if (s_wb_len == RECORD_LOG_WB_RECORDS) {
+                ESP_RETURN_ON_ERROR(wb_flush(), TAG, "flush");
+            }
+        }
+
+        recno   += run;
+        entries += run;
+        count   -= run;
+    }
+    return ESP_OK;
+}
+
+esp_err_t record_log_read(uint32_t recno, record_log_entry_t *entry)
+{
+    if (!entry || recno >= RECORD_LOG_CAPACITY) return ESP_ERR_INVALID_ARG;
+
+    // Ainda no write-behind: responde da RAM
+    if (s_wb_len > 0 && recno >= s_wb_first && recno - s_wb_first < s_wb_len) {
+        memcpy(entry, &s_wb[recno - s_wb_first], sizeof(*entry));
+        return record_log_entry_valid(entry) ? ESP_OK : ESP_ERR_INVALID_CRC;
+    }
+
+    const uint32_t seg  = recno / RECORD_LOG_SEGMENT_RECORDS;
+    const uint32_t slot = recno % RECORD_LOG_SEGMENT_RECORDS;
+
+    // Trocar de segmento fecharia o handle de escrita: descarrega antes
+    if (s_wb_len > 0 && seg != s_wb_first / RECORD_LOG_SEGMENT_RECORDS) {
+        ESP_RETURN_ON_ERROR(wb_flush(), TAG, "flush");
+    }
+
+    FILE *f = seg_open(seg, false);
+    if (!f) return ESP_ERR_NOT_FOUND;
+
+    size_t n = 0;
+    if (fseek(f, (long)(RECORD_LOG_HDR_SIZE + slot * RECORD_LOG_ENTRY_SIZE), SEEK_SET) == 0) {
+        n = fread(entry, RECORD_LOG_ENTRY_SIZE, 1, f);
+    }
+
+    if (n != 1) return ESP_ERR_NOT_FOUND;
+    return record_log_entry_valid(entry) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+esp_err_t record_log_sync(void)
+{
+    esp_err_t ret = wb_flush();
+
+    if (s_seg_file && s_seg_dirty) {
+        if (fflush(s_seg_file) != 0 || fsync(fileno(s_seg_file)) != 0) {
+            ESP_LOGE(TAG, "Falha no fsync do segmento %u (errno=%d)", (unsigned)s_seg_no, errno);
+            ret = ESP_FAIL;
+        } else {
+            s_seg_dirty = false;
+        }
+    }
+    return ret;
+}
+
+esp_err_t record_log_close(void)
+{
+    esp_err_t ret = record_log_sync();
+    seg_close();
+    return ret;
+}
+
+esp_err_t record_log_erase(void)
+{
+    // O conteúdo vai ser apagado: descarta o buffer e solta o handle
+    s_wb_len = 0;
+    seg_close();
+
+    DIR *dir = opendir(RECORD_LOG_DIR);
+    if (!dir) return ESP_OK;
+
+    char path[32 + sizeof(((struct dirent *)0)->d_name)];
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), RECORD_LOG_DIR "/%s", de->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+    ESP_LOGI(TAG, "Segmentos apagados");
+    return ESP_OK;
+}
+
+//---------------------------------------------------------------
+//  Conversões registro <-> texto
+//---------------------------------------------------------------
+
+bool record_log_entry_valid(const record_log_entry_t *entry)
+{
+    return entry && entry->epoch != 0 && entry->crc == entry_crc(entry);
+}
+
+// Casas decimais que o KIND_DECIMAL guarda (10^9 ainda cabe em uint32)
+#define RECORD_LOG_MAX_DECIMALS   9
+
+static const uint32_t s_pow10[RECORD_LOG_MAX_DECIMALS + 1] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u,
+};
+
+// "[+-]ddd[.ddd]" com espaços só nas pontas -> magnitude/casas decimais.
+// Casas além de RECORD_LOG_MAX_DECIMALS são descartadas; parte inteira com
+// mais de 18 dígitos devolve false (o chamador tenta strtof).
+static bool parse_decimal(const char *s, bool *neg, uint64_t *mag, uint8_t *dec, bool *has_dot)
+{
+    *neg = false; *mag = 0; *dec = 0; *has_dot = false;
+    if (*s == '+' || *s == '-') *neg = (*s++ == '-');
+
+    int int_digits = 0, frac_digits = 0;
+    for (; isdigit((unsigned char)*s); s++) {
+        if (++int_digits > 18) return false;
+        *mag = *mag * 10u + (uint64_t)(*s - '0');
+    }
+    if (*s == '.') {
+        *has_dot = true;
+        for (s++; isdigit((unsigned char)*s); s++) {
+            // casas além do limite (ou que estourariam o int64) não contam
+            if (++frac_digits > RECORD_LOG_MAX_DECIMALS || *mag >= 100000000000000000ull) continue;
+            *mag = *mag * 10u + (uint64_t)(*s - '0');
+            (*dec)++;
+        }
+    }
+    while (isspace((unsigned char)*s)) s++;
+    return (int_digits + frac_digits) > 0 && *s == '\0';
+}
+
+esp_err_t record_log_entry_make(record_log_entry_t *entry, time_t ts,
+                                uint8_t channel, uint8_t subchannel,
+                                const char *value_str)
+{
+    memset(entry, 0, sizeof(*entry));
+
+    const char *s = value_str ? value_str : "0";
+    while (isspace((unsigned char)*s)) s++;
+
+    bool     neg, has_dot;
+    uint64_t mag;
+    uint8_t  dec;
+    if (parse_decimal(s, &neg, &mag, &dec, &has_dot)) {
+        if (!has_dot && !neg && mag > INT32_MAX && mag <= UINT32_MAX) {
+            entry->flags = RECORD_LOG_KIND_UINT32;
+            entry->raw   = (uint32_t)mag;
+        } else {
+            // Mantissa maior que int32: perde casas (arredondando) até caber
+            uint64_t lim = neg ? (uint64_t)INT32_MAX + 1u : (uint64_t)INT32_MAX;
+            while (mag > lim && dec > 0) {
+                mag = (mag + 5u) / 10u;
+                dec--;
+            }
+            if (mag <= lim) {
+                int32_t m = neg ? (int32_t)(-(int64_t)mag) : (int32_t)mag;
+                entry->flags    = has_dot ? RECORD_LOG_KIND_DECIMAL : RECORD_LOG_KIND_INT32;
+                entry->decimals = dec;
+                entry->raw      = (uint32_t)m;
+            } else {
+                // |valor| >= 2^31 sem casas a perder: só o float alcança
+                float f = strtof(s, NULL);
+                entry->flags    = RECORD_LOG_KIND_FLOAT;
+                entry->decimals = dec;
+                memcpy(&entry->raw, &f, sizeof(f));
+            }
+        }
+    } else {
+        // Notação com expoente ainda é número; texto ("nan", "ERR", "") não
+        char *end = NULL;
+        float f = strtof(s, &end);
+        while (end && isspace((unsigned char)*end)) end++;
+        if (end == s || !end || *end != '\0' || !isfinite(f)) {
+            ESP_LOGW(TAG, "Valor '%s' (canal %u.%u) não é número; registro descartado",
+                     value_str ? value_str : "(null)", channel, subchannel);
+            return ESP_ERR_INVALID_ARG;
+        }
+        entry->flags    = RECORD_LOG_KIND_FLOAT;
+        entry->decimals = 3;
+        memcpy(&entry->raw, &f, sizeof(f));
+    }
+
+    entry->epoch      = (uint32_t)ts;
+    entry->channel    = channel;
+    entry->subchannel = subchannel;
+    entry->crc        = entry_crc(entry);
+    return ESP_OK;
+}
+
+size_t record_log_format_value(const record_log_entry_t *entry, char *out, size_t out_sz)
+{
+    if (!out || out_sz == 0) return 0;
+    int n;
+    switch (entry->flags & RECORD_LOG_KIND_MASK) {
+        case RECORD_LOG_KIND_INT32:
+            n = snprintf(out, out_sz, "%ld", (long)(int32_t)entry->raw);
+            break;
+        case RECORD_LOG_KIND_UINT32:
+            n = snprintf(out, out_sz, "%lu", (unsigned long)entry->raw);
+            break;
+        case RECORD_LOG_KIND_DECIMAL: {
+            int32_t  m   = (int32_t)entry->raw;
+            uint32_t mag = (m < 0) ? (uint32_t)(-(int64_t)m) : (uint32_t)m;
+            uint8_t  dec = entry->decimals > RECORD_LOG_MAX_DECIMALS ? RECORD_LOG_MAX_DECIMALS
+                                                                     : entry->decimals;
+            uint32_t p   = s_pow10[dec];
+            if (dec == 0) n = snprintf(out, out_sz, "%s%lu", m < 0 ? "-" : "", (unsigned long)mag);
+            else          n = snprintf(out, out_sz, "%s%lu.%0*lu", m < 0 ? "-" : "",
+                                       (unsigned long)(mag / p), (int)dec, (unsigned long)(mag % p));
+            break;
+        }
+        default: {
+            float f;
+            memcpy(&f, &entry->raw, sizeof(f));
+            n = snprintf(out, out_sz, "%.*f", (int)entry->decimals, (double)f);
+            break;
+        }
+    }
+    if (n < 0) { out[0] = '\0'; return 0; }
+    return ((size_t)n < out_sz) ? (size_t)n : out_sz - 1;
+}
+
+void record_log_format_date_time(const record_log_entry_t *entry,
+                                 char *date_out, size_t date_sz,
+                                 char *time_out, size_t time_sz)
+{
+    time_t ts = (time_t)entry->epoch + RECORD_LOG_UTC_OFFSET_S;
+    struct tm tm_local;
+    gmtime_r(&ts, &tm_local);
+
+    if (date_out && date_sz) strftime(date_out, date_sz, "%d/%m/%Y", &tm_local);
+    if (time_out && time_sz) strftime(time_out, time_sz, "%H:%M:%S", &tm_local);
+}
+
+size_t record_log_format_channel(const record_log_entry_t *entry, char *out, size_t out_sz)
+{
+    int n;
+    if (entry->subchannel > 0) n = snprintf(out, out_sz, "%u.%u", entry->channel, entry->subchannel);
+    else                       n = snprintf(out, out_sz, "%u", entry->channel);
+    if (n < 0) { out[0] = '\0'; return 0; }
+    return ((size_t)n < out_sz) ? (size_t)n : out_sz - 1;
+}
+
+void record_log_export_line(const record_log_entry_t *entry, char *out)
+{
+    char date[11], tim[9], ch[8], val[24];
+    record_log_format_date_time(entry, date, sizeof(date), tim, sizeof(tim));
+    record_log_format_channel(entry, ch, sizeof(ch));
+    size_t vlen = record_log_format_value(entry, val, sizeof(val));
+
+    // Inteiros e KIND_DECIMAL cabem sempre na coluna ("-2.147483648").
+    // Só um float legado grande passa dela: vai em notação científica,
+    // que também cabe ("-3.40282e+38"), em vez de ser cortado.
+    if (vlen > RECORD_LOG_EXPORT_VALUE_LEN) {
+        float f;
+        memcpy(&f, &entry->raw, sizeof(f));
+        snprintf(val, sizeof(val), "%.6g", (double)f);
+    }
+
+    // Mesmas colunas do registro.csv antigo, mas com largura fixa:
+    // permite mapear offset de byte -> nº do registro na exportação.
+    snprintf(out, RECORD_LOG_EXPORT_LINE_LEN + 1, " %-10s   %-8s     %-5.5s   %-12.12s\n",
+             date, tim, ch, val);
+}
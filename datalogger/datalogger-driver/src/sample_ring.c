@@ -0,0 +1,136 @@
+/*
+ * sample_ring.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "sample_ring.h"
+
+#include <string.h>
+#include <stddef.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define SAMPLE_RING_MAGIC  0x474E5253u     // "SRNG"
+
+static const char *TAG = "Sample_Ring";
+
+typedef struct {
+    uint32_t magic;
+    uint16_t head;          // índice da amostra mais antiga
+    uint16_t count;
+    uint32_t crc;           // dos campos acima
+} sample_ring_hdr_t;
+
+RTC_NOINIT_ATTR static sample_ring_hdr_t  s_hdr;
+RTC_NOINIT_ATTR static record_log_entry_t s_slots[SAMPLE_RING_CAPACITY];
+
+static bool              s_checked;
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock;
+static portMUX_TYPE      s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint32_t hdr_crc(const sample_ring_hdr_t *h)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)h, offsetof(sample_ring_hdr_t, crc));
+}
+
+static inline void hdr_commit(uint16_t head, uint16_t count)
+{
+    sample_ring_hdr_t h = { .magic = SAMPLE_RING_MAGIC, .head = head, .count = count };
+    h.crc = hdr_crc(&h);
+    s_hdr = h;
+}
+
+// Chamar com o lock
+static void ring_check_locked(void)
+{
+    if (s_checked) return;
+    s_checked = true;
+
+    if (s_hdr.magic == SAMPLE_RING_MAGIC && s_hdr.crc == hdr_crc(&s_hdr) &&
+        s_hdr.head < SAMPLE_RING_CAPACITY && s_hdr.count <= SAMPLE_RING_CAPACITY) {
+        if (s_hdr.count) {
+            ESP_LOGI(TAG, "%u amostra(s) pendentes na RTC", (unsigned)s_hdr.count);
+        }
+        return;
+    }
+    // power-on: conteúdo da RTC é lixo
+    hdr_commit(0, 0);
+}
+
+static void lock(void)
+{
+    if (!s_lock) {
+        portENTER_CRITICAL(&s_init_mux);
+        if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+        portEXIT_CRITICAL(&s_init_mux);
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ring_check_locked();
+}
+
+static void unlock(void) { xSemaphoreGive(s_lock); }
+
+void sample_ring_init(void)
+{
+    lock();
+    unlock();
+}
+
+uint32_t sample_ring_count(void)
+{
+    lock();
+    uint32_t n = s_hdr.count;
+    unlock();
+    return n;
+}
+
+esp_err_t sample_ring_push(const record_log_entry_t *entries, size_t count)
+{
+    if (!entries && count) return ESP_ERR_INVALID_ARG;
+    if (count == 0) return ESP_OK;
+
+    lock();
+    if (s_hdr.count + count > SAMPLE_RING_CAPACITY) {
+        unlock();
+        return ESP_ERR_NO_MEM;
+    }
+    // Amostras primeiro, cabeçalho depois: um reset no meio não corrompe o anel
+    uint32_t pos = (s_hdr.head + s_hdr.count) % SAMPLE_RING_CAPACITY;
+    for (size_t i = 0; i < count; i++) {
+        s_slots[pos] = entries[i];
+        pos = (pos + 1) % SAMPLE_RING_CAPACITY;
+    }
+    hdr_commit(s_hdr.head, (uint16_t)(s_hdr.count + count));
+    unlock();
+    return ESP_OK;
+}
+
+size_t sample_ring_peek(record_log_entry_t *out, size_t max)
+{
+    if (!out) return 0;
+
+    lock();
+    size_t n = (s_hdr.count < max) ? s_hdr.count : max;
+    uint32_t pos = s_hdr.head;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_slots[pos];
+        pos = (pos + 1) % SAMPLE_RING_CAPACITY;
+    }
+    unlock();
+    return n;
+}
+
+void sample_ring_drop(size_t count)
+{
+    lock();
+    if (count > s_hdr.count) count = s_hdr.count;
+    hdr_commit((uint16_t)((s_hdr.head + count) % SAMPLE_RING_CAPACITY),
+               (uint16_t)(s_hdr.count - count));
+    unlock();
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
+#include <sys/param.h>
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
 #include "driver/gpio.h"
@@ -10,6 +11,10 @@
 
 #include "datalogger_driver.h"
 #include "sdmmc_driver.h"
+#include "record_log.h"
+#include "sample_ring.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
 #include "pulse_meter.h"
 #include "pressure_meter.h"
 
@@ -26,8 +31,9 @@ static const char *TAG = "SDMMC";
 #define PLUVIOMETER 0
 #define pluv_channel 1
 
-#define RECORD_FILE_HEADER_SIZE  39
-#define RECORD_FILE_DATA_SIZE 43
+// Cabeçalho da exportação CSV (visão gerada a partir do log binário)
+static const char s_export_header[] = "    DATA    |   HORA   | CANAL |  DADOS\n";
+#define EXPORT_HEADER_LEN  (sizeof(s_export_header) - 1)
 
 /*#define RECORD_FILE_HEADER_PLUV_SIZE  28
 #define RECORD_FILE_DATA_PLUV_SIZE 31
@@ -40,11 +46,34 @@ static const char *TAG = "SDMMC";
 
 static sdmmc_card_t *card;
 
+// Montagem adiada: o cartão só é ligado/montado quando alguém precisa dele
+// (anel RTC quase cheio, envio, leitura do log). Depois de uma falha as
+// novas tentativas esperam um backoff crescente (um cartão ausente não custa
+// uma montagem por chamada, e um always_on volta a gravar quando ele aparece).
+#define SD_MOUNT_BACKOFF_MIN_MS   5000
+#define SD_MOUNT_BACKOFF_MAX_MS   (5 * 60 * 1000)
+static bool     s_sd_mounted       = false;
+static int64_t  s_sd_mount_next_us = 0;     // esp_timer; 0 = pode tentar
+static uint32_t s_sd_mount_backoff_ms = 0;
+static StaticSemaphore_t s_mount_lock_buf;
+static SemaphoreHandle_t s_mount_lock;
+static portMUX_TYPE      s_mount_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
 static uint32_t current_index = 0;
 
+// Cabeça de escrita ainda não persistida (protegida pelo sdMutex). Os
+// registros que ela cobre podem estar só no write-behind do log: o índice
+// vai para o journal/RTC apenas depois do fsync, senão um reset deixaria o
+// índice à frente dos dados e, após reciclar, slots antigos com CRC válido
+// seriam reenviados como novos.
+static struct record_index_config s_idx_pending;
+static bool s_idx_dirty = false;
+
 bool no_register = false;
 
 const char *record_file = MOUNT_POINT"/registro.csv";
+// registro.csv de firmwares antigos é preservado com este nome na migração
+static const char *legacy_record_file = MOUNT_POINT"/registro.old";
 /*const char *record_file_pulse = MOUNT_POINT"/pulsos.csv";
 const char *record_file_pressure = MOUNT_POINT"/pressao.csv";*/
 
@@ -66,13 +95,19 @@ const int pins[] = {CONFIG_PIN_CLK,
 
 const int pin_count = sizeof(pins)/sizeof(pins[0]);
 
-static void check_if_file_exists(const char* file);
+static void record_log_prepare(void);
 
 
 void unmount_sd_card(void)
 {
     const char mount_point[] = MOUNT_POINT;
+    if (sdMutex) {
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        record_log_close();
+        xSemaphoreGive(sdMutex);
+    }
     esp_vfs_fat_sdcard_unmount(mount_point, card);
+    s_sd_mounted = false;
     ESP_LOGI(TAG, "Card unmounted");
     sdmmc_host_deinit();
      
@@ -153,16 +188,68 @@ esp_err_t mount_sd_card(void) {
         return ret;
     }
     ESP_LOGI(TAG, "Filesystem mounted");
+    s_sd_mounted = true;
 
  //   sdmmc_card_print_info(stdout, card);
     
-    check_if_file_exists(record_file);
+    record_log_prepare();
     index_config_init();
     
  //   xSemaphoreGive(sdMutex);
     return ret;
 }
 
+// Boot sem ligar o cartão: só prepara o mutex e valida o anel em RTC
+esp_err_t sdcard_init_deferred(void)
+{
+    if (sdMutex == NULL) {
+        sdMutex = xSemaphoreCreateMutex();
+        if (sdMutex == NULL) {
+            ESP_LOGE(TAG, "Failed to create mutex");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    sample_ring_init();
+    return ESP_OK;
+}
+
+// Monta o cartão na primeira necessidade desta ativação (chamar sem sdMutex:
+// a montagem inicializa o índice, que usa o sdMutex)
+static esp_err_t sd_ensure_mounted(void)
+{
+    if (s_sd_mounted) return ESP_OK;
+
+    if (!s_mount_lock) {
+        portENTER_CRITICAL(&s_mount_init_mux);
+        if (!s_mount_lock) s_mount_lock = xSemaphoreCreateMutexStatic(&s_mount_lock_buf);
+        portEXIT_CRITICAL(&s_mount_init_mux);
+    }
+    xSemaphoreTake(s_mount_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_OK;
+    if (!s_sd_mounted) {
+        int64_t t0 = esp_timer_get_time();
+        if (t0 < s_sd_mount_next_us) {
+            ret = ESP_ERR_INVALID_STATE;      // falhou há pouco; aguarda o backoff
+        } else {
+            ret = mount_sd_card();
+            ESP_LOGI(TAG, "Montagem sob demanda: %s em %lldms", esp_err_to_name(ret),
+                     (long long)((esp_timer_get_time() - t0) / 1000));
+            if (ret == ESP_OK) {
+                s_sd_mount_backoff_ms = 0;
+                s_sd_mount_next_us    = 0;
+            } else {
+                s_sd_mount_backoff_ms = s_sd_mount_backoff_ms ?
+                        MIN(s_sd_mount_backoff_ms * 2, SD_MOUNT_BACKOFF_MAX_MS) : SD_MOUNT_BACKOFF_MIN_MS;
+                s_sd_mount_next_us = esp_timer_get_time() + (int64_t)s_sd_mount_backoff_ms * 1000;
+                ESP_LOGW(TAG, "Nova tentativa de montagem em %lus",
+                         (unsigned long)(s_sd_mount_backoff_ms / 1000));
+            }
+        }
+    }
+    xSemaphoreGive(s_mount_lock);
+    return ret;
+}
+
 //static void save_default_record_pulse_config(void)
 void save_default_record_idx_config(void)
 {
@@ -175,6 +262,7 @@ void save_default_record_idx_config(void)
     idx_config.cursor_position = 0;
 
     save_index_config(&idx_config);
+    s_idx_dirty = false;
     xSemaphoreGive(sdMutex);
 }
 
@@ -191,63 +279,33 @@ void index_config_init(void)
     current_index = idx_config.total_idx;
 }
 
-static bool has_enough_size(void)
+// Cria o diretório do log binário. Na primeira montagem após a troca de
+// formato, o registro.csv antigo é preservado como registro.old e o índice
+// é zerado (o cursor antigo era offset de byte no CSV).
+static void record_log_prepare(void)
 {
-    FILE *f = fopen(record_file,"r");
-
-    if (f==NULL)
-      {
-    	printf("Falha ao abrir arquivo para verificar tamanho\n");
-    	return false;
-      }
-
-    if(fseek(f, 0L, SEEK_END)<0)
-    {
-	 ESP_LOGE(TAG, "Falha ao buscar o final do arquivo");
-     fclose(f);
-     return false;
+    bool created = false;
+    if (record_log_init(&created) != ESP_OK || !created) {
+        return;
     }
 
-    int64_t size = ftell(f);
-    if (size < 0) {
-        ESP_LOGE(TAG, "Falha ao obter tamanho do arquivo");
-        fclose(f);
-        return false;
-    }
-    rewind(f);
-    fclose(f);
-//    return size < 1024*1024*1024;
-    return size < 15LL*1024*1024*1024;  // 15 GB, calculado em 64 bits
-}
-
-static void check_if_file_exists(const char* file)
-{
     struct stat st;
-
-    // Só faz algo se o arquivo NÃO existir
-    if (stat(file, &st) != 0) {
-        // Protege toda operação de SDMMC com mutex
-        if (xSemaphoreTake(sdMutex, portMAX_DELAY) == pdTRUE) {
-            FILE *f = fopen(file, "w");
-            if (f != NULL) {
-			// Alinhe o cabeçalho com as mesmas larguras dos dados
-                fprintf(f,"    DATA    |   HORA   | CANAL |  DADOS\n");
-                no_register = true;
-                fclose(f);
-            } else {
-                ESP_LOGE(TAG, "Falha ao criar arquivo '%s'", file);
-            }
-            xSemaphoreGive(sdMutex);
+    if (stat(record_file, &st) == 0) {
+        unlink(legacy_record_file);
+        if (rename(record_file, legacy_record_file) == 0) {
+            ESP_LOGW(TAG, "registro.csv antigo preservado em %s", legacy_record_file);
         }
     }
-    // Se o arquivo já existir, não precisa fazer nada
+    no_register = true;
+    save_default_record_idx_config();
 }
 
 esp_err_t has_SD_FILE_Created(void)
 {
-    check_if_file_exists(record_file);
+    bool created = false;
+    record_log_init(&created);
 
-    if (no_register)
+    if (no_register || created)
     {
      no_register =false;
      return ESP_OK;
@@ -256,127 +314,346 @@ esp_err_t has_SD_FILE_Created(void)
    return ESP_FAIL;
 }
 
+static uint32_t record_write_head(const struct record_index_config *idx);
+
+// Índice persistido com a cabeça de escrita pendente por cima
+static esp_err_t index_view(struct record_index_config *idx)
+{
+    esp_err_t ret = get_index_config(idx);
+    if (ret == ESP_OK && s_idx_dirty) {
+        idx->last_write_idx = s_idx_pending.last_write_idx;
+        idx->total_idx      = s_idx_pending.total_idx;
+    }
+    return ret;
+}
+
+// fsync do log e só então a cabeça de escrita. Os campos de leitura vêm do
+// índice persistido (o envio pode tê-los avançado). Chamar com sdMutex.
+static esp_err_t index_commit_locked(void)
+{
+    esp_err_t ret = record_log_sync();
+    if (ret != ESP_OK || !s_idx_dirty) return ret;
+
+    struct record_index_config idx;
+    ret = index_view(&idx);
+    if (ret == ESP_OK) ret = save_index_config(&idx);
+    if (ret == ESP_OK) s_idx_dirty = false;
+    return ret;
+}
+
+// Há dados pendentes quando há amostras no anel RTC ou o cursor de leitura
+// ainda não alcançou a cabeça de escrita. Não toca no SD nem no LittleFS.
 bool has_measurement_to_send(void)
 {
-	xSemaphoreTake(sdMutex,portMAX_DELAY);
-    bool ret = false;
     struct record_index_config idx_config = {0};
-    
-    get_index_config(&idx_config);
 
-    if(idx_config.total_idx > 0)
-    {
-        if(idx_config.last_write_idx == UNSPECIFIC_RECORD)
-        {
-            if (idx_config.last_read_idx != (idx_config.total_idx - 1) ){
-                ret = true;
-            }
-        }
-        else{
-            if (idx_config.last_write_idx != idx_config.last_read_idx) {
-                ret = true;
-            }
+    if (sample_ring_count() > 0 || s_idx_dirty) {
+        return true;
+    }
+    if (get_index_config(&idx_config) != ESP_OK || idx_config.total_idx == 0) {
+        return false;
+    }
+    return idx_config.cursor_position != record_write_head(&idx_config);
+}
+
+
+esp_err_t advance_read_index(uint32_t points, uint32_t new_cursor)
+{
+    struct record_index_config idx_config = {0};
+
+    if (sdMutex == NULL) return ESP_ERR_INVALID_STATE;
+
+    // o índice só muda junto com o log: sem montar, nada foi lido
+    if (!s_sd_mounted) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    esp_err_t ret = index_commit_locked();
+    if (ret == ESP_OK) ret = get_index_config(&idx_config);
+    if (ret == ESP_OK) {
+        if (idx_config.total_idx > 0) {
+            idx_config.last_read_idx = (idx_config.last_read_idx + points) % idx_config.total_idx;
         }
+        idx_config.cursor_position = new_cursor;
+        ret = save_index_config(&idx_config);
     }
- xSemaphoreGive(sdMutex);
+    xSemaphoreGive(sdMutex);
     return ret;
 }
 
-
 //=======================================================
-// SAVE data to Flash with channel
+// SAVE data to SD with channel
 //=======================================================
-// ============================================================================
-// NOVO: Grava registro usando CANAL como string (ex.: "3" ou "4.2")
-// Mantém toda a política de índice/crescimento igual à save_record_sd(int,...)
-// ============================================================================
-esp_err_t save_record_sd_str(const char *channel_str, const char *data)
+// Próximo slot a ser gravado (mesma convenção do índice antigo):
+//  - last_write_idx == UNSPECIFIC_RECORD: log ainda não reciclou, grava em total_idx
+//  - senão: grava em last_write_idx + 1 (módulo total_idx)
+static uint32_t record_write_head(const struct record_index_config *idx)
 {
-    if (!channel_str || !data) return ESP_ERR_INVALID_ARG;
+    if (idx->last_write_idx == UNSPECIFIC_RECORD) {
+        return idx->total_idx % record_log_capacity();
+    }
+    return (idx->total_idx > 0) ? (idx->last_write_idx + 1) % idx->total_idx : 0;
+}
 
-    esp_err_t ret = ESP_OK;
-    uint32_t write_idx = UNSPECIFIC_RECORD;
-    struct record_index_config idx_config = {0};
-    FILE *f = NULL;
+static inline uint32_t record_next(const struct record_index_config *idx, uint32_t recno)
+{
+    uint32_t mod = (idx->last_write_idx == UNSPECIFIC_RECORD || idx->total_idx == 0)
+                       ? record_log_capacity() : idx->total_idx;
+    return (recno + 1) % mod;
+}
 
-    // Seção crítica igual à original
-    xSemaphoreTake(sdMutex, portMAX_DELAY);
+// "3" -> (3,0) ; "4.2" -> (4,2)
+static void channel_str_split(const char *ch, uint8_t *base, uint8_t *sub)
+{
+    int b = 0, s = 0;
+    if (sscanf(ch, "%d.%d", &b, &s) < 1) b = 0;
+    *base = (uint8_t)b;
+    *sub  = (uint8_t)s;
+}
 
-    ESP_LOGI(TAG, "Obtendo configuração de índice...");
-    ret = get_index_config(&idx_config);
+// Acrescenta 'count' registros ao log e avança a cabeça de escrita pendente
+// (persistida em index_commit_locked()). Chamar com sdMutex. A política de avanço é a mesma de sempre: antes de
+// reciclar grava em total_idx; cheio, volta ao início e segue circular.
+static esp_err_t record_append_locked(const record_log_entry_t *entries, size_t count)
+{
+    struct record_index_config idx_config = {0};
+    esp_err_t ret = index_view(&idx_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Falha ao obter configuração de índice: %d", ret);
-        xSemaphoreGive(sdMutex);
         return ret;
     }
 
-    // Mesma política de avanço do índice da sua save_record_sd(int,...)
-    if (idx_config.last_write_idx != write_idx) {
-        printf(">>>>>>REC CONFIG TOTAL =%d\n", idx_config.total_idx);
-        if (idx_config.total_idx > 0) {
-            write_idx = (idx_config.last_write_idx + 1) % idx_config.total_idx;
-        } else {
-            write_idx = (idx_config.last_write_idx + 1) % 1;
+    size_t done = 0;
+    while (done < count) {
+        uint32_t write_idx = UNSPECIFIC_RECORD;
+        if (idx_config.last_write_idx != UNSPECIFIC_RECORD) {
+            write_idx = record_write_head(&idx_config);
+        } else if (idx_config.total_idx >= record_log_capacity()) {
+            write_idx = 0;   // log cheio: começa a sobrescrever do início
+        }
+        const uint32_t first = (write_idx == UNSPECIFIC_RECORD) ? idx_config.total_idx : write_idx;
+
+        // Trecho contíguo até o fim do log (ou do anel, depois de reciclar)
+        uint32_t limit = (write_idx == UNSPECIFIC_RECORD) ? record_log_capacity() : idx_config.total_idx;
+        size_t run = count - done;
+        if (run > limit - first) run = limit - first;
+
+        ret = record_log_write_many(first, entries + done, run);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Falha ao gravar registros %u..%u no log",
+                     (unsigned)first, (unsigned)(first + run - 1));
+            break;
         }
-    }
 
-    // APPEND se houver espaço, senão abre r+ e começa a sobreescrever do início dos dados
-    if (write_idx == UNSPECIFIC_RECORD) {
-        if (has_enough_size()) {
-            f = fopen(record_file, "a");
-            if (f == NULL) {
-                ESP_LOGE(TAG, "Failed to open file for append");
-                xSemaphoreGive(sdMutex);
-                return ESP_FAIL;
-            }
+        if (write_idx == UNSPECIFIC_RECORD) {
+            idx_config.total_idx += run;
         } else {
-            f = fopen(record_file, "r+");
-            if (f == NULL) {
-                ESP_LOGE(TAG, "Failed to open file for read+write");
-                xSemaphoreGive(sdMutex);
-                return ESP_FAIL;
-            }
-            write_idx = 0;
-            fseeko(f, RECORD_FILE_HEADER_SIZE, SEEK_SET);
-            fseeko(f, 0, SEEK_CUR);
+            idx_config.last_write_idx = first + run - 1;
         }
+        done += run;
+    }
 
-        // >>>>>>>> AQUI: CANAL como %s (string) <<<<<<<<
-        fprintf(f, " %s   %s     %s       %s\n", get_date(), get_time(), channel_str, data);
-        (void)ftell(f);
-        fclose(f);
-    } else {
-        f = fopen(record_file, "r+");
-        if (f == NULL) {
-            ESP_LOGE(TAG, "Failed to open file for read");
-            xSemaphoreGive(sdMutex);
-            return ESP_FAIL;
-        }
-        fseeko(f, RECORD_FILE_HEADER_SIZE, SEEK_SET);
-        fseeko(f, 0, SEEK_CUR);
+    if (done > 0) {
+        current_index = idx_config.total_idx;
+        s_idx_pending = idx_config;
+        s_idx_dirty   = true;
+    }
+    return ret;
+}
 
-        // >>>>>>>> AQUI: CANAL como %s (string) <<<<<<<<
-        fprintf(f, " %s   %s     %s       %s\n", get_date(), get_time(), channel_str, data);
-        fclose(f);
+//=======================================================
+// Anel RTC -> SD
+//=======================================================
+static record_log_entry_t s_ring_buf[RECORD_BATCH_MAX];   // protegido pelo sdMutex
+
+// Descarrega o anel no log (mais antigas primeiro) e faz o fsync antes de
+// descartar: um reset no meio duplica amostras, nunca perde. Chamar com sdMutex.
+static esp_err_t ring_drain_locked(void)
+{
+    esp_err_t ret = ESP_OK;
+    size_t total = 0;
+    size_t n;
+
+    while ((n = sample_ring_peek(s_ring_buf, RECORD_BATCH_MAX)) > 0) {
+        ret = record_append_locked(s_ring_buf, n);
+        if (ret == ESP_OK) ret = index_commit_locked();
+        if (ret != ESP_OK) break;
+        sample_ring_drop(n);
+        total += n;
+    }
+    if (total) {
+        ESP_LOGI(TAG, "Anel RTC: %u amostra(s) gravadas no SD (%s)",
+                 (unsigned)total, esp_err_to_name(ret));
     }
+    return ret;
+}
 
-    ESP_LOGI(TAG, "Record %s   %s     %s       %s", get_date(), get_time(), channel_str, data);
+// Destino das amostras: anel RTC enquanto o SD não foi montado nesta
+// ativação e o anel não passou da marca de quase cheio; senão monta,
+// descarrega o anel e grava direto no log.
+static esp_err_t record_store(const record_log_entry_t *entries, size_t count)
+{
+    if (count == 0) return ESP_OK;
 
-    // Atualiza config de índice (mesma lógica da sua função original)
+    if (!s_sd_mounted && sample_ring_count() + count <= SAMPLE_RING_HIGH_WATER &&
+        sample_ring_push(entries, count) == ESP_OK) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = sd_ensure_mounted();
     if (ret == ESP_OK) {
-        idx_config.last_write_idx = write_idx;
-        if (write_idx == UNSPECIFIC_RECORD) {
-            idx_config.total_idx = idx_config.total_idx + 1;
-            current_index = idx_config.total_idx;
-        }
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        ret = ring_drain_locked();
+        if (ret == ESP_OK) ret = record_append_locked(entries, count);
+        xSemaphoreGive(sdMutex);
+        if (ret == ESP_OK) return ESP_OK;
     }
 
-    ESP_LOGI(TAG, "Salvando configuração de índice...");
-    ret = save_index_config(&idx_config);
+    // SD indisponível: a folga acima da marca ainda guarda as amostras
+    if (sample_ring_push(entries, count) == ESP_OK) {
+        ESP_LOGW(TAG, "SD indisponível (%s); amostras mantidas na RTC", esp_err_to_name(ret));
+        return ESP_OK;
+    }
+    return ret;
+}
+
+esp_err_t record_ring_flush(void)
+{
+    if (sample_ring_count() == 0) {
+        return ESP_OK;
+    }
+    esp_err_t ret = sd_ensure_mounted();
+    if (ret != ESP_OK) return ret;
+
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    ret = ring_drain_locked();
     xSemaphoreGive(sdMutex);
     return ret;
 }
 
+// Leitores do log: monta e descarrega o anel antes, para ver tudo
+static esp_err_t sd_ready_for_read(void)
+{
+    esp_err_t ret = sd_ensure_mounted();
+    if (ret == ESP_OK) ret = record_ring_flush();
+    return ret;
+}
+
+// ============================================================================
+// Grava registro usando CANAL como string (ex.: "3" ou "4.2")
+// ============================================================================
+esp_err_t save_record_sd_str(const char *channel_str, const char *data)
+{
+    if (!channel_str || !data) return ESP_ERR_INVALID_ARG;
+
+    record_log_entry_t entry;
+    uint8_t ch = 0, sub = 0;
+
+    channel_str_split(channel_str, &ch, &sub);
+    esp_err_t ret = record_log_entry_make(&entry, time(NULL), ch, sub, data);
+    if (ret != ESP_OK) return ret;
+
+    ret = record_store(&entry, 1);
+
+    ESP_LOGI(TAG, "Record CANAL=%s  DADOS=%s (%s)", channel_str, data, esp_err_to_name(ret));
+    return ret;
+}
+
+//=======================================================
+// Lote de registros (1 transação de SD por ciclo)
+//=======================================================
+static record_log_entry_t s_batch[RECORD_BATCH_MAX];
+static size_t             s_batch_len   = 0;
+static TaskHandle_t       s_batch_owner = NULL;
+static time_t             s_batch_ts    = 0;
+
+// Ações que só valem se o lote chegar ao armazenamento (ex.: checkpoint do pulso)
+#define RECORD_BATCH_MAX_HOOKS 4
+static struct { record_batch_done_cb_t cb; uint32_t arg; } s_batch_hooks[RECORD_BATCH_MAX_HOOKS];
+static size_t             s_batch_hooks_len = 0;
+
+esp_err_t record_batch_begin(void)
+{
+    if (s_batch_owner != NULL) {
+        ESP_LOGW(TAG, "Lote já aberto; reaproveitando");
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_batch_len   = 0;
+    s_batch_hooks_len = 0;
+    s_batch_ts    = time(NULL);   // mesmo carimbo para todas as amostras do ciclo
+    s_batch_owner = xTaskGetCurrentTaskHandle();
+    return ESP_OK;
+}
+
+esp_err_t record_batch_add(int channel, int subindex, const char *value_str)
+{
+    if (!value_str) value_str = "0";
+
+    // Sem lote aberto por esta task: grava direto (comportamento antigo)
+    if (s_batch_owner == NULL || s_batch_owner != xTaskGetCurrentTaskHandle()) {
+        return save_record_sd_rs485(channel, subindex, value_str);
+    }
+
+    if (s_batch_len == RECORD_BATCH_MAX) {
+        ESP_LOGW(TAG, "Lote cheio (%d); gravando parcial", RECORD_BATCH_MAX);
+        esp_err_t e = record_store(s_batch, s_batch_len);
+        s_batch_len = 0;
+        if (e != ESP_OK) return e;
+    }
+
+    // Valor que não é número não entra no lote (o resto do ciclo segue)
+    esp_err_t e = record_log_entry_make(&s_batch[s_batch_len], s_batch_ts,
+                                        (uint8_t)channel, (uint8_t)subindex, value_str);
+    if (e != ESP_OK) return e;
+    s_batch_len++;
+    ESP_LOGI(TAG, "Lote +CANAL=%d.%d  DADOS=%s", channel, subindex, value_str);
+    return ESP_OK;
+}
+
+esp_err_t record_batch_on_commit(record_batch_done_cb_t cb, uint32_t arg)
+{
+    if (!cb) return ESP_ERR_INVALID_ARG;
+
+    // Sem lote aberto o registro já foi gravado pelo record_batch_add()
+    if (s_batch_owner == NULL || s_batch_owner != xTaskGetCurrentTaskHandle()) {
+        cb(arg);
+        return ESP_OK;
+    }
+    if (s_batch_hooks_len == RECORD_BATCH_MAX_HOOKS) {
+        ESP_LOGE(TAG, "Lote: ações pendentes demais");
+        return ESP_ERR_NO_MEM;
+    }
+    s_batch_hooks[s_batch_hooks_len].cb  = cb;
+    s_batch_hooks[s_batch_hooks_len].arg = arg;
+    s_batch_hooks_len++;
+    return ESP_OK;
+}
+
+esp_err_t record_batch_commit(void)
+{
+    if (s_batch_owner != xTaskGetCurrentTaskHandle()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (s_batch_len > 0) {
+        int64_t t0 = esp_timer_get_time();
+        ret = record_store(s_batch, s_batch_len);
+        ESP_LOGI(TAG, "Lote gravado: %u registro(s) em %lldms, anel RTC=%u (%s)", (unsigned)s_batch_len,
+                 (long long)((esp_timer_get_time() - t0) / 1000),
+                 (unsigned)sample_ring_count(), esp_err_to_name(ret));
+    }
+    // Falha no commit descarta as ações: o próximo ciclo regrava a partir
+    // do estado anterior (nada avança sem o dado no SD/anel)
+    size_t hooks = s_batch_hooks_len;
+    s_batch_hooks_len = 0;
+    s_batch_len   = 0;
+    s_batch_owner = NULL;
+    for (size_t i = 0; ret == ESP_OK && i < hooks; i++) {
+        s_batch_hooks[i].cb(s_batch_hooks[i].arg);
+    }
+    return ret;
+}
+
 esp_err_t save_record_sd(int channel, char *data)
 {
     char chan_str[16];
@@ -399,99 +676,152 @@ esp_err_t save_record_sd_rs485(int channel, int subindex, const char *value_str)
     return save_record_sd_str(chan_str, value_str);
 }
 
-// "3"  -> 3
-// "3.1"-> 31 (o builder depois divide 31 -> Canal=3, Subcanal=1)
-static int channel_str_to_int(const char *ch) {
-    int base=0, sub=0;
-    if (!ch || !*ch) return 0;
-    if (sscanf(ch, "%d.%d", &base, &sub) == 2) return base*10 + sub;
-    if (sscanf(ch, "%d", &base) == 1)         return base;
-    return 0;
-}
-
-
+// Lê o próximo registro válido a partir de *cursor_pos (nº do registro no log)
+// e avança o cursor. Slots corrompidos são pulados. ESP_FAIL quando o cursor
+// alcança a cabeça de escrita (nada mais para ler).
 esp_err_t read_record_sd(uint32_t *cursor_pos, struct record_data_saved* record_data)
 {
     if (!cursor_pos || !record_data) return ESP_ERR_INVALID_ARG;
 
-    xSemaphoreTake(sdMutex, portMAX_DELAY);
-    FILE *f = fopen(record_file, "r");
-    if (!f) { xSemaphoreGive(sdMutex); return ESP_FAIL; }
+    struct record_index_config idx_config = {0};
+    record_log_entry_t entry;
+    esp_err_t ret = ESP_FAIL;
 
-    if (*cursor_pos == 0) {
-        // Consome a primeira linha (cabeçalho "DATA | HORA | ..."), qualquer que seja o tamanho
-        char hdr[160];
-        (void)fgets(hdr, sizeof(hdr), f);
-    } else {
-        fseeko(f, *cursor_pos, SEEK_SET);
+    if (sd_ready_for_read() != ESP_OK) {
+        return ESP_FAIL;
+    }
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    if (get_index_config(&idx_config) != ESP_OK) {
+        xSemaphoreGive(sdMutex);
+        return ESP_FAIL;
     }
 
-    char line[256];
-    if (!fgets(line, sizeof(line), f)) { fclose(f); xSemaphoreGive(sdMutex); return ESP_FAIL; }
+    const uint32_t head = record_write_head(&idx_config);
+    while (*cursor_pos != head) {
+        uint32_t recno = *cursor_pos;
+        if (recno >= record_log_capacity()) {
+            *cursor_pos = 0;
+            continue;
+        }
+        *cursor_pos = record_next(&idx_config, recno);
 
-    *cursor_pos = ftell(f);
-    fclose(f);
+        esp_err_t r = record_log_read(recno, &entry);
+        if (r == ESP_OK) {
+            ret = ESP_OK;
+            break;
+        }
+        ESP_LOGW(TAG, "Registro %u inválido (%s); pulando", (unsigned)recno, esp_err_to_name(r));
+    }
     xSemaphoreGive(sdMutex);
 
-    // Quebra por "qualquer quantidade de espaços" (as colunas estão alinhadas com espaços)
-    char date[24], tim[16], chs[16], val[32];
-    int n = sscanf(line, " %23s %15s %15s %31s", date, tim, chs, val);
-    if (n != 4) return ESP_FAIL;
-
-    // Copia para a sua struct
-    snprintf(record_data->date, sizeof(record_data->date), "%s", date);
-    snprintf(record_data->time, sizeof(record_data->time), "%s", tim);
-    record_data->channel = channel_str_to_int(chs);          // "3.1" -> 31
-    snprintf(record_data->data, sizeof(record_data->data), "%s", val);
+    if (ret != ESP_OK) return ret;
 
+    char chs[8];
+    record_log_format_date_time(&entry, record_data->date, sizeof(record_data->date),
+                                record_data->time, sizeof(record_data->time));
+    record_log_format_channel(&entry, chs, sizeof(chs));
+    record_log_format_value(&entry, record_data->data, sizeof(record_data->data));
+    // "3.1" -> 31 (o builder depois divide 31 -> Canal=3, Subcanal=1)
+    record_data->channel = (uint8_t)(entry.subchannel > 0 ? entry.channel * 10 + entry.subchannel
+                                                          : entry.channel);
     return ESP_OK;
 }
 
-
+// Exportação CSV sob demanda para o portal (/loadRegisters).
+// O arquivo "virtual" é: cabeçalho + 1 linha de largura fixa por registro,
+// do mais antigo para o mais novo; *byte_to_read é o offset nessa visão.
 bool read_record_file_sd(uint32_t* byte_to_read, char* str)
 {
-	xSemaphoreTake(sdMutex,portMAX_DELAY);
-//    const char *record_file = MOUNT_POINT"/registro.csv";
-    FILE *f = fopen(record_file,"r");
-    bool end_file = false;
+    struct record_index_config idx_config = {0};
+    size_t w = 0;
+    const size_t chunk = 255;
 
-    if(f == NULL){
-        ESP_LOGE(TAG, "FILE NULL");
+    if (sd_ready_for_read() != ESP_OK) {
+        ESP_LOGE(TAG, "SD indisponível para exportação");
+        str[0] = '\0';
+        return true;
+    }
+    xSemaphoreTake(sdMutex,portMAX_DELAY);
+    if (get_index_config(&idx_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Índice indisponível para exportação");
+        str[0] = '\0';
+        xSemaphoreGive(sdMutex);
+        return true;
     }
-    else{
-        fseeko(f, *byte_to_read, SEEK_SET);
 
-        size_t read = fread(str, sizeof(char), 255,f);
-        fclose(f);
+    const uint32_t count  = idx_config.total_idx;
+    const uint32_t oldest = (idx_config.last_write_idx == UNSPECIFIC_RECORD || count == 0)
+                                ? 0 : (idx_config.last_write_idx + 1) % count;
+    uint32_t pos = *byte_to_read;
+
+    if (pos < EXPORT_HEADER_LEN) {
+        size_t n = EXPORT_HEADER_LEN - pos;
+        if (n > chunk) n = chunk;
+        memcpy(str, s_export_header + pos, n);
+        w += n;
+        pos += n;
+    }
 
-        (*byte_to_read) += read;
+    char line[RECORD_LOG_EXPORT_LINE_LEN + 1];
+    while (w < chunk) {
+        uint32_t k = (pos - EXPORT_HEADER_LEN) / RECORD_LOG_EXPORT_LINE_LEN;
+        uint32_t off = (pos - EXPORT_HEADER_LEN) % RECORD_LOG_EXPORT_LINE_LEN;
+        if (k >= count) break;
 
-        if(read < 255)
-        {
-            str[read] = '\0';
-            end_file = true;
+        record_log_entry_t entry;
+        if (record_log_read((oldest + k) % count, &entry) == ESP_OK) {
+            record_log_export_line(&entry, line);
+        } else {
+            // Mantém a largura fixa mesmo para slot inválido
+            memset(line, ' ', RECORD_LOG_EXPORT_LINE_LEN - 1);
+            line[RECORD_LOG_EXPORT_LINE_LEN - 1] = '\n';
+            line[RECORD_LOG_EXPORT_LINE_LEN] = '\0';
         }
+
+        size_t n = RECORD_LOG_EXPORT_LINE_LEN - off;
+        if (n > chunk - w) n = chunk - w;
+        memcpy(str + w, line + off, n);
+        w += n;
+        pos += n;
     }
     xSemaphoreGive(sdMutex);
-    return end_file;
+
+    *byte_to_read = pos;
+    if (w < chunk) {
+        str[w] = '\0';
+        return true;
+    }
+    return false;
+}
+
+// Descarrega o write-behind do log, faz um único fsync e só então persiste
+// o índice. Pontos de chamada: antes do deep sleep e antes de enviar dados.
+esp_err_t flush_record_sd(void)
+{
+    if (sdMutex == NULL) return ESP_ERR_INVALID_STATE;
+    if (!s_sd_mounted) return ESP_OK;       // nada no write-behind (anel fica na RTC)
+
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    esp_err_t ret = index_commit_locked();
+    xSemaphoreGive(sdMutex);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao sincronizar o log de registros: %s", esp_err_to_name(ret));
+    }
+    return ret;
 }
 
 esp_err_t delete_record_sd(void)
 {
-    // Check if destination file exists before renaming
-    struct stat st;
-    if (stat(record_file, &st) == 0) {
-        // Delete it if it exists
-        unlink(record_file);
-    }
-   if (has_SD_FILE_Created()==ESP_OK)
-      {
-	   save_default_record_idx_config();
-	   return ESP_OK;
-	  }
-   else
-      {
-	   return ESP_FAIL;
-	  } 
-   
+    sample_ring_drop(SAMPLE_RING_CAPACITY);
+    if (sd_ensure_mounted() != ESP_OK) {
+        return ESP_FAIL;
+    }
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    record_log_erase();
+    xSemaphoreGive(sdMutex);
+
+    save_default_record_idx_config();
+    current_index = 0;
+    return ESP_OK;
 }
@@ -1,7 +1,9 @@
 #include "datalogger_control.h"
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include "cJSON.h"
+#include "json_writer.h"
 #include "esp_err.h"
 #include "esp_log.h"
 
@@ -15,7 +17,10 @@
 #include "pulse_meter.h"
 #include "sdmmc_driver.h"
 
-#define MAX_POINTS_TO_SEND 10
+// Corpo de um envio: o lote leva quantos registros couberem aqui
+#ifndef SERVER_PAYLOAD_MAX
+#define SERVER_PAYLOAD_MAX 5000
+#endif
 uint32_t cursor_position; 
 
 static const char *TAG = "SERVER_COMM";
@@ -35,9 +40,13 @@ printf(">>>>>>Cursor Position = %d\n",rec_index.cursor_position );
 printf(">>>>>>Last Read Index= %d\n",rec_index.last_read_idx );
 printf(">>>>>>Last Write Index= %d\n",rec_index.last_write_idx); 
   
-char server_payload[5000] = {0};
+char *server_payload = malloc(SERVER_PAYLOAD_MAX);
+    if (!server_payload) {
+        return false;
+    }
     
-    esp_err_t err = json_data_payload(server_payload, sizeof(server_payload),rec_index, &counter, &cursor_position);
+    esp_err_t err = json_data_payload(server_payload, SERVER_PAYLOAD_MAX,rec_index, &counter, &cursor_position);
+    free(server_payload);
     if (err != ESP_OK) {
         printf("Erro ao montar o payload JSON: %d", err);
         return err;
@@ -75,9 +84,8 @@ void server_comm_init(void)
 
 // Adaptação: monta payload customizado incluindo múltiplas leituras SD
 // e todos os campos de configuração.
-// Usa cJSON e mantém cursor/index para não reenviar dados já enviados.
-
-#define MAX_POINTS_TO_SEND 10  // ou o que for adequado
+// Mantém cursor/index para não reenviar dados já enviados; o lote vai até
+// o fim dos dados ou até encher buf.
 
 esp_err_t json_data_payload(char *buf,
                                size_t bufSize,
@@ -88,38 +96,31 @@ esp_err_t json_data_payload(char *buf,
     if (!buf || bufSize == 0 || !counter_out || !cursor_position) {
         return ESP_FAIL;
     }
-    cJSON *root = cJSON_CreateObject();
-    if (!root) {
-        return ESP_FAIL;
-    }
-    
-    
-cJSON_AddStringToObject(root, "id", get_device_id());
+    // Escreve direto em buf (sem árvore cJSON / heap); mesma saída do PrintUnformatted
+    json_writer_t w;
+    jw_init(&w, buf, bufSize);
+    jw_obj_begin(&w, NULL);
 
-    
-     cJSON_AddStringToObject(root, "Nome", get_name());
-     cJSON_AddStringToObject(root, "Número Serial",get_serial_number());
-     cJSON_AddStringToObject(root, "Telefone",get_phone());
-     cJSON_AddNumberToObject(root, "CSQ",get_csq());
+    jw_str(&w, "id", get_device_id());
+
+    jw_str(&w, "Nome", get_name());
+    jw_str(&w, "Número Serial", get_serial_number());
+    jw_str(&w, "Telefone", get_phone());
+    jw_num(&w, "CSQ", get_csq());
  //    cJSON_AddNumberToObject(root, "battery",get_battery());
      
     if (has_network_user_enabled()&&!has_network_http_enabled()) {
-        cJSON_AddStringToObject(root, "Usuario", get_network_user());
+        jw_str(&w, "Usuario", get_network_user());
     }
     if (has_network_pw_enabled()&&!has_network_http_enabled()) {
-        cJSON_AddStringToObject(root, "Senha", get_network_pw());
+        jw_str(&w, "Senha", get_network_pw());
     }
     if (has_network_token_enabled()&&!has_network_http_enabled()) {
-        cJSON_AddStringToObject(root, "Token", get_network_token());
+        jw_str(&w, "Token", get_network_token());
     }
     
     // 2) Preparar array de medições
-    cJSON *meas_array = cJSON_CreateArray();
-    if (!meas_array) {
-        cJSON_Delete(root);
-        return ESP_FAIL;
-    }
-    cJSON_AddItemToObject(root, "measurements", meas_array);
+    jw_arr_begin(&w, "measurements");
 
     // 3) Calcular index inicial
     uint32_t index;
@@ -131,23 +132,30 @@ cJSON_AddStringToObject(root, "id", get_device_id());
     *cursor_position = rec_index.cursor_position;
 
     // 4) Loop de leitura e montagem de cada registro
-    while (*counter_out < MAX_POINTS_TO_SEND) {
+    for (;;) {
         struct record_data_saved database;
+        uint32_t cursor_before = *cursor_position;
         // read_record_sd atualiza cursor_position conforme rec_index
         if (read_record_sd(cursor_position, &database) != ESP_OK) {
             ESP_LOGW(TAG, "Falha ao ler registro SD no index %u", index);
             break;
         }
-        cJSON *rec_obj = cJSON_CreateObject();
-        if (!rec_obj) {
-            ESP_LOGE(TAG, "Falha ao criar objeto de medição");
+
+        json_writer_mark_t mark;
+        jw_mark(&w, &mark);
+        jw_obj_begin(&w, NULL);
+        jw_str(&w, "Data",  database.date);
+        jw_str(&w, "Hora",  database.time);
+        jw_num(&w, "Canal", database.channel);
+        jw_num(&w, "Dados", atof(database.data));
+        jw_obj_end(&w);
+
+        // Não coube no buffer: o registro fica para o próximo envio
+        if (!jw_can_close(&w)) {
+            jw_rewind(&w, &mark);
+            *cursor_position = cursor_before;
             break;
         }
-        cJSON_AddStringToObject(rec_obj, "Data",  database.date);
-        cJSON_AddStringToObject(rec_obj, "Hora",  database.time);
-        cJSON_AddNumberToObject(rec_obj, "Canal", database.channel);
-        cJSON_AddNumberToObject(rec_obj, "Dados", atof(database.data));
-        cJSON_AddItemToArray(meas_array, rec_obj);
 
         (*counter_out)++;
 
@@ -172,19 +180,13 @@ cJSON_AddStringToObject(root, "id", get_device_id());
 /*    cJSON *alarms = cJSON_CreateArray();
     cJSON_AddItemToObject(root, "alarmes", alarms);*/
 
-    // 6) Serializa em buffer
-    char *p = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    if (!p) {
-        return ESP_FAIL;
-    }
-    size_t len = strlen(p);
-    if (len + 1 > bufSize) {
-        free(p);
+    jw_arr_end(&w);
+    jw_obj_end(&w);
+
+    // 6) Fecha o texto em buf
+    if (jw_finish(&w, NULL) != ESP_OK) {
         return ESP_FAIL;
     }
-    memcpy(buf, p, len + 1);
-    free(p);
     return ESP_OK;
 }
 
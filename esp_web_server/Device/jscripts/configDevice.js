@@ -106,6 +106,7 @@
       $('#always_on').prop('checked', obj.always_on);
   // === novo: modo TimeStamp ===
       $('#timestamp_mode').prop('checked', !!obj.timestamp_mode);
+      $('#binary_payload').prop('checked', !!obj.binary_payload);
       
       // **Novo: popula toggle e status**
       $('#device_toggle').prop('checked', obj.device_active);
@@ -184,6 +185,7 @@
       finished_factory:  $('#config_factory').prop('checked'),
       always_on:         $('#always_on').prop('checked'),
       timestamp_mode:    $('#timestamp_mode').prop('checked'),
+      binary_payload:    $('#binary_payload').prop('checked'),
       // **Novo: estado do toggle**
       device_active:     $('#device_toggle').prop('checked')
     };
@@ -68,11 +68,15 @@ function rs485RenderList(items) {
     return;
   }
 
+  const healthSpans = {};
+
   sorted.forEach((s) => {
     const desc = `Canal ${s.channel} – Endereço ${s.address} – ${s.type || ''}${s.subtype ? ' (' + s.subtype + ')' : ''}`;
 
     const $line = $('<div class="sensor-line">');
-    const $desc = $('<span class="sensor-desc">').text(desc);
+    const $health = $('<span class="hint sensor-health">');
+    healthSpans[s.address] = $health;
+    const $desc = $('<span class="sensor-desc">').text(desc).append(' ', $health);
     const $icon = $('<span class="status-icon led circle disconnected" aria-label="status"></span>');
     const $remove = $('<button type="button" class="rm-btn">Remover</button>').on('click', async () => {
       if (!confirm(`Remover o sensor do Canal ${s.channel}, Endereço ${s.address}?`)) return;
@@ -104,6 +108,23 @@ function rs485RenderList(items) {
         $icon.removeClass('connected').addClass('disconnected');
       });
   });
+
+  rs485FetchHealth(healthSpans);
+}
+
+// Saúde por escravo (latência p50/p95, falhas, backoff) — só leitura de RAM no device
+function rs485FetchHealth(spans) {
+  $.getJSON(`/rs485Health?ts=${Date.now()}`)
+    .done(res => {
+      ((res && res.devices) || []).forEach(d => {
+        const $h = spans[d.address];
+        if (!$h) return;
+        let txt = d.ok ? `· ${d.p50_ms}/${d.p95_ms} ms` : '·';
+        if (d.fail) txt += ` · falhas ${d.fail}`;
+        if (d.backoff) txt += ` · lendo 1 a cada ${d.backoff} ciclos`;
+        $h.text(txt).attr('title', `ok=${d.ok} falhas=${d.fail} timeout=${d.timeout_ms} ms`);
+      });
+    });
 }
 
 function rs485SyncLocalMap(list) {
@@ -401,6 +422,79 @@ document.addEventListener('visibilitychange', () => {
   }
 });
 
+// ===== Varredura do barramento (/rs485Scan, NDJSON em chunks) =====
+function rs485ScanUse(hit) {
+  const $addr = $('#addr_input');
+  if (!$addr.find(`option[value="${hit.addr}"]`).length) {
+    $addr.append(`<option value="${hit.addr}">${hit.addr}</option>`);
+  }
+  $addr.val(String(hit.addr));
+  if (hit.type) $('#type_input').val(hit.type).trigger('change');
+  if (hit.subtype) $('#subtype_input').val(hit.subtype);
+  startTopPingMonitor();
+}
+
+async function rs485Scan(from = 1, to = 247) {
+  const $btn = $('#rs485ScanBtn');
+  const $out = $('#rs485-scan');
+  const used = new Set(sensorMap.map(s => s.address));
+  const rows = {};
+
+  $btn.prop('disabled', true);
+  $out.empty();
+  const $status = $('<div class="hint">').text(`Varrendo ${from}..${to}…`);
+  $out.append($status);
+
+  const handle = (ev) => {
+    if (ev.ev === 'progress') {
+      $status.text(`Varrendo… endereço ${ev.addr}/${to} — ${ev.alive} respondeu(ram)`);
+    } else if (ev.ev === 'alive') {
+      const $row = $('<div class="sensor-line">')
+        .append($('<span class="sensor-desc">').text(`Endereço ${ev.addr} – respondeu (${ev.ms} ms)`));
+      rows[ev.addr] = $row;
+      $out.append($row);
+    } else if (ev.ev === 'id') {
+      const $row = rows[ev.addr];
+      if (!$row) return;
+      const cad = used.has(ev.addr) ? ' · já cadastrado' : '';
+      const txt = ev.found ? `Endereço ${ev.addr} – ${ev.driver} (${ev.type}${ev.subtype ? ', ' + ev.subtype : ''})${cad}`
+                           : `Endereço ${ev.addr} – dispositivo não reconhecido${cad}`;
+      $row.find('.sensor-desc').text(txt);
+      if (ev.found && !used.has(ev.addr)) {
+        $row.append($('<button type="button" class="rm-btn">Usar</button>').on('click', () => rs485ScanUse(ev)));
+      }
+    } else if (ev.ev === 'done') {
+      $status.text(`${ev.alive} dispositivo(s) em ${ev.scanned} endereços · ` +
+                   `varredura ${(ev.sweep_ms / 1000).toFixed(1)} s, identificação ${(ev.id_ms / 1000).toFixed(1)} s`);
+    } else if (ev.ev === 'error') {
+      $status.text(`Falha na varredura: ${ev.error}`);
+    }
+  };
+
+  try {
+    const res = await fetch(`/rs485Scan?from=${from}&to=${to}&ts=${Date.now()}`);
+    if (!res.ok || !res.body) throw new Error(`HTTP ${res.status}`);
+    const reader = res.body.getReader();
+    const dec = new TextDecoder();
+    let buf = '';
+    for (;;) {
+      const { value, done } = await reader.read();
+      if (done) break;
+      buf += dec.decode(value, { stream: true });
+      let nl;
+      while ((nl = buf.indexOf('\n')) >= 0) {
+        const line = buf.slice(0, nl).trim();
+        buf = buf.slice(nl + 1);
+        if (line) { try { handle(JSON.parse(line)); } catch (e) { /* linha parcial */ } }
+      }
+    }
+  } catch (e) {
+    $status.text(`Falha na varredura: ${e && e.message ? e.message : e}`);
+  } finally {
+    $btn.prop('disabled', false);
+  }
+}
+
 // ===== Eventos =====
 $(document).ready(function() {
   refreshChannelOptions();
@@ -421,6 +515,11 @@ $(document).ready(function() {
     addSensorFromInputs();
   });
 
+  $('#rs485ScanBtn').on('click', (ev) => {
+    ev.preventDefault();
+    rs485Scan();
+  });
+
   rs485FetchAndRender();
 
   $(document).on('change keyup', '#channel_input, #addr_input', startTopPingMonitor);
@@ -0,0 +1,57 @@
+/*
+ * job_scheduler.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Agenda de tarefas periódicas do TimeManager_Task.
+ *
+ * Cada job calcula o seu próximo prazo absoluto (epoch) a partir da hora
+ * local; um único esp_timer one-shot é armado para o prazo mais próximo e
+ * acorda a task dona por notificação. Entre prazos a task fica bloqueada e
+ * a CPU ociosa, sem o laço de 1 s.
+ *
+ * O prazo já atendido de cada job fica em RTC (RTC_DATA_ATTR): atravessa o
+ * deep sleep sem escrita em NVS e impede que o mesmo prazo rode duas vezes
+ * na mesma janela. Um prazo vencido enquanto o aparelho dormia roda na
+ * primeira ativação dentro de 'grace_s' segundos depois dele. Sem a cópia
+ * em RTC (boot a frio) os prazos já passados contam como atendidos.
+ */
+
+#ifndef MAIN_INCLUDE_JOB_SCHEDULER_H_
+#define MAIN_INCLUDE_JOB_SCHEDULER_H_
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_err.h"
+
+#define JOB_SCHEDULER_MAX_JOBS   8
+#define JOB_LOCAL_UTC_OFFSET_S   (-3 * 3600)   // BRT fixo (mesmo "GMT+3" do resto do firmware)
+
+typedef struct {
+    const char *name;
+    time_t    (*next)(time_t from);   // primeiro prazo >= from
+    uint32_t    grace_s;              // atraso tolerado para um prazo vencido
+    bool      (*enabled)(void);       // NULL = sempre
+    void      (*run)(void);
+} sched_job_t;
+
+/**
+ * @brief Registra a tabela (executada na ordem dada quando vários prazos
+ *        coincidem) e arma o timer. A task chamadora passa a ser notificada.
+ */
+esp_err_t job_scheduler_init(const sched_job_t *jobs, size_t count);
+
+/** @brief Executa os jobs vencidos e rearma o timer. @return quantos rodaram. */
+uint32_t job_scheduler_run_due(void);
+
+/** @brief Prazo: minutos da hora múltiplos de 'period_min' (1..60), segundo 0. */
+time_t job_next_every_minutes(time_t from, uint32_t period_min);
+
+/** @brief Prazo: todo dia às hh:mm locais. */
+time_t job_next_daily(time_t from, int hour, int minute);
+
+#endif /* MAIN_INCLUDE_JOB_SCHEDULER_H_ */
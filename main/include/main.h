@@ -5,6 +5,7 @@
  *      Author: geopo
  */
 #include "stdbool.h"
+#include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -39,6 +40,9 @@ int get_wakeup_cause(void);
 
 void init_sensor_pwr_supply(void);
 
+// Resultado da sessão LTE (registro + entrega) para o backoff do worker de envio
+void upload_report_lte_result(esp_err_t err);
+
 
 
 #endif /* MAIN_INCLUDE_MAIN_H_ */
@@ -0,0 +1,43 @@
+/*
+ * wake_timeline.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Linha do tempo da ativação: aquisição, subida do rádio (associação Wi-Fi
+ * ou registro do SARA) e envio. O rádio sobe em paralelo com a aquisição;
+ * o envio espera as duas. O relatório antes do deep sleep mostra quanto as
+ * fases se sobrepuseram.
+ */
+
+#ifndef MAIN_INCLUDE_WAKE_TIMELINE_H_
+#define MAIN_INCLUDE_WAKE_TIMELINE_H_
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    WAKE_PH_ACQUIRE = 0,    // sensores internos + RS485
+    WAKE_PH_RADIO,          // Wi-Fi GOT_IP / SARA registrado
+    WAKE_PH_UPLOAD,         // publicação
+    WAKE_PH_COUNT
+} wake_phase_t;
+
+/** @brief Marca o início da fase (só a primeira chamada conta). */
+void wake_phase_begin(wake_phase_t ph);
+
+/** @brief Marca o fim da fase (a última chamada conta). */
+void wake_phase_end(wake_phase_t ph);
+
+/** @brief Aquisição desta ativação concluída e no armazenamento. */
+void wake_acquisition_done(void);
+
+/** @brief Espera a aquisição desta ativação. @return false no timeout. */
+bool wake_wait_acquisition(TickType_t timeout);
+
+/** @brief Loga as fases, a sobreposição aquisição/rádio e o tempo ganho. */
+void wake_timeline_report(void);
+
+#endif /* MAIN_INCLUDE_WAKE_TIMELINE_H_ */
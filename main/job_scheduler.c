@@ -0,0 +1,163 @@
+/*
+ * job_scheduler.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "job_scheduler.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "Job_Scheduler";
+
+#define JOB_TIME_VALID   1600000000    // relógio ainda não acertado
+
+static const sched_job_t *s_jobs;
+static size_t             s_count;
+static time_t             s_next[JOB_SCHEDULER_MAX_JOBS];
+static TaskHandle_t       s_owner;
+static esp_timer_handle_t s_timer;
+
+// Prazo já atendido por job: sobrevive ao deep sleep (zera no power-on e
+// em qualquer reset que não seja o despertar do deep sleep)
+RTC_DATA_ATTR static time_t s_last_run[JOB_SCHEDULER_MAX_JOBS];
+RTC_DATA_ATTR static bool   s_seeded;
+
+time_t job_next_every_minutes(time_t from, uint32_t period_min)
+{
+    if (period_min < 1)  period_min = 1;
+    if (period_min > 60) period_min = 60;
+
+    // Mesma regra do sleep_time(): minuto da hora % período == 0
+    time_t t = ((from + 59) / 60) * 60;
+    int minute = (int)(((t + JOB_LOCAL_UTC_OFFSET_S) / 60) % 60);
+    if (minute < 0) minute += 60;
+    while (minute % period_min != 0) {
+        t += 60;
+        minute = (minute + 1) % 60;
+    }
+    return t;
+}
+
+time_t job_next_daily(time_t from, int hour, int minute)
+{
+    time_t local = from + JOB_LOCAL_UTC_OFFSET_S;
+    time_t t = (local / 86400) * 86400 + hour * 3600 + minute * 60 - JOB_LOCAL_UTC_OFFSET_S;
+    if (t < from) t += 86400;
+    return t;
+}
+
+static void timer_cb(void *arg)
+{
+    (void)arg;
+    if (s_owner) xTaskNotifyGive(s_owner);
+}
+
+// Último prazo <= now dentro da tolerância (0 se não houver)
+static time_t last_deadline(const sched_job_t *job, time_t now)
+{
+    time_t d = job->next(now - (time_t)job->grace_s);
+    if (d > now) return 0;
+    for (time_t n = job->next(d + 1); n <= now; n = job->next(d + 1)) d = n;
+    return d;
+}
+
+// Sem s_last_run válido (power-on, brown-out, troca de bateria) nada dos
+// prazos passados foi perdido: o aparelho não estava rodando. Marca o
+// último como atendido, senão os jobs diários disparariam em todo boot.
+// Espera o relógio ser acertado, senão semearia prazos de 1970
+static void seed_if_needed(time_t now)
+{
+    if (s_seeded || now < JOB_TIME_VALID) return;
+    for (size_t i = 0; i < s_count; i++) {
+        s_last_run[i] = last_deadline(&s_jobs[i], now);
+    }
+    s_seeded = true;
+}
+
+// Próximo prazo do job: o mais antigo ainda dentro da tolerância que não
+// tenha sido atendido; senão o seguinte
+static void refresh(size_t i, time_t now)
+{
+    const sched_job_t *job = &s_jobs[i];
+    time_t d = job->next(now - (time_t)job->grace_s);
+    while (d <= now && d == s_last_run[i]) {
+        d = job->next(d + 1);
+    }
+    s_next[i] = d;
+}
+
+static void arm(time_t now)
+{
+    time_t earliest = 0;
+    seed_if_needed(now);
+    for (size_t i = 0; i < s_count; i++) {
+        refresh(i, now);
+        if (earliest == 0 || s_next[i] < earliest) earliest = s_next[i];
+    }
+    esp_timer_stop(s_timer);
+    if (earliest <= now) {
+        xTaskNotifyGive(s_owner);
+        return;
+    }
+    esp_timer_start_once(s_timer, (uint64_t)(earliest - now) * 1000000ULL);
+}
+
+esp_err_t job_scheduler_init(const sched_job_t *jobs, size_t count)
+{
+    if (!jobs || count == 0 || count > JOB_SCHEDULER_MAX_JOBS) return ESP_ERR_INVALID_ARG;
+
+    s_jobs  = jobs;
+    s_count = count;
+    s_owner = xTaskGetCurrentTaskHandle();
+
+    if (!s_timer) {
+        const esp_timer_create_args_t args = {
+            .callback        = timer_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name            = "job_sched",
+        };
+        esp_err_t err = esp_timer_create(&args, &s_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_timer_create: %s", esp_err_to_name(err));
+            return err;
+        }
+    }
+    arm(time(NULL));
+    return ESP_OK;
+}
+
+uint32_t job_scheduler_run_due(void)
+{
+    if (!s_jobs) return 0;
+
+    uint32_t ran = 0;
+    time_t now = time(NULL);
+    seed_if_needed(now);
+    for (size_t i = 0; i < s_count; i++) {
+        refresh(i, now);
+        if (s_next[i] > now) continue;
+
+        // Prazo consumido mesmo desabilitado: não roda atrasado quando reativar
+        s_last_run[i] = s_next[i];
+        if (s_jobs[i].enabled && !s_jobs[i].enabled()) continue;
+
+        int64_t t0 = esp_timer_get_time();
+        s_jobs[i].run();
+        ran++;
+        ESP_LOGI(TAG, "%s: %lldms", s_jobs[i].name,
+                 (long long)((esp_timer_get_time() - t0) / 1000));
+    }
+
+    now = time(NULL);
+    arm(now);
+    for (size_t i = 0; i < s_count; i++) {
+        ESP_LOGD(TAG, "%s: próximo em %llds", s_jobs[i].name, (long long)(s_next[i] - now));
+    }
+    return ran;
+}
@@ -254,7 +254,7 @@ esp_err_t ret;
 // Precisa para inicializar os dados no front e tem que ser depois do mout driver
     init_config_control();
 //=================================================================== 
-    mount_sd_card();
+    sdcard_init_deferred();   // SD só é montado quando o anel RTC precisa ser descarregado
     battery_monitor_init(false);
     blink_init();
     
@@ -33,28 +33,51 @@
 #include "system.h"
 
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "sleep_control.h"
 #include "led_blink_control.h"
 
 #include "tcp_log_server.h"  
 #include "mqtt_publisher.h"
+#include "mqtt_session.h"
 #include "u_cell_sms.h"
 #include "wifi_link.h"
 #include "wifi_softap_sta.h"
+#include "wifi_fast_connect.h"
 #include "esp_netif.h"
 #include <lwip/netdb.h>
 #include "portal_state.h"
 #include "sdkconfig.h"
 
 #include "payload_time.h"
+#include "job_scheduler.h"
+#include "wake_timeline.h"
 
 #include "lte_ppp_test.h"
 
 xTaskHandle TimeManager_TaskHandle = NULL;
+static TaskHandle_t Upload_TaskHandle = NULL;
 
 static const char *TAG = "Main_Control";
 
 #define UPDATE_SYSTEM_TIME      12       //Hora para atualizar o rel�gio interno do ESP32
+#define BATTERY_CHECK_HOUR      12       //Leitura da bateria, 1x por dia
+#define DAILY_JOB_GRACE_S       (24 * 3600 - 1)   // roda na primeira ativação do dia após o horário
+#define SCHED_SLEEP_CHECK_MS    1000     // sem "sempre ligado": reavalia o deep sleep
+#define SCHED_RESYNC_MS         60000    // sempre ligado: reavalia relógio/config
+
+// Worker de envio
+#define UPLOAD_ATTEMPT_BUDGET_MS     45000    // teto de uma tentativa Wi-Fi (link + DNS + publicação)
+#define UPLOAD_BACKOFF_MIN_S         60
+#define UPLOAD_BACKOFF_MAX_S         (60 * 60)
+#define UPLOAD_MAX_ATTEMPTS_DAY_BATT 48       // sem fonte externa: teto de tentativas de rádio por dia
+#define UPLOAD_ACQ_WAIT_MS           60000    // rádio pronto esperando as leituras do ciclo
+
+#define UPLOAD_EV_PREWARM   (1u << 0)   // início do ciclo: sobe o rádio em paralelo com a aquisição
+#define UPLOAD_EV_DATA      (1u << 1)   // registros novos no armazenamento
+#define UPLOAD_EV_LTE_OK    (1u << 2)   // LTE_System_Task entregou
+#define UPLOAD_EV_LTE_FAIL  (1u << 3)   // LTE_System_Task não registrou/não entregou
 #define WKUP_BOOT 0
 #define WKUP_RING 2
 
@@ -78,6 +101,27 @@ static volatile bool s_send_in_progress = false;
 static portMUX_TYPE s_send_mux = portMUX_INITIALIZER_UNLOCKED;
 static uint32_t s_last_send_ticks = 0;   // (opcional) debounce temporal
 
+// Estado do worker de envio: atravessa o deep sleep para o backoff valer
+// entre ativações
+typedef struct {
+    time_t   next_try;          // 0 = sem backoff
+    uint32_t backoff_s;
+    uint32_t daykey;            // dia (local) do contador abaixo
+    uint16_t attempts_today;
+} upload_state_t;
+
+RTC_DATA_ATTR static upload_state_t s_upload;
+// Pedidos ao worker x pedidos já atendidos: diferentes (ou worker rodando)
+// seguram o deep sleep. Um contador não perde o pedido que chega enquanto o
+// worker termina, o que um bool zerado no fim perderia.
+static volatile uint32_t s_upload_req  = 0;
+static volatile uint32_t s_upload_done = 0;
+static volatile bool     s_upload_busy = false;
+static portMUX_TYPE      s_upload_mux  = portMUX_INITIALIZER_UNLOCKED;
+
+typedef enum { RADIO_NONE = 0, RADIO_WIFI, RADIO_LTE } radio_state_t;
+static radio_state_t s_radio = RADIO_NONE;       // rádio já levantado pelo prewarm (só no worker)
+
 extern uint32_t ulp_inactivity;
 
 extern bool wakeup_inactivity;
@@ -98,10 +142,9 @@ static bool console_tcp_start = false;
 //----------------------------------------
 
 void TimeManager_Task(void* pvParameters);
-static void save_last_processed_minute(int minute);
-static int load_last_processed_minute(void);
-static void lte_send_data_to_server(void);
-static void wifi_send_data_to_server(void);
+static bool lte_send_data_to_server(void);
+static esp_err_t wifi_send_data_to_server(uint32_t budget_ms);
+static void upload_kick(void);
 static uint8_t save_sensor_data(void);
 //static void update_system_time(void);
 
@@ -170,49 +213,6 @@ static void console_tcp_register_http_logs(void *httpd_handle)
     }
 }
 
-//----------------------------------------
-static void save_last_processed_minute(int minute)
-{
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open("storage", NVS_READWRITE, &handle);
-    if (err == ESP_OK) {
-        nvs_set_i32(handle, "last_minute", minute);
-        nvs_commit(handle);
-        nvs_close(handle);
-    }
-}
-
-static int load_last_processed_minute(void)
-{
-    nvs_handle_t handle;
-    int32_t minute = -1; // Valor padrão
-    esp_err_t err = nvs_open("storage", NVS_READONLY, &handle);
-    if (err == ESP_OK) {
-        nvs_get_i32(handle, "last_minute", &minute);
-        nvs_close(handle);
-    }
-    return minute;
-}
-
-static bool has_passed_midnight(void)
-{
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    setenv("TZ", "GMT+3", 1);
-    tzset();
-
-    localtime_r(&now, &timeinfo);
-
-    timeinfo.tm_hour = 0;
-    timeinfo.tm_min = 0;
-    timeinfo.tm_sec = 0;
-
-    time_t midnight = mktime(&timeinfo);
-
-    return (now - midnight) <= 80;
-}
-
 static uint8_t save_sensor_data(void)
 {
 //printf("+++++>>> Vai Gravar dados <<<+++++\n");
@@ -222,6 +222,9 @@ bool pressure_sensor_2 = false;
 uint8_t result = SAVE_OK;
 
 	pressure_sensor_read(&pressure_sensor_1, &pressure_sensor_2);
+	// Leitura já feita (uma varredura do ADS): sensores desligados antes das
+	// gravações no SD, o MOSFET fica ligado só estabilização + conversões
+	activate_mosfet(disable_analog_sensors);
 
     if (pressure_sensor_1)
     {
@@ -261,7 +264,6 @@ uint8_t result = SAVE_OK;
 		    }
 	}
 	
-	activate_mosfet(disable_analog_sensors);
 	   return result;
 }
 
@@ -293,33 +295,46 @@ static void save_sensor_data_rs485(void)
 }
 
 
-static void lte_send_data_to_server(void){
+// true se uma sessão LTE foi disparada (o envio segue no LTE_System_Task)
+static bool lte_send_data_to_server(void){
 
 	if (is_send_mode_freq()){
 		if(get_send_period()<=60){
 			if (get_time_minute() % get_send_period()==0)
 			   {
+				   record_ring_flush();
 				   activate_mosfet(enable_sara);
 				   init_LTE_System(); 
+				   return true;
 			   }
 		   } else if((get_time_hour()%(get_send_period()/60)==0)&& (get_time_minute()<1)){
 			
+			         record_ring_flush();
 			         activate_mosfet(enable_sara);
 			         init_LTE_System();
+			         return true;
 		            }
 	   }
 	   
 	 if (is_send_mode_time()&&(get_time_minute()<1)){
 		   
 	    if(get_time_hour()==get_send_time1()||get_time_hour()==get_send_time2()||get_time_hour()==get_send_time3()||get_time_hour()==get_send_time4()){
+		  record_ring_flush();
 		  activate_mosfet(enable_sara);
 		  init_LTE_System();
+		  return true;
 		  }
        }
+    return false;
 }
 
-static void wifi_send_data_to_server(void)
+// ESP_OK: publicado; ESP_ERR_INVALID_STATE: ignorado (envio em curso/debounce);
+// demais: falha de rede dentro de 'budget_ms'
+static esp_err_t wifi_send_data_to_server(uint32_t budget_ms)
 {
+    esp_err_t result = ESP_FAIL;
+    const TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(budget_ms);
+
     // ----------------- Guard de sessão (sem mutex) -----------------
     bool already_sending;
     portENTER_CRITICAL(&s_send_mux);
@@ -329,7 +344,7 @@ static void wifi_send_data_to_server(void)
 
     if (already_sending) {
         ESP_LOGW(TAG, "Envio já em progresso; ignorando novo trigger.");
-        return;
+        return ESP_ERR_INVALID_STATE;
     }
 
     // (Opcional) Debounce de 15s para qualquer fonte ruidosa
@@ -339,7 +354,7 @@ static void wifi_send_data_to_server(void)
         portENTER_CRITICAL(&s_send_mux);
         s_send_in_progress = false;
         portEXIT_CRITICAL(&s_send_mux);
-        return;
+        return ESP_ERR_INVALID_STATE;
     }
     s_last_send_ticks = now;
 
@@ -358,41 +373,61 @@ static void wifi_send_data_to_server(void)
     // ----------------- Garante Wi-Fi pronto (STA) -----------------
     // Se o portal/factory estiver ativo, mantemos AP+STA; se headless, forçamos STA-only.
     bool sta_only = !factory_portal_active();
-    if (wifi_link_ensure_ready_sta(20000 /*ms*/, sta_only) != ESP_OK) {
+    uint32_t link_ms = (budget_ms < 20000) ? budget_ms : 20000;
+    if (wifi_link_ensure_ready_sta(link_ms, sta_only) != ESP_OK) {
         ESP_LOGW(TAG, "Wi-Fi não ficou pronto; abortando envio.");
+        result = ESP_ERR_TIMEOUT;
         goto done;
     }
 
+    // Sempre ligado + MQTT: sessão persistente (sem handshake por envio)
+    bool use_session = has_network_mqtt_enabled() && has_always_on();
+    if (!use_session && mqtt_session_is_running()) {
+        mqtt_session_stop();
+    }
+
     // ----------------- (Opcional) Pré-resolve DNS do destino -----------------
     // Mantemos seu pré-resolve apenas para MQTT; HTTP resolve dentro do esp_http_client.
-    if (has_network_mqtt_enabled()) {
+    if (has_network_mqtt_enabled() && !use_session) {
         const char *host = get_mqtt_url();
         if (!host || !host[0]) {
             ESP_LOGE(TAG, "Host MQTT vazio; abortando.");
+            result = ESP_ERR_INVALID_ARG;
             goto done;
         }
-        bool resolved = false;
-        for (int i = 0; i < 10; ++i) { // 10 * 500 ms ~ 5 s
-            struct addrinfo *ai = NULL;
-            if (getaddrinfo(host, NULL, NULL, &ai) == 0 && ai) {
-                freeaddrinfo(ai);
-                resolved = true;
-                break;
-            }
-            vTaskDelay(pdMS_TO_TICKS(500));
-        }
-        if (!resolved) {
+        // Endereço da ativação anterior (RTC, com TTL) dispensa a espera pelo
+        // DNS; mqtt_wifi_publish_now() conecta direto no endereço do cache
+        int32_t left_ms = (int32_t)(deadline - xTaskGetTickCount()) * portTICK_PERIOD_MS;
+        int dns_ms = (left_ms < 5000) ? (int)left_ms : 5000;
+        if (dns_ms <= 0 || wifi_fast_resolve(host, NULL, dns_ms) != ESP_OK) {
             ESP_LOGW(TAG, "DNS não respondeu para '%s'; abortando envio.", host);
+            result = ESP_ERR_TIMEOUT;
             goto done;
         }
     }
 
     // ----------------- Publica (1x) -----------------
+    // O que sobrou do orçamento vai para a publicação (conexão, PUBACK/POST)
+    int32_t pub_ms = (int32_t)(deadline - xTaskGetTickCount()) * portTICK_PERIOD_MS;
+    if (pub_ms <= 0) {
+        ESP_LOGW(TAG, "Orçamento de envio esgotado antes da publicação.");
+        result = ESP_ERR_TIMEOUT;
+        goto done;
+    }
+
+    // Tempo até o primeiro byte da aplicação, contado desde o wake
+    ESP_LOGI(TAG, "TTFB Wi-Fi: IP em %" PRIu32 " ms, envio em %lld ms (caminho %s)",
+             wifi_fast_connect_link_ms(), (long long)(esp_timer_get_time() / 1000),
+             wifi_fast_connect_last_was_fast() ? "rapido" : "completo");
+
     // Prioriza MQTT se ambos estiverem habilitados (mantenho sua política típica).
-    if (has_network_mqtt_enabled()) {
-        mqtt_wifi_publish_now();   // internamente atualiza índices se sucesso
+    if (use_session && mqtt_session_start() == ESP_OK) {
+        mqtt_session_kick();       // a sessão publica e avança os índices (PUBACK)
+        result = ESP_OK;
+    } else if (has_network_mqtt_enabled()) {
+        result = mqtt_wifi_publish_now((uint32_t)pub_ms);   // internamente atualiza índices se sucesso
     } else if (has_network_http_enabled()) {
-        http_wifi_publish_now();   // idem
+        result = http_wifi_publish_now((uint32_t)pub_ms);   // idem
     } else {
         ESP_LOGW(TAG, "Nenhum protocolo de aplicação habilitado (MQTT/HTTP).");
     }
@@ -411,6 +446,7 @@ done:
     portENTER_CRITICAL(&s_send_mux);
     s_send_in_progress = false;
     portEXIT_CRITICAL(&s_send_mux);
+    return result;
 }
 
 static void handle_sms_on_wakeup(void)
@@ -454,6 +490,245 @@ void init_queue_notification(void)
        }
 }
             
+//------------------------------------------------
+//  Jobs agendados do TimeManager
+//------------------------------------------------
+static time_t next_cycle(time_t from)
+{
+    return job_next_every_minutes(from, get_deep_sleep_period());
+}
+
+static time_t next_midnight(time_t from)
+{
+    return job_next_daily(from, 0, 0);
+}
+
+static time_t next_battery_check(time_t from)
+{
+    return job_next_daily(from, BATTERY_CHECK_HOUR, 0);
+}
+
+// Sensores internos (pressão e pulsos)
+static void job_sample(void)
+{
+    wake_phase_begin(WAKE_PH_ACQUIRE);
+    record_batch_begin();   // amostras do ciclo vão para o SD de uma vez só
+    uint8_t save_ret = save_sensor_data();
+    if (save_ret != SAVE_OK) {
+        ESP_LOGW(TAG, "save_sensor_data falhou com máscara 0x%02x", save_ret);
+    }
+    if (record_batch_commit() != ESP_OK) {
+        ESP_LOGW(TAG, "Falha ao gravar o lote do ciclo no SD");
+    }
+    // Sem fonte externa e com bateria baixa o anel RTC pode não sobreviver
+    if (battery_monitor_power_at_risk()) {
+        record_ring_flush();
+    }
+    wake_phase_end(WAKE_PH_ACQUIRE);
+    upload_kick();
+}
+
+#if CONFIG_MODBUS_SERIAL_ENABLE
+// Leitores dos sensores RS485 externos
+static void job_rs485(void)
+{
+    wake_phase_begin(WAKE_PH_ACQUIRE);
+    record_batch_begin();
+    rs485_central_poll_and_save(5000);
+    if (record_batch_commit() != ESP_OK) {
+        ESP_LOGW(TAG, "Falha ao gravar o lote RS485 no SD");
+    }
+    wake_phase_end(WAKE_PH_ACQUIRE);
+    upload_kick();
+}
+#endif
+
+//------------------------------------------------
+//  Worker de envio: a rede nunca atrasa a aquisição
+//------------------------------------------------
+static void upload_notify(uint32_t ev)
+{
+    if (Upload_TaskHandle == NULL) return;
+    portENTER_CRITICAL(&s_upload_mux);   // TimeManager, LTE e o próprio worker notificam
+    s_upload_req++;     // antes da notificação: o worker nunca a vê sem o pedido
+    portEXIT_CRITICAL(&s_upload_mux);
+    xTaskNotify(Upload_TaskHandle, ev, eSetBits);
+}
+
+static bool upload_pending(void)
+{
+    return s_upload_busy || s_upload_req != s_upload_done;
+}
+
+// Fim da sessão LTE (LTE_System_Task): o backoff é aplicado pelo worker,
+// dono de s_upload
+void upload_report_lte_result(esp_err_t err)
+{
+    upload_notify(err == ESP_OK ? UPLOAD_EV_LTE_OK : UPLOAD_EV_LTE_FAIL);
+}
+
+// Chamado quando há registros novos no armazenamento
+static void upload_kick(void)
+{
+    upload_notify(UPLOAD_EV_DATA);
+}
+
+// Rede habilitada, fora do backoff e dentro do orçamento diário.
+// Com o rádio já no ar (prewarm) a tentativa já foi contada.
+static bool upload_gate(bool radio_up)
+{
+    if ((ulp_inactivity & UINT16_MAX) == 1) return false;
+    if (!has_network_http_enabled() && !has_network_mqtt_enabled()) return false;
+
+    time_t now = time(NULL);
+    if (s_upload.next_try && now < s_upload.next_try) {
+        ESP_LOGI(TAG, "Envio em backoff por mais %llds", (long long)(s_upload.next_try - now));
+        return false;
+    }
+
+    // Orçamento de energia: na bateria, no máximo N tentativas de rádio por dia
+    uint32_t today = (uint32_t)((now + JOB_LOCAL_UTC_OFFSET_S) / 86400);
+    if (s_upload.daykey != today) {
+        s_upload.daykey = today;
+        s_upload.attempts_today = 0;
+    }
+    bool on_battery = get_power_source_volts() < POWER_SOURCE_MIN_OK;
+    if (!radio_up && on_battery &&
+        s_upload.attempts_today >= UPLOAD_MAX_ATTEMPTS_DAY_BATT) {
+        ESP_LOGW(TAG, "Orçamento diário de envios esgotado (%u)", s_upload.attempts_today);
+        return false;
+    }
+    return true;
+}
+
+static void upload_result(esp_err_t err)
+{
+    if (err == ESP_OK) {
+        s_upload.next_try  = 0;
+        s_upload.backoff_s = 0;
+    } else if (err != ESP_ERR_INVALID_STATE) {
+        uint32_t b = s_upload.backoff_s ? s_upload.backoff_s * 2 : UPLOAD_BACKOFF_MIN_S;
+        s_upload.backoff_s = (b > UPLOAD_BACKOFF_MAX_S) ? UPLOAD_BACKOFF_MAX_S : b;
+        s_upload.next_try  = time(NULL) + s_upload.backoff_s;
+        ESP_LOGW(TAG, "Envio falhou (%s); nova tentativa em %lus",
+                 esp_err_to_name(err), (unsigned long)s_upload.backoff_s);
+    }
+}
+
+// Início do ciclo: associa o Wi-Fi / liga e registra o SARA enquanto a
+// aquisição roda no TimeManager_Task
+static void upload_prewarm(void)
+{
+    if (!upload_gate(false)) return;
+
+    if (has_activate_sta()) {
+        s_upload.attempts_today++;
+        wake_phase_begin(WAKE_PH_RADIO);
+        esp_err_t err = wifi_link_ensure_ready_sta(20000, !factory_portal_active());
+        wake_phase_end(WAKE_PH_RADIO);
+        if (err == ESP_OK) {
+            s_radio = RADIO_WIFI;
+        } else {
+            upload_result(err);
+        }
+    } else if (!Receive_NetConnect_Task_ON && !wifi_on && lte_send_data_to_server()) {
+        s_upload.attempts_today++;
+        s_radio = RADIO_LTE;     // o LTE_System_Task registra e espera a aquisição
+    }
+}
+
+static void upload_attempt(void)
+{
+    radio_state_t radio = s_radio;
+    s_radio = RADIO_NONE;
+
+    if (radio == RADIO_LTE) return;         // envio segue no LTE_System_Task
+    if (!has_measurement_to_send() || !upload_gate(radio != RADIO_NONE)) return;
+
+    flush_record_sd();   // dados no cartão antes de o índice de leitura avançar
+
+    esp_err_t err;
+    if (has_activate_sta()) {
+        if (radio != RADIO_WIFI) s_upload.attempts_today++;
+        record_ring_flush();
+        wake_phase_begin(WAKE_PH_UPLOAD);
+        err = wifi_send_data_to_server(UPLOAD_ATTEMPT_BUDGET_MS);
+        wake_phase_end(WAKE_PH_UPLOAD);
+    } else if (!Receive_NetConnect_Task_ON && !wifi_on && lte_send_data_to_server()) {
+        s_upload.attempts_today++;
+        return;          // resultado chega por upload_report_lte_result()
+    } else {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    upload_result(err);
+
+    if (!ap_active)
+    {wifi_on=false;}
+}
+
+static void Upload_Task(void* pvParameters)
+{
+    for (;;) {
+        // Sempre ligado: acorda sozinho quando o backoff vence
+        TickType_t wait = portMAX_DELAY;
+        if (has_always_on() && s_upload.next_try) {
+            time_t now = time(NULL);
+            wait = (s_upload.next_try > now)
+                       ? pdMS_TO_TICKS((uint32_t)(s_upload.next_try - now) * 1000) : 1;
+        }
+        uint32_t ev = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &ev, wait);
+
+        s_upload_busy = true;
+        uint32_t req = s_upload_req;        // pedidos cobertos por esta passada
+        int64_t t0 = esp_timer_get_time();
+        if (ev & UPLOAD_EV_PREWARM) {
+            upload_prewarm();
+            // Rádio pronto: publica só depois das leituras deste ciclo
+            wake_wait_acquisition(pdMS_TO_TICKS(UPLOAD_ACQ_WAIT_MS));
+            // os kicks da aquisição já estão cobertos; um resultado LTE não
+            uint32_t more = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &more, 0);
+            ev |= more & (UPLOAD_EV_LTE_OK | UPLOAD_EV_LTE_FAIL);
+            req = s_upload_req;
+        }
+        if (ev & (UPLOAD_EV_LTE_OK | UPLOAD_EV_LTE_FAIL)) {
+            upload_result((ev & UPLOAD_EV_LTE_OK) ? ESP_OK : ESP_FAIL);
+        }
+        if ((ev & (UPLOAD_EV_PREWARM | UPLOAD_EV_DATA)) || ev == 0) {
+            upload_attempt();   // ev == 0: backoff vencido (sempre ligado)
+        }
+        // Pedido chegado depois de 'req' continua segurando o sono (e a
+        // notificação dele faz o worker rodar de novo)
+        s_upload_done = req;
+        s_upload_busy = false;
+        ESP_LOGI(TAG, "Worker de envio: %lldms", (long long)((esp_timer_get_time() - t0) / 1000));
+    }
+}
+
+// Virada do dia: zera o contador de pulsos mesmo sem ciclo de amostragem
+static void job_midnight(void)
+{
+    pulse_meter_check_daily_reset();
+}
+
+// Só a leitura: não há caminho de carga real para um teste sob carga
+static void job_battery_check(void)
+{
+    battery_monitor_update();
+}
+
+// Na mesma ordem em que rodam quando os prazos coincidem. O envio não é
+// job: roda no Upload_Task, acordado pelas leituras (upload_kick)
+static const sched_job_t s_jobs[] = {
+    { "sample",   next_cycle,         59,                has_device_active, job_sample },
+#if CONFIG_MODBUS_SERIAL_ENABLE
+    { "rs485",    next_cycle,         59,                has_device_active, job_rs485 },
+#endif
+    { "midnight", next_midnight,      DAILY_JOB_GRACE_S, NULL,              job_midnight },
+    { "battery",  next_battery_check, DAILY_JOB_GRACE_S, has_device_active, job_battery_check },
+};
+
 //------------------------------------------------
 //  Gerencia o Datalogger
 //------------------------------------------------
@@ -467,9 +742,6 @@ void TimeManager_Task(void* pvParameters)
         nvs_flash_init();
     }
     
-    time_t now, keepAlive;
-    
-   	struct tm timeinfo;//Cria a estrutura que contem as informacoes da data.
 //   	uint8_t periodo = get_send_period();
 
 /*   	if (get_time_minute()==0)
@@ -500,9 +772,27 @@ uint8_t counter=0;
     );*/
 //=====================================	 
 
+    // Ciclo de aquisição agora: o rádio sobe em paralelo com as leituras
+    time_t wake_now = time(NULL);
+    if (has_device_active() && next_cycle(wake_now - 59) <= wake_now) {
+        upload_notify(UPLOAD_EV_PREWARM);
+    }
+    bool acq_signaled = false;
+
+    job_scheduler_init(s_jobs, sizeof(s_jobs) / sizeof(s_jobs[0]));
+
 while(1)
 {	
-	vTaskDelay(pdMS_TO_TICKS(1000));
+    // Bloqueia até o próximo prazo (esp_timer). Sem "sempre ligado" a
+    // janela acordada é curta e o deep sleep é reavaliado a cada segundo
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(has_always_on() ? SCHED_RESYNC_MS : SCHED_SLEEP_CHECK_MS));
+    job_scheduler_run_due();
+    if (!acq_signaled) {
+        // Primeira passada da ativação: leituras no armazenamento, libera o envio
+        flush_record_sd();
+        wake_acquisition_done();
+        acq_signaled = true;
+    }
 
 //----------------------------------------------------------
 //Show Display
@@ -525,68 +815,21 @@ if ((get_wakeup_cause() == WAKE_UP_EXTERN_SENSOR)&& counter<=7)
  }
  #endif
  
-//----------------------------------------------------------
-//        Keep working even if awake
-//----------------------------------------------------------
-if ((get_time_minute() % get_deep_sleep_period()==0) && (get_time_minute()!=load_last_processed_minute())&&has_device_active())// acrescentado para não enviar duas vezes
-   {
-	save_last_processed_minute(get_time_minute());  
-	
-    ESP_LOGI("Save Sensor Data", "TESTE: vou chamar save_sensor_data()");
-    
- //===============================
-//  Leitores do sensor interno
-//-------------------------------   
-	uint8_t save_ret = save_sensor_data();
-	if (save_ret != SAVE_OK) {
-    ESP_LOGW(TAG, "save_sensor_data falhou com máscara 0x%02x", save_ret);
-}
-//===============================
-//  Leitores dos sensores RS485 externos
-//-------------------------------
-#if CONFIG_MODBUS_SERIAL_ENABLE
-    rs485_central_poll_and_save(5000);
-#endif
-
-  if(has_measurement_to_send()&&(ulp_inactivity & UINT16_MAX) != 1)
-	 {
-		 if (has_network_http_enabled()||has_network_mqtt_enabled()){
-			 if (has_activate_sta()){
-			     wifi_send_data_to_server();
-			     }else{
-				       if (!Receive_NetConnect_Task_ON &&!wifi_on){
-					   lte_send_data_to_server();
-				      }
-				  } 
-		     }
-		     
-//       printf(">>>>Tem dados para enviar<<<\n");
-	  }
-    
-    if (!ap_active)
-    {wifi_on=false;}
-        
-    
-//        Send Keep Alive
-//-----------------------------------------------------------
-  time(&now);
-  get_keep_alive_time(&timeinfo);
-  keepAlive = mktime(&timeinfo);
-
-   }//finish periodic
-
 //***********************************************************
 
-xQueueReceive(xQueue_NetConnect, &Receive_NetConnect_Task_ON , (TickType_t)5);
-xQueueReceive(xQueue_get_network_time, &Receive_Get_Network_Time_Task_ON , (TickType_t)5);
+// Só vale o último estado de cada task: esvazia as filas sem esperar, senão
+// um ON/OFF empilhado só seria visto na próxima passada (sono adiado)
+while (xQueueReceive(xQueue_NetConnect, &Receive_NetConnect_Task_ON, 0) == pdTRUE) { }
+while (xQueueReceive(xQueue_get_network_time, &Receive_Get_Network_Time_Task_ON, 0) == pdTRUE) { }
 #if ENABLE_DEEP_SLEEP
-xQueueReceive(xQueue_Factory_Control, &Receive_FactoryControl_Task_ON , (TickType_t)5);
+while (xQueueReceive(xQueue_Factory_Control, &Receive_FactoryControl_Task_ON, 0) == pdTRUE) { }
 /*
 printf("Factory task on = %d ####  NetConnect = %d #### Receive_Get_Network_Time =%d \n ",
        Receive_FactoryControl_Task_ON, Receive_NetConnect_Task_ON,Receive_Get_Network_Time_Task_ON);
 */       
-if (!Receive_FactoryControl_Task_ON && !Receive_NetConnect_Task_ON &&!Receive_Get_Network_Time_Task_ON)
+if (!Receive_FactoryControl_Task_ON && !Receive_NetConnect_Task_ON &&!Receive_Get_Network_Time_Task_ON && !upload_pending())
    {
+	wake_timeline_report();
 	vTaskDelay(pdMS_TO_TICKS(10));
  	start_deep_sleep();
  	}
@@ -600,6 +843,9 @@ if (!Receive_FactoryControl_Task_ON && !Receive_NetConnect_Task_ON &&!Receive_Ge
 
 void init_timemanager_task(void)
 {
+ if(Upload_TaskHandle==NULL)
+   xTaskCreatePinnedToCore( Upload_Task, "Upload_Task", 10000, NULL, 1, &Upload_TaskHandle,1);
+
  if(TimeManager_TaskHandle==NULL)
 
    xTaskCreatePinnedToCore( TimeManager_Task, "TimeManager_Task", 10000, NULL, 1, &TimeManager_TaskHandle,1);
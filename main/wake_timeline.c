@@ -0,0 +1,102 @@
+/*
+ * wake_timeline.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "wake_timeline.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/event_groups.h"
+
+#define WAKE_ACQ_DONE_BIT   BIT0
+
+static const char *TAG = "Wake_Timeline";
+
+static const char *const s_ph_name[WAKE_PH_COUNT] = {
+    [WAKE_PH_ACQUIRE] = "aquisicao",
+    [WAKE_PH_RADIO]   = "radio",
+    [WAKE_PH_UPLOAD]  = "envio",
+};
+
+// µs desde o boot/wake (esp_timer); 0 = fase não ocorreu
+static int64_t s_begin[WAKE_PH_COUNT];
+static int64_t s_end[WAKE_PH_COUNT];
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static StaticEventGroup_t s_evt_buf;
+static EventGroupHandle_t s_evt;
+
+static EventGroupHandle_t evt(void)
+{
+    if (!s_evt) {
+        portENTER_CRITICAL(&s_mux);
+        if (!s_evt) s_evt = xEventGroupCreateStatic(&s_evt_buf);
+        portEXIT_CRITICAL(&s_mux);
+    }
+    return s_evt;
+}
+
+void wake_phase_begin(wake_phase_t ph)
+{
+    if (ph >= WAKE_PH_COUNT) return;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    if (s_begin[ph] == 0) s_begin[ph] = now;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void wake_phase_end(wake_phase_t ph)
+{
+    if (ph >= WAKE_PH_COUNT) return;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    if (s_begin[ph] != 0) s_end[ph] = now;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void wake_acquisition_done(void)
+{
+    xEventGroupSetBits(evt(), WAKE_ACQ_DONE_BIT);
+}
+
+bool wake_wait_acquisition(TickType_t timeout)
+{
+    EventBits_t bits = xEventGroupWaitBits(evt(), WAKE_ACQ_DONE_BIT, pdFALSE, pdTRUE, timeout);
+    return (bits & WAKE_ACQ_DONE_BIT) != 0;
+}
+
+static inline int64_t ph_len(int i)
+{
+    return (s_begin[i] && s_end[i] > s_begin[i]) ? s_end[i] - s_begin[i] : 0;
+}
+
+void wake_timeline_report(void)
+{
+    int64_t b[WAKE_PH_COUNT], e[WAKE_PH_COUNT];
+    portENTER_CRITICAL(&s_mux);
+    for (int i = 0; i < WAKE_PH_COUNT; i++) {
+        b[i] = s_begin[i];
+        e[i] = ph_len(i) ? s_end[i] : s_begin[i];
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    for (int i = 0; i < WAKE_PH_COUNT; i++) {
+        if (b[i] == 0) continue;
+        ESP_LOGI(TAG, "%-9s %6lld .. %6lld ms (%lld ms)", s_ph_name[i],
+                 (long long)(b[i] / 1000), (long long)(e[i] / 1000),
+                 (long long)((e[i] - b[i]) / 1000));
+    }
+
+    // Tempo ganho = sobreposição aquisição x rádio (antes eram sequenciais)
+    int64_t overlap = 0;
+    if (b[WAKE_PH_ACQUIRE] && b[WAKE_PH_RADIO]) {
+        int64_t lo = (b[WAKE_PH_ACQUIRE] > b[WAKE_PH_RADIO]) ? b[WAKE_PH_ACQUIRE] : b[WAKE_PH_RADIO];
+        int64_t hi = (e[WAKE_PH_ACQUIRE] < e[WAKE_PH_RADIO]) ? e[WAKE_PH_ACQUIRE] : e[WAKE_PH_RADIO];
+        if (hi > lo) overlap = hi - lo;
+    }
+    ESP_LOGI(TAG, "acordado %lld ms, sobreposicao aquisicao/radio %lld ms",
+             (long long)(esp_timer_get_time() / 1000), (long long)(overlap / 1000));
+}
@@ -33,6 +33,11 @@ esp_err_t energy_meter_save_currents(uint8_t channel, uint8_t addr);
 */
 esp_err_t energy_meter_save_currents_by_channel(uint8_t channel);
 
+/* Igual, com canal/endereço/fases já conhecidos (sem reler o cadastro).
+   deadline_us (esp_timer_get_time) != 0 limita o fallback de FC. */
+esp_err_t energy_meter_save_currents_for(uint8_t channel, uint8_t addr,
+                                         int phases, int64_t deadline_us);
+
 /* Best-effort: percorre todos cadastrados e salva correntes dos de energia. */
 esp_err_t energy_meter_save_registered_currents(void);
 
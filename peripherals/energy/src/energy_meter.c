@@ -6,6 +6,8 @@
 #include "esp_log.h"
 #include "modbus_rtu_master.h"
 #include "modbus_guard_session.h"
+#include "modbus_dev_profile.h"
+#include "esp_timer.h"
 #include "datalogger_driver.h"
 #include "rs485_registry.h"  
 
@@ -57,6 +59,8 @@ int  rs485_registry_iterate_configured(bool (*cb)(uint8_t, uint8_t, void*), void
  * Ex.: CANAL "3", "4.1", "4.2", "4.3"
  */
 esp_err_t save_record_sd_rs485(int channel, int subindex, const char *value_str);
+/* Entra no lote do ciclo quando houver um aberto (record_batch_begin); senão grava direto */
+esp_err_t record_batch_add(int channel, int subindex, const char *value_str);
 
 static const char *TAG = "ENERGY_METER";
 
@@ -89,7 +93,8 @@ static inline void convert_raw_currents(const uint16_t raw[3], float outI[3])
     outI[2] = (float)raw[2] / JSY_I_SCALE;
 }
 
-esp_err_t energy_meter_read_currents(uint8_t addr, float outI[3])
+/* deadline_us (esp_timer) != 0: não tenta a FC de fallback depois do prazo */
+static esp_err_t read_currents_until(uint8_t addr, float outI[3], int64_t deadline_us)
 {
     if (!outI) return ESP_ERR_INVALID_ARG;
 
@@ -99,45 +104,43 @@ esp_err_t energy_meter_read_currents(uint8_t addr, float outI[3])
 #endif
     
 
-     uint16_t raw[3] = {0};
-    esp_err_t err = ESP_OK;
+    uint16_t raw[3] = {0};
+    esp_err_t err = ESP_ERR_TIMEOUT;   // sessão não abriu => não lemos nada
+    bool tried = false;
+    uint8_t ok_fc = 0;
+    uint32_t lat_ms = 0;
 
-    // [NEW] Lê hint persistido para decidir a ordem de tentativa
-    uint8_t hinted_fc = 0;
-    (void)rs485_hint_get_used_fc(addr, &hinted_fc); // OK se não existir ainda
+    // FC da última leitura OK (tabela em RAM; sem abrir o JSON da UI)
+    uint8_t hinted_fc = mb_prof_used_fc(addr);
+    uint8_t order[2]  = { 0x03, 0x04 };
+    if (hinted_fc == 0x04) { order[0] = 0x04; order[1] = 0x03; }
 
     // Janela curta e exclusiva para a transação Modbus
+    // (dentro do ciclo do rs485_central a sessão já está aberta: só refcount)
     MB_SESSION_WITH(pdMS_TO_TICKS(500)) {
-        esp_err_t e1 = ESP_FAIL, e2 = ESP_FAIL;
-        if (hinted_fc == 0x03) {
-            e1 = read_currents_fc03(addr, raw);
-            if (e1 != ESP_OK) e2 = read_currents_fc04(addr, raw);
-            err = (e1 == ESP_OK) ? e1 : e2;
-            if (e1 != ESP_OK && e2 == ESP_OK) {
-                // Atualiza hint: agora 0x04 funcionou
-                rs485_hint_set_used_fc(addr, 0x04);
-            }
-        } else if (hinted_fc == 0x04) {
-            e1 = read_currents_fc04(addr, raw);
-            if (e1 != ESP_OK) e2 = read_currents_fc03(addr, raw);
-            err = (e1 == ESP_OK) ? e1 : e2;
-            if (e1 != ESP_OK && e2 == ESP_OK) {
-                // Atualiza hint: agora 0x03 funcionou
-                rs485_hint_set_used_fc(addr, 0x03);
+        tried = true;
+        for (int i = 0; i < 2; ++i) {
+            int64_t t0 = esp_timer_get_time();
+            if (i > 0 && deadline_us && t0 >= deadline_us) {
+                ESP_LOGW(TAG, "addr=%u: prazo esgotado, sem fallback de FC", addr);
+                break;
             }
-        } else {
-            // Sem hint: tenta 0x03 -> 0x04 e grava o que funcionou
-            e1 = read_currents_fc03(addr, raw);
-            if (e1 != ESP_OK) e2 = read_currents_fc04(addr, raw);
-            err = (e1 == ESP_OK) ? e1 : e2;
-            if (e1 == ESP_OK) {
-                rs485_hint_set_used_fc(addr, 0x03);
-            } else if (e2 == ESP_OK) {
-                rs485_hint_set_used_fc(addr, 0x04);
+            // FC já conhecida e o escravo nem respondeu: a outra FC não vai
+            // mudar isso (FC errada volta exceção, não silêncio)
+            if (i > 0 && hinted_fc && err == ESP_ERR_TIMEOUT) break;
+            err = (order[i] == 0x03) ? read_currents_fc03(addr, raw)
+                                     : read_currents_fc04(addr, raw);
+            if (err == ESP_OK) {
+                ok_fc  = order[i];
+                lat_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+                break;
             }
         }
     } // sessão fecha aqui, garantindo flush+idle
-    
+
+    if (ok_fc)      mb_prof_note_ok(addr, ok_fc, lat_ms);
+    else if (tried) mb_prof_note_fail(addr);
+
     if (err == ESP_ERR_TIMEOUT) {
         ESP_LOGW(TAG, "sem resposta do escravo addr=%u (timeout)", addr);
         return err;
@@ -150,6 +153,11 @@ esp_err_t energy_meter_read_currents(uint8_t addr, float outI[3])
     
 }
 
+esp_err_t energy_meter_read_currents(uint8_t addr, float outI[3])
+{
+    return read_currents_until(addr, outI, 0);
+}
+
 /* Força salvar 3 linhas (3.1..3.3) */
 esp_err_t energy_meter_save_currents(uint8_t channel, uint8_t addr)
 {
@@ -159,7 +167,7 @@ esp_err_t energy_meter_save_currents(uint8_t channel, uint8_t addr)
     for (int sub = 1; sub <= 3; ++sub) {
         int n = snprintf(buf, sizeof(buf), "%.3f", I[sub - 1]);
         if (n <= 0 || n >= (int)sizeof(buf)) return ESP_FAIL;
-        ESP_RETURN_ON_ERROR(save_record_sd_rs485(channel, sub, buf), TAG, "save");
+        ESP_RETURN_ON_ERROR(record_batch_add(channel, sub, buf), TAG, "save");
     }
     return ESP_OK;
 }
@@ -172,15 +180,20 @@ esp_err_t energy_meter_save_currents_by_channel(uint8_t channel)
         ESP_LOGW("ENERGY", "[CH %u] não encontrado no cadastro.", channel);
         return ESP_ERR_NOT_FOUND;
     }
+    int phases = rs485_registry_get_channel_phase_count(channel);  // 1=mono, 3=tri
+    return energy_meter_save_currents_for(channel, addr, phases, 0);
+}
 
+esp_err_t energy_meter_save_currents_for(uint8_t channel, uint8_t addr,
+                                         int phases, int64_t deadline_us)
+{
     float I[3] = {0};
-    esp_err_t err = energy_meter_read_currents(addr, I);
+    esp_err_t err = read_currents_until(addr, I, deadline_us);
     if (err != ESP_OK) {
         ESP_LOGW("ENERGY", "[CH %u] addr=%u leitura falhou: %s", channel, addr, esp_err_to_name(err));
         return err;
     }
 
-    int phases = rs485_registry_get_channel_phase_count(channel);  // 1=mono, 3=tri
     if (phases != 1 && phases != 3) phases = 3; // default seguro
 
     ESP_LOGI("ENERGY", "[CH %u] addr=%u phases=%d  I_A=%.3f  I_B=%.3f  I_C=%.3f",
@@ -189,11 +202,11 @@ esp_err_t energy_meter_save_currents_by_channel(uint8_t channel)
     char buf[24];
     if (phases == 1) {
         snprintf(buf, sizeof(buf), "%.3f", I[0]);
-        return save_record_sd_rs485((int)channel, /*subindex=*/0, buf); // grava "3"
+        return record_batch_add((int)channel, /*subindex=*/0, buf); // grava "3"
     } else {
         for (int sub = 1; sub <= 3; ++sub) {
             snprintf(buf, sizeof(buf), "%.3f", I[sub - 1]);
-            esp_err_t e = save_record_sd_rs485((int)channel, sub, buf); // grava "4.1/4.2/4.3"
+            esp_err_t e = record_batch_add((int)channel, sub, buf); // grava "4.1/4.2/4.3"
             if (e != ESP_OK) return e;
         }
         return ESP_OK;
@@ -26,6 +26,8 @@ typedef enum {
 float interpolate_pressure(float voltage, float *cal_voltages, float *ref_pressures_bar);
 float bar_to_mca(float bar);
 float get_calibrated_pressure(sensor_t leitor, pressure_unit_t unidade, bool *sensor_ok);
+// Mesma conversão, a partir de uma tensão já lida (ex.: ads1015_scan)
+float pressure_from_voltage(sensor_t leitor, float voltage, pressure_unit_t unidade, bool *sensor_ok);
 
 esp_err_t save_reference_points_sensor1(const reference_point_t *sensor1);
 esp_err_t save_reference_points_sensor2(const reference_point_t *sensor2);
@@ -225,7 +225,10 @@ esp_err_t load_reference_points_sensor2(reference_point_t *points) {
 }
 
 float get_calibrated_pressure(sensor_t leitor, pressure_unit_t unidade, bool *sensor_ok) {
-    float voltage = oneshot_analog_read(leitor);
+    return pressure_from_voltage(leitor, oneshot_analog_read(leitor), unidade, sensor_ok);
+}
+
+float pressure_from_voltage(sensor_t leitor, float voltage, pressure_unit_t unidade, bool *sensor_ok) {
     ESP_LOGI(TAG_SENSOR, "Leitura atual: %.3f V\n", voltage);
     ESP_LOGI(TAG, "Unidade solicitada: %d", unidade);
 
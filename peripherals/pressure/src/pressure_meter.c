@@ -49,7 +49,7 @@ int error;
    if (channel == 0)
       {
 		ESP_LOGI(TAG,">>>>>Pressure 1 = %s<<<<\n", press.pressure1);
-             if (save_record_sd(channel,press.pressure1)==0)
+             if (record_batch_add(channel, 0, press.pressure1)==0)
                 {
 				 error=ESP_OK; 
 			    } 
@@ -60,7 +60,7 @@ int error;
        }
    else {
          ESP_LOGI(TAG,">>>>>Pressure 1 = %s<<<<\n", press.pressure2);
-             if (save_record_sd(channel,press.pressure2)==0)
+             if (record_batch_add(channel, 0, press.pressure2)==0)
                 {
 				 error=ESP_OK; 
 			    } 
@@ -79,14 +79,25 @@ int error;
 //-------------------------------------------------------------------
 void pressure_sensor_read(bool *sensor_1, bool *sensor_2)
 {
-	struct pressure_data saved_data;
+	// Parte da última leitura: um canal ausente mantém o valor anterior
+	struct pressure_data saved_data = {0};
+	if (has_pressure_data()) {
+		get_pressure_data(&saved_data);
+	}
 
 	bool sensor_ok_1 = false;
 	bool sensor_ok_2 = false;
+
+	// Os dois canais numa só varredura do ADS (com oversampling); a
+	// calibração (NVS) e o display vêm depois, já sem depender do ADC
+	static const sensor_t chans[2] = { analog_1, analog_2 };
+	float volts[2] = { 0.0f, 0.0f };
+	if (ads1015_scan(chans, 2, NULL, volts) != ESP_OK) {
+		ESP_LOGW(TAG,"Falha na leitura dos sensores de pressão\n");
+		return;
+	}
 	
-//	saved_data = get_saved_pressure_data();
-	
-float p_1 = get_calibrated_pressure(analog_1, PRESSURE_UNIT_MCA, &sensor_ok_1);	   
+float p_1 = pressure_from_voltage(analog_1, volts[0], PRESSURE_UNIT_MCA, &sensor_ok_1);	   
 if (sensor_ok_1) {
     int channel = 0;
     *sensor_1 = true;
@@ -102,7 +113,7 @@ if (sensor_ok_1) {
     ESP_LOGI(TAG,"Sensor de pressão canal 0 não está instalado ou leitura inválida\n");
 }
 	   
-float p_2 = get_calibrated_pressure(analog_2, PRESSURE_UNIT_MCA, &sensor_ok_2);
+float p_2 = pressure_from_voltage(analog_2, volts[1], PRESSURE_UNIT_MCA, &sensor_ok_2);
      	        
 	if (sensor_ok_2) {
     int channel = 2;
@@ -0,0 +1,63 @@
+/*
+ * cbor_writer.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef SYSTEM_INCLUDE_CBOR_WRITER_H_
+#define SYSTEM_INCLUDE_CBOR_WRITER_H_
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Encoder CBOR (RFC 8949) mínimo, sem alocação.
+ *
+ * Só o que os payloads precisam: inteiros, texto, array/map de tamanho
+ * definido e tag. Inteiros usam sempre a menor codificação (1, 2, 3, 5 ou
+ * 9 bytes), que é a forma canônica.
+ *
+ * Mesmo modelo do json_writer: o tamanho é sempre contado, e com
+ * buf == NULL o writer só mede.
+ */
+typedef struct {
+    uint8_t *buf;        // NULL => só mede
+    size_t   cap;
+    size_t   len;        // bytes gerados (exato, mesmo em overflow)
+    bool     overflow;
+} cbor_writer_t;
+
+void cw_init(cbor_writer_t *w, uint8_t *buf, size_t cap);
+
+void cw_uint(cbor_writer_t *w, uint64_t v);
+void cw_int(cbor_writer_t *w, int64_t v);
+void cw_text(cbor_writer_t *w, const char *s);     // s == NULL => null
+void cw_array(cbor_writer_t *w, size_t count);
+void cw_map(cbor_writer_t *w, size_t count);
+void cw_tag(cbor_writer_t *w, uint64_t tag);
+void cw_null(cbor_writer_t *w);
+
+static inline bool cw_ok(const cbor_writer_t *w) { return !w->overflow; }
+
+/** @brief Volta para 'len' (descartar um trecho que não coube). */
+void cw_rewind(cbor_writer_t *w, size_t len);
+
+/**
+ * @param len_out  tamanho exato, mesmo se não coube.
+ * @return ESP_OK ou ESP_ERR_NO_MEM.
+ */
+esp_err_t cw_finish(const cbor_writer_t *w, size_t *len_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSTEM_INCLUDE_CBOR_WRITER_H_ */
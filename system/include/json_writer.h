@@ -0,0 +1,105 @@
+/*
+ * json_writer.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef SYSTEM_INCLUDE_JSON_WRITER_H_
+#define SYSTEM_INCLUDE_JSON_WRITER_H_
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_WRITER_MAX_DEPTH  16
+
+/**
+ * @brief Destino alternativo ao buffer: recebe o JSON em pedaços (ex.: transporte).
+ * Retornar != ESP_OK interrompe a escrita.
+ */
+typedef esp_err_t (*json_writer_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Encoder JSON em fluxo, sem alocação (nada de árvore cJSON).
+ *
+ * Gera exatamente os mesmos bytes que cJSON_PrintUnformatted() para a mesma
+ * sequência de campos (escape de strings e formatação de números idênticos),
+ * direto no buffer do chamador ou num sink.
+ *
+ * O tamanho é sempre contado, mesmo quando não cabe: com buf == NULL o writer
+ * só mede, e jw_finish() devolve o tamanho exato necessário. Medindo com
+ * cap > 0, cap vale como limite (jw_can_close/rollback iguais ao modo
+ * buffer): é assim que se escolhe quantos registros cabem num corpo antes
+ * de mandá-lo por um sink com Content-Length.
+ */
+typedef struct {
+    char              *buf;        // NULL => só mede
+    size_t             cap;        // capacidade de buf (inclui o '\0'); medindo: limite (0 = sem)
+    size_t             len;        // bytes gerados até agora (exato, mesmo em overflow)
+    json_writer_sink_t sink;       // modo sink: buf é só um buffer de passagem
+    void              *sink_ctx;
+    size_t             sink_fill;
+    uint8_t            depth;
+    uint32_t           first;      // bit n: próximo item do nível n é o primeiro
+    bool               overflow;
+    esp_err_t          err;
+} json_writer_t;
+
+/** Ponto de retorno para desfazer um trecho que não coube (só no modo buffer). */
+typedef struct {
+    size_t   len;
+    uint8_t  depth;
+    uint32_t first;
+} json_writer_mark_t;
+
+/** @brief Escreve em buf (cap bytes, inclui o '\0'). buf == NULL mede apenas, até cap (0 = sem limite). */
+void jw_init(json_writer_t *w, char *buf, size_t cap);
+
+/** @brief Envia ao sink em pedaços de até scratch_cap bytes. */
+void jw_init_sink(json_writer_t *w, json_writer_sink_t sink, void *ctx,
+                  char *scratch, size_t scratch_cap);
+
+/*
+ * Campos: 'key' é o nome dentro de objeto; use NULL para itens de array.
+ * jw_str() com valor NULL não escreve nada (mesmo efeito do
+ * cJSON_AddStringToObject com string NULL).
+ */
+void jw_obj_begin(json_writer_t *w, const char *key);
+void jw_obj_end(json_writer_t *w);
+void jw_arr_begin(json_writer_t *w, const char *key);
+void jw_arr_end(json_writer_t *w);
+void jw_str(json_writer_t *w, const char *key, const char *value);
+void jw_num(json_writer_t *w, const char *key, double value);
+
+/** @brief true se tudo gerado até aqui coube no buffer (ou no limite da medição). */
+static inline bool jw_ok(const json_writer_t *w) { return !w->overflow && w->err == ESP_OK; }
+
+/** @brief true se o que foi gerado, mais os fechamentos pendentes ('}' / ']'), cabe no buffer. */
+static inline bool jw_can_close(const json_writer_t *w)
+{
+    return jw_ok(w) && (w->sink || w->cap == 0 || w->len + w->depth + 1 <= w->cap);
+}
+
+/** @brief Salva / restaura a posição (ex.: descartar um registro que não coube). */
+void jw_mark(const json_writer_t *w, json_writer_mark_t *m);
+void jw_rewind(json_writer_t *w, const json_writer_mark_t *m);
+
+/**
+ * @brief Fecha o texto ('\0' no buffer, flush no sink).
+ * @param len_out  tamanho exato do JSON (sem o '\0'), mesmo se não coube.
+ * @return ESP_OK, ESP_ERR_NO_MEM (não coube em buf) ou o erro do sink.
+ */
+esp_err_t jw_finish(json_writer_t *w, size_t *len_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSTEM_INCLUDE_JSON_WRITER_H_ */
@@ -0,0 +1,98 @@
+/*
+ * tls_cache.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef SYSTEM_INCLUDE_TLS_CACHE_H_
+#define SYSTEM_INCLUDE_TLS_CACHE_H_
+
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/ssl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cache das CAs configuradas (PEM), já parseadas, para o tls_transport.
+ *
+ * Sem o cache, cada conexão MQTT com PEM explícito faz o parse X.509 da CA
+ * de novo. Aqui o PEM é parseado uma vez (chave = CRC32 + tamanho) e cada
+ * transporte segura uma referência à cadeia enquanto a usa: trocar a CA não
+ * mexe na cadeia de uma conexão aberta. Entradas sem referência ficam no
+ * cache até serem substituídas.
+ */
+#ifndef TLS_CA_CACHE_SLOTS
+#define TLS_CA_CACHE_SLOTS  2
+#endif
+
+/**
+ * @brief Tickets de sessão TLS em memória RTC.
+ *
+ * O ticket (mbedtls_ssl_session_save) de cada servidor (host:porta) fica em
+ * RTC_DATA_ATTR com CRC, então sobrevive ao deep sleep: a primeira conexão
+ * depois do wake retoma a sessão (handshake abreviado, sem ECDHE nem
+ * verificação da cadeia). Só o MQTT usa (tls_transport); o HTTP vai pelo
+ * esp_http_client. Requer CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE
+ * desligado, senão o certificado do servidor inteiro vai junto na sessão e
+ * não cabe no slot. Nada no firmware lê o certificado do servidor depois
+ * do handshake (a verificação é durante ele), e cada conexão TLS deixa de
+ * segurar a cadeia do servidor em RAM.
+ */
+#ifndef TLS_TICKET_SLOTS
+#define TLS_TICKET_SLOTS    1      // broker MQTT
+#endif
+#ifndef TLS_TICKET_MAX
+#define TLS_TICKET_MAX      400    // sessão serializada (~150 B) + ticket do servidor
+#endif
+
+typedef struct {
+    uint32_t hits;          // PEM já estava parseado
+    uint32_t parses;        // PEM parseado (primeira vez ou CA trocada)
+    uint32_t parse_ms_last;
+    uint8_t  cached;        // CAs no cache agora
+    uint32_t ticket_saves;
+    uint32_t ticket_loads;  // tickets oferecidos ao servidor
+} tls_cache_stats_t;
+
+/**
+ * @brief Referência à cadeia parseada de 'pem' (parseia na primeira vez).
+ *
+ * @param pem         PEM terminado em '\0'.
+ * @param was_cached  (opcional) true se não precisou parsear.
+ * @return cadeia para mbedtls_ssl_conf_ca_chain(), ou NULL (PEM inválido,
+ *         sem memória ou todos os slots em uso).
+ */
+mbedtls_x509_crt *tls_cache_ca_acquire(const char *pem, bool *was_cached);
+
+/** @brief Devolve a referência obtida em tls_cache_ca_acquire(). */
+void tls_cache_ca_release(mbedtls_x509_crt *ca);
+
+/** @brief Libera as CAs sem referência (ex.: antes de dormir sem Wi-Fi). */
+void tls_cache_flush(void);
+
+/**
+ * @brief Carrega em 'out' o ticket guardado para host:porta.
+ * @return true se havia ticket válido ('out' precisa estar inicializada).
+ */
+bool tls_cache_ticket_load(const char *host, int port, mbedtls_ssl_session *out);
+
+/** @brief Guarda a sessão do handshake recém-concluído de 'ssl'. */
+void tls_cache_ticket_save(const char *host, int port, const mbedtls_ssl_context *ssl);
+
+/** @brief Esquece o ticket de host:porta (ex.: retomada recusada). */
+void tls_cache_ticket_forget(const char *host, int port);
+
+void tls_cache_get_stats(tls_cache_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSTEM_INCLUDE_TLS_CACHE_H_ */
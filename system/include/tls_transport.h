@@ -0,0 +1,58 @@
+/*
+ * tls_transport.h
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Transporte TLS (esp_transport) com retomada de sessão entre deep sleeps.
+ *
+ * O esp-tls não expõe a sessão para ser guardada fora da RAM, então cada
+ * wake fazia o handshake completo. Este transporte fala mbedtls direto:
+ * antes do handshake oferece o ticket guardado em RTC (tls_cache) e, ao
+ * concluir, guarda o ticket novo. A CA vem do cache de CAs por referência
+ * ou, sem PEM, do bundle de certificados.
+ *
+ * Serve para o esp-mqtt (mqtt_cfg.network.transport). O HTTP fica no
+ * esp_http_client (redirecionamentos, Host com porta, etc.), que não aceita
+ * transporte próprio: lá a sessão TLS vale pelo keep-alive da sessão.
+ */
+
+#ifndef SYSTEM_INCLUDE_TLS_TRANSPORT_H_
+#define SYSTEM_INCLUDE_TLS_TRANSPORT_H_
+
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t handshakes;
+    uint32_t handshake_ms_last;
+    bool     ticket_offered;   // último handshake ofereceu ticket do RTC
+    bool     ca_cached;        // CA veio do cache (sem parse X.509)
+} tls_transport_stats_t;
+
+/**
+ * @brief Cria o transporte.
+ * @param ca_pem  PEM da CA (NULL/"" => bundle, se habilitado).
+ * @return handle ou NULL (sem memória, PEM inválido ou sem como verificar).
+ */
+esp_transport_handle_t tls_transport_new(const char *ca_pem);
+
+/**
+ * @brief Nome do servidor para SNI, verificação do certificado e ticket
+ *        quando o connect recebe um IP já resolvido (NULL/"" => o host do connect).
+ */
+void tls_transport_set_server_name(esp_transport_handle_t t, const char *name);
+
+void tls_transport_get_stats(esp_transport_handle_t t, tls_transport_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSTEM_INCLUDE_TLS_TRANSPORT_H_ */
@@ -0,0 +1,108 @@
+/*
+ * cbor_writer.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "cbor_writer.h"
+
+#include <string.h>
+
+// Tipos maiores do CBOR (3 bits altos do byte inicial)
+#define CBOR_MT_UINT    0u
+#define CBOR_MT_NINT    1u
+#define CBOR_MT_TEXT    3u
+#define CBOR_MT_ARRAY   4u
+#define CBOR_MT_MAP     5u
+#define CBOR_MT_TAG     6u
+#define CBOR_SIMPLE_NULL 0xF6u
+
+static void emit(cbor_writer_t *w, const void *p, size_t n)
+{
+    if (w->buf && w->len + n <= w->cap) {
+        memcpy(w->buf + w->len, p, n);
+    } else if (w->buf) {
+        w->overflow = true;
+    }
+    w->len += n;
+}
+
+// Cabeçalho: tipo maior + argumento na menor forma possível (big-endian)
+static void emit_head(cbor_writer_t *w, uint8_t major, uint64_t v)
+{
+    uint8_t h[9];
+    size_t n;
+
+    if (v < 24) {
+        h[0] = (uint8_t)((major << 5) | v);
+        n = 1;
+    } else if (v <= 0xFF) {
+        h[0] = (uint8_t)((major << 5) | 24);
+        h[1] = (uint8_t)v;
+        n = 2;
+    } else if (v <= 0xFFFF) {
+        h[0] = (uint8_t)((major << 5) | 25);
+        h[1] = (uint8_t)(v >> 8);
+        h[2] = (uint8_t)v;
+        n = 3;
+    } else if (v <= 0xFFFFFFFFull) {
+        h[0] = (uint8_t)((major << 5) | 26);
+        for (int i = 0; i < 4; i++) h[1 + i] = (uint8_t)(v >> (24 - 8 * i));
+        n = 5;
+    } else {
+        h[0] = (uint8_t)((major << 5) | 27);
+        for (int i = 0; i < 8; i++) h[1 + i] = (uint8_t)(v >> (56 - 8 * i));
+        n = 9;
+    }
+    emit(w, h, n);
+}
+
+void cw_init(cbor_writer_t *w, uint8_t *buf, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->cap = buf ? cap : 0;
+}
+
+void cw_uint(cbor_writer_t *w, uint64_t v) { emit_head(w, CBOR_MT_UINT, v); }
+
+void cw_int(cbor_writer_t *w, int64_t v)
+{
+    if (v >= 0) emit_head(w, CBOR_MT_UINT, (uint64_t)v);
+    else        emit_head(w, CBOR_MT_NINT, (uint64_t)(-1 - v));
+}
+
+void cw_text(cbor_writer_t *w, const char *s)
+{
+    if (!s) {
+        cw_null(w);
+        return;
+    }
+    size_t n = strlen(s);
+    emit_head(w, CBOR_MT_TEXT, n);
+    emit(w, s, n);
+}
+
+void cw_array(cbor_writer_t *w, size_t count) { emit_head(w, CBOR_MT_ARRAY, count); }
+void cw_map(cbor_writer_t *w, size_t count)   { emit_head(w, CBOR_MT_MAP, count); }
+void cw_tag(cbor_writer_t *w, uint64_t tag)   { emit_head(w, CBOR_MT_TAG, tag); }
+
+void cw_null(cbor_writer_t *w)
+{
+    uint8_t b = CBOR_SIMPLE_NULL;
+    emit(w, &b, 1);
+}
+
+void cw_rewind(cbor_writer_t *w, size_t len)
+{
+    if (len > w->len) return;
+    w->len = len;
+    w->overflow = w->buf && w->len > w->cap;
+}
+
+esp_err_t cw_finish(const cbor_writer_t *w, size_t *len_out)
+{
+    if (len_out) *len_out = w->len;
+    return w->overflow ? ESP_ERR_NO_MEM : ESP_OK;
+}
@@ -0,0 +1,213 @@
+/*
+ * json_writer.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "json_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <float.h>
+
+static void emit(json_writer_t *w, const char *s, size_t n)
+{
+    if (w->err != ESP_OK) return;
+
+    if (w->sink) {
+        while (n > 0) {
+            size_t room = w->cap - w->sink_fill;
+            size_t k = n < room ? n : room;
+            memcpy(w->buf + w->sink_fill, s, k);
+            w->sink_fill += k;
+            w->len += k;
+            s += k;
+            n -= k;
+            if (w->sink_fill == w->cap) {
+                w->err = w->sink(w->sink_ctx, w->buf, w->sink_fill);
+                w->sink_fill = 0;
+                if (w->err != ESP_OK) return;
+            }
+        }
+        return;
+    }
+
+    // Modo buffer: copia o que couber (reservando o '\0'), mas conta tudo.
+    // Sem buf só mede; cap, se houver, vale como limite.
+    if (w->buf && w->len < w->cap) {
+        size_t room = w->cap - 1 - w->len;
+        memcpy(w->buf + w->len, s, n < room ? n : room);
+    }
+    w->len += n;
+    if (w->cap && w->len + 1 > w->cap) w->overflow = true;
+}
+
+static inline void emit_c(json_writer_t *w, char c) { emit(w, &c, 1); }
+
+// Mesmo escape do cJSON (print_string_ptr): só ", \ e controles < 0x20
+static void emit_string(json_writer_t *w, const char *s)
+{
+    emit_c(w, '"');
+    const char *run = s;
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 32 && c != '"' && c != '\\') continue;
+
+        emit(w, run, (size_t)(s - run));
+        char esc[7];
+        switch (c) {
+            case '"':  emit(w, "\\\"", 2); break;
+            case '\\': emit(w, "\\\\", 2); break;
+            case '\b': emit(w, "\\b", 2);  break;
+            case '\f': emit(w, "\\f", 2);  break;
+            case '\n': emit(w, "\\n", 2);  break;
+            case '\r': emit(w, "\\r", 2);  break;
+            case '\t': emit(w, "\\t", 2);  break;
+            default:
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                emit(w, esc, 6);
+                break;
+        }
+        run = s + 1;
+    }
+    emit(w, run, (size_t)(s - run));
+    emit_c(w, '"');
+}
+
+static bool same_double(double a, double b)
+{
+    double max_val = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return fabs(a - b) <= max_val * DBL_EPSILON;
+}
+
+// Mesma regra do cJSON (print_number + valueint do cJSON_CreateNumber)
+static void emit_number(json_writer_t *w, double d)
+{
+    char num[26];
+    int n;
+
+    if (isnan(d) || isinf(d)) {
+        n = snprintf(num, sizeof(num), "null");
+    } else {
+        int vi = (d >= INT_MAX) ? INT_MAX : (d <= (double)INT_MIN) ? INT_MIN : (int)d;
+        if (d == (double)vi) {
+            n = snprintf(num, sizeof(num), "%d", vi);
+        } else {
+            double test = 0.0;
+            n = snprintf(num, sizeof(num), "%1.15g", d);
+            if (sscanf(num, "%lg", &test) != 1 || !same_double(test, d)) {
+                n = snprintf(num, sizeof(num), "%1.17g", d);
+            }
+        }
+    }
+    if (n > 0) emit(w, num, (size_t)n);
+}
+
+// Vírgula (se não for o primeiro item do nível) + "chave":
+static void begin_item(json_writer_t *w, const char *key)
+{
+    uint32_t bit = 1u << w->depth;
+    if (w->first & bit) w->first &= ~bit;
+    else                emit_c(w, ',');
+
+    if (key) {
+        emit_string(w, key);
+        emit_c(w, ':');
+    }
+}
+
+static void open_level(json_writer_t *w, const char *key, char c)
+{
+    begin_item(w, key);
+    emit_c(w, c);
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->err = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth++;
+    w->first |= 1u << w->depth;
+}
+
+static void close_level(json_writer_t *w, char c)
+{
+    if (w->depth > 0) w->depth--;
+    emit_c(w, c);
+}
+
+void jw_init(json_writer_t *w, char *buf, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf   = buf;
+    w->cap   = cap;
+    w->err   = ESP_OK;
+    w->first = 1u;   // nível 0 (raiz) sem vírgula
+    if (buf && cap) buf[0] = '\0';
+    if (buf && !cap) w->err = ESP_ERR_INVALID_ARG;   // sem espaço nem para o '\0'
+}
+
+void jw_init_sink(json_writer_t *w, json_writer_sink_t sink, void *ctx,
+                  char *scratch, size_t scratch_cap)
+{
+    jw_init(w, scratch, scratch_cap);
+    w->sink     = sink;
+    w->sink_ctx = ctx;
+    if (!sink || !scratch || scratch_cap == 0) w->err = ESP_ERR_INVALID_ARG;
+}
+
+void jw_obj_begin(json_writer_t *w, const char *key) { open_level(w, key, '{'); }
+void jw_obj_end(json_writer_t *w)                    { close_level(w, '}'); }
+void jw_arr_begin(json_writer_t *w, const char *key) { open_level(w, key, '['); }
+void jw_arr_end(json_writer_t *w)                    { close_level(w, ']'); }
+
+void jw_str(json_writer_t *w, const char *key, const char *value)
+{
+    if (!value) return;
+    begin_item(w, key);
+    emit_string(w, value);
+}
+
+void jw_num(json_writer_t *w, const char *key, double value)
+{
+    begin_item(w, key);
+    emit_number(w, value);
+}
+
+void jw_mark(const json_writer_t *w, json_writer_mark_t *m)
+{
+    m->len   = w->len;
+    m->depth = w->depth;
+    m->first = w->first;
+}
+
+void jw_rewind(json_writer_t *w, const json_writer_mark_t *m)
+{
+    if (w->sink) return;   // o que já foi entregue ao sink não volta
+    w->len      = m->len;
+    w->depth    = m->depth;
+    w->first    = m->first;
+    w->overflow = w->cap && w->len + 1 > w->cap;
+}
+
+esp_err_t jw_finish(json_writer_t *w, size_t *len_out)
+{
+    if (len_out) *len_out = w->len;
+
+    if (w->sink) {
+        if (w->err == ESP_OK && w->sink_fill > 0) {
+            w->err = w->sink(w->sink_ctx, w->buf, w->sink_fill);
+            w->sink_fill = 0;
+        }
+        return w->err;
+    }
+
+    if (w->err != ESP_OK) return w->err;
+    if (w->overflow) {
+        if (w->buf) w->buf[0] = '\0';
+        return ESP_ERR_NO_MEM;
+    }
+    if (w->buf) w->buf[w->len] = '\0';
+    return ESP_OK;
+}
@@ -0,0 +1,272 @@
+/*
+ * tls_cache.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "tls_cache.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "TLS/CACHE";
+
+typedef struct {
+    uint32_t          crc;
+    uint32_t          len;
+    uint32_t          refs;
+    mbedtls_x509_crt *crt;      // NULL = slot livre
+} ca_slot_t;
+
+static ca_slot_t         s_ca[TLS_CA_CACHE_SLOTS];
+static tls_cache_stats_t s_stats;
+
+// Tickets em RTC: cada slot tem CRC próprio (lixo no power-on é descartado)
+typedef struct {
+    uint32_t key;               // CRC32 de "host:porta" (0 = livre)
+    uint16_t len;
+    uint8_t  blob[TLS_TICKET_MAX];
+    uint32_t crc;
+} ticket_slot_t;
+
+RTC_DATA_ATTR static ticket_slot_t s_tickets[TLS_TICKET_SLOTS];
+RTC_DATA_ATTR static uint8_t       s_ticket_next;   // rodízio quando cheio
+
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_lock;
+static portMUX_TYPE      s_init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void lock(void)
+{
+    if (!s_lock) {
+        portENTER_CRITICAL(&s_init_mux);
+        if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+        portEXIT_CRITICAL(&s_init_mux);
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void) { xSemaphoreGive(s_lock); }
+
+static void ca_slot_free(ca_slot_t *s)
+{
+    mbedtls_x509_crt_free(s->crt);
+    free(s->crt);
+    memset(s, 0, sizeof(*s));
+}
+
+static uint8_t ca_count(void)
+{
+    uint8_t n = 0;
+    for (int i = 0; i < TLS_CA_CACHE_SLOTS; i++) {
+        if (s_ca[i].crt) n++;
+    }
+    return n;
+}
+
+mbedtls_x509_crt *tls_cache_ca_acquire(const char *pem, bool *was_cached)
+{
+    if (was_cached) *was_cached = false;
+    if (!pem || !pem[0]) return NULL;
+
+    // mbedtls exige o '\0' dentro do tamanho para PEM
+    size_t len = strlen(pem) + 1;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)pem, len);
+
+    lock();
+    ca_slot_t *free_slot = NULL;
+    for (int i = 0; i < TLS_CA_CACHE_SLOTS; i++) {
+        ca_slot_t *s = &s_ca[i];
+        if (s->crt && s->crc == crc && s->len == len) {
+            s->refs++;
+            s_stats.hits++;
+            unlock();
+            if (was_cached) *was_cached = true;
+            return s->crt;
+        }
+        // Prefere slot vazio; senão reaproveita uma CA que ninguém usa
+        if (!s->crt) {
+            if (!free_slot || free_slot->crt) free_slot = s;
+        } else if (s->refs == 0 && !free_slot) {
+            free_slot = s;
+        }
+    }
+    if (!free_slot) {
+        unlock();
+        ESP_LOGE(TAG, "Todos os %d slots de CA em uso", TLS_CA_CACHE_SLOTS);
+        return NULL;
+    }
+    if (free_slot->crt) ca_slot_free(free_slot);   // CA antiga sem uso (trocada no portal)
+
+    mbedtls_x509_crt *crt = calloc(1, sizeof(*crt));
+    if (!crt) {
+        unlock();
+        return NULL;
+    }
+    mbedtls_x509_crt_init(crt);
+
+    uint64_t t0 = esp_timer_get_time();
+    int ret = mbedtls_x509_crt_parse(crt, (const unsigned char *)pem, len);
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - t0) / 1000ULL);
+
+    if (ret < 0) {
+        ESP_LOGE(TAG, "Falha ao parsear CA: -0x%04x", (unsigned)-ret);
+        mbedtls_x509_crt_free(crt);
+        free(crt);
+        unlock();
+        return NULL;
+    }
+
+    free_slot->crc  = crc;
+    free_slot->len  = (uint32_t)len;
+    free_slot->refs = 1;
+    free_slot->crt  = crt;
+    s_stats.parses++;
+    s_stats.parse_ms_last = ms;
+    s_stats.cached = ca_count();
+    ESP_LOGI(TAG, "CA parseada em %ums (crc=0x%08x, %u no cache)",
+             (unsigned)ms, (unsigned)crc, (unsigned)s_stats.cached);
+    unlock();
+    return crt;
+}
+
+void tls_cache_ca_release(mbedtls_x509_crt *ca)
+{
+    if (!ca) return;
+    lock();
+    for (int i = 0; i < TLS_CA_CACHE_SLOTS; i++) {
+        if (s_ca[i].crt == ca && s_ca[i].refs > 0) {
+            s_ca[i].refs--;
+            break;
+        }
+    }
+    unlock();
+}
+
+void tls_cache_flush(void)
+{
+    lock();
+    for (int i = 0; i < TLS_CA_CACHE_SLOTS; i++) {
+        if (s_ca[i].crt && s_ca[i].refs == 0) ca_slot_free(&s_ca[i]);
+    }
+    s_stats.cached = ca_count();
+    unlock();
+}
+
+// ----------------------------- Tickets -----------------------------
+
+static uint32_t ticket_key(const char *host, int port)
+{
+    char buf[80];
+    int n = snprintf(buf, sizeof(buf), "%s:%d", host, port);
+    if (n < 0) return 0;
+    if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+    uint32_t k = esp_rom_crc32_le(0, (const uint8_t *)buf, (uint32_t)n);
+    return k ? k : 1;   // 0 marca slot livre
+}
+
+static uint32_t ticket_crc(const ticket_slot_t *t)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)t, offsetof(ticket_slot_t, crc));
+}
+
+static ticket_slot_t *ticket_find(uint32_t key)
+{
+    for (int i = 0; i < TLS_TICKET_SLOTS; i++) {
+        ticket_slot_t *t = &s_tickets[i];
+        if (t->key == key && t->len <= TLS_TICKET_MAX && t->crc == ticket_crc(t)) return t;
+    }
+    return NULL;
+}
+
+bool tls_cache_ticket_load(const char *host, int port, mbedtls_ssl_session *out)
+{
+    if (!host || !host[0] || !out) return false;
+    uint32_t key = ticket_key(host, port);
+
+    lock();
+    ticket_slot_t *t = ticket_find(key);
+    bool ok = false;
+    if (t) {
+        int ret = mbedtls_ssl_session_load(out, t->blob, t->len);
+        if (ret == 0) {
+            ok = true;
+            s_stats.ticket_loads++;
+        } else {
+            // Formato de outra versão do mbedtls (OTA) ou corrompido
+            ESP_LOGW(TAG, "Ticket de %s:%d inválido (-0x%04x)", host, port, (unsigned)-ret);
+            memset(t, 0, sizeof(*t));
+        }
+    }
+    unlock();
+    return ok;
+}
+
+void tls_cache_ticket_save(const char *host, int port, const mbedtls_ssl_context *ssl)
+{
+    if (!host || !host[0] || !ssl) return;
+
+    mbedtls_ssl_session sess;
+    mbedtls_ssl_session_init(&sess);
+    if (mbedtls_ssl_get_session(ssl, &sess) != 0) {
+        mbedtls_ssl_session_free(&sess);
+        return;
+    }
+
+    uint32_t key = ticket_key(host, port);
+    lock();
+    ticket_slot_t *t = ticket_find(key);
+    if (!t) {
+        for (int i = 0; i < TLS_TICKET_SLOTS && !t; i++) {
+            if (s_tickets[i].key == 0 || s_tickets[i].crc != ticket_crc(&s_tickets[i])) {
+                t = &s_tickets[i];
+            }
+        }
+        if (!t) {
+            t = &s_tickets[s_ticket_next % TLS_TICKET_SLOTS];
+            s_ticket_next = (uint8_t)((s_ticket_next + 1) % TLS_TICKET_SLOTS);
+        }
+    }
+
+    size_t olen = 0;
+    int ret = mbedtls_ssl_session_save(&sess, t->blob, sizeof(t->blob), &olen);
+    if (ret == 0) {
+        t->key = key;
+        t->len = (uint16_t)olen;
+        t->crc = ticket_crc(t);
+        s_stats.ticket_saves++;
+        ESP_LOGD(TAG, "Ticket de %s:%d salvo (%u B)", host, port, (unsigned)olen);
+    } else {
+        // Sessão maior que o slot (ex.: KEEP_PEER_CERTIFICATE ligado)
+        ESP_LOGW(TAG, "Sessão de %s:%d não cabe no slot (-0x%04x)", host, port, (unsigned)-ret);
+        memset(t, 0, sizeof(*t));
+    }
+    unlock();
+    mbedtls_ssl_session_free(&sess);
+}
+
+void tls_cache_ticket_forget(const char *host, int port)
+{
+    if (!host || !host[0]) return;
+    lock();
+    ticket_slot_t *t = ticket_find(ticket_key(host, port));
+    if (t) memset(t, 0, sizeof(*t));
+    unlock();
+}
+
+void tls_cache_get_stats(tls_cache_stats_t *out)
+{
+    if (!out) return;
+    lock();
+    *out = s_stats;
+    unlock();
+}
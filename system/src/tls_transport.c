@@ -0,0 +1,322 @@
+/*
+ * tls_transport.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#include "tls_transport.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "tls_cache.h"
+
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
+
+static const char *TAG = "TLS/TR";
+
+#define TLS_TR_DEFAULT_PORT  443
+
+typedef struct {
+    mbedtls_ssl_config    conf;
+    mbedtls_ssl_context   ssl;
+    mbedtls_net_context   net;
+    mbedtls_x509_crt     *ca;         // referência do tls_cache (NULL => bundle)
+    bool                  ssl_ready;  // 'ssl' inicializado (conexão aberta)
+    char                  host[64];
+    char                  server_name[64];   // SNI/CN se o host do connect for um IP
+    int                   port;
+    tls_transport_stats_t stats;
+} tls_tr_ctx_t;
+
+static int tls_rng(void *arg, unsigned char *buf, size_t len)
+{
+    (void)arg;
+    esp_fill_random(buf, len);   // RNG de hardware (RF ligado durante o envio)
+    return 0;
+}
+
+static void set_timeouts(int fd, int timeout_ms)
+{
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+// connect() não bloqueante com prazo; devolve o socket já bloqueante
+static int tcp_connect(const char *host, int port, int timeout_ms)
+{
+    char port_s[8];
+    snprintf(port_s, sizeof(port_s), "%d", port);
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, port_s, &hints, &res) != 0 || !res) {
+        ESP_LOGE(TAG, "DNS falhou para %s", host);
+        return -1;
+    }
+
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+    int fl = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+
+    int ret = connect(fd, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (ret < 0 && errno != EINPROGRESS) goto fail;
+
+    if (ret < 0) {
+        fd_set wset;
+        FD_ZERO(&wset);
+        FD_SET(fd, &wset);
+        struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+        if (select(fd + 1, NULL, &wset, NULL, &tv) <= 0) goto fail;
+        int so_err = 0;
+        socklen_t sl = sizeof(so_err);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_err, &sl) < 0 || so_err != 0) goto fail;
+    }
+
+    fcntl(fd, F_SETFL, fl & ~O_NONBLOCK);
+    set_timeouts(fd, timeout_ms);
+    return fd;
+
+fail:
+    ESP_LOGE(TAG, "TCP %s:%d falhou (errno=%d)", host, port, errno);
+    close(fd);
+    return -1;
+}
+
+static int tr_close(esp_transport_handle_t t)
+{
+    tls_tr_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (!ctx) return 0;
+    if (ctx->ssl_ready) {
+        mbedtls_ssl_close_notify(&ctx->ssl);
+        mbedtls_ssl_free(&ctx->ssl);
+        ctx->ssl_ready = false;
+    }
+    mbedtls_net_free(&ctx->net);   // fecha o socket (fd = -1)
+    return 0;
+}
+
+static int tr_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    tls_tr_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (!ctx || !host || !host[0]) return -1;
+    tr_close(t);
+
+    if (port <= 0) port = TLS_TR_DEFAULT_PORT;
+    if (timeout_ms <= 0) timeout_ms = 10000;
+    snprintf(ctx->host, sizeof(ctx->host), "%s", host);
+    ctx->port = port;
+
+    uint64_t t0 = esp_timer_get_time();
+    int fd = tcp_connect(host, port, timeout_ms);
+    if (fd < 0) return -1;
+    ctx->net.fd = fd;
+
+    // Daqui em diante vale o nome do servidor (o ticket também é por nome)
+    const char *name = ctx->server_name[0] ? ctx->server_name : host;
+
+    mbedtls_ssl_init(&ctx->ssl);
+    ctx->ssl_ready = true;
+    int ret = mbedtls_ssl_setup(&ctx->ssl, &ctx->conf);
+    if (ret == 0) ret = mbedtls_ssl_set_hostname(&ctx->ssl, name);   // SNI + CN
+    if (ret != 0) {
+        ESP_LOGE(TAG, "ssl_setup: -0x%04x", (unsigned)-ret);
+        tr_close(t);
+        return -1;
+    }
+    mbedtls_ssl_set_bio(&ctx->ssl, &ctx->net, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    // Ticket da ativação anterior (RTC) => handshake abreviado
+    mbedtls_ssl_session sess;
+    mbedtls_ssl_session_init(&sess);
+    ctx->stats.ticket_offered = tls_cache_ticket_load(name, port, &sess) &&
+                                mbedtls_ssl_set_session(&ctx->ssl, &sess) == 0;
+    mbedtls_ssl_session_free(&sess);
+
+    while ((ret = mbedtls_ssl_handshake(&ctx->ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) break;
+    }
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Handshake %s:%d falhou: -0x%04x (flags=0x%x)", name, port,
+                 (unsigned)-ret, (unsigned)mbedtls_ssl_get_verify_result(&ctx->ssl));
+        // Ticket recusado de um jeito que derruba o handshake: próxima vez, completo
+        if (ctx->stats.ticket_offered) tls_cache_ticket_forget(name, port);
+        tr_close(t);
+        return -1;
+    }
+
+    ctx->stats.handshakes++;
+    ctx->stats.handshake_ms_last = (uint32_t)((esp_timer_get_time() - t0) / 1000ULL);
+    tls_cache_ticket_save(name, port, &ctx->ssl);
+    ESP_LOGI(TAG, "TLS %s:%d em %ums (ticket %s)", name, port,
+             (unsigned)ctx->stats.handshake_ms_last,
+             ctx->stats.ticket_offered ? "oferecido" : "ausente");
+    return 0;
+}
+
+static int tr_poll(tls_tr_ctx_t *ctx, bool rd, int timeout_ms)
+{
+    if (!ctx->ssl_ready || ctx->net.fd < 0) return -1;
+    if (rd && mbedtls_ssl_get_bytes_avail(&ctx->ssl) > 0) return 1;
+
+    fd_set set, eset;
+    FD_ZERO(&set);
+    FD_ZERO(&eset);
+    FD_SET(ctx->net.fd, &set);
+    FD_SET(ctx->net.fd, &eset);
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    int ret = select(ctx->net.fd + 1, rd ? &set : NULL, rd ? NULL : &set, &eset,
+                     timeout_ms < 0 ? NULL : &tv);
+    if (ret > 0 && FD_ISSET(ctx->net.fd, &eset)) return -1;
+    return ret;
+}
+
+static int tr_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    return tr_poll(esp_transport_get_context_data(t), true, timeout_ms);
+}
+
+static int tr_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    return tr_poll(esp_transport_get_context_data(t), false, timeout_ms);
+}
+
+static int tr_read(esp_transport_handle_t t, char *buf, int len, int timeout_ms)
+{
+    tls_tr_ctx_t *ctx = esp_transport_get_context_data(t);
+    int p = tr_poll(ctx, true, timeout_ms);
+    if (p <= 0) return p;   // 0 = sem dado no prazo
+
+    int ret = mbedtls_ssl_read(&ctx->ssl, (unsigned char *)buf, (size_t)len);
+    if (ret > 0) return ret;
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) return 0;
+    if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    ESP_LOGW(TAG, "ssl_read: -0x%04x", (unsigned)-ret);
+    return -1;
+}
+
+static int tr_write(esp_transport_handle_t t, const char *buf, int len, int timeout_ms)
+{
+    tls_tr_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (!ctx->ssl_ready) return -1;
+
+    int done = 0;
+    while (done < len) {
+        int ret = mbedtls_ssl_write(&ctx->ssl, (const unsigned char *)buf + done, (size_t)(len - done));
+        if (ret > 0) {
+            done += ret;
+        } else if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) {
+            if (tr_poll(ctx, false, timeout_ms) <= 0) break;
+        } else {
+            ESP_LOGW(TAG, "ssl_write: -0x%04x", (unsigned)-ret);
+            return -1;
+        }
+    }
+    return done;
+}
+
+static int tr_destroy(esp_transport_handle_t t)
+{
+    tls_tr_ctx_t *ctx = esp_transport_get_context_data(t);
+    if (!ctx) return 0;
+    tr_close(t);
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+    if (!ctx->ca) esp_crt_bundle_detach(&ctx->conf);
+#endif
+    mbedtls_ssl_config_free(&ctx->conf);
+    tls_cache_ca_release(ctx->ca);
+    free(ctx);
+    esp_transport_set_context_data(t, NULL);
+    return 0;
+}
+
+esp_transport_handle_t tls_transport_new(const char *ca_pem)
+{
+    tls_tr_ctx_t *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) return NULL;
+    mbedtls_net_init(&ctx->net);
+    mbedtls_ssl_config_init(&ctx->conf);
+
+    int ret = mbedtls_ssl_config_defaults(&ctx->conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) goto fail;
+    mbedtls_ssl_conf_rng(&ctx->conf, tls_rng, NULL);
+    mbedtls_ssl_conf_authmode(&ctx->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&ctx->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    if (ca_pem && ca_pem[0]) {
+        // Cadeia compartilhada por referência: outro cliente trocar a CA dele
+        // não libera esta.
+        ctx->ca = tls_cache_ca_acquire(ca_pem, &ctx->stats.ca_cached);
+        if (!ctx->ca) goto fail;
+        mbedtls_ssl_conf_ca_chain(&ctx->conf, ctx->ca, NULL);
+    } else {
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+        if (esp_crt_bundle_attach(&ctx->conf) != ESP_OK) goto fail;
+#else
+        ESP_LOGE(TAG, "Sem CA e sem bundle: não há como verificar o servidor");
+        goto fail;
+#endif
+    }
+
+    esp_transport_handle_t t = esp_transport_init();
+    if (!t) {
+#if CONFIG_MBEDTLS_CERTIFICATE_BUNDLE
+        if (!ctx->ca) esp_crt_bundle_detach(&ctx->conf);
+#endif
+        goto fail;
+    }
+    esp_transport_set_context_data(t, ctx);
+    esp_transport_set_default_port(t, TLS_TR_DEFAULT_PORT);
+    esp_transport_set_func(t, tr_connect, tr_read, tr_write, tr_close,
+                           tr_poll_read, tr_poll_write, tr_destroy);
+    return t;
+
+fail:
+    ESP_LOGE(TAG, "Falha ao criar transporte TLS");
+    mbedtls_ssl_config_free(&ctx->conf);
+    tls_cache_ca_release(ctx->ca);
+    free(ctx);
+    return NULL;
+}
+
+void tls_transport_set_server_name(esp_transport_handle_t t, const char *name)
+{
+    tls_tr_ctx_t *ctx = t ? esp_transport_get_context_data(t) : NULL;
+    if (!ctx) return;
+    snprintf(ctx->server_name, sizeof(ctx->server_name), "%s", name ? name : "");
+}
+
+void tls_transport_get_stats(esp_transport_handle_t t, tls_transport_stats_t *out)
+{
+    if (!out) return;
+    tls_tr_ctx_t *ctx = t ? esp_transport_get_context_data(t) : NULL;
+    if (!ctx) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = ctx->stats;
+}
@@ -0,0 +1,284 @@
+# tools/fieldbus_host_bench.py
+#
+# Benchmark do fieldbus do firmware no PC: rs485_central.c, energy_meter.c,
+# os drivers JSY/XY, modbus_rtu_master.c + modbus_rtu_lite.c,
+# modbus_guard_session.c, modbus_block_plan.c e modbus_dev_profile.c são
+# compilados como estão, com UART/FreeRTOS/SD/cadastro de tools/host, e
+# leem os medidores simulados do modbus_sim.py por um pty.
+#
+# Cada ciclo chama rs485_central_poll_and_save() (o mesmo do firmware) e
+# relata tempo de barramento por ciclo, retentativas de FC, timeouts e
+# tempo perdido esperando timeout, leituras puladas pelo backoff e linhas
+# que iriam para o SD. O "bench" do modbus_sim.py roda a mesma política
+# reescrita em Python; este roda o código C.
+#
+# Uso:
+#   python fieldbus_host_bench.py --meters 8 --dead 2 --cycles 20
+#   python fieldbus_host_bench.py --meters 8 --dead 1 --drop 0.1 --latency 40
+#   python fieldbus_host_bench.py --check       (invariantes da política; sai != 0 se falhar)
+#
+# Requer um compilador C ($CC ou cc). Sem dependências além da biblioteca
+# padrão (Linux/macOS: pty + termios).
+import argparse
+import ctypes
+import os
+import random
+import statistics
+import sys
+import tempfile
+import threading
+import time
+
+from host import hostbuild
+import modbus_sim as sim
+
+FIELDBUS = "connectivity/fieldbus"
+SOURCES = [
+    FIELDBUS + "/buses/RS485/src/rs485_central.c",
+    FIELDBUS + "/buses/RS485/src/rs485_registry.c",
+    FIELDBUS + "/buses/RS485/src/rs485_registry_adapter.c",
+    "peripherals/energy/src/energy_meter.c",
+    FIELDBUS + "/driver/JSY-MK-333/src/energy_jsy_mk_333_driver.c",
+    FIELDBUS + "/driver/XY_MD02/src/xy_md02_driver.c",
+    FIELDBUS + "/protocols/modbus/src/modbus_rtu_master.c",
+    FIELDBUS + "/protocols/modbus/src/modbus_rtu_lite.c",
+    FIELDBUS + "/protocols/modbus/src/modbus_guard_session.c",
+    FIELDBUS + "/protocols/modbus/src/modbus_block_plan.c",
+    FIELDBUS + "/protocols/modbus/src/modbus_dev_profile.c",
+    "tools/host/host_uart.c",
+    "tools/host/host_rtos.c",
+    "tools/host/host_datalogger.c",
+]
+INCLUDES = [
+    FIELDBUS + "/protocols/modbus/include",
+    FIELDBUS + "/buses/RS485/include",
+    FIELDBUS + "/driver/JSY-MK-333/include",
+    FIELDBUS + "/driver/XY_MD02/include",
+    "peripherals/energy/include",
+    "connectivity/services/log_mux/include",
+]
+
+MB_PROF_MAX_DEVICES = 16
+MB_PROF_RTT_SAMPLES = 8
+FIRST_CHANNEL = 3
+
+
+class SensorMap(ctypes.Structure):
+    # espelho de sensor_map_t (datalogger_driver.h)
+    _fields_ = [("channel", ctypes.c_uint8), ("address", ctypes.c_uint8),
+                ("type", ctypes.c_char * 16), ("subtype", ctypes.c_char * 16)]
+
+
+class RtuStats(ctypes.Structure):
+    # espelho de mb_rtu_stats_t (modbus_rtu_lite.h)
+    _fields_ = [(n, ctypes.c_uint32) for n in
+                ("transactions", "ok", "timeouts", "crc_errors", "bad_frames", "exceptions",
+                 "timeout_wait_ms")] + \
+               [(n, ctypes.c_uint16) for n in ("latency_last_ms", "latency_avg_ms", "latency_max_ms")]
+
+
+class DevProfile(ctypes.Structure):
+    # espelho de mb_dev_profile_t (modbus_dev_profile.h)
+    _fields_ = [("addr", ctypes.c_uint8), ("used_fc", ctypes.c_uint8),
+                ("fail_streak", ctypes.c_uint8),
+                ("last_latency_ms", ctypes.c_uint16), ("srtt_ms", ctypes.c_uint16),
+                ("rttvar_ms", ctypes.c_uint16), ("rtt_hist", ctypes.c_uint16 * MB_PROF_RTT_SAMPLES),
+                ("hist_pos", ctypes.c_uint8), ("hist_n", ctypes.c_uint8),
+                ("skip_level", ctypes.c_uint8), ("skip_left", ctypes.c_uint8),
+                ("flags", ctypes.c_uint8),
+                ("ok_total", ctypes.c_uint32), ("fail_total", ctypes.c_uint32),
+                ("skipped_total", ctypes.c_uint32), ("last_used", ctypes.c_uint32)]
+
+
+def load(verbose=False):
+    prof_dir = tempfile.mkdtemp(prefix="mb_prof_")
+    lib = hostbuild.build(
+        "fieldbus", SOURCES, include_dirs=INCLUDES,
+        defines={"MB_PROF_FILE": '"%s/rs485_prof.bin"' % prof_dir,
+                 "MB_PROF_FILE_TMP": '"%s/rs485_prof.tmp"' % prof_dir},
+        verbose=verbose)
+    lib.host_uart_attach.argtypes = [ctypes.c_int]
+    lib.host_rs485_set_config.argtypes = [ctypes.POINTER(SensorMap), ctypes.c_size_t]
+    lib.host_record_count.restype = ctypes.c_size_t
+    lib.host_record_get.restype = ctypes.c_char_p
+    lib.host_record_get.argtypes = [ctypes.c_size_t]
+    lib.rs485_central_poll_and_save.argtypes = [ctypes.c_uint32]
+    lib.mb_rtu_get_stats.argtypes = [ctypes.POINTER(RtuStats)]
+    lib.mb_prof_snapshot.restype = ctypes.c_size_t
+    lib.mb_prof_snapshot.argtypes = [ctypes.POINTER(DevProfile), ctypes.c_size_t]
+    lib.host_log_level = ctypes.c_int.in_dll(lib, "host_log_level")
+    if verbose:
+        lib.host_log_level.value = 3
+    return lib
+
+
+def make_slaves(args):
+    rng = random.Random(args.seed)
+    n_dead = min(args.dead, args.meters)
+    slaves = []
+    for i in range(args.meters):
+        dead = i >= args.meters - n_dead
+        fcs = (0x04,) if (args.fc4_every and (i % args.fc4_every) == args.fc4_every - 1) else (0x03,)
+        slaves.append(sim.Slave(i + 1, "dead" if dead else "jsy", lat=args.latency, jitter=args.jitter,
+                                drop=args.drop, fcs=fcs, rng=random.Random(rng.random())))
+    return slaves
+
+
+def set_config(lib, slaves):
+    arr = (SensorMap * len(slaves))()
+    for i, s in enumerate(slaves):
+        arr[i] = SensorMap(channel=FIRST_CHANNEL + i, address=s.addr,
+                           type=b"energia", subtype=b"trifasico")
+    lib.host_rs485_set_config(arr, len(slaves))
+
+
+def snapshot(lib):
+    out = (DevProfile * MB_PROF_MAX_DEVICES)()
+    n = lib.mb_prof_snapshot(out, MB_PROF_MAX_DEVICES)
+    return {out[i].addr: out[i] for i in range(n)}
+
+
+def stats(lib):
+    st = RtuStats()
+    lib.mb_rtu_get_stats(ctypes.byref(st))
+    return st
+
+
+def run_cycles(lib, slaves, args):
+    """Roda os ciclos; devolve a lista de resultados por ciclo."""
+    mfd, sfd = os.openpty()
+    sim.set_raw(mfd)
+    sim.set_raw(sfd)
+    bus = sim.SimBus(sfd, slaves, args.baud)
+    th = threading.Thread(target=bus.serve_forever, daemon=True)
+    th.start()
+    lib.host_uart_attach(mfd)
+    set_config(lib, slaves)
+
+    cycles = []
+    try:
+        # 1º init do boot faz o ping de diagnóstico (addr 1); fica fora da medida
+        lib.modbus_master_init()
+        lib.modbus_master_deinit()
+        base = snapshot(lib)
+        for c in range(args.cycles):
+            st0 = stats(lib)
+            rec0 = lib.host_record_count()
+            t0 = time.monotonic()
+            lib.rs485_central_poll_and_save(args.budget)
+            ms = (time.monotonic() - t0) * 1000
+            st1 = stats(lib)
+            rows = [lib.host_record_get(i).decode() for i in range(rec0, lib.host_record_count())]
+            cyc = {
+                "ms": ms,
+                "requests": st1.transactions - st0.transactions,
+                "ok": st1.ok - st0.ok,
+                "timeouts": st1.timeouts - st0.timeouts,
+                "waste_ms": st1.timeout_wait_ms - st0.timeout_wait_ms,
+                "exceptions": st1.exceptions - st0.exceptions,
+                "crc": st1.crc_errors - st0.crc_errors,
+                "rows": rows,
+                "meters_saved": len({r.split("=")[0].split(".")[0] for r in rows}),
+            }
+            cycles.append(cyc)
+            if args.verbose:
+                print("ciclo %3d: %7.1f ms  %2d pedido(s), %d timeout(s), %d medidor(es) gravado(s)"
+                      % (c + 1, ms, cyc["requests"], cyc["timeouts"], cyc["meters_saved"]))
+    finally:
+        bus.stop.set()
+        th.join(timeout=1)
+        os.close(mfd)
+        os.close(sfd)
+    return cycles, base
+
+
+def run_bench(args):
+    lib = load(args.verbose)
+    slaves = make_slaves(args)
+    n_dead = sum(1 for s in slaves if s.dead)
+    cycles, base = run_cycles(lib, slaves, args)
+    profs = snapshot(lib)
+
+    ms = [c["ms"] for c in cycles]
+    p95 = sorted(ms)[int(0.95 * (len(ms) - 1))]
+    reads_ok = sum(c["meters_saved"] for c in cycles)
+    requests = sum(c["requests"] for c in cycles)
+    fails = sum(p.fail_total - (base[a].fail_total if a in base else 0) for a, p in profs.items())
+    skipped = sum(p.skipped_total for p in profs.values())
+    timeouts = sum(c["timeouts"] for c in cycles)
+    waste = sum(c["waste_ms"] for c in cycles)
+    print("firmware (rs485_central.c) | %d medidor(es), %d morto(s), perda %.0f%%, latência %.0f±%.0f ms, %d bps"
+          % (args.meters, n_dead, args.drop * 100, args.latency, args.jitter, args.baud))
+    print("ciclos: %d | barramento por ciclo: média %.1f ms, p95 %.1f ms, máx %.1f ms"
+          % (len(ms), statistics.mean(ms), p95, max(ms)))
+    print("leituras: %d ok, %d falha(s), %d retentativa(s) de FC, %d pulada(s) em backoff, %d linha(s) p/ SD"
+          % (reads_ok, fails, requests - reads_ok - fails, skipped, sum(len(c["rows"]) for c in cycles)))
+    print("timeouts: %d | tempo perdido em timeout: %d ms (%.1f ms/ciclo) | CRC: %d, exceções: %d"
+          % (timeouts, waste, waste / len(cycles), sum(c["crc"] for c in cycles),
+             sum(c["exceptions"] for c in cycles)))
+    return 0
+
+
+def run_check(args):
+    """Invariantes da política do firmware contra o simulador."""
+    ok = True
+
+    def check(name, good):
+        nonlocal ok
+        ok &= bool(good)
+        print("%-58s %s" % (name, "OK" if good else "FALHOU"))
+
+    args.meters, args.dead, args.drop, args.cycles = 4, 1, 0.0, 12
+    args.latency, args.jitter, args.fc4_every = 10.0, 2.0, 2
+    lib = load(args.verbose)
+    slaves = make_slaves(args)
+    cycles, _ = run_cycles(lib, slaves, args)
+    profs = snapshot(lib)
+    live = [s for s in slaves if not s.dead]
+    dead = [s for s in slaves if s.dead][0]
+
+    check("todo medidor vivo gravado em todo ciclo",
+          all(c["meters_saved"] == len(live) for c in cycles))
+    ch = [r.split("=") for r in cycles[0]["rows"] if r.startswith("%d." % FIRST_CHANNEL)]
+    check("trifásico grava canal.1..3 com as correntes do JSY (/100)",
+          sorted(k for k, _ in ch) == ["%d.%d" % (FIRST_CHANNEL, i) for i in (1, 2, 3)]
+          and all(4.0 < float(v) < 6.0 and len(v.split(".")[1]) == 3 for _, v in ch))
+    check("FC04 aprendida pelo medidor que só aceita FC04",
+          profs[2].used_fc == 0x04 and profs[1].used_fc == 0x03)
+    check("depois do 1º ciclo, sem retentativa de FC nos vivos",
+          all(c["exceptions"] == 0 for c in cycles[1:]))
+    check("morto entra em backoff (%d ciclo(s) pulado(s))" % profs[dead.addr].skipped_total,
+          profs[dead.addr].skip_level > 0 and profs[dead.addr].skipped_total > 0)
+    idle = [c for c in cycles if c["timeouts"] == 0]
+    check("ciclos em que o morto é pulado não esperam timeout (%d)" % len(idle),
+          len(idle) == profs[dead.addr].skipped_total)
+    check("ciclo sem o morto fica abaixo de 150 ms (%.0f ms)" % min(c["ms"] for c in cycles),
+          min(c["ms"] for c in cycles) < 150)
+    check("timeout adaptado dos vivos (srtt %d ms)" % profs[1].srtt_ms,
+          profs[1].hist_n == MB_PROF_RTT_SAMPLES and 0 < profs[1].srtt_ms < 60)
+    check("todo ciclo dentro do orçamento", all(c["ms"] < args.budget for c in cycles))
+    return 0 if ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Benchmark do fieldbus do firmware contra o simulador")
+    ap.add_argument("--check", action="store_true", help="confere as invariantes da política")
+    ap.add_argument("--meters", type=int, default=8)
+    ap.add_argument("--dead", type=int, default=1, help="quantos medidores (os últimos) não respondem")
+    ap.add_argument("--drop", type=float, default=0.0, help="probabilidade de perder cada resposta")
+    ap.add_argument("--latency", type=float, default=15.0, help="processamento do escravo (ms)")
+    ap.add_argument("--jitter", type=float, default=5.0)
+    ap.add_argument("--fc4-every", type=int, default=0, help="1 a cada N medidores só aceita FC04")
+    ap.add_argument("--cycles", type=int, default=20)
+    ap.add_argument("--budget", type=int, default=sim.CYCLE_BUDGET_MS, help="orçamento do ciclo (ms)")
+    ap.add_argument("--baud", type=int, default=9600)
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args()
+    if args.meters + FIRST_CHANNEL - 1 > 13 or args.meters > 10:
+        ap.error("no máximo 10 medidores (RS485_MAX_SENSORS, canais 3..13)")
+    return run_check(args) if args.check else run_bench(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,127 @@
+/*
+ * host_datalogger.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Cadastro RS-485, dicas de FC, lote do SD e modelos JSON do datalogger
+ * para o PC. O teste define o cadastro com host_rs485_set_config() e lê as
+ * linhas que iriam para o SD com host_record_get().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "datalogger_driver.h"
+#include "sdmmc_driver.h"
+#include "rs485_model.h"
+
+#define HOST_MAX_RECORDS 4096
+
+static sensor_map_t s_map[RS485_MAX_SENSORS];
+static size_t       s_map_n;
+static uint8_t      s_hint[248];
+
+static char   s_rec[HOST_MAX_RECORDS][32];   // "canal[.sub]=valor"
+static size_t s_rec_n;
+
+void host_rs485_set_config(const sensor_map_t *map, size_t count)
+{
+    if (count > RS485_MAX_SENSORS) count = RS485_MAX_SENSORS;
+    memcpy(s_map, map, count * sizeof(*map));
+    s_map_n = count;
+}
+
+size_t host_record_count(void) { return s_rec_n; }
+
+const char *host_record_get(size_t i) { return i < s_rec_n ? s_rec[i] : NULL; }
+
+void host_record_clear(void) { s_rec_n = 0; }
+
+/* ---------------- datalogger_driver.h ---------------- */
+
+esp_err_t save_rs485_config(const sensor_map_t *map, size_t count)
+{
+    host_rs485_set_config(map, count);
+    return ESP_OK;
+}
+
+esp_err_t load_rs485_config(sensor_map_t *map, size_t *count)
+{
+    if (!map || !count) return ESP_ERR_INVALID_ARG;
+    memcpy(map, s_map, s_map_n * sizeof(*map));
+    *count = s_map_n;
+    return ESP_OK;
+}
+
+esp_err_t rs485_hint_get_used_fc(uint8_t addr, uint8_t *out_fc)
+{
+    if (!out_fc || addr == 0 || addr > 247) return ESP_ERR_INVALID_ARG;
+    *out_fc = s_hint[addr];
+    return s_hint[addr] ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t rs485_hint_set_used_fc(uint8_t addr, uint8_t used_fc)
+{
+    if (addr == 0 || addr > 247) return ESP_ERR_INVALID_ARG;
+    s_hint[addr] = used_fc;
+    return ESP_OK;
+}
+
+/* ---------------- sdmmc_driver.h ---------------- */
+
+esp_err_t save_record_sd_rs485(int channel, int subindex, const char *value_str)
+{
+    if (!value_str) return ESP_ERR_INVALID_ARG;
+    if (s_rec_n >= HOST_MAX_RECORDS) return ESP_ERR_NO_MEM;
+    if (subindex > 0) snprintf(s_rec[s_rec_n], sizeof(s_rec[0]), "%d.%d=%s", channel, subindex, value_str);
+    else              snprintf(s_rec[s_rec_n], sizeof(s_rec[0]), "%d=%s", channel, value_str);
+    s_rec_n++;
+    return ESP_OK;
+}
+
+esp_err_t record_batch_begin(void)  { return ESP_OK; }
+esp_err_t record_batch_commit(void) { return ESP_OK; }
+
+esp_err_t record_batch_add(int channel, int subindex, const char *value_str)
+{
+    return save_record_sd_rs485(channel, subindex, value_str);
+}
+
+/* ---------------- rs485_model.h ----------------
+ * Sem LittleFS/cJSON no PC: nenhum modelo JSON cadastrado, todo escravo
+ * segue pelo driver nativo (JSY/XY). */
+
+esp_err_t rs485_models_load(void) { return ESP_OK; }
+size_t    rs485_models_count(void) { return 0; }
+
+int rs485_model_find(uint8_t addr, rs485_type_t type, rs485_subtype_t subtype)
+{
+    (void)addr; (void)type; (void)subtype;
+    return -1;
+}
+
+esp_err_t rs485_model_get(int idx, rs485_model_t *out)
+{
+    (void)idx; (void)out;
+    return ESP_ERR_NOT_FOUND;
+}
+
+int rs485_model_read(int idx, uint8_t addr, uint16_t channel,
+                     rs485_measurement_t *out, size_t out_len)
+{
+    (void)idx; (void)addr; (void)channel; (void)out; (void)out_len;
+    return -1;
+}
+
+int rs485_model_probe(uint8_t addr, uint8_t *out_fc)
+{
+    (void)addr; (void)out_fc;
+    return -1;
+}
+
+const char *rs485_model_name(int idx)
+{
+    (void)idx;
+    return NULL;
+}
@@ -0,0 +1,105 @@
+/*
+ * host_lte.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Configuração, fonte e registros do SD para o lte_payload_builder.c rodar
+ * no PC. O teste define a identificação com host_lte_set_info(), as
+ * credenciais/checkboxes com host_lte_set_net()/host_lte_set_flags() e os
+ * registros com host_lte_set_records(); read_record_sd() anda por eles
+ * com o cursor = índice do registro.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "datalogger_control.h"
+#include "battery_monitor.h"
+#include "sdmmc_driver.h"
+
+#define HOST_LTE_STR 64
+
+static char s_id[HOST_LTE_STR], s_name[HOST_LTE_STR], s_serial[HOST_LTE_STR], s_phone[HOST_LTE_STR];
+static char s_user[HOST_LTE_STR], s_pw[HOST_LTE_STR], s_token[HOST_LTE_STR];
+static uint32_t s_csq;
+static bool     s_http, s_timestamp, s_binary;
+static float    s_volts;
+
+static struct record_data_saved *s_recs;
+static size_t                    s_recs_n;
+
+static void set_str(char *dst, const char *src)
+{
+    strncpy(dst, src ? src : "", HOST_LTE_STR - 1);
+    dst[HOST_LTE_STR - 1] = '\0';
+}
+
+void host_lte_set_info(const char *id, const char *name, const char *serial,
+                       const char *phone, uint32_t csq)
+{
+    set_str(s_id, id);
+    set_str(s_name, name);
+    set_str(s_serial, serial);
+    set_str(s_phone, phone);
+    s_csq = csq;
+}
+
+// NULL/"" = checkbox desmarcado
+void host_lte_set_net(const char *user, const char *pw, const char *token, bool http)
+{
+    set_str(s_user, user);
+    set_str(s_pw, pw);
+    set_str(s_token, token);
+    s_http = http;
+}
+
+void host_lte_set_flags(bool timestamp_mode, bool binary_payload, float volts)
+{
+    s_timestamp = timestamp_mode;
+    s_binary    = binary_payload;
+    s_volts     = volts;
+}
+
+void host_lte_set_records(const struct record_data_saved *recs, size_t n)
+{
+    free(s_recs);
+    s_recs   = NULL;
+    s_recs_n = 0;
+    if (!n) return;
+    s_recs = malloc(n * sizeof(*recs));
+    if (!s_recs) return;
+    memcpy(s_recs, recs, n * sizeof(*recs));
+    s_recs_n = n;
+}
+
+esp_err_t read_record_sd(uint32_t *cursor_pos, struct record_data_saved* record_data)
+{
+    if (!cursor_pos || !record_data || *cursor_pos >= s_recs_n) {
+        return ESP_FAIL;
+    }
+    *record_data = s_recs[(*cursor_pos)++];
+    return ESP_OK;
+}
+
+char * get_device_id(void)      { return s_id; }
+char * get_name(void)           { return s_name; }
+char * get_serial_number(void)  { return s_serial; }
+char * get_phone(void)          { return s_phone; }
+uint32_t get_csq(void)          { return s_csq; }
+
+char * get_network_user(void)   { return s_user; }
+char * get_network_pw(void)     { return s_pw; }
+char * get_network_token(void)  { return s_token; }
+bool has_network_user_enabled(void)  { return s_user[0] != '\0'; }
+bool has_network_pw_enabled(void)    { return s_pw[0] != '\0'; }
+bool has_network_token_enabled(void) { return s_token[0] != '\0'; }
+bool has_network_http_enabled(void)  { return s_http; }
+
+bool has_timestamp_mode(void)   { return s_timestamp; }
+bool has_binary_payload(void)   { return s_binary; }
+
+void battery_monitor_update(void) { }
+float battery_monitor_get_power_source_voltage(void) { return s_volts; }
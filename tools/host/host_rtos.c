@@ -0,0 +1,110 @@
+/*
+ * host_rtos.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * FreeRTOS (semáforos, tick), CRC da ROM e log_mux do ESP-IDF para os
+ * módulos do fieldbus rodarem no PC.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "log_mux.h"
+
+struct host_sem {
+    pthread_mutex_t mtx;
+    bool            heap;
+};
+
+_Static_assert(sizeof(struct host_sem) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t pequeno");
+
+static SemaphoreHandle_t sem_init(struct host_sem *s, bool recursive, bool heap)
+{
+    pthread_mutexattr_t a;
+    pthread_mutexattr_init(&a);
+    pthread_mutexattr_settype(&a, recursive ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_NORMAL);
+    pthread_mutex_init(&s->mtx, &a);
+    pthread_mutexattr_destroy(&a);
+    s->heap = heap;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_sem *s = calloc(1, sizeof(*s));
+    return s ? sem_init(s, false, true) : NULL;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf)
+{
+    return sem_init((struct host_sem *)buf, false, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    struct host_sem *s = calloc(1, sizeof(*s));
+    return s ? sem_init(s, true, true) : NULL;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    if (!s) return pdFALSE;
+    if (ticks == portMAX_DELAY) return pthread_mutex_lock(&s->mtx) == 0;
+
+    const int64_t deadline = esp_timer_get_time() + (int64_t)ticks * (1000000 / configTICK_RATE_HZ);
+    for (;;) {
+        if (pthread_mutex_trylock(&s->mtx) == 0) return pdTRUE;
+        if (esp_timer_get_time() >= deadline) return pdFALSE;
+        struct timespec ts = { 0, 200000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    return s && pthread_mutex_unlock(&s->mtx) == 0;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    if (!s) return;
+    pthread_mutex_destroy(&s->mtx);
+    if (s->heap) free(s);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    int64_t us = (int64_t)ticks * (1000000 / configTICK_RATE_HZ);
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// Mesma convenção da ROM: complementa na entrada e na saída (= zlib)
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+void logmux_notify_rs485_active(uart_port_t uart, bool active)
+{
+    (void)uart;
+    (void)active;
+}
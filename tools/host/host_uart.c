@@ -0,0 +1,196 @@
+/*
+ * host_uart.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * UART/rs485_hw/esp_timer do ESP-IDF sobre um descritor do PC, para rodar
+ * o modbus_rtu_lite contra o simulador (tools/modbus_sim.py) num pty.
+ * O teste liga o descritor com host_uart_attach() e confere o silêncio
+ * entre quadros com host_uart_min_gap_us().
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "driver/uart.h"
+#include "rs485_hw.h"
+
+int host_log_level = 0;
+
+static int     s_fd = -1;
+static bool    s_installed;
+static uint8_t s_tout;
+static uint32_t s_baud;
+static int64_t s_last_edge_us;        // último byte recebido ou fim do TX
+static int64_t s_min_gap_us = -1;     // menor silêncio antes de um TX
+
+void host_uart_attach(int fd)
+{
+    s_fd = fd;
+    s_min_gap_us = -1;
+    s_last_edge_us = 0;
+}
+
+int64_t host_uart_min_gap_us(void) { return s_min_gap_us; }
+uint8_t host_uart_rx_tout(void)   { return s_tout; }
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                   return "ESP_OK";
+        case ESP_FAIL:                 return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:           return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:      return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:    return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:     return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:        return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:    return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:          return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:      return "ESP_ERR_INVALID_CRC";
+        default:                       return "UNKNOWN";
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    // Espera ativa, como no ROM: nanosleep acorda tarde demais para t3.5
+    int64_t end = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < end) { }
+}
+
+/* ---------------- driver/uart.h ---------------- */
+
+bool uart_is_driver_installed(uart_port_t uart_num)
+{
+    (void)uart_num;
+    return s_installed;
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num)
+{
+    (void)uart_num;
+    s_installed = false;
+    return ESP_OK;
+}
+
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t *baudrate)
+{
+    (void)uart_num;
+    if (!baudrate) return ESP_ERR_INVALID_ARG;
+    *baudrate = s_baud;
+    return s_installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, uint8_t tout_thresh)
+{
+    (void)uart_num;
+    if (!s_installed || tout_thresh > 126) return ESP_ERR_INVALID_ARG;
+    s_tout = tout_thresh;
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num)
+{
+    (void)uart_num;
+    if (s_fd < 0) return ESP_ERR_INVALID_STATE;
+    uint8_t junk[64];
+    struct pollfd p = { .fd = s_fd, .events = POLLIN };
+    while (poll(&p, 1, 0) > 0 && (p.revents & POLLIN)) {
+        if (read(s_fd, junk, sizeof(junk)) <= 0) break;
+    }
+    return ESP_OK;
+}
+
+// Como no IDF: volta com 'length' bytes ou quando o prazo acaba
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    (void)uart_num;
+    if (s_fd < 0 || !buf) return -1;
+    const int64_t deadline = esp_timer_get_time() +
+                             (int64_t)ticks_to_wait * (1000000 / configTICK_RATE_HZ);
+    uint32_t got = 0;
+    while (got < length) {
+        int64_t left_us = deadline - esp_timer_get_time();
+        if (left_us <= 0) break;
+        struct pollfd p = { .fd = s_fd, .events = POLLIN };
+        int pr = poll(&p, 1, (int)((left_us + 999) / 1000));
+        if (pr < 0 && errno == EINTR) continue;
+        if (pr <= 0) break;
+        ssize_t r = read(s_fd, (uint8_t *)buf + got, length - got);
+        if (r <= 0) break;
+        got += (uint32_t)r;
+        s_last_edge_us = esp_timer_get_time();
+    }
+    return (int)got;
+}
+
+/* ---------------- rs485_hw.h ---------------- */
+
+void rs485_hw_fill_defaults(rs485_hw_cfg_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->uart_num   = RS485_UART_NUM;
+    cfg->tx_gpio    = RS485_TX_PIN;
+    cfg->rx_gpio    = RS485_RX_PIN;
+    cfg->de_re_gpio = RS485_DE_RE_PIN;
+    cfg->baudrate   = RS485_DEFAULT_BAUD;
+    cfg->data_bits  = 8;
+    cfg->stop_bits  = 1;
+}
+
+esp_err_t rs485_hw_init(const rs485_hw_cfg_t *cfg)
+{
+    if (!cfg || s_fd < 0) return ESP_ERR_INVALID_STATE;
+    s_installed = true;
+    s_baud = cfg->baudrate;
+    return ESP_OK;
+}
+
+esp_err_t rs485_hw_deinit(void)
+{
+    s_installed = false;
+    return ESP_OK;
+}
+
+int rs485_hw_get_uart_num(void) { return RS485_UART_NUM; }
+
+esp_err_t rs485_hw_tx(const uint8_t *data, size_t len, TickType_t tmo)
+{
+    (void)tmo;
+    if (!s_installed || s_fd < 0) return ESP_ERR_INVALID_STATE;
+
+    int64_t now = esp_timer_get_time();
+    if (s_last_edge_us) {
+        int64_t gap = now - s_last_edge_us;
+        if (s_min_gap_us < 0 || gap < s_min_gap_us) s_min_gap_us = gap;
+    }
+    size_t off = 0;
+    while (off < len) {
+        ssize_t w = write(s_fd, data + off, len - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return ESP_FAIL;
+        off += (size_t)w;
+    }
+    tcdrain(s_fd);
+    s_last_edge_us = esp_timer_get_time();
+    return ESP_OK;
+}
@@ -0,0 +1,50 @@
+# tools/host/hostbuild.py
+#
+# Compila módulos C do firmware para o PC (biblioteca compartilhada) com os
+# stubs de tools/host/include no lugar do ESP-IDF, para os testes em tools/
+# chamarem via ctypes. Usa o cc do sistema ($CC, padrão "cc").
+#
+# Sem dependências além da biblioteca padrão.
+import ctypes
+import os
+import subprocess
+import tempfile
+
+HOST_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.normpath(os.path.join(HOST_DIR, "..", ".."))
+
+# Kconfig mínimo para os headers do fieldbus (rs485_hw.h exige os pinos)
+DEFAULT_DEFINES = {
+    "CONFIG_RS485_UART_NUM": 2,
+    "CONFIG_RS485_TX_PIN": 17,
+    "CONFIG_RS485_RX_PIN": 16,
+    "CONFIG_RS485_DE_RE_PIN": 4,
+}
+
+
+def repo_path(*parts):
+    return os.path.join(REPO, *parts)
+
+
+def build(name, sources, include_dirs=(), defines=None, verbose=False):
+    """Compila 'sources' (caminhos relativos à raiz do repo) e carrega a .so."""
+    defs = dict(DEFAULT_DEFINES)
+    defs.update(defines or {})
+    out_dir = tempfile.mkdtemp(prefix="host_%s_" % name)
+    lib = os.path.join(out_dir, "lib%s.so" % name)
+    cmd = [os.environ.get("CC", "cc"), "-std=gnu11", "-O1", "-g", "-fPIC", "-shared",
+           # mesmos avisos/erros do build do ESP-IDF
+           "-Wall", "-Werror=all", "-Wno-error=unused-function", "-Wno-error=unused-variable",
+           "-Wno-error=unused-but-set-variable", "-Wno-error=deprecated-declarations",
+           "-Wextra", "-Wno-unused-parameter", "-Wno-sign-compare",
+           "-I", os.path.join(HOST_DIR, "include")]
+    for d in include_dirs:
+        cmd += ["-I", repo_path(d)]
+    for k, v in sorted(defs.items()):
+        cmd.append("-D%s=%s" % (k, v))
+    cmd += [repo_path(s) for s in sources]
+    cmd += ["-o", lib]
+    if verbose:
+        print(" ".join(cmd))
+    subprocess.run(cmd, check=True)
+    return ctypes.CDLL(lib)
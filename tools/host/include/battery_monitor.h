@@ -0,0 +1,16 @@
+/*
+ * battery_monitor.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Só a leitura da fonte; a tensão vem do teste, ver host_lte.c.
+ */
+
+#ifndef TOOLS_HOST_BATTERY_MONITOR_H_
+#define TOOLS_HOST_BATTERY_MONITOR_H_
+
+void battery_monitor_update(void);
+float battery_monitor_get_power_source_voltage(void);
+
+#endif /* TOOLS_HOST_BATTERY_MONITOR_H_ */
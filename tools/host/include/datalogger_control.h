@@ -0,0 +1,35 @@
+/*
+ * datalogger_control.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Só os getters de configuração usados pelo lte_payload_builder.c; os
+ * valores vêm do teste, ver host_lte.c.
+ */
+
+#ifndef TOOLS_HOST_DATALOGGER_CONTROL_H_
+#define TOOLS_HOST_DATALOGGER_CONTROL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "datalogger_driver.h"
+
+bool has_network_http_enabled(void);
+char * get_network_user(void);
+char * get_network_token(void);
+char * get_network_pw(void);
+bool has_network_user_enabled(void);
+bool has_network_token_enabled(void);
+bool has_network_pw_enabled(void);
+
+char * get_device_id(void);
+char * get_name(void);
+char * get_phone(void);
+char * get_serial_number(void);
+uint32_t get_csq(void);
+
+bool has_timestamp_mode(void);
+bool has_binary_payload(void);
+
+#endif /* TOOLS_HOST_DATALOGGER_CONTROL_H_ */
@@ -0,0 +1,44 @@
+/*
+ * datalogger_driver.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Só a parte RS-485 e o índice do SD do datalogger_driver.h real (mesmos
+ * tipos e protótipos); o cadastro vem do teste, ver host_datalogger.c.
+ */
+
+#ifndef TOOLS_HOST_DATALOGGER_DRIVER_H_
+#define TOOLS_HOST_DATALOGGER_DRIVER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_check.h"
+
+struct record_index_config {
+    uint32_t    last_write_idx;
+    uint32_t    last_read_idx;
+    uint32_t    total_idx;
+    uint32_t    cursor_position;
+};
+
+#define UNSPECIFIC_RECORD 0x7FFFFFFFU
+
+#define RS485_MAX_SENSORS 10
+
+typedef struct {
+    uint8_t  channel;           // 3…13
+    uint8_t  address;           // 1…247
+    char     type[16];          // "energia", "temperatura", ...
+    char     subtype[16];       // "monofasico"/"trifasico" ou ""
+} sensor_map_t;
+
+esp_err_t save_rs485_config(const sensor_map_t *map, size_t count);
+esp_err_t load_rs485_config(sensor_map_t *map, size_t *count);
+
+esp_err_t rs485_hint_get_used_fc(uint8_t addr, uint8_t *out_fc);
+esp_err_t rs485_hint_set_used_fc(uint8_t addr, uint8_t used_fc);
+
+#endif /* TOOLS_HOST_DATALOGGER_DRIVER_H_ */
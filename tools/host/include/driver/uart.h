@@ -0,0 +1,36 @@
+/*
+ * uart.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * UART sobre um descritor (pty ou porta serial), ver host_uart.c.
+ */
+
+#ifndef TOOLS_HOST_DRIVER_UART_H_
+#define TOOLS_HOST_DRIVER_UART_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int uart_port_t;
+
+typedef enum {
+    UART_MODE_UART,
+    UART_MODE_RS485_HALF_DUPLEX,
+} uart_mode_t;
+
+#define UART_NUM_0          0
+#define UART_PIN_NO_CHANGE  (-1)
+
+bool      uart_is_driver_installed(uart_port_t uart_num);
+esp_err_t uart_driver_delete(uart_port_t uart_num);
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, uint8_t tout_thresh);
+esp_err_t uart_flush_input(uart_port_t uart_num);
+esp_err_t uart_get_baudrate(uart_port_t uart_num, uint32_t *baudrate);
+int       uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait);
+
+#endif /* TOOLS_HOST_DRIVER_UART_H_ */
@@ -0,0 +1,16 @@
+/*
+ * esp_attr.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_ESP_ATTR_H_
+#define TOOLS_HOST_ESP_ATTR_H_
+
+// Sem RTC no PC: a "memória RTC" dura enquanto a biblioteca estiver carregada
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+#endif /* TOOLS_HOST_ESP_ATTR_H_ */
@@ -0,0 +1,22 @@
+/*
+ * esp_check.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_ESP_CHECK_H_
+#define TOOLS_HOST_ESP_CHECK_H_
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#define ESP_RETURN_ON_ERROR(x, tag, fmt, ...) do {                      \
+        esp_err_t err_rc_ = (x);                                         \
+        if (err_rc_ != ESP_OK) {                                         \
+            ESP_LOGE(tag, "%s(%d): " fmt, __func__, __LINE__, ##__VA_ARGS__); \
+            return err_rc_;                                              \
+        }                                                                \
+    } while (0)
+
+#endif /* TOOLS_HOST_ESP_CHECK_H_ */
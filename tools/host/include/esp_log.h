@@ -0,0 +1,31 @@
+/*
+ * esp_log.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_ESP_LOG_H_
+#define TOOLS_HOST_ESP_LOG_H_
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE, ESP_LOG_ERROR, ESP_LOG_WARN, ESP_LOG_INFO, ESP_LOG_DEBUG, ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+extern int host_log_level;   // 0 = mudo, 1 = E, 2 = W, 3 = I, 4 = D
+
+#define HOST_LOG(lvl, c, tag, fmt, ...) \
+    do { if (host_log_level >= (lvl)) fprintf(stderr, c " (%s) " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, fmt, ...) HOST_LOG(1, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) HOST_LOG(2, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) HOST_LOG(3, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) HOST_LOG(4, "D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) HOST_LOG(5, "V", tag, fmt, ##__VA_ARGS__)
+
+// Nível por tag não existe no PC; host_log_level vale para tudo
+static inline void esp_log_level_set(const char *tag, esp_log_level_t level) { (void)tag; (void)level; }
+
+#endif /* TOOLS_HOST_ESP_LOG_H_ */
@@ -0,0 +1,15 @@
+/*
+ * esp_rom_crc.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_ESP_ROM_CRC_H_
+#define TOOLS_HOST_ESP_ROM_CRC_H_
+
+#include <stdint.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif /* TOOLS_HOST_ESP_ROM_CRC_H_ */
@@ -0,0 +1,15 @@
+/*
+ * esp_rom_sys.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_ESP_ROM_SYS_H_
+#define TOOLS_HOST_ESP_ROM_SYS_H_
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
+
+#endif /* TOOLS_HOST_ESP_ROM_SYS_H_ */
@@ -0,0 +1,15 @@
+/*
+ * esp_timer.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_ESP_TIMER_H_
+#define TOOLS_HOST_ESP_TIMER_H_
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);   // µs, CLOCK_MONOTONIC
+
+#endif /* TOOLS_HOST_ESP_TIMER_H_ */
@@ -0,0 +1,15 @@
+/*
+ * factory_control.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Vazio no PC: os getters de identificação estão em datalogger_control.h.
+ */
+
+#ifndef TOOLS_HOST_FACTORY_CONTROL_H_
+#define TOOLS_HOST_FACTORY_CONTROL_H_
+
+#include "datalogger_control.h"
+
+#endif /* TOOLS_HOST_FACTORY_CONTROL_H_ */
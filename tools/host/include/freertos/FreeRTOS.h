@@ -0,0 +1,33 @@
+/*
+ * FreeRTOS.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_FREERTOS_H_
+#define TOOLS_HOST_FREERTOS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+
+#define configTICK_RATE_HZ  1000
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFu)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(t)    ((TickType_t)(((uint64_t)(t) * 1000) / configTICK_RATE_HZ))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+
+// Um único núcleo e sem ISR no PC: seção crítica não precisa travar nada
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(m)        ((void)(m))
+#define portEXIT_CRITICAL(m)         ((void)(m))
+
+#include "freertos/task.h"
+
+#endif /* TOOLS_HOST_FREERTOS_H_ */
@@ -0,0 +1,28 @@
+/*
+ * semphr.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Semáforos do FreeRTOS sobre pthread (mutex comum e recursivo).
+ */
+
+#ifndef TOOLS_HOST_FREERTOS_SEMPHR_H_
+#define TOOLS_HOST_FREERTOS_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_sem *SemaphoreHandle_t;
+typedef struct { void *priv[8]; } StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t s);
+void              vSemaphoreDelete(SemaphoreHandle_t s);
+
+#define xSemaphoreTakeRecursive(s, t) xSemaphoreTake((s), (t))
+#define xSemaphoreGiveRecursive(s)    xSemaphoreGive((s))
+
+#endif /* TOOLS_HOST_FREERTOS_SEMPHR_H_ */
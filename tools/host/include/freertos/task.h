@@ -0,0 +1,16 @@
+/*
+ * task.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ */
+
+#ifndef TOOLS_HOST_FREERTOS_TASK_H_
+#define TOOLS_HOST_FREERTOS_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+TickType_t xTaskGetTickCount(void);
+void       vTaskDelay(TickType_t ticks);
+
+#endif /* TOOLS_HOST_FREERTOS_TASK_H_ */
@@ -0,0 +1,18 @@
+/*
+ * sdkconfig.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Só as opções que os módulos do fieldbus leem (espelho do sdkconfig).
+ * Pinos do RS-485 vêm de hostbuild.py (-D).
+ */
+
+#ifndef TOOLS_HOST_SDKCONFIG_H_
+#define TOOLS_HOST_SDKCONFIG_H_
+
+#define CONFIG_MODBUS_SERIAL_ENABLE 1
+#define CONFIG_MODBUS_GUARD_ENABLE  1
+#define CONFIG_MODBUS_RTU_LITE      1
+
+#endif /* TOOLS_HOST_SDKCONFIG_H_ */
@@ -0,0 +1,30 @@
+/*
+ * sdmmc_driver.h (host)
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Só o lote de registros RS-485 (host_datalogger.c guarda as linhas para
+ * o teste conferir) e a leitura dos registros (host_lte.c).
+ */
+
+#ifndef TOOLS_HOST_SDMMC_DRIVER_H_
+#define TOOLS_HOST_SDMMC_DRIVER_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+struct record_data_saved {
+    char        date[11];
+    char        time[9];
+    uint8_t     channel;
+    char        data[8];
+};
+
+esp_err_t save_record_sd_rs485(int channel, int subindex, const char *value_str);
+esp_err_t record_batch_begin(void);
+esp_err_t record_batch_add(int channel, int subindex, const char *value_str);
+esp_err_t record_batch_commit(void);
+esp_err_t read_record_sd(uint32_t *cursor_pos, struct record_data_saved* record_data);
+
+#endif /* TOOLS_HOST_SDMMC_DRIVER_H_ */
@@ -0,0 +1,401 @@
+/*
+ * json_formats.c
+ *
+ *  Created on: 17 de out. de 2026
+ *      Author: geopo
+ *
+ * Formatos de upload montados duas vezes a partir das mesmas entradas:
+ * com o json_writer (mesma sequência de campos dos builders do firmware) e
+ * com cJSON + cJSON_PrintUnformatted (a sequência que os builders usavam
+ * antes do json_writer). O teste (tools/json_writer_test.py) compara os
+ * bytes. Sem HOST_WITH_CJSON só a metade json_writer é compilada.
+ *
+ * Formatos (HOST_FMT_*):
+ *   SD          mqtt_payload_write_from_sd()      payload_builder.c
+ *   SERVER      json_data_payload()               server_comm.c
+ *   LTE_MS      lte_json_data_payload(), DateTime em ms
+ *   LTE_STR     lte_json_data_payload(), DateTime em texto
+ *   WEG_ENERGY  mqtt_payload_build_from_sd_weg_energy()
+ *   WEG_WATER   mqtt_payload_build_from_sd_weg_water()
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_writer.h"
+#ifdef HOST_WITH_CJSON
+#include "cJSON.h"
+#endif
+
+enum {
+    HOST_FMT_SD = 0,
+    HOST_FMT_SERVER,
+    HOST_FMT_LTE_MS,
+    HOST_FMT_LTE_STR,
+    HOST_FMT_WEG_ENERGY,
+    HOST_FMT_WEG_WATER,
+    HOST_FMT_COUNT,
+};
+
+typedef struct {
+    const char *date;      // "DD/MM/AAAA" como sai do read_record_sd()
+    const char *time;      // "HH:MM:SS"
+    const char *iso;       // "time" do formato SD (payload_time_iso)
+    const char *data;      // texto do SD
+    int         channel;
+    double      ms;        // DateTime do LTE em modo timestamp
+} host_rec_t;
+
+typedef struct {
+    const char *id;
+    const char *name;
+    const char *serial;
+    const char *phone;
+    const char *battery;   // LTE: "%.2f" da fonte
+    const char *user;      // NULL => credencial desabilitada
+    const char *pw;
+    const char *token;
+    const char *ts_iso;    // WEG: carimbo do relógio
+    double      csq;
+    double      ts_ms;     // WEG: registro mais recente
+} host_hdr_t;
+
+static host_hdr_t        s_hdr;
+static const host_rec_t *s_recs;
+static size_t            s_n;
+
+void host_fmt_set_input(const host_hdr_t *hdr, const host_rec_t *recs, size_t n)
+{
+    s_hdr  = *hdr;
+    s_recs = recs;
+    s_n    = n;
+}
+
+static void split_channel(int ch, int *base, int *sub)
+{
+    *base = ch;
+    *sub  = 0;
+    if (ch >= 31 && ch <= 39)      { *base = 3;      *sub = ch - 30; }
+    else if (ch >= 10 && ch <= 99) { *base = ch / 10; *sub = ch % 10; }
+}
+
+static const char *dev_id(void)
+{
+    return (s_hdr.id && s_hdr.id[0]) ? s_hdr.id : "esp32";
+}
+
+static int has_text(const char *s)
+{
+    if (!s) return 0;
+    while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') s++;
+    return *s != '\0';
+}
+
+/* ------------------------------------------------------------------------
+ * json_writer
+ * ---------------------------------------------------------------------- */
+
+static void jw_header(json_writer_t *w, int fmt)
+{
+    switch (fmt) {
+    case HOST_FMT_SD:
+        jw_str(w, "id", dev_id());
+        if (s_hdr.name && s_hdr.name[0])     jw_str(w, "Nome", s_hdr.name);
+        if (s_hdr.serial && s_hdr.serial[0]) jw_str(w, "Número Serial", s_hdr.serial);
+        if (s_hdr.phone && s_hdr.phone[0])   jw_str(w, "Telefone", s_hdr.phone);
+        jw_num(w, "CSQ", s_hdr.csq);
+        if (s_hdr.user)  jw_str(w, "Usuario", s_hdr.user);
+        if (s_hdr.pw)    jw_str(w, "Senha",   s_hdr.pw);
+        if (s_hdr.token) jw_str(w, "Token",   s_hdr.token);
+        break;
+    case HOST_FMT_SERVER:
+        jw_str(w, "id", s_hdr.id);
+        jw_str(w, "Nome", s_hdr.name);
+        jw_str(w, "Número Serial", s_hdr.serial);
+        jw_str(w, "Telefone", s_hdr.phone);
+        jw_num(w, "CSQ", s_hdr.csq);
+        if (s_hdr.user)  jw_str(w, "Usuario", s_hdr.user);
+        if (s_hdr.pw)    jw_str(w, "Senha", s_hdr.pw);
+        if (s_hdr.token) jw_str(w, "Token", s_hdr.token);
+        break;
+    default:   // LTE
+        jw_str(w, "id", s_hdr.id);
+        jw_str(w, "Name", s_hdr.name);
+        jw_str(w, "Serial Number", s_hdr.serial);
+        jw_str(w, "Phone", s_hdr.phone);
+        jw_num(w, "CSQ", s_hdr.csq);
+        jw_str(w, "Battery", s_hdr.battery);
+        if (s_hdr.user)  jw_str(w, "User", s_hdr.user);
+        if (s_hdr.pw)    jw_str(w, "Password", s_hdr.pw);
+        if (s_hdr.token) jw_str(w, "Token", s_hdr.token);
+        break;
+    }
+}
+
+static void jw_record(json_writer_t *w, int fmt, const host_rec_t *r)
+{
+    int base, sub;
+
+    jw_obj_begin(w, NULL);
+    switch (fmt) {
+    case HOST_FMT_SD:
+        split_channel(r->channel, &base, &sub);
+        jw_str(w, "Data",  r->date);
+        jw_str(w, "Hora",  r->time);
+        jw_str(w, "time",  r->iso);
+        jw_num(w, "Canal", base);
+        if (sub > 0) jw_num(w, "Subcanal", sub);
+        jw_num(w, "Dados", atof(r->data));
+        break;
+    case HOST_FMT_SERVER:
+        jw_str(w, "Data",  r->date);
+        jw_str(w, "Hora",  r->time);
+        jw_num(w, "Canal", r->channel);
+        jw_num(w, "Dados", atof(r->data));
+        break;
+    default:   // LTE
+        if (fmt == HOST_FMT_LTE_MS) jw_num(w, "DateTime", r->ms);
+        else                        jw_str(w, "DateTime", r->iso);
+        jw_num(w, "Canal", r->channel);
+        if (has_text(r->data)) {
+            if (r->channel == 0 || r->channel == 2) jw_num(w, "Pressao", atof(r->data));
+            else if (r->channel == 1)               jw_num(w, "Vazao", atof(r->data));
+        }
+        break;
+    }
+    jw_obj_end(w);
+}
+
+static void jw_snapshot(json_writer_t *w, int fmt)
+{
+    jw_obj_begin(w, NULL);
+    jw_num(w, "time", s_hdr.ts_ms);
+    if (fmt == HOST_FMT_WEG_ENERGY) {
+        jw_obj_begin(w, "metadata");
+        jw_str(w, "ts_iso", s_hdr.ts_iso);
+        jw_num(w, "ts_s", (double)((long long)s_hdr.ts_ms / 1000));
+        jw_obj_end(w);
+    } else {
+        jw_str(w, "timestamp", s_hdr.ts_iso);
+        jw_num(w, "ts_ms", s_hdr.ts_ms);
+    }
+    jw_obj_begin(w, "data");
+    for (size_t i = 0; i < s_n; i++) {
+        const host_rec_t *r = &s_recs[i];
+        const char *key = NULL;
+        if (fmt == HOST_FMT_WEG_ENERGY) {
+            key = r->channel == 31 ? "i_a" : r->channel == 32 ? "i_b" :
+                  r->channel == 33 ? "i_c" : r->channel == 1  ? "pulse_count" : NULL;
+        } else {
+            key = r->channel == 0 ? "press_1" : r->channel == 2 ? "press_2" :
+                  r->channel == 1 ? "flow" : NULL;
+        }
+        if (key) jw_num(w, key, atof(r->data));
+    }
+    jw_obj_end(w);
+    jw_obj_end(w);
+}
+
+// Lote como nos builders: registro que não cabe é desfeito e encerra o lote
+static void jw_format(json_writer_t *w, int fmt, size_t max_points, uint32_t *points)
+{
+    *points = 0;
+    if (fmt == HOST_FMT_WEG_ENERGY || fmt == HOST_FMT_WEG_WATER) {
+        jw_snapshot(w, fmt);
+        *points = (uint32_t)s_n;
+        return;
+    }
+
+    jw_obj_begin(w, NULL);
+    jw_header(w, fmt);
+    jw_arr_begin(w, "measurements");
+    for (size_t i = 0; i < s_n && (max_points == 0 || *points < max_points); i++) {
+        json_writer_mark_t mark;
+        jw_mark(w, &mark);
+        jw_record(w, fmt, &s_recs[i]);
+        if (!jw_can_close(w)) {
+            jw_rewind(w, &mark);
+            break;
+        }
+        (*points)++;
+    }
+    jw_arr_end(w);
+    jw_obj_end(w);
+}
+
+/** Buffer (out != NULL) ou medição com limite (out == NULL, cap = limite). */
+int host_fmt_jw(int fmt, char *out, size_t cap, uint32_t *points, size_t *len)
+{
+    json_writer_t w;
+    jw_init(&w, out, cap);
+    jw_format(&w, fmt, 0, points);
+    return jw_finish(&w, len);
+}
+
+typedef struct {
+    char  *out;
+    size_t cap;
+    size_t len;
+    size_t calls;
+} host_sink_t;
+
+static esp_err_t collect(void *ctx, const char *data, size_t len)
+{
+    host_sink_t *s = (host_sink_t *)ctx;
+    if (s->len + len > s->cap) return ESP_ERR_INVALID_SIZE;
+    memcpy(s->out + s->len, data, len);
+    s->len += len;
+    s->calls++;
+    return ESP_OK;
+}
+
+/** Sink com pedaços de 'chunk' bytes, no máximo max_points registros. */
+int host_fmt_jw_sink(int fmt, size_t chunk, size_t max_points,
+                     char *out, size_t cap, uint32_t *points, size_t *len, size_t *calls)
+{
+    char *scratch = malloc(chunk ? chunk : 1);
+    host_sink_t s = { out, cap, 0, 0 };
+    json_writer_t w;
+    jw_init_sink(&w, collect, &s, scratch, chunk);
+    jw_format(&w, fmt, max_points, points);
+    int err = jw_finish(&w, len);
+    free(scratch);
+    *calls = s.calls;
+    return err;
+}
+
+/* ------------------------------------------------------------------------
+ * cJSON (referência)
+ * ---------------------------------------------------------------------- */
+#ifdef HOST_WITH_CJSON
+
+static void cj_header(cJSON *root, int fmt)
+{
+    switch (fmt) {
+    case HOST_FMT_SD:
+        cJSON_AddStringToObject(root, "id", dev_id());
+        if (s_hdr.name && s_hdr.name[0])     cJSON_AddStringToObject(root, "Nome", s_hdr.name);
+        if (s_hdr.serial && s_hdr.serial[0]) cJSON_AddStringToObject(root, "Número Serial", s_hdr.serial);
+        if (s_hdr.phone && s_hdr.phone[0])   cJSON_AddStringToObject(root, "Telefone", s_hdr.phone);
+        cJSON_AddNumberToObject(root, "CSQ", s_hdr.csq);
+        if (s_hdr.user)  cJSON_AddStringToObject(root, "Usuario", s_hdr.user);
+        if (s_hdr.pw)    cJSON_AddStringToObject(root, "Senha",   s_hdr.pw);
+        if (s_hdr.token) cJSON_AddStringToObject(root, "Token",   s_hdr.token);
+        break;
+    case HOST_FMT_SERVER:
+        cJSON_AddStringToObject(root, "id", s_hdr.id);
+        cJSON_AddStringToObject(root, "Nome", s_hdr.name);
+        cJSON_AddStringToObject(root, "Número Serial", s_hdr.serial);
+        cJSON_AddStringToObject(root, "Telefone", s_hdr.phone);
+        cJSON_AddNumberToObject(root, "CSQ", s_hdr.csq);
+        if (s_hdr.user)  cJSON_AddStringToObject(root, "Usuario", s_hdr.user);
+        if (s_hdr.pw)    cJSON_AddStringToObject(root, "Senha", s_hdr.pw);
+        if (s_hdr.token) cJSON_AddStringToObject(root, "Token", s_hdr.token);
+        break;
+    default:
+        cJSON_AddStringToObject(root, "id", s_hdr.id);
+        cJSON_AddStringToObject(root, "Name", s_hdr.name);
+        cJSON_AddStringToObject(root, "Serial Number", s_hdr.serial);
+        cJSON_AddStringToObject(root, "Phone", s_hdr.phone);
+        cJSON_AddNumberToObject(root, "CSQ", s_hdr.csq);
+        cJSON_AddStringToObject(root, "Battery", s_hdr.battery);
+        if (s_hdr.user)  cJSON_AddStringToObject(root, "User", s_hdr.user);
+        if (s_hdr.pw)    cJSON_AddStringToObject(root, "Password", s_hdr.pw);
+        if (s_hdr.token) cJSON_AddStringToObject(root, "Token", s_hdr.token);
+        break;
+    }
+}
+
+static cJSON *cj_record(int fmt, const host_rec_t *r)
+{
+    int base, sub;
+    cJSON *o = cJSON_CreateObject();
+
+    switch (fmt) {
+    case HOST_FMT_SD:
+        split_channel(r->channel, &base, &sub);
+        cJSON_AddStringToObject(o, "Data",  r->date);
+        cJSON_AddStringToObject(o, "Hora",  r->time);
+        cJSON_AddStringToObject(o, "time",  r->iso);
+        cJSON_AddNumberToObject(o, "Canal", base);
+        if (sub > 0) cJSON_AddNumberToObject(o, "Subcanal", sub);
+        cJSON_AddNumberToObject(o, "Dados", atof(r->data));
+        break;
+    case HOST_FMT_SERVER:
+        cJSON_AddStringToObject(o, "Data",  r->date);
+        cJSON_AddStringToObject(o, "Hora",  r->time);
+        cJSON_AddNumberToObject(o, "Canal", r->channel);
+        cJSON_AddNumberToObject(o, "Dados", atof(r->data));
+        break;
+    default:
+        if (fmt == HOST_FMT_LTE_MS) cJSON_AddNumberToObject(o, "DateTime", r->ms);
+        else                        cJSON_AddStringToObject(o, "DateTime", r->iso);
+        cJSON_AddNumberToObject(o, "Canal", r->channel);
+        if (has_text(r->data)) {
+            if (r->channel == 0 || r->channel == 2) cJSON_AddNumberToObject(o, "Pressao", atof(r->data));
+            else if (r->channel == 1)               cJSON_AddNumberToObject(o, "Vazao", atof(r->data));
+        }
+        break;
+    }
+    return o;
+}
+
+static cJSON *cj_snapshot(int fmt)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "time", s_hdr.ts_ms);
+    if (fmt == HOST_FMT_WEG_ENERGY) {
+        cJSON *meta = cJSON_CreateObject();
+        cJSON_AddStringToObject(meta, "ts_iso", s_hdr.ts_iso);
+        cJSON_AddNumberToObject(meta, "ts_s", (double)((long long)s_hdr.ts_ms / 1000));
+        cJSON_AddItemToObject(root, "metadata", meta);
+    } else {
+        cJSON_AddStringToObject(root, "timestamp", s_hdr.ts_iso);
+        cJSON_AddNumberToObject(root, "ts_ms", s_hdr.ts_ms);
+    }
+    cJSON *data = cJSON_CreateObject();
+    for (size_t i = 0; i < s_n; i++) {
+        const host_rec_t *r = &s_recs[i];
+        const char *key = NULL;
+        if (fmt == HOST_FMT_WEG_ENERGY) {
+            key = r->channel == 31 ? "i_a" : r->channel == 32 ? "i_b" :
+                  r->channel == 33 ? "i_c" : r->channel == 1  ? "pulse_count" : NULL;
+        } else {
+            key = r->channel == 0 ? "press_1" : r->channel == 2 ? "press_2" :
+                  r->channel == 1 ? "flow" : NULL;
+        }
+        if (key) cJSON_AddNumberToObject(data, key, atof(r->data));
+    }
+    cJSON_AddItemToObject(root, "data", data);
+    return root;
+}
+
+/** Os 'points' primeiros registros, impressos pelo cJSON. -1 se não couber em out. */
+int host_fmt_cjson(int fmt, uint32_t points, char *out, size_t cap)
+{
+    cJSON *root;
+    if (fmt == HOST_FMT_WEG_ENERGY || fmt == HOST_FMT_WEG_WATER) {
+        root = cj_snapshot(fmt);
+    } else {
+        root = cJSON_CreateObject();
+        cj_header(root, fmt);
+        cJSON *arr = cJSON_CreateArray();
+        cJSON_AddItemToObject(root, "measurements", arr);
+        for (uint32_t i = 0; i < points && i < s_n; i++) {
+            cJSON_AddItemToArray(arr, cj_record(fmt, &s_recs[i]));
+        }
+    }
+
+    char *txt = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!txt) return -1;
+
+    size_t len = strlen(txt);
+    int ret = (len + 1 <= cap) ? (int)len : -1;
+    if (ret >= 0) memcpy(out, txt, len + 1);
+    cJSON_free(txt);
+    return ret;
+}
+
+#endif /* HOST_WITH_CJSON */
@@ -0,0 +1,377 @@
+# tools/json_writer_test.py
+#
+# Teste do json_writer (system/src/json_writer.c) no PC contra o cJSON:
+# tools/host/json_formats.c monta cada formato de upload (SD genérico,
+# server_comm, LTE em ms e em texto, WEG energia e água) com jw_* e com
+# cJSON_AddXxx + cJSON_PrintUnformatted, e os bytes têm de ser idênticos.
+#
+# Cobre também o que os publishers usam do writer:
+#   - sink em pedaços (1, 7, 64 e 512 bytes) == buffer;
+#   - medição com limite (buf NULL) escolhe os mesmos pontos e o mesmo
+#     tamanho que o buffer daquele cap, e o ponto seguinte não cabe;
+#   - números (0.1, 1e21, -0.0, INT_MAX+1, epoch em ms, NaN -> null) e
+#     strings (aspas, barra, controles, UTF-8, NULL) nos casos de borda.
+#
+# Fonte do cJSON: $CJSON_DIR (com cJSON.c/cJSON.h) ou
+# $IDF_PATH/components/json/cJSON. Sem ele a comparação byte a byte com o
+# cJSON é pulada e só roda a verificação contra o modelo em Python do
+# cJSON_PrintUnformatted (mesmas regras de número e escape).
+#
+# Uso:
+#   python json_writer_test.py
+#   CJSON_DIR=~/esp/esp-idf/components/json/cJSON python json_writer_test.py -v
+#
+# Requer um compilador C ($CC ou cc). Sem dependências além da biblioteca
+# padrão.
+import argparse
+import ctypes
+import json
+import math
+import os
+import sys
+
+from host import hostbuild
+
+ESP_OK = 0
+ESP_ERR_NO_MEM = 0x101
+
+FMT_SD, FMT_SERVER, FMT_LTE_MS, FMT_LTE_STR, FMT_WEG_ENERGY, FMT_WEG_WATER = range(6)
+FMT_NAMES = ["sd", "server", "lte_ms", "lte_str", "weg_energy", "weg_water"]
+SNAPSHOT = (FMT_WEG_ENERGY, FMT_WEG_WATER)
+
+INT_MAX = 2 ** 31 - 1
+INT_MIN = -2 ** 31
+DBL_EPSILON = sys.float_info.epsilon
+
+
+class Rec(ctypes.Structure):
+    # espelho de host_rec_t (json_formats.c)
+    _fields_ = [("date", ctypes.c_char_p), ("time", ctypes.c_char_p),
+                ("iso", ctypes.c_char_p), ("data", ctypes.c_char_p),
+                ("channel", ctypes.c_int), ("ms", ctypes.c_double)]
+
+
+class Hdr(ctypes.Structure):
+    # espelho de host_hdr_t
+    _fields_ = [(n, ctypes.c_char_p) for n in
+                ("id", "name", "serial", "phone", "battery", "user", "pw", "token", "ts_iso")] + \
+               [("csq", ctypes.c_double), ("ts_ms", ctypes.c_double)]
+
+
+def _b(s):
+    return None if s is None else s.encode("utf-8")
+
+
+# (data, canal): cobre a divisão 31..39 / XY do formato SD, o 'Subcanal',
+# valores sem texto útil no LTE e os números de borda do cJSON.
+RECORDS = [
+    ("0.1", 0), ("12.5", 1), ("-0.0", 2), ("1e21", 3), ("123456789.123", 31),
+    ("NaN", 35), ("abc", 39), ("  ", 1), ("2147483647", 10), ("2147483648", 45),
+    ("-2147483649", 99), ("1e-7", 2), ("3.14159265358979", 0), ("-3", 5),
+    ("0.30000000000000004", 1), ("1.5e300", 2), ("5e-324", 0),
+]
+
+
+def fixture_records():
+    recs = []
+    for i, (data, ch) in enumerate(RECORDS):
+        day, sec = 1 + i % 28, i * 37
+        date = "%02d/10/2026" % day
+        tm = "%02d:%02d:%02d" % (sec // 3600, sec // 60 % 60, sec % 60)
+        iso = "2026-10-%02dT%s-03:00" % (day, tm)
+        ms = 1792000000000.0 + i * 60000.0 + 123
+        recs.append(Rec(_b(date), _b(tm), _b(iso), _b(data), ch, ms))
+    return recs
+
+
+WEG_RECORDS = {
+    FMT_WEG_ENERGY: [("12.25", 31), ("0.1", 32), ("1e21", 33), ("4294967295", 1)],
+    FMT_WEG_WATER: [("3.5", 0), ("-0.0", 2), ("0.30000000000000004", 1)],
+}
+
+HEADERS = [
+    dict(id="esp32-ÿ01", name='Estação "A"\\\n\t\x01\x1f', serial="SN/€-42", phone="+55 11 9",
+         battery="3.71", user="u\b", pw="p\f\r", token="tok", ts_iso="2026-10-17T10:00:00-03:00",
+         csq=17, ts_ms=1792000000123.0),
+    # credenciais desabilitadas, campos vazios/NULL, CSQ fracionário
+    dict(id="", name="", serial=None, phone=None, battery="0.00", user=None, pw=None, token=None,
+         ts_iso="", csq=99.5, ts_ms=0.0),
+]
+
+
+def make_hdr(h):
+    return Hdr(*(_b(h[k]) for k in ("id", "name", "serial", "phone", "battery", "user", "pw",
+                                    "token", "ts_iso")), float(h["csq"]), float(h["ts_ms"]))
+
+
+# ---------------------------------------------------------------------------
+# Modelo do cJSON_PrintUnformatted (cJSON 1.7.x)
+# ---------------------------------------------------------------------------
+def _same_double(a, b):
+    maxval = max(abs(a), abs(b))
+    return abs(a - b) <= maxval * DBL_EPSILON
+
+
+def cjson_number(d):
+    if math.isnan(d) or math.isinf(d):
+        return "null"
+    valueint = INT_MAX if d >= INT_MAX else INT_MIN if d <= INT_MIN else int(d)
+    if d == float(valueint):
+        return "%d" % valueint
+    s = "%1.15g" % d
+    if not _same_double(float(s), d):
+        s = "%1.17g" % d
+    return s
+
+
+_ESC = {'"': '\\"', "\\": "\\\\", "\b": "\\b", "\f": "\\f", "\n": "\\n", "\r": "\\r", "\t": "\\t"}
+
+
+def cjson_string(s):
+    out = []
+    for c in s:
+        if c in _ESC:
+            out.append(_ESC[c])
+        elif ord(c) < 0x20:
+            out.append("\\u%04x" % ord(c))
+        else:
+            out.append(c)
+    return '"' + "".join(out) + '"'
+
+
+class _Obj(list):
+    pass
+
+
+def cjson_print(v):
+    if isinstance(v, _Obj):
+        return "{" + ",".join(cjson_string(k) + ":" + cjson_print(x) for k, x in v) + "}"
+    if isinstance(v, list):
+        return "[" + ",".join(cjson_print(x) for x in v) + "]"
+    if v is None:
+        return "null"
+    if isinstance(v, str):
+        return cjson_string(v)
+    return cjson_number(v)
+
+
+def model_reprint(raw):
+    doc = json.loads(raw.decode("utf-8"), object_pairs_hook=_Obj,
+                     parse_int=float, parse_float=float)
+    return cjson_print(doc).encode("utf-8")
+
+
+# ---------------------------------------------------------------------------
+def find_cjson():
+    cands = []
+    if os.environ.get("CJSON_DIR"):
+        cands.append(os.environ["CJSON_DIR"])
+    if os.environ.get("IDF_PATH"):
+        cands.append(os.path.join(os.environ["IDF_PATH"], "components", "json", "cJSON"))
+    for d in cands:
+        d = os.path.abspath(os.path.expanduser(d))
+        if os.path.isfile(os.path.join(d, "cJSON.c")) and os.path.isfile(os.path.join(d, "cJSON.h")):
+            return d
+    return None
+
+
+def load(cjson_dir, verbose=False):
+    sources = ["system/src/json_writer.c", "tools/host/json_formats.c"]
+    include_dirs = ["system/include"]
+    defines = {}
+    if cjson_dir:
+        sources.append(os.path.join(cjson_dir, "cJSON.c"))
+        include_dirs.append(cjson_dir)
+        defines["HOST_WITH_CJSON"] = 1
+    lib = hostbuild.build("json_formats", sources, include_dirs=include_dirs,
+                          defines=defines, verbose=verbose)
+    sz, u32 = ctypes.c_size_t, ctypes.c_uint32
+    lib.host_fmt_set_input.argtypes = [ctypes.POINTER(Hdr), ctypes.POINTER(Rec), sz]
+    lib.host_fmt_jw.argtypes = [ctypes.c_int, ctypes.c_char_p, sz, ctypes.POINTER(u32),
+                                ctypes.POINTER(sz)]
+    lib.host_fmt_jw_sink.argtypes = [ctypes.c_int, sz, sz, ctypes.c_char_p, sz,
+                                     ctypes.POINTER(u32), ctypes.POINTER(sz), ctypes.POINTER(sz)]
+    if cjson_dir:
+        lib.host_fmt_cjson.argtypes = [ctypes.c_int, u32, ctypes.c_char_p, sz]
+    return lib
+
+
+class Tester:
+    def __init__(self, lib, with_cjson, verbose):
+        self.lib, self.with_cjson, self.verbose = lib, with_cjson, verbose
+        self.failures = 0
+        self.checks = 0
+
+    def check(self, cond, what):
+        self.checks += 1
+        if not cond:
+            self.failures += 1
+            print("FALHA: %s" % what)
+        elif self.verbose:
+            print("ok    %s" % what)
+
+    def set_input(self, hdr, recs):
+        # mantém as referências vivas enquanto o C usa os ponteiros
+        self._hdr = hdr
+        self._recs = (Rec * max(len(recs), 1))(*recs)
+        self.n = len(recs)
+        self.lib.host_fmt_set_input(ctypes.byref(hdr), self._recs, len(recs))
+
+    def jw(self, fmt, cap):
+        out = ctypes.create_string_buffer(cap) if cap else None
+        pts, ln = ctypes.c_uint32(), ctypes.c_size_t()
+        err = self.lib.host_fmt_jw(fmt, out, cap if out else cap, ctypes.byref(pts), ctypes.byref(ln))
+        return err, pts.value, ln.value, (out.raw[:ln.value] if out is not None and err == ESP_OK else None)
+
+    def measure(self, fmt, limit):
+        pts, ln = ctypes.c_uint32(), ctypes.c_size_t()
+        err = self.lib.host_fmt_jw(fmt, None, limit, ctypes.byref(pts), ctypes.byref(ln))
+        return err, pts.value, ln.value
+
+    def sink(self, fmt, chunk, max_points, cap=1 << 16):
+        out = ctypes.create_string_buffer(cap)
+        pts, ln, calls = ctypes.c_uint32(), ctypes.c_size_t(), ctypes.c_size_t()
+        err = self.lib.host_fmt_jw_sink(fmt, chunk, max_points, out, cap, ctypes.byref(pts),
+                                        ctypes.byref(ln), ctypes.byref(calls))
+        return err, pts.value, out.raw[:ln.value], calls.value
+
+    def cjson(self, fmt, points, cap=1 << 16):
+        out = ctypes.create_string_buffer(cap)
+        n = self.lib.host_fmt_cjson(fmt, points, out, cap)
+        return None if n < 0 else out.raw[:n]
+
+    # -----------------------------------------------------------------------
+    def full(self, fmt, tag):
+        err, pts, ln, raw = self.jw(fmt, 1 << 16)
+        self.check(err == ESP_OK and raw is not None, "%s: buffer grande gera o JSON" % tag)
+        if raw is None:
+            return
+        self.check(pts == self.n, "%s: todos os %d pontos (%d)" % (tag, self.n, pts))
+        self.check(len(raw) == ln, "%s: len_out == strlen" % tag)
+        try:
+            reprint = model_reprint(raw)
+        except ValueError as e:
+            reprint = None
+            print("      JSON inválido: %s" % e)
+        self.check(reprint == raw, "%s: bytes == modelo do cJSON_PrintUnformatted" % tag)
+        if reprint != raw and reprint is not None:
+            print("      jw:     %r\n      modelo: %r" % (raw, reprint))
+        if self.with_cjson:
+            ref = self.cjson(fmt, pts)
+            self.check(ref == raw, "%s: bytes == cJSON_PrintUnformatted" % tag)
+            if ref != raw:
+                print("      jw:    %r\n      cJSON: %r" % (raw, ref))
+
+        m_err, m_pts, m_len = self.measure(fmt, 0)
+        self.check(m_err == ESP_OK and m_pts == pts and m_len == ln,
+                   "%s: medição sem limite == buffer (%d/%d B)" % (tag, m_len, ln))
+        for chunk in (1, 7, 64, 512):
+            s_err, s_pts, s_raw, calls = self.sink(fmt, chunk, 0)
+            self.check(s_err == ESP_OK and s_pts == pts and s_raw == raw,
+                       "%s: sink em pedaços de %d == buffer (%d chamadas)" % (tag, chunk, calls))
+
+        # buffer exato (len + '\0') cabe; um byte a menos não
+        err, _, _, raw2 = self.jw(fmt, ln + 1)
+        self.check(err == ESP_OK and raw2 == raw, "%s: cabe em cap = len + 1" % tag)
+        err, pts2, ln2, _ = self.jw(fmt, ln)
+        if fmt in SNAPSHOT or self.n == 0:
+            self.check(err == ESP_ERR_NO_MEM and ln2 == ln,
+                       "%s: cap = len devolve NO_MEM com o tamanho exato" % tag)
+        else:
+            self.check(err == ESP_OK and pts2 == pts - 1,
+                       "%s: cap = len desfaz o último ponto" % tag)
+
+    def limits(self, fmt, tag):
+        _, _, full_len, _ = self.jw(fmt, 1 << 16)
+        caps = sorted({60, 120, 200, 333, 512, 700, 1024, full_len // 2, full_len - 1})
+        for cap in caps:
+            if cap <= 1:
+                continue
+            err, pts, ln, raw = self.jw(fmt, cap)
+            m_err, m_pts, m_len = self.measure(fmt, cap)
+            if err != ESP_OK:
+                # nem o cabeçalho cabe: a medição tem de dizer o mesmo
+                self.check(err == ESP_ERR_NO_MEM and m_err == ESP_ERR_NO_MEM and m_len == ln,
+                           "%s cap %d: NO_MEM igual no buffer e na medição" % (tag, cap))
+                continue
+            self.check(len(raw) + 1 <= cap, "%s cap %d: %d B cabem" % (tag, cap, len(raw)))
+            self.check(m_err == ESP_OK and m_pts == pts and m_len == ln,
+                       "%s cap %d: medição escolhe %d pontos / %d B (buffer %d / %d)"
+                       % (tag, cap, m_pts, m_len, pts, ln))
+            # o publisher HTTP manda pelo sink os pontos que a medição escolheu
+            # (com 0 só o cabeçalho coube: não há lote a mandar)
+            if pts > 0:
+                s_err, s_pts, s_raw, _ = self.sink(fmt, 64, pts)
+                self.check(s_err == ESP_OK and s_pts == pts and s_raw == raw,
+                           "%s cap %d: sink com max_points = %d == buffer" % (tag, cap, pts))
+                if pts < self.n:
+                    _, _, nxt, _ = self.sink(fmt, 64, pts + 1)
+                    self.check(len(nxt) + 1 > cap,
+                               "%s cap %d: o ponto %d não caberia (%d B)" % (tag, cap, pts + 1, len(nxt)))
+            if self.with_cjson:
+                ref = self.cjson(fmt, pts)
+                self.check(ref == raw, "%s cap %d: lote == cJSON com %d pontos" % (tag, cap, pts))
+                if pts < self.n:
+                    nxt = self.cjson(fmt, pts + 1)
+                    self.check(nxt is not None and len(nxt) + 1 > cap,
+                               "%s cap %d: cJSON com %d pontos não cabe" % (tag, cap, pts + 1))
+
+    def run(self):
+        recs = fixture_records()
+        for hi, h in enumerate(HEADERS):
+            hdr = make_hdr(h)
+            for fmt in range(len(FMT_NAMES)):
+                tag = "%s/h%d" % (FMT_NAMES[fmt], hi)
+                if fmt in SNAPSHOT:
+                    self.set_input(hdr, [Rec(None, None, None, _b(d), ch, 0.0)
+                                         for d, ch in WEG_RECORDS[fmt]])
+                    self.full(fmt, tag)
+                    continue
+                self.set_input(hdr, recs)
+                self.full(fmt, tag)
+                self.limits(fmt, tag)
+                self.set_input(hdr, [])
+                self.full(fmt, tag + "/vazio")
+        return self.failures == 0
+
+
+def selftest_model():
+    # o modelo em si, contra saídas conhecidas do cJSON_PrintUnformatted
+    # (compare_double tolera maxVal * DBL_EPSILON: 0.30000000000000004 sai "0.3")
+    cases = [(0.1, "0.1"), (-0.0, "0"), (1e21, "1e+21"), (2147483648.0, "2147483648"),
+             (2147483647.0, "2147483647"), (1792000000123.0, "1792000000123"),
+             (0.30000000000000004, "0.3"), (float("nan"), "null"),
+             (123456789.123, "123456789.123"), (5e-324, "4.94065645841247e-324"),
+             (1.0000000000000002, "1"), (1e-7, "1e-07")]
+    ok = True
+    for v, want in cases:
+        got = cjson_number(v)
+        if got != want:
+            print("FALHA: modelo de número %r -> %s (esperado %s)" % (v, got, want))
+            ok = False
+    if cjson_string('a"\\\x01é') != '"a\\"\\\\\\u0001é"':
+        print("FALHA: modelo de string")
+        ok = False
+    return ok
+
+
+def main():
+    ap = argparse.ArgumentParser(description="json_writer x cJSON nos formatos de upload")
+    ap.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args()
+
+    if not selftest_model():
+        return 1
+    cjson_dir = find_cjson()
+    lib = load(cjson_dir, args.verbose)
+    t = Tester(lib, cjson_dir is not None, args.verbose)
+    ok = t.run()
+    if not cjson_dir:
+        print("cJSON não encontrado (CJSON_DIR / IDF_PATH): comparação byte a byte com o cJSON "
+              "pulada, só o modelo em Python foi verificado")
+    print("%d verificações, %d falhas" % (t.checks, t.failures))
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
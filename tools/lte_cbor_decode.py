@@ -0,0 +1,400 @@
+# tools/lte_cbor_decode.py
+#
+# Decodificador de referência do payload binário (CBOR) enviado pelo LTE
+# quando "Payload LTE: Binário" está marcado (lte_cbor_data_payload() em
+# connectivity/ip/access_network/4G/src/lte_payload_builder.c).
+#
+# Converte o CBOR no MESMO JSON que o dispositivo enviaria no modo texto
+# (lte_json_data_payload), byte a byte, para o backend validar a sua
+# implementação.
+#
+# Atenção aos canais: o CBOR leva o valor de TODOS os canais do SD (chave
+# 14), inclusive os RS-485 (3, 31..39, 45...), enquanto o JSON só põe
+# Pressao (canais 0 e 2) e Vazao (canal 1) e deixa os outros só com
+# DateTime + Canal. Para dar o mesmo JSON o decodificador descarta esses
+# valores; quem quiser os RS-485 lê decode_payload(..., all_values=True)
+# (campo "Valor") ou os registros crus de cbor_loads().
+#
+# Uso:
+#   python lte_cbor_decode.py <arquivo.cbor>     # imprime o JSON equivalente
+#   python lte_cbor_decode.py --hex <hex>
+#   python lte_cbor_decode.py --all-values ...   # + "Valor" dos outros canais
+#   python lte_cbor_decode.py --selftest [-v]    # compila o builder do firmware
+#                                                # e decodifica o CBOR real
+#
+# O --selftest requer um compilador C ($CC ou cc), como os testes de
+# tools/host. Fora isso, só a biblioteca padrão.
+import argparse
+import datetime
+import struct
+import sys
+
+# ---- Chaves do map raiz (ver cabeçalho do lte_payload_builder.c)
+K_VERSION, K_ID, K_NAME, K_SERIAL, K_PHONE, K_CSQ, K_BATTERY, \
+    K_USER, K_PASSWORD, K_TOKEN, K_FLAGS, K_INFO_CRC, K_BASE_TIME, \
+    K_DECIMALS, K_RECORDS = range(15)
+
+FLAG_TIMESTAMP = 0x01
+SUPPORTED_VERSION = 1
+
+# Canal -> nome do campo no JSON (outros canais só levam DateTime + Canal;
+# o valor deles vem no CBOR mas não no JSON)
+CHANNEL_FIELD = {0: "Pressao", 1: "Vazao", 2: "Pressao"}
+
+
+# -------- CBOR (subconjunto usado pelo firmware) --------
+class CborError(ValueError):
+    pass
+
+
+def _cbor_item(data, pos):
+    if pos >= len(data):
+        raise CborError("fim inesperado")
+    ib = data[pos]
+    major, info = ib >> 5, ib & 0x1F
+    pos += 1
+
+    if major == 7:
+        if info == 22:
+            return None, pos
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info == 25:
+            return struct.unpack(">e", data[pos:pos + 2])[0], pos + 2
+        if info == 26:
+            return struct.unpack(">f", data[pos:pos + 4])[0], pos + 4
+        if info == 27:
+            return struct.unpack(">d", data[pos:pos + 8])[0], pos + 8
+        raise CborError("simple/float 0x%02x não suportado" % ib)
+
+    if info < 24:
+        arg = info
+    elif info in (24, 25, 26, 27):
+        n = 1 << (info - 24)
+        arg = int.from_bytes(data[pos:pos + n], "big")
+        pos += n
+    else:
+        raise CborError("tamanho indefinido não suportado")
+
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major == 2:
+        return bytes(data[pos:pos + arg]), pos + arg
+    if major == 3:
+        return data[pos:pos + arg].decode("utf-8"), pos + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            v, pos = _cbor_item(data, pos)
+            items.append(v)
+        return items, pos
+    if major == 5:
+        m = {}
+        for _ in range(arg):
+            k, pos = _cbor_item(data, pos)
+            v, pos = _cbor_item(data, pos)
+            m[k] = v
+        return m, pos
+    # major 6: tag, devolve só o conteúdo
+    return _cbor_item(data, pos)
+
+
+def cbor_loads(data):
+    value, pos = _cbor_item(bytes(data), 0)
+    if pos != len(data):
+        raise CborError("%d bytes sobrando" % (len(data) - pos))
+    return value
+
+
+# -------- JSON com a mesma formatação do cJSON_PrintUnformatted --------
+def _json_number(v):
+    if v != v or v in (float("inf"), float("-inf")):
+        return "null"
+    if float(v).is_integer() and -2**31 <= v <= 2**31 - 1:
+        return "%d" % int(v)
+    s = "%1.15g" % v
+    if float(s) != v:
+        s = "%1.17g" % v
+    return s
+
+
+def _json_string(s):
+    out = ['"']
+    for ch in s:
+        c = ord(ch)
+        if ch == '"':
+            out.append('\\"')
+        elif ch == "\\":
+            out.append("\\\\")
+        elif ch in "\b\f\n\r\t":
+            out.append({"\b": "\\b", "\f": "\\f", "\n": "\\n", "\r": "\\r", "\t": "\\t"}[ch])
+        elif c < 0x20:
+            out.append("\\u%04x" % c)
+        else:
+            out.append(ch)
+    out.append('"')
+    return "".join(out)
+
+
+def _json(v):
+    if isinstance(v, dict):
+        return "{" + ",".join(_json_string(k) + ":" + _json(x) for k, x in v.items()) + "}"
+    if isinstance(v, list):
+        return "[" + ",".join(_json(x) for x in v) + "]"
+    if isinstance(v, str):
+        return _json_string(v)
+    return _json_number(v)
+
+
+# -------- Payload --------
+def _iso(secs):
+    t = datetime.datetime(1970, 1, 1) + datetime.timedelta(seconds=secs)
+    return t.strftime("%Y-%m-%dT%H:%M:%S") + ".000-03:00"
+
+
+def decode_payload(data, info_cache=None, all_values=False):
+    """CBOR -> dict na ordem/forma do JSON do dispositivo.
+
+    info_cache: dict {id: {"crc":..., "Name":..., ...}} mantido pelo backend;
+    usado quando o payload não traz Name/Serial Number/Phone (não mudaram).
+    all_values: põe o valor dos canais fora do JSON (RS-485) em "Valor";
+    o resultado deixa de ser igual ao JSON do dispositivo.
+    """
+    root = cbor_loads(data)
+    if not isinstance(root, dict) or root.get(K_VERSION) != SUPPORTED_VERSION:
+        raise CborError("versão de payload desconhecida")
+
+    dev_id = root.get(K_ID)
+    info_crc = root.get(K_INFO_CRC)
+    info = None
+    if K_NAME in root or K_SERIAL in root or K_PHONE in root:
+        info = {"Name": root.get(K_NAME),
+                "Serial Number": root.get(K_SERIAL),
+                "Phone": root.get(K_PHONE)}
+        if info_cache is not None:
+            info_cache[dev_id] = dict(info, crc=info_crc)
+    elif info_cache is not None and dev_id in info_cache \
+            and info_cache[dev_id].get("crc") == info_crc:
+        info = {k: v for k, v in info_cache[dev_id].items() if k != "crc"}
+
+    out = {}
+    if dev_id is not None:
+        out["id"] = dev_id
+    for k, v in (info or {}).items():
+        if v is not None:
+            out[k] = v
+    out["CSQ"] = root.get(K_CSQ, 0)
+    cv = root.get(K_BATTERY, 0)
+    out["Battery"] = "%d.%02d" % (cv // 100, cv % 100)
+    for key, name in ((K_USER, "User"), (K_PASSWORD, "Password"), (K_TOKEN, "Token")):
+        if root.get(key) is not None:
+            out[name] = root[key]
+
+    ts_mode = bool(root.get(K_FLAGS, 0) & FLAG_TIMESTAMP)
+    decimals = root.get(K_DECIMALS, {})
+    secs = root.get(K_BASE_TIME, 0)
+    meas = []
+    for rec in root.get(K_RECORDS, []):
+        secs += rec[0]
+        ch = rec[1]
+        m = {"DateTime": secs * 1000 if ts_mode else _iso(secs), "Canal": ch}
+        if len(rec) > 2 and (ch in CHANNEL_FIELD or all_values):
+            m[CHANNEL_FIELD.get(ch, "Valor")] = rec[2] / (10 ** decimals.get(ch, 0))
+        meas.append(m)
+    out["measurements"] = meas
+    return out
+
+
+def decode_to_json(data, info_cache=None, all_values=False):
+    return _json(decode_payload(data, info_cache, all_values))
+
+
+# -------- Autoteste contra o firmware compilado no PC --------
+# O lte_payload_builder.c (com cbor_writer.c e json_writer.c) é compilado com
+# os stubs de tools/host; cada cenário gera o CBOR e o JSON dos MESMOS
+# registros e o CBOR decodificado aqui tem que dar o JSON byte a byte.
+HEAD = ("COGNETi_TEST", "Poço 3", "SN-000123", "+5511999990000", 18)
+
+# (data, hora, canal, valor do SD). Canais 31 e 45 são RS-485: o CBOR leva
+# o valor, o JSON não (ver CHANNEL_FIELD)
+RECORDS = [
+    ("23/09/2025", "17:00:00", 0, "37.1"), ("23/09/2025", "17:00:00", 1, "0.5"),
+    ("23/09/2025", "17:00:00", 2, "12.375"), ("23/09/2025", "17:10:00", 0, "37.25"),
+    ("23/09/2025", "17:10:00", 1, "6"), ("23/09/2025", "17:10:00", 2, ""),
+    ("23/09/2025", "17:20:00", 0, "-0.8"), ("23/09/2025", "17:20:00", 3, ""),
+    ("23/09/2025", "17:20:00", 31, "231.4"), ("23/09/2025", "17:20:00", 45, "-12"),
+    ("23/09/2025", "17:20:00", 1, "120"), ("23/09/2025", "17:30:00", 0, "36.9"),
+]
+# relógio ajustado para trás entre os dois registros
+RECORDS_BACKWARDS = [("01/01/2026", "00:00:05", 1, "42"), ("31/12/2025", "23:59:59", 1, "41")]
+
+
+def _load_firmware(verbose=False):
+    import ctypes
+    from host import hostbuild
+
+    class Rec(ctypes.Structure):
+        # espelho de struct record_data_saved (sdmmc_driver.h)
+        _fields_ = [("date", ctypes.c_char * 11), ("time", ctypes.c_char * 9),
+                    ("channel", ctypes.c_uint8), ("data", ctypes.c_char * 8)]
+
+    class Index(ctypes.Structure):
+        # espelho de struct record_index_config (datalogger_driver.h)
+        _fields_ = [("last_write_idx", ctypes.c_uint32), ("last_read_idx", ctypes.c_uint32),
+                    ("total_idx", ctypes.c_uint32), ("cursor_position", ctypes.c_uint32)]
+
+    lib = hostbuild.build(
+        "lte_payload",
+        ["connectivity/ip/access_network/4G/src/lte_payload_builder.c",
+         "system/src/cbor_writer.c", "system/src/json_writer.c",
+         "tools/host/host_lte.c", "tools/host/host_rtos.c", "tools/host/host_uart.c"],
+        include_dirs=["connectivity/ip/access_network/4G/include", "system/include",
+                      "connectivity/services/log_mux/include",
+                      "connectivity/fieldbus/buses/RS485/include"],
+        verbose=verbose)
+    cp, u32, sz = ctypes.c_char_p, ctypes.c_uint32, ctypes.c_size_t
+    lib.host_lte_set_info.argtypes = [cp, cp, cp, cp, u32]
+    lib.host_lte_set_net.argtypes = [cp, cp, cp, ctypes.c_bool]
+    lib.host_lte_set_flags.argtypes = [ctypes.c_bool, ctypes.c_bool, ctypes.c_float]
+    lib.host_lte_set_records.argtypes = [ctypes.POINTER(Rec), sz]
+    lib.lte_json_data_payload.argtypes = [ctypes.c_char_p, sz, Index,
+                                          ctypes.POINTER(u32), ctypes.POINTER(u32)]
+    lib.lte_cbor_data_payload.argtypes = [ctypes.c_char_p, sz, Index, ctypes.POINTER(u32),
+                                          ctypes.POINTER(u32), ctypes.POINTER(sz)]
+    lib.Rec, lib.Index = Rec, Index
+    return lib
+
+
+class _Firmware:
+    def __init__(self, lib):
+        self.lib = lib
+
+    def setup(self, records, timestamp=False, user="", pw="", token=""):
+        import ctypes
+        lib = self.lib
+        lib.host_lte_set_info(*[v.encode("utf-8") if isinstance(v, str) else v for v in HEAD])
+        lib.host_lte_set_net(user.encode(), pw.encode(), token.encode(), False)
+        lib.host_lte_set_flags(timestamp, True, 7.08)
+        arr = (lib.Rec * len(records))(*[lib.Rec(d.encode(), t.encode(), c, v.encode())
+                                         for d, t, c, v in records])
+        lib.host_lte_set_records(arr, len(records))
+        self.total = len(records)
+        self._ctypes = ctypes
+
+    def index(self, first, last):
+        # lê do registro 'first' (cursor = índice) até 'last'
+        return self.lib.Index(last, (first - 1) % self.total, self.total, first)
+
+    def cbor(self, first, last, cap=4096):
+        c = self._ctypes
+        buf = c.create_string_buffer(cap)
+        n, cur, ln = c.c_uint32(), c.c_uint32(), c.c_size_t()
+        err = self.lib.lte_cbor_data_payload(buf, cap, self.index(first, last),
+                                             c.byref(n), c.byref(cur), c.byref(ln))
+        return err, buf.raw[:ln.value], n.value, cur.value
+
+    def json(self, first, last, cap=8192):
+        c = self._ctypes
+        buf = c.create_string_buffer(cap)
+        n, cur = c.c_uint32(), c.c_uint32()
+        err = self.lib.lte_json_data_payload(buf, cap, self.index(first, last),
+                                             c.byref(n), c.byref(cur))
+        return err, buf.value.decode("utf-8"), n.value, cur.value
+
+
+def selftest(verbose=False):
+    try:
+        fw = _Firmware(_load_firmware(verbose))
+    except (OSError, ImportError) as e:
+        print("não foi possível compilar o lte_payload_builder.c:", e)
+        return 1
+
+    cache = {}
+    results = []
+
+    def case(name, first, last, cap=4096, expect_info=None, expect_n=None, delivered=True):
+        err, data, n, cur = fw.cbor(first, last, cap)
+        jerr, expected, jn, jcur = fw.json(first, first + n - 1 if n else last)
+        root = cbor_loads(data) if err == 0 else {}
+        got = decode_to_json(data, cache) if err == 0 else None
+        problems = []
+        if err != 0 or jerr != 0:
+            problems.append("erro cbor=%d json=%d" % (err, jerr))
+        if got != expected:
+            problems.append("JSON diferente")
+        if (n, cur) != (jn, jcur):
+            problems.append("CBOR %d regs/cursor %d, JSON %d regs/cursor %d" % (n, cur, jn, jcur))
+        if expect_n is not None and n != expect_n:
+            problems.append("%d registros, esperado %d" % (n, expect_n))
+        if expect_info is not None and (K_NAME in root) != expect_info:
+            problems.append("identificação %s" % ("ausente" if expect_info else "presente"))
+        if delivered:
+            fw.lib.lte_payload_delivered()
+        results.append(not problems)
+        print("%-45s %4d B CBOR / %4d B JSON  %s" % (
+            name, len(data), len(expected.encode("utf-8")), "OK" if not problems else "FALHOU"))
+        for p in problems:
+            print("  " + p)
+        if got != expected:
+            print("  esperado:", expected)
+            print("  obtido:  ", got)
+        return data, root, n, cur
+
+    last = len(RECORDS) - 1
+    fw.setup(RECORDS)
+    data, root, _, _ = case("iso_com_identificacao", 0, last, expect_info=True, expect_n=len(RECORDS))
+
+    # Os canais RS-485 vão no CBOR (chave 14) mas não no JSON
+    rs485 = [r for r in root.get(K_RECORDS, []) if r[1] in (31, 45)]
+    good = len(rs485) == 2 and all(len(r) == 3 for r in rs485)
+    results.append(good)
+    print("%-45s %s" % ("canais_rs485_so_no_cbor", "OK" if good else "FALHOU"))
+
+    fw.setup(RECORDS, timestamp=True, user="user1", pw="s3nha")
+    case("ms_identificacao_do_cache_com_credenciais", 0, last, expect_info=False)
+
+    fw.setup(RECORDS_BACKWARDS)
+    case("delta_negativo_ajuste_de_relogio", 0, 1)
+
+    # Buffer pequeno: o que não cabe fica para o próximo lote, sem perder nada
+    fw.setup(RECORDS)
+    _, _, n, cur = case("lote_parcial", 0, last, cap=64, delivered=False)
+    if 0 < n < len(RECORDS):
+        case("lote_parcial_resto", cur, last, expect_n=len(RECORDS) - n)
+    else:
+        results.append(False)
+        print("lote_parcial: %d registros em 64 B" % n)
+
+    return 0 if all(results) else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decodifica o payload CBOR do LTE")
+    ap.add_argument("file", nargs="?")
+    ap.add_argument("--hex")
+    ap.add_argument("--all-values", action="store_true",
+                    help="inclui o valor dos canais que o JSON não leva (RS-485)")
+    ap.add_argument("--selftest", action="store_true")
+    ap.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest(args.verbose)
+    if args.hex:
+        data = bytes.fromhex(args.hex)
+    elif args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        ap.print_usage()
+        return 2
+    print(decode_to_json(data, all_values=args.all_values))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
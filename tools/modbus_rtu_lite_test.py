@@ -0,0 +1,231 @@
+# tools/modbus_rtu_lite_test.py
+#
+# Teste de ida e volta do master RTU próprio (modbus_rtu_lite.c) no PC:
+# o .c do firmware é compilado com os stubs de tools/host (UART sobre pty,
+# esp_timer no relógio monotônico) e fala com os escravos simulados do
+# modbus_sim.py pelo pty, no baud rate dado.
+#
+# Cobre: CRC16 e montagem de quadro contra o simulador, t3.5 (valor, TOUT
+# da UART e silêncio real entre quadros seguidos), resposta normal FC03/
+# FC04/FC10, exceções 01/02, CRC corrompido, quadros truncados (antes e
+# depois do 5º byte), escravo mudo (timeout por pedido) e contadores.
+#
+# Uso:
+#   python modbus_rtu_lite_test.py
+#   python modbus_rtu_lite_test.py --baud 19200 -v
+#
+# Requer um compilador C ($CC ou cc). Sem dependências além da biblioteca
+# padrão (Linux/macOS: pty + termios).
+import argparse
+import ctypes
+import os
+import random
+import sys
+import threading
+import time
+
+from host import hostbuild
+import modbus_sim as sim
+
+ESP_OK = 0
+ESP_ERR_NOT_SUPPORTED = 0x106
+ESP_ERR_TIMEOUT = 0x107
+ESP_ERR_INVALID_RESPONSE = 0x108
+ESP_ERR_INVALID_CRC = 0x109
+
+
+class Txn(ctypes.Structure):
+    # espelho de mb_rtu_txn_t (modbus_rtu_lite.h)
+    _fields_ = [("addr", ctypes.c_uint8), ("fc", ctypes.c_uint8),
+                ("reg", ctypes.c_uint16), ("count", ctypes.c_uint16),
+                ("words", ctypes.POINTER(ctypes.c_uint16)), ("timeout_ms", ctypes.c_uint32),
+                ("status", ctypes.c_int), ("exception", ctypes.c_uint8),
+                ("latency_ms", ctypes.c_uint16), ("t_sent_us", ctypes.c_int64),
+                ("pending", ctypes.c_bool)]
+
+
+class Stats(ctypes.Structure):
+    # espelho de mb_rtu_stats_t
+    _fields_ = [(n, ctypes.c_uint32) for n in
+                ("transactions", "ok", "timeouts", "crc_errors", "bad_frames", "exceptions",
+                 "timeout_wait_ms")] + \
+               [(n, ctypes.c_uint16) for n in ("latency_last_ms", "latency_avg_ms", "latency_max_ms")]
+
+
+def load(verbose=False):
+    lib = hostbuild.build(
+        "rtu_lite",
+        ["connectivity/fieldbus/protocols/modbus/src/modbus_rtu_lite.c", "tools/host/host_uart.c"],
+        include_dirs=["connectivity/fieldbus/protocols/modbus/include",
+                      "connectivity/fieldbus/buses/RS485/include"],
+        verbose=verbose)
+    u8p = ctypes.POINTER(ctypes.c_uint8)
+    lib.mb_rtu_crc16.restype = ctypes.c_uint16
+    lib.mb_rtu_crc16.argtypes = [u8p, ctypes.c_size_t]
+    lib.mb_rtu_crc_ok.restype = ctypes.c_bool
+    lib.mb_rtu_crc_ok.argtypes = [u8p, ctypes.c_size_t]
+    lib.mb_rtu_t35_us.restype = ctypes.c_uint32
+    lib.mb_rtu_t35_us.argtypes = [ctypes.c_uint32]
+    lib.mb_rtu_rx_tout_symbols.restype = ctypes.c_uint8
+    lib.mb_rtu_rx_tout_symbols.argtypes = [ctypes.c_uint32]
+    lib.mb_rtu_build_request.restype = ctypes.c_size_t
+    lib.mb_rtu_build_request.argtypes = [ctypes.POINTER(Txn), u8p, ctypes.c_size_t]
+    lib.mb_rtu_parse_response.argtypes = [ctypes.POINTER(Txn), u8p, ctypes.c_size_t]
+    lib.mb_rtu_open.argtypes = [ctypes.c_uint32]
+    lib.mb_rtu_transact.argtypes = [ctypes.POINTER(Txn)]
+    lib.mb_rtu_get_stats.argtypes = [ctypes.POINTER(Stats)]
+    lib.host_uart_attach.argtypes = [ctypes.c_int]
+    lib.host_uart_min_gap_us.restype = ctypes.c_int64
+    lib.host_uart_rx_tout.restype = ctypes.c_uint8
+    lib.host_log_level = ctypes.c_int.in_dll(lib, "host_log_level")
+    if verbose:
+        lib.host_log_level.value = 4
+    return lib
+
+
+def buf(data):
+    return (ctypes.c_uint8 * max(1, len(data)))(*data)
+
+
+def txn(addr, fc, reg, count, words=None, timeout_ms=0):
+    w = (ctypes.c_uint16 * max(1, count))(*(words or []))
+    t = Txn(addr=addr, fc=fc, reg=reg, count=count, words=w, timeout_ms=timeout_ms)
+    return t, w
+
+
+def run(args):
+    lib = load(args.verbose)
+    ok = True
+
+    def check(name, good):
+        nonlocal ok
+        ok &= bool(good)
+        print("%-52s %s" % (name, "OK" if good else "FALHOU"))
+
+    # ---- quadro (sem E/S) ----
+    rng = random.Random(1)
+    frames = [bytes(rng.randrange(256) for _ in range(rng.randrange(1, 64))) for _ in range(200)]
+    check("crc16 igual ao do simulador (200 quadros)",
+          all(lib.mb_rtu_crc16(buf(f), len(f)) == sim.crc16(f) for f in frames))
+    good = sim.with_crc(bytes.fromhex("0103020208"))
+    bad = good[:-1] + bytes((good[-1] ^ 1,))
+    check("crc_ok aceita o bom e recusa o corrompido",
+          lib.mb_rtu_crc_ok(buf(good), len(good)) and not lib.mb_rtu_crc_ok(buf(bad), len(bad)))
+    check("t3.5: 9600 -> 4011 us, 19200 -> 2006 us, 115200 -> 1750 us",
+          (lib.mb_rtu_t35_us(9600), lib.mb_rtu_t35_us(19200), lib.mb_rtu_t35_us(115200))
+          == (4011, 2006, 1750))
+    check("TOUT da UART: 9600 -> 4 símbolos, 115200 -> 21",
+          (lib.mb_rtu_rx_tout_symbols(9600), lib.mb_rtu_rx_tout_symbols(115200)) == (4, 21))
+
+    out = buf(bytes(256))
+    t, _ = txn(7, 0x03, sim.JSY_REG_I1, 3)
+    n = lib.mb_rtu_build_request(ctypes.byref(t), out, 256)
+    check("pedido FC03 igual ao do simulador",
+          bytes(out[:n]) == sim.read_request(7, 0x03, sim.JSY_REG_I1, 3))
+    t, _ = txn(7, 0x10, sim.JSY_REG_V, 2, [0x1234, 0xBEEF])
+    n = lib.mb_rtu_build_request(ctypes.byref(t), out, 256)
+    check("pedido FC10 igual ao do simulador",
+          bytes(out[:n]) == sim.write_multiple_request(7, sim.JSY_REG_V, [0x1234, 0xBEEF]))
+    t, _ = txn(0, 0x03, 0, 1)
+    t2, _ = txn(7, 0x03, 0, 126)
+    check("pedido inválido (addr 0, 126 words) -> 0 bytes",
+          lib.mb_rtu_build_request(ctypes.byref(t), out, 256) == 0
+          and lib.mb_rtu_build_request(ctypes.byref(t2), out, 256) == 0)
+
+    t, _ = txn(7, 0x04, 0, 1)
+    exc = sim.with_crc(bytes((7, 0x84, 0x02)))
+    st = lib.mb_rtu_parse_response(ctypes.byref(t), buf(exc), len(exc))
+    check("parse: exceção 02", st == ESP_ERR_NOT_SUPPORTED and t.exception == 2)
+    other = sim.with_crc(bytes((8, 0x04, 0x02, 0x00, 0x01)))
+    check("parse: resposta de outro escravo",
+          lib.mb_rtu_parse_response(ctypes.byref(t), buf(other), len(other)) == ESP_ERR_INVALID_RESPONSE)
+
+    # ---- ida e volta pelo pty ----
+    mfd, sfd = os.openpty()
+    sim.set_raw(mfd)
+    sim.set_raw(sfd)
+    slaves = [sim.Slave(1, "jsy", lat=2, jitter=0),
+              sim.Slave(2, "dead"),
+              sim.Slave(3, "jsy", crc=1.0, lat=2, jitter=0),
+              sim.Slave(4, "jsy", cut=3, lat=2, jitter=0),
+              sim.Slave(5, "jsy", cut=8, lat=2, jitter=0),
+              sim.Slave(6, "xy", fcs=(0x03,), lat=2, jitter=0)]
+    bus = sim.SimBus(sfd, slaves, args.baud)
+    th = threading.Thread(target=bus.serve_forever, daemon=True)
+    th.start()
+    lib.host_uart_attach(mfd)
+
+    try:
+        check("mb_rtu_open", lib.mb_rtu_open(args.baud) == ESP_OK
+              and lib.host_uart_rx_tout() == lib.mb_rtu_rx_tout_symbols(args.baud))
+
+        def transact(t):
+            return lib.mb_rtu_transact(ctypes.byref(t))
+
+        t, w = txn(1, 0x03, sim.JSY_REG_I1, 3, timeout_ms=200)
+        check("FC03 ok (correntes do JSY)", transact(t) == ESP_OK and list(w) == [520, 480, 505])
+        t, w = txn(6, 0x03, sim.XY_REG_T, 2, timeout_ms=200)
+        check("FC03 ok (XY-MD02 T/UR)", transact(t) == ESP_OK and list(w) == [235, 612])
+        t, _ = txn(1, 0x04, sim.JSY_REG_I1, 3, timeout_ms=200)
+        check("FC04 no JSY -> exceção 01",
+              transact(t) == ESP_ERR_NOT_SUPPORTED and t.exception == sim.EXC_ILLEGAL_FUNCTION)
+        t, _ = txn(1, 0x03, 0x0200, 1, timeout_ms=200)
+        check("registrador inexistente -> exceção 02",
+              transact(t) == ESP_ERR_NOT_SUPPORTED and t.exception == sim.EXC_ILLEGAL_ADDRESS)
+        t, _ = txn(1, 0x10, sim.JSY_REG_KWH, 1, [4321], timeout_ms=200)
+        check("FC10 ok (eco conferido)", transact(t) == ESP_OK and slaves[0].regs[sim.JSY_REG_KWH] == 4321)
+        t, _ = txn(3, 0x03, sim.JSY_REG_I1, 3, timeout_ms=200)
+        check("CRC corrompido -> INVALID_CRC", transact(t) == ESP_ERR_INVALID_CRC)
+        t, _ = txn(4, 0x03, sim.JSY_REG_I1, 3, timeout_ms=200)
+        check("truncado depois do 5º byte -> INVALID_RESPONSE", transact(t) == ESP_ERR_INVALID_RESPONSE)
+        t0 = time.monotonic()
+        t, _ = txn(5, 0x03, sim.JSY_REG_I1, 3, timeout_ms=150)
+        st = transact(t)
+        dt = (time.monotonic() - t0) * 1000
+        check("truncado antes do 5º byte -> INVALID_RESPONSE", st == ESP_ERR_INVALID_RESPONSE)
+        check("  ... sem esperar além do timeout (%.0f ms)" % dt, dt < 150 + 60)
+        t0 = time.monotonic()
+        t, _ = txn(2, 0x03, sim.JSY_REG_I1, 3, timeout_ms=120)
+        st = transact(t)
+        dt = (time.monotonic() - t0) * 1000
+        check("escravo mudo -> TIMEOUT em ~120 ms (%.0f ms)" % dt,
+              st == ESP_ERR_TIMEOUT and 120 <= dt < 120 + 60)
+
+        gap0 = bus.bad_crc
+        okn = 0
+        for i in range(20):
+            t, w = txn(1, 0x03, sim.JSY_REG_V, 4, timeout_ms=200)
+            okn += transact(t) == ESP_OK
+        check("20 pedidos seguidos, todos ok", okn == 20)
+        check("simulador separou todos os quadros (sem CRC ruim)", bus.bad_crc == gap0)
+        gap = lib.host_uart_min_gap_us()
+        check("silêncio antes de cada TX >= t3.5 (%d us)" % gap,
+              gap >= lib.mb_rtu_t35_us(args.baud))
+
+        st = Stats()
+        lib.mb_rtu_get_stats(ctypes.byref(st))
+        check("contadores (ok/exc/crc/quadro ruim/timeout)",
+              (st.transactions, st.ok, st.exceptions, st.crc_errors, st.bad_frames, st.timeouts)
+              == (29, 23, 2, 1, 2, 1))
+        check("tempo perdido em timeout contado (%d ms)" % st.timeout_wait_ms,
+              120 <= st.timeout_wait_ms < 120 + 60)
+        if args.verbose:
+            print({n: getattr(st, n) for n, _ in Stats._fields_})
+        lib.mb_rtu_close()
+    finally:
+        bus.stop.set()
+        th.join(timeout=1)
+        os.close(mfd)
+        os.close(sfd)
+    return 0 if ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Teste do modbus_rtu_lite.c contra o simulador")
+    ap.add_argument("--baud", type=int, default=9600)
+    ap.add_argument("-v", "--verbose", action="store_true")
+    return run(ap.parse_args())
+
+
+if __name__ == "__main__":
+    sys.exit(main())
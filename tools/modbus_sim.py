@@ -0,0 +1,640 @@
+# tools/modbus_sim.py
+#
+# Simulador de escravos Modbus RTU (JSY-MK-333 e XY-MD02) e benchmark do
+# barramento RS-485, para testar o fieldbus sem medidor na bancada.
+#
+#  - serve: abre um pty (ou uma porta serial real, ex. adaptador USB-RS485
+#    ligado à placa) e responde como os escravos dados em --slave. Cada
+#    escravo pode ter latência, jitter, perda de quadro, CRC corrompido ou
+#    estar morto. O tempo de fio é emulado no baud rate configurado.
+#  - bench: sobe o simulador num pty e roda, no mesmo processo, um master
+#    que segue a política do firmware (rs485_central + energy_meter +
+#    modbus_dev_profile): ordem por falhas seguidas/srtt, timeout por
+#    escravo (srtt + 4*rttvar, p95*1,5, margem, 60..600 ms), backoff
+#    exponencial de quem não responde e fallback FC03/FC04 com dica.
+#    Com --fixed-timeout roda a política antiga (timeout global, sem
+#    backoff nem dica) para comparar. Relata tempo de barramento por ciclo,
+#    retentativas e tempo perdido esperando timeout.
+#    O fieldbus_host_bench.py roda o código C do firmware contra este
+#    simulador e relata as mesmas grandezas, para conferir este espelho.
+#
+# Uso:
+#   python modbus_sim.py serve --slave 7:jsy --slave 3:xy:lat=40 --slave 9:dead
+#   python modbus_sim.py serve --port /dev/ttyUSB0 --baud 9600 --slave 1:jsy:drop=0.1
+#   python modbus_sim.py bench --meters 8 --dead 2 --cycles 20
+#   python modbus_sim.py bench --meters 8 --dead 2 --fixed-timeout 600
+#   python modbus_sim.py --selftest
+#
+# Opções de escravo (addr:tipo[:k=v,...]), tipo = jsy | xy | dead:
+#   lat=ms  jitter=ms  drop=0..1  crc=0..1  fc=3|4|34 (FCs de leitura aceitas)
+#   cut=n (corta os n últimos bytes de cada resposta: quadro truncado)
+#
+# Sem dependências além da biblioteca padrão (Linux/macOS: pty + termios).
+import argparse
+import os
+import random
+import select
+import statistics
+import struct
+import sys
+import termios
+import threading
+import time
+import tty
+
+# ---- Mapas de registradores (ver drivers em peripherals/energy e sensors)
+JSY_REG_V, JSY_REG_A, JSY_REG_W, JSY_REG_KWH, JSY_REG_COMM = 0x0000, 0x0001, 0x0002, 0x0003, 0x0004
+JSY_REG_I1 = 0x0103                     # I1..I3 em 0x0103..0x0105 (/100)
+XY_REG_T, XY_REG_RH = 0x0001, 0x0002    # s16 /10
+
+# ---- Constantes espelhadas do firmware (modbus_dev_profile.h / rs485_central.c)
+PROF_RTT_SAMPLES = 8
+PROF_TO_MARGIN_MS = 30
+PROF_TO_MIN_MS = 60
+PROF_TO_MAX_MS = 600                    # CONFIG_FMB_MASTER_TIMEOUT_MS_RESPOND
+PROF_DEAD_AFTER = 3
+PROF_SKIP_MAX_LEVEL = 5
+SLAVE_DEADLINE_MS = 800
+CYCLE_BUDGET_MS = 5000
+
+EXC_ILLEGAL_FUNCTION = 0x01
+EXC_ILLEGAL_ADDRESS = 0x02
+
+
+# -------- Quadro RTU --------
+def _crc_table():
+    tab = []
+    for i in range(256):
+        c = i
+        for _ in range(8):
+            c = (c >> 1) ^ 0xA001 if c & 1 else c >> 1
+        tab.append(c)
+    return tab
+
+
+_CRC_TAB = _crc_table()
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc = (crc >> 8) ^ _CRC_TAB[(crc ^ b) & 0xFF]
+    return crc
+
+
+def with_crc(body):
+    return bytes(body) + struct.pack("<H", crc16(body))
+
+
+def crc_ok(frame):
+    return len(frame) >= 4 and crc16(frame[:-2]) == struct.unpack("<H", frame[-2:])[0]
+
+
+def char_s(baud):
+    return 11.0 / baud                   # 11 bits por caractere, como o char_us do modbus_rtu_lite
+
+
+def t35_s(baud):
+    return 3.5 * 11.0 / baud if baud <= 19200 else 0.00175   # mesma regra do mb_rtu_t35_us
+
+
+def read_request(addr, fc, reg, count):
+    return with_crc(struct.pack(">BBHH", addr, fc, reg, count))
+
+
+def write_multiple_request(addr, reg, words):
+    body = struct.pack(">BBHHB", addr, 0x10, reg, len(words), 2 * len(words))
+    return with_crc(body + b"".join(struct.pack(">H", w & 0xFFFF) for w in words))
+
+
+# -------- Escravos --------
+class Slave:
+    def __init__(self, addr, kind, lat=8.0, jitter=2.0, drop=0.0, crc=0.0, fcs=None, rng=None, cut=0):
+        self.addr = addr
+        self.kind = kind
+        self.lat = lat
+        self.jitter = jitter
+        self.drop = drop
+        self.crc = crc
+        self.cut = int(cut)
+        self.rng = rng or random.Random(addr)
+        if fcs is None:
+            fcs = (0x03,) if kind == "jsy" else (0x03, 0x04)
+        self.fcs = tuple(fcs)
+        self.regs = {}
+        self.served = 0
+        self.dropped = 0
+        if kind == "jsy":
+            self.regs = {JSY_REG_V: 2200, JSY_REG_A: 150, JSY_REG_W: 3300, JSY_REG_KWH: 1234,
+                         JSY_REG_COMM: (addr << 8) | 0x06,
+                         JSY_REG_I1: 520, JSY_REG_I1 + 1: 480, JSY_REG_I1 + 2: 505}
+        elif kind == "xy":
+            self.regs = {XY_REG_T: 235, XY_REG_RH: 612}
+
+    @property
+    def dead(self):
+        return self.kind == "dead"
+
+    def tick(self):
+        # passeio aleatório nas grandezas, para o master ver valores mudando
+        if self.kind == "jsy":
+            for r in (JSY_REG_I1, JSY_REG_I1 + 1, JSY_REG_I1 + 2):
+                self.regs[r] = max(0, min(65535, self.regs[r] + self.rng.randint(-15, 15)))
+            self.regs[JSY_REG_V] = 2200 + self.rng.randint(-30, 30)
+            self.regs[JSY_REG_KWH] = (self.regs[JSY_REG_KWH] + 1) & 0xFFFF
+        elif self.kind == "xy":
+            t = self.regs[XY_REG_T]
+            t = t - 0x10000 if t & 0x8000 else t
+            self.regs[XY_REG_T] = (t + self.rng.randint(-3, 3)) & 0xFFFF
+            self.regs[XY_REG_RH] = max(0, min(1000, self.regs[XY_REG_RH] + self.rng.randint(-5, 5)))
+
+    def delay_s(self):
+        return max(0.0, self.lat + self.rng.uniform(-self.jitter, self.jitter)) / 1000.0
+
+    def _exception(self, fc, code):
+        return with_crc(bytes((self.addr, fc | 0x80, code)))
+
+    def handle(self, req):
+        """Resposta ao pedido (já com CRC) ou None (silêncio). Sem E/S."""
+        if self.dead:
+            return None
+        if self.drop and self.rng.random() < self.drop:
+            self.dropped += 1
+            return None
+        fc = req[1]
+        if fc in (0x03, 0x04):
+            if len(req) != 8:
+                return None
+            reg, count = struct.unpack(">HH", req[2:6])
+            if fc not in self.fcs:
+                resp = self._exception(fc, EXC_ILLEGAL_FUNCTION)
+            elif count == 0 or count > 125 or any((reg + i) not in self.regs for i in range(count)):
+                resp = self._exception(fc, EXC_ILLEGAL_ADDRESS)
+            else:
+                data = b"".join(struct.pack(">H", self.regs[reg + i]) for i in range(count))
+                resp = with_crc(bytes((self.addr, fc, len(data))) + data)
+                self.tick()
+        elif fc == 0x10:
+            if len(req) < 9:
+                return None
+            reg, count, nbytes = struct.unpack(">HHB", req[2:7])
+            if nbytes != 2 * count or len(req) != 9 + nbytes:
+                return None
+            if any((reg + i) not in self.regs for i in range(count)):
+                resp = self._exception(fc, EXC_ILLEGAL_ADDRESS)
+            else:
+                for i in range(count):
+                    self.regs[reg + i] = struct.unpack(">H", req[7 + 2 * i:9 + 2 * i])[0]
+                resp = with_crc(req[:6])
+                # JSY: byte alto do registrador de comunicação é o endereço
+                if self.kind == "jsy" and reg <= JSY_REG_COMM < reg + count:
+                    self.addr = self.regs[JSY_REG_COMM] >> 8
+        else:
+            resp = self._exception(fc, EXC_ILLEGAL_FUNCTION)
+        self.served += 1
+        if self.crc and self.rng.random() < self.crc:
+            resp = resp[:-1] + bytes((resp[-1] ^ 0x5A,))
+        if self.cut:
+            resp = resp[:max(1, len(resp) - self.cut)]
+        return resp
+
+
+def parse_slave(spec, rng_seed=None):
+    parts = spec.split(":")
+    if len(parts) < 2:
+        raise ValueError("escravo inválido: %r (use addr:tipo[:k=v,...])" % spec)
+    addr = int(parts[0], 0)
+    kind = parts[1].lower()
+    if not 1 <= addr <= 247 or kind not in ("jsy", "xy", "dead"):
+        raise ValueError("escravo inválido: %r" % spec)
+    kw = {}
+    if len(parts) > 2 and parts[2]:
+        for opt in parts[2].split(","):
+            k, _, v = opt.partition("=")
+            if k in ("lat", "jitter", "drop", "crc"):
+                kw[k] = float(v)
+            elif k == "cut":
+                kw[k] = int(v)
+            elif k == "fc":
+                kw["fcs"] = tuple(int(c) for c in v)
+            else:
+                raise ValueError("opção desconhecida: %r" % k)
+    rng = random.Random(addr if rng_seed is None else rng_seed * 1000 + addr)
+    return Slave(addr, kind, rng=rng, **kw)
+
+
+class SimBus:
+    """Lado escravo do barramento: separa quadros pelo silêncio de t3.5."""
+
+    def __init__(self, fd, slaves, baud):
+        self.fd = fd
+        self.slaves = list(slaves)
+        self.baud = baud
+        self.frames = 0
+        self.bad_crc = 0
+        self.stop = threading.Event()
+
+    def _slave(self, addr):
+        for s in self.slaves:
+            if s.addr == addr:
+                return s
+        return None
+
+    def _read_frame(self):
+        buf = b""
+        gap = t35_s(self.baud)
+        while not self.stop.is_set():
+            r, _, _ = select.select([self.fd], [], [], gap if buf else 0.1)
+            if not r:
+                if buf:
+                    return buf
+                continue
+            try:
+                chunk = os.read(self.fd, 512)
+            except OSError:
+                return None
+            if not chunk:
+                return None
+            buf += chunk
+        return None
+
+    def serve_forever(self, verbose=False):
+        ch = char_s(self.baud)
+        while not self.stop.is_set():
+            req = self._read_frame()
+            if req is None:
+                break
+            self.frames += 1
+            if len(req) < 4 or not crc_ok(req):
+                self.bad_crc += 1
+                continue
+            s = self._slave(req[0])
+            resp = s.handle(req) if s else None
+            if verbose:
+                print("rx %s -> %s" % (req.hex(), resp.hex() if resp else "(silêncio)"), flush=True)
+            if resp is None:
+                continue
+            # fio do pedido (já "passou" no pty) + processamento + fio da resposta
+            time.sleep(len(req) * ch + s.delay_s() + len(resp) * ch)
+            try:
+                os.write(self.fd, resp)
+            except OSError:
+                break
+
+
+def set_raw(fd, baud=None):
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[3] &= ~termios.ECHO
+    if baud is not None:
+        speed = getattr(termios, "B%d" % baud, None)
+        if speed is None:
+            raise ValueError("baud não suportado pelo termios: %d" % baud)
+        attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+
+
+# -------- Master (espelha modbus_rtu_lite + modbus_dev_profile) --------
+class Profile:
+    def __init__(self):
+        self.srtt = 0
+        self.rttvar = 0
+        self.hist = []
+        self.fail_streak = 0
+        self.skip_level = 0
+        self.skip_left = 0
+        self.used_fc = 0
+
+    def note_ok(self, fc, ms):
+        self.used_fc = fc
+        self.fail_streak = self.skip_level = self.skip_left = 0
+        if ms <= 0:
+            return
+        if not self.hist and self.srtt == 0:
+            self.srtt, self.rttvar = ms, ms // 2
+        else:
+            err = ms - self.srtt
+            self.srtt += int(err / 8)
+            self.rttvar += int((abs(err) - self.rttvar) / 4)
+        self.hist = (self.hist + [ms])[-PROF_RTT_SAMPLES:]
+
+    def note_fail(self):
+        self.fail_streak += 1
+        if self.fail_streak >= PROF_DEAD_AFTER:
+            self.skip_level = min(self.skip_level + 1, PROF_SKIP_MAX_LEVEL)
+            self.skip_left = (1 << self.skip_level) - 1
+
+    def should_poll(self):
+        if self.skip_left > 0:
+            self.skip_left -= 1
+            return False
+        return True
+
+    def timeout_ms(self):
+        if not self.hist:
+            return PROF_TO_MAX_MS
+        v = sorted(self.hist)
+        p95 = v[(95 * (len(v) - 1) + 50) // 100]
+        rto = max(self.srtt + 4 * self.rttvar, p95 * 3 // 2) + PROF_TO_MARGIN_MS
+        return max(PROF_TO_MIN_MS, min(PROF_TO_MAX_MS, rto))
+
+
+class Master:
+    def __init__(self, fd, baud):
+        self.fd = fd
+        self.baud = baud
+        self.last_rx = 0.0
+        self.timeouts = 0
+        self.crc_errors = 0
+        self.exceptions = 0
+        self.waste_s = 0.0
+
+    def _read(self, n, deadline):
+        buf = b""
+        while len(buf) < n:
+            left = deadline - time.monotonic()
+            if left <= 0:
+                break
+            r, _, _ = select.select([self.fd], [], [], left)
+            if r:
+                buf += os.read(self.fd, n - len(buf))
+        return buf
+
+    def transact(self, req, want, timeout_ms):
+        """Retorna ('ok', payload) | ('timeout'|'crc'|'exc'|'bad', None)."""
+        ch, t35 = char_s(self.baud), t35_s(self.baud)
+        gap = self.last_rx + t35 - time.monotonic()
+        if gap > 0:
+            time.sleep(gap)
+        termios.tcflush(self.fd, termios.TCIFLUSH)
+        t_start = time.monotonic()
+        os.write(self.fd, req)
+        t_sent = t_start + len(req) * ch                     # fim do pedido no fio
+        hdr = self._read(5, t_sent + timeout_ms / 1000.0 + 5 * ch + t35)
+        if len(hdr) < 5:
+            self.timeouts += 1
+            self.waste_s += time.monotonic() - t_start
+            self.last_rx = time.monotonic()
+            return "timeout", None
+        if hdr[1] & 0x80:
+            frame = hdr
+            status = "exc"
+            self.exceptions += 1
+        else:
+            frame = hdr + self._read(want - 5, time.monotonic() + (want - 5) * ch + t35 + 0.05)
+            status = "ok"
+        self.last_rx = time.monotonic()
+        if not crc_ok(frame) or frame[0] != req[0]:
+            self.crc_errors += status == "ok"
+            return ("crc" if status == "ok" else "bad"), None
+        if status == "exc":
+            return "exc", None
+        if len(frame) != want:
+            return "bad", None
+        return "ok", frame[3:-2]
+
+
+def run_bench(args):
+    rng = random.Random(args.seed)
+    n_dead = min(args.dead, args.meters)
+    slaves = []
+    for i in range(args.meters):
+        addr = i + 1
+        dead = i >= args.meters - n_dead
+        fcs = (0x04,) if (args.fc4_every and (i % args.fc4_every) == args.fc4_every - 1) else (0x03,)
+        slaves.append(Slave(addr, "dead" if dead else "jsy", lat=args.latency, jitter=args.jitter,
+                            drop=args.drop, fcs=fcs, rng=random.Random(rng.random())))
+
+    mfd, sfd = os.openpty()
+    set_raw(mfd)
+    set_raw(sfd)
+    bus = SimBus(sfd, slaves, args.baud)
+    th = threading.Thread(target=bus.serve_forever, daemon=True)
+    th.start()
+    master = Master(mfd, args.baud)
+
+    adaptive = args.fixed_timeout is None
+    profs = {s.addr: Profile() for s in slaves}
+    want = 5 + 2 * 3
+    cycles = []
+    ok_total = fail_total = retries = skipped_backoff = deferred = 0
+
+    for c in range(args.cycles):
+        t0 = time.monotonic()
+        cycle_deadline = t0 + args.budget / 1000.0
+        items = []
+        for s in slaves:
+            p = profs[s.addr]
+            if adaptive and not p.should_poll():
+                skipped_backoff += 1
+                continue
+            items.append(s.addr)
+        if adaptive:
+            items.sort(key=lambda a: (profs[a].fail_streak, profs[a].srtt, a))
+
+        for i, addr in enumerate(items):
+            now = time.monotonic()
+            if now >= cycle_deadline:
+                deferred += len(items) - i
+                break
+            p = profs[addr]
+            if adaptive:
+                tmo = p.timeout_ms()
+                # rs485_central só encurta o prazo do escravo com histórico
+                slave_ms = min(SLAVE_DEADLINE_MS, tmo) if p.hist else SLAVE_DEADLINE_MS
+                slave_deadline = min(now + slave_ms / 1000.0, cycle_deadline)
+                hinted = p.used_fc
+            else:
+                tmo, slave_deadline, hinted = args.fixed_timeout, None, 0
+            order = (0x04, 0x03) if hinted == 0x04 else (0x03, 0x04)
+            st, ok_fc, lat = "timeout", 0, 0
+            for k, fc in enumerate(order):
+                tk = time.monotonic()
+                if k > 0:
+                    if slave_deadline and tk >= slave_deadline:
+                        break
+                    if hinted and st == "timeout":
+                        break
+                    retries += 1
+                st, _ = master.transact(read_request(addr, fc, JSY_REG_I1, 3), want, tmo)
+                if st == "ok":
+                    ok_fc, lat = fc, int((time.monotonic() - tk) * 1000)
+                    break
+            if ok_fc:
+                ok_total += 1
+                p.note_ok(ok_fc, lat)
+            else:
+                fail_total += 1
+                p.note_fail()
+        ms = (time.monotonic() - t0) * 1000
+        cycles.append(ms)
+        if args.verbose:
+            print("ciclo %3d: %7.1f ms  (%d lido(s))" % (c + 1, ms, len(items)))
+
+    bus.stop.set()
+    th.join(timeout=1)
+    os.close(mfd)
+    os.close(sfd)
+
+    mode = "adaptativo (firmware)" if adaptive else "timeout fixo %d ms" % args.fixed_timeout
+    p95 = sorted(cycles)[int(0.95 * (len(cycles) - 1))]
+    print("modo: %s | %d medidor(es), %d morto(s), perda %.0f%%, latência %.0f±%.0f ms, %d bps"
+          % (mode, args.meters, n_dead, args.drop * 100, args.latency, args.jitter, args.baud))
+    print("ciclos: %d | barramento por ciclo: média %.1f ms, p95 %.1f ms, máx %.1f ms"
+          % (len(cycles), statistics.mean(cycles), p95, max(cycles)))
+    print("leituras: %d ok, %d falha(s), %d retentativa(s) de FC, %d pulada(s) em backoff, %d adiada(s)"
+          % (ok_total, fail_total, retries, skipped_backoff, deferred))
+    print("timeouts: %d | tempo perdido em timeout: %.0f ms (%.1f ms/ciclo) | CRC: %d, exceções: %d"
+          % (master.timeouts, master.waste_s * 1000, master.waste_s * 1000 / len(cycles),
+             master.crc_errors, master.exceptions))
+    return 0
+
+
+def run_serve(args):
+    slaves = [parse_slave(s) for s in args.slave]
+    if not slaves:
+        print("nenhum escravo (use --slave addr:tipo)", file=sys.stderr)
+        return 2
+    if args.port:
+        fd = os.open(args.port, os.O_RDWR | os.O_NOCTTY)
+        set_raw(fd, args.baud)
+        path = args.port
+        keep = None
+    else:
+        keep, fd = os.openpty()      # 'keep' (lado master) fica aberto enquanto servimos
+        set_raw(keep)
+        set_raw(fd)
+        path = os.ttyname(fd)
+        if args.link:
+            if os.path.islink(args.link):
+                os.unlink(args.link)
+            os.symlink(path, args.link)
+            path = "%s -> %s" % (args.link, path)
+        # o cliente abre o lado escravo; nós servimos pelo lado master
+        fd, keep = keep, fd
+    print("escravos em %s (%d bps): %s" % (path, args.baud, ", ".join(
+        "%d=%s" % (s.addr, s.kind) for s in slaves)), flush=True)
+    bus = SimBus(fd, slaves, args.baud)
+    try:
+        bus.serve_forever(verbose=args.verbose)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print("quadros: %d, CRC inválido: %d" % (bus.frames, bus.bad_crc))
+        if args.link and os.path.islink(args.link):
+            os.unlink(args.link)
+    return 0
+
+
+# -------- Autoteste --------
+def selftest():
+    ok = True
+
+    def check(name, good):
+        nonlocal ok
+        ok &= bool(good)
+        print("%-45s %s" % (name, "OK" if good else "FALHOU"))
+
+    check("crc16 (01 03 00 00 00 01 -> 0x0A84)",
+          crc16(bytes.fromhex("010300000001")) == 0x0A84)
+    check("crc16 vetor clássico (01 04 00 00 00 0A)",
+          with_crc(bytes.fromhex("01040000000A")).hex() == "01040000000a700d")
+    check("t3.5 a 9600 bps ~ 4,01 ms", abs(t35_s(9600) - 0.0040104) < 1e-6)
+
+    jsy = Slave(7, "jsy", lat=0, jitter=0)
+    r = jsy.handle(read_request(7, 0x03, JSY_REG_I1, 3))
+    check("JSY FC03 correntes", r is not None and crc_ok(r) and r[:3] == bytes((7, 3, 6))
+          and struct.unpack(">H", r[3:5])[0] == 520)
+    r = jsy.handle(read_request(7, 0x04, JSY_REG_I1, 3))
+    check("JSY FC04 -> exceção 01", r == with_crc(bytes((7, 0x84, 1))))
+    r = jsy.handle(read_request(7, 0x03, 0x0200, 1))
+    check("JSY registrador inexistente -> exceção 02", r == with_crc(bytes((7, 0x83, 2))))
+    r = jsy.handle(write_multiple_request(7, JSY_REG_COMM, [(9 << 8) | 0x06]))
+    check("JSY FC10 troca o endereço", r is not None and crc_ok(r) and jsy.addr == 9)
+
+    xy = Slave(3, "xy", lat=0, jitter=0)
+    xy.regs[XY_REG_T] = (-52) & 0xFFFF
+    r = xy.handle(read_request(3, 0x04, XY_REG_T, 2))
+    check("XY FC04 temperatura negativa (s16)",
+          r is not None and struct.unpack(">h", r[3:5])[0] == -52)
+
+    check("escravo morto fica em silêncio",
+          Slave(9, "dead").handle(read_request(9, 3, 0, 1)) is None)
+    lossy = Slave(5, "jsy", drop=1.0)
+    check("drop=1 nunca responde", lossy.handle(read_request(5, 3, JSY_REG_I1, 3)) is None)
+    bad = Slave(6, "jsy", crc=1.0, lat=0, jitter=0)
+    check("crc=1 corrompe a resposta", not crc_ok(bad.handle(read_request(6, 3, JSY_REG_I1, 3))))
+    check("cut=4 trunca a resposta",
+          len(Slave(8, "jsy", cut=4, lat=0, jitter=0).handle(read_request(8, 3, JSY_REG_I1, 3))) == 7)
+
+    s = parse_slave("12:xy:lat=40,drop=0.25,fc=4")
+    check("parse de --slave", (s.addr, s.kind, s.lat, s.drop, s.fcs) == (12, "xy", 40.0, 0.25, (4,)))
+
+    p = Profile()
+    for _ in range(8):
+        p.note_ok(3, 20)
+    check("timeout adaptativo com latência estável", PROF_TO_MIN_MS <= p.timeout_ms() < 100)
+    for _ in range(3):
+        p.note_fail()
+    check("backoff após 3 falhas (pula 1 ciclo)", not p.should_poll() and p.should_poll())
+
+    # ida e volta por um pty real
+    mfd, sfd = os.openpty()
+    set_raw(mfd)
+    set_raw(sfd)
+    bus = SimBus(sfd, [Slave(1, "jsy", lat=1, jitter=0), Slave(2, "dead")], 115200)
+    th = threading.Thread(target=bus.serve_forever, daemon=True)
+    th.start()
+    m = Master(mfd, 115200)
+    st1, data = m.transact(read_request(1, 3, JSY_REG_I1, 3), 11, 200)
+    st2, _ = m.transact(read_request(2, 3, JSY_REG_I1, 3), 11, 60)
+    st3, _ = m.transact(read_request(1, 4, JSY_REG_I1, 3), 11, 200)
+    bus.stop.set()
+    th.join(timeout=1)
+    os.close(mfd)
+    os.close(sfd)
+    check("pty: leitura ok", st1 == "ok" and len(data) == 6)
+    check("pty: escravo morto -> timeout", st2 == "timeout")
+    check("pty: FC não suportada -> exceção", st3 == "exc")
+    return 0 if ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Simulador Modbus RTU e benchmark do barramento RS-485")
+    ap.add_argument("--selftest", action="store_true")
+    sub = ap.add_subparsers(dest="cmd")
+
+    sp = sub.add_parser("serve", help="responde como escravos num pty ou porta serial")
+    sp.add_argument("--slave", action="append", default=[], help="addr:jsy|xy|dead[:lat=,jitter=,drop=,crc=,fc=,cut=]")
+    sp.add_argument("--port", help="porta serial real (padrão: cria um pty)")
+    sp.add_argument("--link", help="symlink estável para o pty criado")
+    sp.add_argument("--baud", type=int, default=9600)
+    sp.add_argument("-v", "--verbose", action="store_true")
+
+    bp = sub.add_parser("bench", help="mede o ciclo do rs485_central contra N medidores simulados")
+    bp.add_argument("--meters", type=int, default=8)
+    bp.add_argument("--dead", type=int, default=1, help="quantos medidores (os últimos) não respondem")
+    bp.add_argument("--drop", type=float, default=0.0, help="probabilidade de perder cada resposta")
+    bp.add_argument("--latency", type=float, default=15.0, help="processamento do escravo (ms)")
+    bp.add_argument("--jitter", type=float, default=5.0)
+    bp.add_argument("--fc4-every", type=int, default=0, help="1 a cada N medidores só aceita FC04")
+    bp.add_argument("--cycles", type=int, default=20)
+    bp.add_argument("--budget", type=int, default=CYCLE_BUDGET_MS, help="orçamento do ciclo (ms)")
+    bp.add_argument("--fixed-timeout", type=int, help="política antiga: timeout global (ms), sem backoff")
+    bp.add_argument("--baud", type=int, default=9600)
+    bp.add_argument("--seed", type=int, default=1)
+    bp.add_argument("-v", "--verbose", action="store_true")
+    args = ap.parse_args()
+
+    if args.selftest:
+        return selftest()
+    if args.cmd == "serve":
+        return run_serve(args)
+    if args.cmd == "bench":
+        return run_bench(args)
+    ap.print_usage()
+    return 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
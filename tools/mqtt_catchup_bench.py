@@ -0,0 +1,334 @@
+# tools/mqtt_catchup_bench.py
+#
+# Broker MQTT 3.1.1 mínimo para bancada e benchmark de recuperação de
+# backlog (envio do SD após dias sem rede).
+#
+#  - broker: escuta em --bind:--port e aceita CONNECT/SUBSCRIBE/PUBLISH
+#    (QoS 0/1/2)/PINGREQ/DISCONNECT. Cada resposta sai depois de --rtt ms
+#    (metade ida, metade volta) para emular o enlace (Wi-Fi ~20 ms, LTE-M
+#    ~150-400 ms). Ao fim de cada conexão relata lotes, pontos, bytes,
+#    duração e pontos/s. Aponte o datalogger (Wi-Fi ou SARA) para ele e
+#    compare com o log "MQTT/TIME" do firmware.
+#  - bench: sobe o broker no mesmo processo e envia um backlog de
+#    --records registros em lotes de --batch pontos com três
+#    políticas: 1 lote por ativação (firmware antigo, nova conexão a cada
+#    lote), sessão sequencial (SARA: um publish confirmado por vez) e
+#    sessão com janela de --window publishes em voo (Wi-Fi, esp-mqtt).
+#    Os orçamentos espelham mqtt_tcp.c/u_cell_mqtt.c (60 s, 500 lotes).
+#    Relata tempo de rádio, ativações necessárias e pontos/s.
+#
+# Uso:
+#   python mqtt_catchup_bench.py broker --port 1883 --rtt 250
+#   python mqtt_catchup_bench.py bench --records 10000 --rtt 250 --connect-ms 2500
+#   python mqtt_catchup_bench.py --selftest
+#
+# Sem dependências além da biblioteca padrão.
+import argparse
+import asyncio
+import json
+import struct
+import sys
+import time
+
+# ---- Constantes espelhadas do firmware (mqtt_tcp.c / u_cell_mqtt.c)
+BATCH_POINTS = 10          # o firmware enche o buffer do transporte; ~12 pontos cabem no JSON de 1 KB do SARA
+STREAM_WINDOW = 4
+STREAM_BUDGET_MS = 60000
+STREAM_MAX_BATCHES = 500
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 0x10, 0x20, 0x30, 0x40
+PUBREC, PUBREL, PUBCOMP = 0x50, 0x60, 0x70
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 0x80, 0x90, 0xC0, 0xD0, 0xE0
+
+
+def enc_len(n):
+    out = bytearray()
+    while True:
+        b = n % 128
+        n //= 128
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def packet(ptype, body=b""):
+    return bytes([ptype]) + enc_len(len(body)) + body
+
+
+async def read_packet(reader):
+    hdr = await reader.readexactly(1)
+    mult, length = 1, 0
+    while True:
+        b = (await reader.readexactly(1))[0]
+        length += (b & 0x7F) * mult
+        mult *= 128
+        if not b & 0x80:
+            break
+    body = await reader.readexactly(length) if length else b""
+    return hdr[0], body
+
+
+def count_points(payload):
+    # JSON do firmware: lista de registros ou objeto com uma lista; CBOR/
+    # desconhecido conta como 1 lote sem pontos conhecidos
+    try:
+        doc = json.loads(payload)
+    except (ValueError, UnicodeDecodeError):
+        return 0
+    if isinstance(doc, list):
+        return len(doc)
+    if isinstance(doc, dict):
+        for v in doc.values():
+            if isinstance(v, list):
+                return len(v)
+    return 1
+
+
+# ============================ broker ============================
+
+class Broker:
+    def __init__(self, rtt_ms, quiet=False):
+        self.rtt = rtt_ms / 1000.0
+        self.quiet = quiet
+        self.sessions = []
+
+    async def handle(self, reader, writer):
+        st = {"batches": 0, "points": 0, "bytes": 0, "t0": time.monotonic()}
+        wlock = asyncio.Lock()
+        pending = set()
+
+        async def reply(data):
+            # ordem preservada: todas as respostas atrasam o mesmo RTT
+            await asyncio.sleep(self.rtt)
+            async with wlock:
+                writer.write(data)
+                await writer.drain()
+
+        def send(data):
+            t = asyncio.ensure_future(reply(data))
+            pending.add(t)
+            t.add_done_callback(pending.discard)
+
+        try:
+            while True:
+                ptype, body = await read_packet(reader)
+                kind = ptype & 0xF0
+                if kind == CONNECT:
+                    send(packet(CONNACK, b"\x00\x00"))
+                elif kind == PUBLISH:
+                    qos = (ptype >> 1) & 3
+                    tlen = struct.unpack(">H", body[:2])[0]
+                    pos = 2 + tlen
+                    pid = None
+                    if qos:
+                        pid = body[pos:pos + 2]
+                        pos += 2
+                    payload = body[pos:]
+                    st["batches"] += 1
+                    st["bytes"] += len(payload)
+                    st["points"] += count_points(payload)
+                    if qos == 1:
+                        send(packet(PUBACK, pid))
+                    elif qos == 2:
+                        send(packet(PUBREC, pid))
+                elif kind == PUBREL:
+                    send(packet(PUBCOMP, body[:2]))
+                elif kind == SUBSCRIBE:
+                    n_topics, pos = 0, 2
+                    while pos < len(body):
+                        tlen = struct.unpack(">H", body[pos:pos + 2])[0]
+                        pos += 2 + tlen + 1
+                        n_topics += 1
+                    send(packet(SUBACK, body[:2] + b"\x01" * n_topics))
+                elif kind == PINGREQ:
+                    send(packet(PINGRESP))
+                elif kind == DISCONNECT:
+                    break
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        except asyncio.CancelledError:
+            writer.close()      # broker encerrado com a conexão aberta
+            return
+        if pending:
+            await asyncio.gather(*pending, return_exceptions=True)
+        writer.close()
+        st["dur"] = time.monotonic() - st["t0"]
+        self.sessions.append(st)
+        if not self.quiet:
+            rate = st["points"] / st["dur"] if st["dur"] > 0 else 0.0
+            print(f"sessão: {st['batches']} lote(s), {st['points']} ponto(s), {st['bytes']} B "
+                  f"em {st['dur'] * 1000:.0f} ms ({rate:.1f} pts/s)", flush=True)
+
+
+async def start_broker(bind, port, rtt_ms, quiet=False):
+    broker = Broker(rtt_ms, quiet)
+    server = await asyncio.start_server(broker.handle, bind, port)
+    return broker, server
+
+
+# ============================ cliente (bench) ============================
+
+class Client:
+    def __init__(self, reader, writer):
+        self.r, self.w = reader, writer
+        self.next_id = 1
+
+    @classmethod
+    async def connect(cls, host, port, connect_ms):
+        # connect_ms: custo fixo além do RTT (TLS, registro do PDP no SARA)
+        await asyncio.sleep(connect_ms / 1000.0)
+        r, w = await asyncio.open_connection(host, port)
+        c = cls(r, w)
+        body = b"\x00\x04MQTT\x04\x02\x00\x3c" + struct.pack(">H", 6) + b"bench0"
+        w.write(packet(CONNECT, body))
+        ptype, _ = await read_packet(r)
+        assert ptype & 0xF0 == CONNACK
+        return c
+
+    def publish(self, payload):
+        pid = self.next_id
+        self.next_id = self.next_id % 65535 + 1
+        topic = b"datalogger/bench"
+        body = struct.pack(">H", len(topic)) + topic + struct.pack(">H", pid) + payload
+        self.w.write(packet(PUBLISH | 0x02, body))
+        return pid
+
+    async def wait_ack(self):
+        while True:
+            ptype, body = await read_packet(self.r)
+            if ptype & 0xF0 == PUBACK:
+                return struct.unpack(">H", body[:2])[0]
+
+    async def close(self):
+        self.w.write(packet(DISCONNECT))
+        await self.w.drain()
+        self.w.close()
+
+
+def make_batch(first, n):
+    return json.dumps([{"ch": 1, "ts": 1700000000 + 60 * (first + i), "v": first + i}
+                       for i in range(n)]).encode()
+
+
+async def session(host, port, backlog, batch, window, connect_ms, max_batches):
+    # Uma ativação: conecta, envia até o orçamento, retorna pontos confirmados
+    t0 = time.monotonic()
+    c = await Client.connect(host, port, connect_ms)
+    sent = acked = 0
+    inflight = []
+    cursor = 0
+    while True:
+        while (cursor < backlog and len(inflight) < window and sent < max_batches and
+               (time.monotonic() - t0) * 1000 < STREAM_BUDGET_MS):
+            n = min(batch, backlog - cursor)
+            inflight.append((c.publish(make_batch(cursor, n)), n))
+            cursor += n
+            sent += 1
+        if not inflight:
+            break
+        await c.w.drain()
+        pid = await c.wait_ack()
+        # confirma na ordem do SD
+        inflight = [(p, n) if p != pid else (p, -n) for p, n in inflight]
+        while inflight and inflight[0][1] < 0:
+            acked += -inflight.pop(0)[1]
+    await c.close()
+    return acked, time.monotonic() - t0
+
+
+async def run_policy(host, port, records, batch, window, connect_ms, per_wake):
+    left, wakes, radio_s = records, 0, 0.0
+    while left > 0:
+        max_b = 1 if per_wake else STREAM_MAX_BATCHES
+        acked, dur = await session(host, port, left, batch, window, connect_ms, max_b)
+        if acked == 0:
+            raise RuntimeError("sessão sem PUBACK")
+        left -= acked
+        wakes += 1
+        radio_s += dur
+    return wakes, radio_s
+
+
+async def bench(args):
+    broker, server = await start_broker("127.0.0.1", 0, args.rtt, quiet=True)
+    port = server.sockets[0].getsockname()[1]
+    results = []
+    policies = [
+        ("1 lote/ativação (antigo)", 1, True),
+        ("sessão sequencial (LTE)", 1, False),
+        (f"sessão janela {args.window} (Wi-Fi)", args.window, False),
+    ]
+    if args.records > args.max_per_wake_records:
+        # 1 lote por ativação com backlog grande leva horas de relógio; estima
+        # a partir de uma amostra
+        sample = args.max_per_wake_records
+    else:
+        sample = args.records
+    for name, window, per_wake in policies:
+        n = sample if per_wake else args.records
+        wakes, radio_s = await run_policy("127.0.0.1", port, n, args.batch, window,
+                                          args.connect_ms, per_wake)
+        scale = args.records / n
+        wakes, radio_s = wakes * scale, radio_s * scale
+        results.append((name, wakes, radio_s, args.records / radio_s if radio_s else 0.0))
+    server.close()
+    await server.wait_closed()
+
+    print(f"backlog={args.records} lote={args.batch} rtt={args.rtt}ms connect={args.connect_ms}ms "
+          f"período={args.period_min}min")
+    print(f"{'política':32s} {'ativações':>10s} {'rádio (s)':>10s} {'pts/s':>8s} {'dias p/ drenar':>15s}")
+    for name, wakes, radio_s, rate in results:
+        days = wakes * args.period_min / 1440.0
+        print(f"{name:32s} {wakes:10.0f} {radio_s:10.1f} {rate:8.1f} {days:15.2f}")
+    return results
+
+
+async def serve(args):
+    _, server = await start_broker(args.bind, args.port, args.rtt)
+    print(f"broker em {args.bind}:{args.port} (rtt {args.rtt} ms)", flush=True)
+    async with server:
+        await server.serve_forever()
+
+
+def selftest():
+    ns = argparse.Namespace(records=400, batch=BATCH_POINTS, rtt=20, connect_ms=50,
+                            window=STREAM_WINDOW, period_min=5, max_per_wake_records=100)
+    res = asyncio.run(bench(ns))
+    old, seq, win = res
+    assert old[1] == 40 and seq[1] == 1 and win[1] == 1, res
+    assert win[3] > seq[3] > old[3], res
+    print("selftest ok")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__)
+    ap.add_argument("--selftest", action="store_true")
+    sub = ap.add_subparsers(dest="cmd")
+    b = sub.add_parser("broker")
+    b.add_argument("--bind", default="0.0.0.0")
+    b.add_argument("--port", type=int, default=1883)
+    b.add_argument("--rtt", type=float, default=0.0)
+    k = sub.add_parser("bench")
+    k.add_argument("--records", type=int, default=10000)
+    k.add_argument("--batch", type=int, default=BATCH_POINTS)
+    k.add_argument("--rtt", type=float, default=250.0)
+    k.add_argument("--connect-ms", type=float, default=2500.0)
+    k.add_argument("--window", type=int, default=STREAM_WINDOW)
+    k.add_argument("--period-min", type=int, default=5)
+    k.add_argument("--max-per-wake-records", type=int, default=200)
+    args = ap.parse_args()
+
+    if args.selftest:
+        selftest()
+    elif args.cmd == "broker":
+        asyncio.run(serve(args))
+    elif args.cmd == "bench":
+        asyncio.run(bench(args))
+    else:
+        ap.print_help()
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())